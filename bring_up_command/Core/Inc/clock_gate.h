@@ -0,0 +1,120 @@
+/**
+ * @file clock_gate.h
+ * @brief Reference-counted peripheral clock gating.
+ *
+ * Drivers take a reference on the clocks they use with ClockGateAcquire()
+ * and give it back with ClockGateRelease(). The RCC enable bit is set when
+ * the first reference is taken and cleared when the last one goes, so a
+ * peripheral only draws current while someone uses it.
+ *
+ * The same is done for the sleep mode enable bits (*SMENR, the L0 name
+ * of the *LPENR registers of other families): a reference taken with
+ * @c in_sleep also keeps the clock running while the core sleeps in WFI,
+ * which a peripheral that must wake it up needs. All of them are set out
+ * of reset; ClockGateInit() clears those of the clocks that are off.
+ *
+ * DMA1 and the UART clocks are referenced by their drivers: the UART
+ * consoles hold their port and DMA1, run and sleep, while they listen,
+ * and dma_copy holds DMA1 while its queue is busy. ClockGateInit() stops
+ * these clocks after the CubeMX initialization, so a port without a
+ * console (USART1 when the SPI console is built in) stays off. Every
+ * UART console listens for good, so in practice DMA1 stays on. Other
+ * clocks the CubeMX initialization enabled (the GPIO ports, SYSCFG, PWR)
+ * are adopted with one "boot" reference, run and sleep, that is never
+ * released.
+ *
+ * The main loop polls and never executes WFI, so the sleep references
+ * have no effect yet: they record which clocks an idle loop that sleeps
+ * would have to keep.
+ *
+ * The manager also keeps how long each clock has been on, reported with
+ * its references by `clocks`.
+ *
+ * Acquire and release are safe from interrupt handlers.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_CLOCK_GATE_H_
+#define SRC_CLOCK_GATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @enum ClockGateId
+ * @brief Gated clocks. The GPIO ports come first, in port order.
+ */
+typedef enum {
+  kClockGateGpioA = 0,
+  kClockGateGpioB,
+  kClockGateGpioC,
+  kClockGateGpioD,
+  kClockGateGpioE,
+  kClockGateGpioH,
+  kClockGateDma1,
+  kClockGateCrc,
+  kClockGateUsart1,
+  kClockGateUsart2,
+  kClockGateLpuart1,
+  kClockGateTim2,
+  kClockGateTim6,
+  kClockGateTim21,
+  kClockGateSpi1,
+  kClockGateI2c1,
+  kClockGateSyscfg,
+  kClockGatePwr,
+  kClockGateDbgmcu,
+  kClockGateCount
+} ClockGateId;
+
+/**
+ * @brief Adopts the clocks enabled so far, stops those their drivers
+ * reference, and gates the sleep clock of the others. Call after the
+ * CubeMX initialization, before any driver uses the manager.
+ */
+void ClockGateInit(void);
+
+/**
+ * @brief Takes a reference on a clock, enabling it if it was off.
+ *
+ * @param id Clock.
+ * @param in_sleep 1 to keep the clock running in sleep mode as well.
+ * @return kOk, kInvalidArgument for an unknown clock, kFull when the
+ *     reference count is saturated.
+ */
+ReturnCode ClockGateAcquire(ClockGateId id, uint8_t in_sleep);
+
+/**
+ * @brief Gives back a reference taken with ClockGateAcquire(), disabling
+ * the clock when it was the last one.
+ *
+ * @param in_sleep As given to ClockGateAcquire().
+ * @return kOk, or kInvalidArgument if no such reference is held.
+ */
+ReturnCode ClockGateRelease(ClockGateId id, uint8_t in_sleep);
+
+/**
+ * @brief Restarts the residency statistics.
+ */
+void ClockGateResetStats(void);
+
+/**
+ * @brief Prints the references, the sleep gating and the time each clock
+ * has been on since the statistics were started.
+ *
+ * @param console Destination session.
+ */
+void ClockGateReport(Console* console);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CLOCK_GATE_H_
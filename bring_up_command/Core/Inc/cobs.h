@@ -0,0 +1,54 @@
+/**
+ * @file cobs.h
+ * @brief Consistent Overhead Byte Stuffing for framed binary links.
+ *
+ * COBS removes every 0x00 from a block at a cost of one byte per 254, so a
+ * single 0x00 can delimit frames and the receiver resynchronizes on the
+ * next delimiter after any corruption.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_COBS_H_
+#define SRC_COBS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Worst-case encoded size of a block of @p len bytes (no delimiter).
+ */
+#define COBS_MAX_ENCODED(len) ((len) + ((len) / 254u) + 1u)
+
+/**
+ * @brief Encodes a block.
+ *
+ * @param src Data to encode.
+ * @param len Number of bytes in @p src.
+ * @param dst Output buffer, at least COBS_MAX_ENCODED(len) bytes. Must not
+ *     overlap @p src.
+ * @return Number of encoded bytes written (no trailing delimiter).
+ */
+uint16_t CobsEncode(const uint8_t* src, uint16_t len, uint8_t* dst);
+
+/**
+ * @brief Decodes a block in place.
+ *
+ * @param buf Encoded block without the trailing delimiter; overwritten with
+ *     the decoded data.
+ * @param len Number of encoded bytes.
+ * @param out_len Pointer to store the decoded length.
+ * @return 0 on success, -1 if the block is malformed.
+ */
+int CobsDecode(uint8_t* buf, uint16_t len, uint16_t* out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_COBS_H_
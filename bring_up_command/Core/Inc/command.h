@@ -3,7 +3,33 @@
  * @brief Interface for the command parser module.
  *
  * This module defines the command structure and parser function
- * used to interpret console commands via UART on the Nucleo L073 board.
+ * used to interpret console commands on the Nucleo L073 board. Commands
+ * receive the console session that issued them and write their output
+ * back to it, so they are independent of the transport in use.
+ *
+ * Commands with typed arguments (command_args.h) can also be called in
+ * binary form on the mux data channel, with the same decoder and checks:
+ *
+ *   host to device:  COMMAND_MSG_CALL  | seq | name | 0 | arguments
+ *   device to host:  COMMAND_MSG_REPLY | seq | ReturnCode | result_le32
+ *
+ * The arguments are packed as listed in command_args.h. The reply comes
+ * once the command has run: kOk with @c console->result, or
+ * kInvalidArgument for an unknown command or bad arguments, with the
+ * index of the offending argument as the result. Text output goes to the
+ * mux console channel. A call that repeats the sequence number of the
+ * previous one is not run again, only answered again, so the host can
+ * simply resend a call whose reply it did not get (tools/cmdcall.py).
+ *
+ * Any command, typed or not, can be run the same way as a command line:
+ *
+ *   host to device:  COMMAND_MSG_LINE  | seq | line | 0
+ *
+ * answered with the same REPLY once it has run: the ReturnCode of
+ * CommandParserProcess() and @c console->result. Its output comes first
+ * on the mux console channel, without the echo of the line, so the reply
+ * marks where it ends (tools/console_broker.py). Lines and calls share
+ * the sequence numbers.
  *
  * @date Sep 30, 2025
  * @author
@@ -18,11 +44,28 @@ extern "C" {
 #endif
 
 #include "stdint.h"
+#include "console.h"
+
+/**
+ * @brief Maximum number of words in a command line (name included).
+ */
+#define COMMAND_MAX_ARGS 8
+
+#define COMMAND_MSG_CALL  0x40
+#define COMMAND_MSG_REPLY 0x41
+#define COMMAND_MSG_LINE  0x42
 
 /**
  * @brief Function pointer type for command execution callbacks.
+ *
+ * Commands that read something back also store it in @c console->result
+ * (cleared before every command), so scripts can act on it.
+ *
+ * @param console Session that issued the command (destination of output).
+ * @param argc Number of words in the command line, name included.
+ * @param argv Words of the command line; argv[0] is the command name.
  */
-typedef void (*ExecuteCommand)();
+typedef void (*ExecuteCommand)(Console* console, int argc, char* argv[]);
 
 /**
  * @struct Command
@@ -40,12 +83,23 @@ typedef struct {
 /**
  * @brief Parses and executes a command string.
  *
- * This function compares the given string against all registered
- * commands and, if a match is found, executes the associated action.
+ * The string is split into space-separated words; the first one is
+ * compared against all registered commands and, if a match is found, the
+ * associated action is executed with the words as arguments.
  *
+ * @param console Session that issued the command.
  * @param command_string Null-terminated string containing the command.
+ * @return kOk if a command was executed, kEmpty for a blank line,
+ *     kInvalidArgument if the command is unknown or the line has too many
+ *     words.
+ */
+ReturnCode CommandParserProcess(Console* console, const uint8_t* command_string);
+
+/**
+ * @brief Attaches binary command calls to the mux data channel. Messages
+ * of other protocols go on to the handler registered before.
  */
-void CommandParserProcess(const uint8_t* command_string);
+void CommandBinaryInit(void);
 
 #ifdef __cplusplus
 }
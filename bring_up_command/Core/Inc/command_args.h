@@ -0,0 +1,235 @@
+/**
+ * @file command_args.h
+ * @brief Typed command arguments with generated decoders.
+ *
+ * A typed command declares its arguments once, as an X-macro list:
+ *
+ *   #define PEEK_ARGS(ARG, T)                                   \
+ *     ARG(T, REQ, addr,  U32,  0, UINT32_MAX, NULL)             \
+ *     ARG(T, REQ, count, U16,  1, 16,         NULL)             \
+ *     ARG(T, OPT, width, Enum, 0, 0,          kWidthNames)
+ *
+ * (presence, name, type, minimum, maximum, NULL-terminated names for
+ * Enum). From that list the macros below generate, at compile time, the
+ * argument struct the handler receives (`PeekArgs`), the table the
+ * decoder walks, and the usage string ("peek <addr> <count> [width]").
+ * The handler only ever sees decoded, range-checked values.
+ *
+ * The text and binary protocols share CommandArgsDecode(); only the way a
+ * single value is read differs:
+ *
+ *   type   text                       binary
+ *   U8     number (strtoul, base 0)   1 byte
+ *   U16    number                     2 bytes, little endian
+ *   U32    number                     4 bytes, little endian
+ *   I32    signed number              4 bytes, little endian
+ *   I64    signed number              8 bytes, little endian
+ *   Enum   one of the names           1 byte, index into the names
+ *   Str    the word                   bytes up to a 0 byte
+ *   Line   the rest of the line       bytes up to a 0 byte
+ *
+ * Optional arguments may only be followed by optional arguments. Those
+ * not given are 0 (NULL for Str and Line); @c argc in the struct tells
+ * how many were given. Enum ignores minimum and maximum, Str and Line
+ * ignore all three. Line comes last; its words must be consecutive words
+ * of one tokenized line, whose separators it puts back.
+ *
+ * A KEY argument is an optional Enum that is only taken when the word is
+ * one of its names: it then holds 1 + the index, otherwise 0 and the
+ * word goes on to the next argument. That lets a keyword stand where a
+ * value could also go (`watch stop` next to `watch <ms> <command>`). In
+ * a binary call it is one byte, 0 when absent.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_COMMAND_ARGS_H_
+#define SRC_COMMAND_ARGS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Argument types: name, C type, size on the binary protocol
+ * (0: NUL-terminated), label printed by the usage help.
+ */
+#define COMMAND_ARG_TYPES(X)            \
+  X(U8,   uint8_t,     1, "u8")         \
+  X(U16,  uint16_t,    2, "u16")        \
+  X(U32,  uint32_t,    4, "u32")        \
+  X(I32,  int32_t,     4, "i32")        \
+  X(I64,  int64_t,     8, "i64")        \
+  X(Enum, uint8_t,     1, "enum")       \
+  X(Str,  const char*, 0, "str")        \
+  X(Line, const char*, 0, "text")
+
+#define COMMAND_ARG_TYPE_ENUM(kind, ctype, size, label) kCommandArg##kind,
+typedef enum {
+  COMMAND_ARG_TYPES(COMMAND_ARG_TYPE_ENUM)
+  kCommandArgTypes
+} CommandArgType;
+#undef COMMAND_ARG_TYPE_ENUM
+
+#define COMMAND_ARG_TYPEDEF(kind, ctype, size, label) typedef ctype CommandArg##kind;
+COMMAND_ARG_TYPES(COMMAND_ARG_TYPEDEF)
+#undef COMMAND_ARG_TYPEDEF
+
+/**
+ * @struct CommandArgSpec
+ * @brief One argument as the decoder sees it.
+ */
+typedef struct {
+  const char* name;
+  uint8_t type;               ///< CommandArgType
+  uint8_t optional;           ///< COMMAND_OPTIONAL_*
+  uint16_t offset;            ///< Of the value in the argument struct
+  int64_t min;
+  int64_t max;
+  const char* const* names;   ///< Enum values, NULL-terminated
+} CommandArgSpec;
+
+/**
+ * @brief Handler of a typed command, with its generated argument struct.
+ */
+typedef void (*CommandTypedFn)(Console* console, const void* args);
+
+/**
+ * @struct CommandTyped
+ * @brief A typed command: what the generator produces for each one.
+ */
+typedef struct {
+  const char* name;
+  const char* usage;          ///< "name <a> <b> [c]"
+  const CommandArgSpec* args;
+  uint8_t num_args;
+  uint8_t args_size;          ///< sizeof of the argument struct
+  CommandTypedFn run;
+} CommandTyped;
+
+/**
+ * @brief Largest argument struct of a typed command.
+ */
+#define COMMAND_ARGS_MAX_SIZE 32
+
+/**
+ * @struct CommandArgSource
+ * @brief Where the values come from: the words of a command line, or the
+ * argument bytes of a binary call.
+ */
+typedef struct {
+  char** argv;                ///< Text: words after the command name
+  int argc;
+  const uint8_t* data;        ///< Binary
+  uint16_t len;
+} CommandArgSource;
+
+// -----------------------------------------------------------------------------
+// Generators
+// -----------------------------------------------------------------------------
+#define COMMAND_OPTIONAL_REQ 0
+#define COMMAND_OPTIONAL_OPT 1
+#define COMMAND_OPTIONAL_KEY 2
+#define COMMAND_USAGE_REQ(name) " <" #name ">"
+#define COMMAND_USAGE_OPT(name) " [" #name "]"
+#define COMMAND_USAGE_KEY(name) " [" #name "]"
+
+#define COMMAND_ARG_FIELD(T, req, name, kind, min, max, names) CommandArg##kind name;
+#define COMMAND_ARG_SPEC(T, req, name, kind, min, max, names) \
+  {#name, kCommandArg##kind, COMMAND_OPTIONAL_##req, (uint16_t)offsetof(T, name), (min), (max), (names)},
+#define COMMAND_ARG_USAGE(T, req, name, kind, min, max, names) COMMAND_USAGE_##req(name)
+
+/**
+ * @brief Usage string of a command, as a string literal.
+ */
+#define COMMAND_USAGE(name, ARGS) name ARGS(COMMAND_ARG_USAGE, void)
+
+/**
+ * @brief Declares the argument struct `Name##Args` and the handler
+ * `static void Cmd##Name(Console*, const Name##Args*)`.
+ */
+#define COMMAND_TYPED_DECLARE(Name, name, ARGS, help)                  \
+  typedef struct {                                                      \
+    uint8_t argc;                                                       \
+    ARGS(COMMAND_ARG_FIELD, void)                                       \
+  } Name##Args;                                                         \
+  static void Cmd##Name(Console* console, const Name##Args* args);
+
+/**
+ * @brief Defines the spec table `k##Name##Args`, the CommandTyped
+ * `k##Name##Typed` and the text entry point `Cmd##Name##Text`, an
+ * ExecuteCommand for the command table. Every typed command takes at
+ * least one argument.
+ */
+#define COMMAND_TYPED_DEFINE(Name, name, ARGS, help)                                  \
+  static const CommandArgSpec k##Name##Args[] = {ARGS(COMMAND_ARG_SPEC, Name##Args)}; \
+  static void Cmd##Name##Run(Console* console, const void* args) {                     \
+    Cmd##Name(console, (const Name##Args*)args);                                       \
+  }                                                                                    \
+  static const CommandTyped k##Name##Typed = {                                         \
+      name, COMMAND_USAGE(name, ARGS), k##Name##Args,                                  \
+      (uint8_t)(sizeof(k##Name##Args) / sizeof(k##Name##Args[0])),                    \
+      (uint8_t)sizeof(Name##Args), Cmd##Name##Run};                                    \
+  _Static_assert(sizeof(Name##Args) <= COMMAND_ARGS_MAX_SIZE, name ": arguments too large"); \
+  static void Cmd##Name##Text(Console* console, int argc, char* argv[]) {              \
+    CommandTypedRunText(console, &k##Name##Typed, argc, argv);                         \
+  }
+
+/**
+ * @brief Command table entry of a typed command.
+ */
+#define COMMAND_TYPED_ENTRY(Name, name, ARGS, help) \
+  {name, Cmd##Name##Text, COMMAND_USAGE(name, ARGS) ": " help},
+
+/**
+ * @brief Pointer to the CommandTyped of a command, for lookup tables.
+ */
+#define COMMAND_TYPED_REF(Name, name, ARGS, help) &k##Name##Typed,
+
+// -----------------------------------------------------------------------------
+// Decoder
+// -----------------------------------------------------------------------------
+/**
+ * @brief Decodes and checks the arguments of a typed command.
+ *
+ * @param command Command.
+ * @param source Text words or binary bytes (exactly one of them).
+ * @param args Argument struct, command->args_size bytes; cleared first.
+ * @param bad Set to the index of the offending argument, or to
+ *     command->num_args for missing or surplus input.
+ * @return kOk, or kInvalidArgument.
+ */
+ReturnCode CommandArgsDecode(const CommandTyped* command, const CommandArgSource* source,
+                             void* args, uint8_t* bad);
+
+/**
+ * @brief Decodes a command line and runs the handler, or prints the usage
+ * and the accepted values of the argument in error.
+ *
+ * @param console Session.
+ * @param command Command.
+ * @param argc Words, name included.
+ * @param argv Words; argv[0] is the command name.
+ */
+void CommandTypedRunText(Console* console, const CommandTyped* command, int argc, char* argv[]);
+
+/**
+ * @brief Prints the usage line, for a handler given arguments that decode
+ * but do not go together (a value its operation does not take).
+ *
+ * @param console Session.
+ * @param command Command.
+ */
+void CommandTypedUsage(Console* console, const CommandTyped* command);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_COMMAND_ARGS_H_
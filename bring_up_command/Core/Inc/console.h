@@ -0,0 +1,144 @@
+/**
+ * @file console.h
+ * @brief Transport-independent console session.
+ *
+ * A console session owns the receive ring buffer, the line discipline and
+ * the output path of one interactive console. Lines are assembled in place
+ * in a record queue (record_queue.h) and executed from there once
+ * complete, so a partial line is never seen by the parser. Transports (UART, ...) feed
+ * received bytes into a session and provide the function used to send
+ * output, so several consoles can run side by side without sharing state.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_CONSOLE_H_
+#define SRC_CONSOLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "record_queue.h"
+#include "ring_buffer.h"
+
+/**
+ * @brief Longest command line accepted by a session (including terminator).
+ */
+#define CONSOLE_LINE_SIZE 64
+
+/**
+ * @brief Line queue storage: a line is executed before the next one is
+ * started, so one line plus the reservation for the next is enough.
+ */
+#define CONSOLE_LINE_QUEUE_SIZE RECORD_QUEUE_STORAGE(0, CONSOLE_LINE_SIZE)
+
+typedef struct Console Console;
+
+/**
+ * @brief Transport callback used to send console output.
+ *
+ * @param console Session producing the output.
+ * @param data Bytes to send.
+ * @param len Number of bytes to send.
+ */
+typedef void (*ConsoleWriteFn)(Console* console, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Optional transport callback reporting how many bytes can be
+ * written without blocking.
+ *
+ * @param console Session to query.
+ * @return Number of bytes ConsoleWrite() accepts without waiting.
+ */
+typedef uint16_t (*ConsoleWritableFn)(const Console* console);
+
+/**
+ * @struct Console
+ * @brief State of one console session.
+ */
+struct Console {
+  const char* name;                 ///< Short session name (e.g. "usart2")
+  ConsoleWriteFn write;             ///< Transport output function
+  ConsoleWritableFn writable;       ///< Transport free-space query (optional)
+  void* transport;                  ///< Transport private data
+  RingBuffer rx;                    ///< Bytes received, not yet processed
+  RecordQueue lines;                ///< Complete lines waiting to be executed
+  uint8_t line_storage[CONSOLE_LINE_QUEUE_SIZE];
+  uint8_t* line;                    ///< Line being assembled (reserved record), or NULL
+  uint16_t line_len;                ///< Characters currently in @c line
+  uint8_t line_overflow;            ///< Set when the current line was too long
+  volatile uint8_t detached;        ///< Input is consumed by another layer (e.g. mux)
+  int32_t result;                   ///< Value reported by the last command (0 if none)
+  uint32_t tx_bytes;                ///< Bytes written so far (wraps)
+};
+
+/**
+ * @brief Initializes a console session.
+ *
+ * @param console Session to initialize.
+ * @param name Short session name.
+ * @param write Transport output function.
+ * @param transport Transport private data, available as console->transport.
+ */
+void ConsoleInit(Console* console, const char* name, ConsoleWriteFn write,
+                 void* transport);
+
+/**
+ * @brief Queues received bytes for processing (producer side, ISR safe).
+ *
+ * Bytes that do not fit in the receive buffer are dropped.
+ *
+ * @param console Destination session.
+ * @param data Received bytes.
+ * @param len Number of received bytes.
+ */
+void ConsoleReceive(Console* console, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Runs the line discipline on pending input, queues complete lines
+ * and executes them (consumer side, main loop).
+ *
+ * Lines are terminated by CR or LF; backspace/DEL remove the last character
+ * and bytes with bit 7 set are ignored.
+ * Does nothing while the session is detached: the raw input is then left in
+ * @c rx for the layer that took over the link.
+ *
+ * @param console Session to service.
+ */
+void ConsoleProcess(Console* console);
+
+/**
+ * @brief Returns how many bytes can be written without blocking.
+ *
+ * @param console Session to query.
+ * @return Free transport space, or UINT16_MAX if the transport does not
+ *     report it.
+ */
+uint16_t ConsoleWritable(const Console* console);
+
+/**
+ * @brief Sends raw bytes through the session transport.
+ *
+ * @param console Destination session.
+ * @param data Bytes to send.
+ * @param len Number of bytes to send.
+ */
+void ConsoleWrite(Console* console, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Sends a null-terminated string through the session transport.
+ *
+ * @param console Destination session.
+ * @param str String to send.
+ */
+void ConsolePrint(Console* console, const char* str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CONSOLE_H_
@@ -0,0 +1,40 @@
+/**
+ * @file crc.h
+ * @brief Checksum helpers shared by the console protocols.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_CRC_H_
+#define SRC_CRC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Initial value for Crc16Ccitt().
+ */
+#define CRC16_CCITT_INIT 0xFFFFu
+
+/**
+ * @brief Computes CRC-16/CCITT-FALSE (poly 0x1021) over a block.
+ *
+ * Can be chained by passing the previous result as @p crc.
+ *
+ * @param crc Running CRC (CRC16_CCITT_INIT for a new computation).
+ * @param data Data block.
+ * @param len Number of bytes in the block.
+ * @return Updated CRC.
+ */
+uint16_t Crc16Ccitt(uint16_t crc, const uint8_t* data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CRC_H_
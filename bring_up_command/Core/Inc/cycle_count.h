@@ -0,0 +1,67 @@
+/**
+ * @file cycle_count.h
+ * @brief Core clock cycle and microsecond timing from SysTick.
+ *
+ * The Cortex-M0+ has no DWT cycle counter, so short intervals are timed
+ * with SysTick, which the HAL runs at the core clock with a 1 ms period:
+ *
+ *   uint32_t start = CycleCountStart();
+ *   ...                                    // Less than 1 ms
+ *   uint32_t cycles = CycleCountElapsed(start);
+ *
+ * SysTick counts down and wraps every millisecond, so an interval is
+ * exact only while it is shorter than one period. Run it with interrupts
+ * masked to keep the HAL tick handler out of the count.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_CYCLE_COUNT_H_
+#define SRC_CYCLE_COUNT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "main.h"
+
+/**
+ * @brief Start of an interval, for CycleCountElapsed().
+ */
+static inline uint32_t CycleCountStart(void) {
+  return SysTick->VAL;
+}
+
+/**
+ * @brief Core clock cycles since @p start (at most one SysTick wrap).
+ */
+static inline uint32_t CycleCountElapsed(uint32_t start) {
+  uint32_t load = SysTick->LOAD + 1U;
+  return (start + load - SysTick->VAL) % load;  // Down counter, may wrap once
+}
+
+/**
+ * @brief Microseconds since boot, from the HAL tick and the SysTick
+ * counter; wraps after about 71 minutes.
+ */
+static inline uint32_t CycleCountMicros(void) {
+  uint32_t ms;
+  uint32_t val;
+
+  do {
+    ms = HAL_GetTick();
+    val = SysTick->VAL;
+  } while (ms != HAL_GetTick());
+
+  uint32_t load = SysTick->LOAD + 1U;
+  return ms * 1000U + ((load - 1U - val) * 1000U) / load;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CYCLE_COUNT_H_
@@ -0,0 +1,108 @@
+/**
+ * @file dma_copy.h
+ * @brief Asynchronous memcpy/memset on DMA1 channel 1.
+ *
+ * Requests are queued and run one after the other in memory-to-memory
+ * mode, so the CPU keeps running while the data moves; each one ends
+ * with its callback, called from the DMA interrupt. The channel has the
+ * lowest DMA priority, so the UART channels still win arbitration, and
+ * it shares the bus with the CPU: a copy slows code that is busy with
+ * memory too.
+ *
+ * Transfers use words when the addresses and length allow it, else
+ * half-words or bytes, in segments of up to 65535 of them. A request
+ * below DMA_COPY_MIN_SIZE bytes made while the queue is empty is copied
+ * by the CPU (FastMemcpy/FastMemset) before the call returns, callback
+ * included: for those, programming the channel and taking the interrupt
+ * cost more than the copy. `dmabench` measures where the crossover sits.
+ *
+ * Requests complete in the order they were queued. A copy whose source
+ * and destination overlap is not supported.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_DMA_COPY_H_
+#define SRC_DMA_COPY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Requests waiting or running at once.
+ */
+#ifndef DMA_COPY_QUEUE_SIZE
+#define DMA_COPY_QUEUE_SIZE 4
+#endif
+
+/**
+ * @brief Shorter requests are copied by the CPU when the queue is empty.
+ */
+#ifndef DMA_COPY_MIN_SIZE
+#define DMA_COPY_MIN_SIZE 64
+#endif
+
+/**
+ * @brief Completion callback.
+ *
+ * @param context Value given with the request.
+ * @param rc kOk, or kError after a DMA transfer error (bad address).
+ */
+typedef void (*DmaCopyDoneFn)(void* context, ReturnCode rc);
+
+/**
+ * @brief Resets the channel and enables its interrupt. The DMA clock is
+ * only held (see clock_gate.h) while requests are queued.
+ */
+void DmaCopyInit(void);
+
+/**
+ * @brief Queues a copy of @p len bytes.
+ *
+ * @param done Completion callback, or NULL.
+ * @param context Passed to @p done.
+ * @return kOk, kFull if the queue is full, kInvalidArgument for an empty
+ *     request.
+ */
+ReturnCode DmaCopyMemcpy(void* dst, const void* src, size_t len, DmaCopyDoneFn done,
+                         void* context);
+
+/**
+ * @brief Queues a fill of @p len bytes with @p value.
+ *
+ * @return As DmaCopyMemcpy().
+ */
+ReturnCode DmaCopyMemset(void* dst, uint8_t value, size_t len, DmaCopyDoneFn done,
+                         void* context);
+
+/**
+ * @brief Returns 1 when no request is waiting or running.
+ */
+uint8_t DmaCopyIsIdle(void);
+
+/**
+ * @brief Compares CPU and DMA copies of growing sizes in the free module
+ * area and prints the cycle counts and the crossover sizes.
+ *
+ * @param console Destination session.
+ * @return kOk, or kFull if the area or the channel is in use.
+ */
+ReturnCode DmaCopyBenchmark(Console* console);
+
+/**
+ * @brief DMA1 channel 1 interrupt handler body.
+ */
+void DmaCopyIrq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_DMA_COPY_H_
@@ -0,0 +1,109 @@
+/**
+ * @file dump.h
+ * @brief Bulk output streams on the mux data channel, optionally
+ * compressed.
+ *
+ * A stream reads its source in small pieces from DumpProcess() and sends
+ * it on MUX_CH_DATA as fast as the channel queue drains, with the LZSS
+ * compressor of lz.h in between when DUMP_FLAG_LZ is set. Memory dumps
+ * (`dump <addr> <len> [lz]`) are one source; capture buffers and the like
+ * stream through DumpStartSource(). One stream runs at a time.
+ *
+ * Messages, device to host (first payload byte):
+ *
+ *   DUMP_MSG_BEGIN | flags | address_le32 | length_le32
+ *   DUMP_MSG_DATA  | stream bytes
+ *   DUMP_MSG_END   | ReturnCode | crc16_le | stream_length_le32
+ *
+ * The CRC-16/CCITT-FALSE is over the uncompressed data, so the host checks
+ * the decompressor and the link in one go (tools/dump.py).
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_DUMP_H_
+#define SRC_DUMP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define DUMP_MSG_BEGIN 0x20
+#define DUMP_MSG_DATA  0x21
+#define DUMP_MSG_END   0x22
+
+#define DUMP_FLAG_LZ   0x01  ///< Stream is LZSS compressed (lz.h)
+
+#define DUMP_ACCESS_WORDS 0x01  ///< Region needs word accesses
+#define DUMP_ACCESS_WRITE 0x02  ///< Region may be written directly (RAM, peripherals)
+
+/**
+ * @brief Reads source bytes for a stream.
+ *
+ * @param offset Offset of the first byte in the source.
+ * @param out Destination.
+ * @param len Number of bytes to read.
+ * @return kOk, or another code to end the stream with that code.
+ */
+typedef ReturnCode (*DumpReadFn)(uint32_t offset, uint8_t* out, uint16_t len);
+
+/**
+ * @brief Starts a memory dump.
+ *
+ * Flash, data EEPROM and RAM are read bytewise; peripheral registers need
+ * a word-aligned range and are read with word accesses.
+ *
+ * @param address First byte.
+ * @param length Number of bytes.
+ * @param flags DUMP_FLAG_...
+ * @return kOk, kError if the mux is not active, kFull if a stream is
+ *     running, kInvalidArgument for a range outside readable memory.
+ */
+ReturnCode DumpStart(uint32_t address, uint32_t length, uint8_t flags);
+
+/**
+ * @brief Checks that a range lies in one readable memory region, as
+ * DumpStart() does, so that other commands can access memory safely.
+ *
+ * @param address First byte.
+ * @param length Number of bytes.
+ * @param access Set to the DUMP_ACCESS_... flags of the region; may be
+ *     NULL.
+ * @return kOk, or kInvalidArgument for a range outside readable memory or
+ *     a word region range that is not word aligned.
+ */
+ReturnCode DumpCheckRange(uint32_t address, uint32_t length, uint8_t* access);
+
+/**
+ * @brief Starts a stream from any source.
+ *
+ * @param read Source reader.
+ * @param tag Value sent as the address in DUMP_MSG_BEGIN.
+ * @param length Number of bytes.
+ * @param flags DUMP_FLAG_...
+ * @return kOk, kError if the mux is not active, kFull if a stream is
+ *     running.
+ */
+ReturnCode DumpStartSource(DumpReadFn read, uint32_t tag, uint32_t length, uint8_t flags);
+
+/**
+ * @brief Returns 1 while a stream is being sent.
+ */
+uint8_t DumpIsActive(void);
+
+/**
+ * @brief Sends stream data as the channel queue allows. Call from the main
+ * loop.
+ */
+void DumpProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_DUMP_H_
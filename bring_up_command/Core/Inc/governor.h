@@ -0,0 +1,151 @@
+/**
+ * @file governor.h
+ * @brief Load-based system clock and core voltage scaling.
+ *
+ * The governor moves the system between three operating points:
+ *
+ *   msi4    MSI 4.194 MHz, voltage range 3, no flash wait state
+ *   hsi16   HSI16 16 MHz, voltage range 2, one wait state
+ *   pll32   PLL 32 MHz (HSI16 x4 / 2), voltage range 1, one wait state
+ *
+ * Every GOVERNOR_WINDOW_MS it takes the load, the share of the window
+ * spent running commands (from the loop monitor), and the console
+ * backlog (bytes waiting on the busiest UART port). A load of
+ * GOVERNOR_UP_PCT or more, or a backlog of GOVERNOR_BACKLOG_BYTES or
+ * more, goes straight to pll32. After GOVERNOR_HOLD_WINDOWS windows in a
+ * row with a load of GOVERNOR_DOWN_PCT or less and nothing waiting, it
+ * steps down one point. The gap between the two thresholds and the hold
+ * time form the hysteresis; `gov tune` changes them at run time.
+ *
+ * A switch waits for the UART ports to go quiet, with console output held
+ * back, for at most GOVERNOR_QUIET_MS. It raises the voltage before the
+ * clock goes up and lowers it after the clock has gone down. HAL SysTick
+ * is reloaded by HAL_RCC_ClockConfig(), the UART dividers are reprogrammed
+ * and the timesync prescaler reloaded. A point at which some port cannot
+ * keep its baud rate (see UartConsoleBaudReachable()), or the SPI console
+ * its SCK (see SpiConsoleClockReachable()), is skipped. The
+ * UART kernel clocks are expected on PCLK or SYSCLK, as CubeMX sets them:
+ * HSI16 is stopped at msi4.
+ *
+ * GovernorBoost() holds pll32 for a while, for work that needs the full
+ * clock or a clock that does not change under it (benchmarks, selftest,
+ * link test). It also applies in fixed mode.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_GOVERNOR_H_
+#define SRC_GOVERNOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief 1 to start in automatic mode, 0 to stay at pll32 until `gov auto`.
+ */
+#ifndef GOVERNOR_AUTO
+#define GOVERNOR_AUTO 1
+#endif
+
+#ifndef GOVERNOR_WINDOW_MS
+#define GOVERNOR_WINDOW_MS      100
+#endif
+#ifndef GOVERNOR_UP_PCT
+#define GOVERNOR_UP_PCT         50
+#endif
+#ifndef GOVERNOR_DOWN_PCT
+#define GOVERNOR_DOWN_PCT       10
+#endif
+#ifndef GOVERNOR_HOLD_WINDOWS
+#define GOVERNOR_HOLD_WINDOWS   20
+#endif
+#ifndef GOVERNOR_BACKLOG_BYTES
+#define GOVERNOR_BACKLOG_BYTES  32
+#endif
+#ifndef GOVERNOR_QUIET_MS
+#define GOVERNOR_QUIET_MS       50
+#endif
+
+/**
+ * @brief Boost length for callers that renew it while they run.
+ */
+#define GOVERNOR_BOOST_MS 500
+
+/**
+ * @enum GovernorPoint
+ * @brief Operating points, slowest first.
+ */
+typedef enum {
+  kGovernorMsi4 = 0,
+  kGovernorHsi16,
+  kGovernorPll32,
+  kGovernorPoints
+} GovernorPoint;
+
+/**
+ * @brief Starts the governor at the clock SystemClock_Config() set up
+ * (pll32). Call after TimesyncInit() and UartConsoleInit().
+ */
+void GovernorInit(void);
+
+/**
+ * @brief Evaluates the load once per window and switches when needed.
+ * Call from the main loop.
+ */
+void GovernorProcess(void);
+
+/**
+ * @brief Runs at pll32 for at least @p ms from now, switching right away
+ * if needed.
+ *
+ * @return kOk if the system runs at pll32 on return, kFull if the switch
+ *     could not be made yet (the governor keeps trying).
+ */
+ReturnCode GovernorBoost(uint32_t ms);
+
+/**
+ * @brief Selects automatic mode.
+ */
+void GovernorSetAuto(void);
+
+/**
+ * @brief Leaves automatic mode and moves to a fixed point.
+ *
+ * @param name Point name ("msi4", "hsi16", "pll32").
+ * @return kOk, kInvalidArgument for an unknown name or one where a port
+ *     baud rate or the SPI console SCK cannot be kept, kFull if the ports did not go quiet
+ *     (the point is selected anyway and reached later), kError if the
+ *     clock did not start.
+ */
+ReturnCode GovernorSetFixed(const char* name);
+
+/**
+ * @brief Sets the hysteresis.
+ *
+ * @param up_pct Load that switches to pll32.
+ * @param down_pct Load at or below which a window counts as idle.
+ * @param hold_windows Idle windows before stepping down.
+ * @return kOk, or kInvalidArgument unless down_pct < up_pct <= 100 and
+ *     hold_windows > 0.
+ */
+ReturnCode GovernorTune(uint32_t up_pct, uint32_t down_pct, uint32_t hold_windows);
+
+/**
+ * @brief Prints the point, the mode, the last load and backlog, the
+ * tuning and the time spent at each point.
+ *
+ * @param console Destination session.
+ */
+void GovernorReport(Console* console);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_GOVERNOR_H_
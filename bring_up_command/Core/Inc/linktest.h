@@ -0,0 +1,97 @@
+/**
+ * @file linktest.h
+ * @brief PRBS bit error rate and throughput test of a UART link.
+ *
+ * `linktest <port> <baud> <7|15|31> <ms> [host|loop|ext]` borrows a console
+ * port, sets it to @c baud and for @c ms milliseconds both sends a PRBS
+ * pattern with circular TX DMA and checks the same pattern received with
+ * circular RX DMA:
+ *
+ * - host: the host sends and checks the pattern too (tools/linktest.py).
+ * - loop: internal loopback, the port runs in half-duplex mode so its
+ *         receiver hears its own transmitter (no wiring).
+ * - ext:  external loopback, TX jumpered to RX (or through the cable,
+ *         level shifters, etc. under test).
+ *
+ * Patterns are PRBS-7 (x^7 + x^6 + 1), PRBS-15 (x^15 + x^14 + 1) and
+ * PRBS-31 (x^31 + x^28 + 1), generated 8 bits at a time with each byte
+ * carrying the sequence MSB first. The checker synchronizes on the
+ * received data (LINKTEST_LOCK_BYTES must match the prediction), then
+ * compares against a free-running reference, so a single bit error counts
+ * once; more than LINKTEST_UNLOCK_ERRORS bit errors in 8 bytes (a slip or
+ * lost bytes) makes it resynchronize. Errors closer than
+ * LINKTEST_BURST_GAP bytes belong to the same burst.
+ *
+ * The port goes back to its console settings at the end and the report is
+ * printed on the session that started the test; `linktest` alone prints
+ * the last report again (for a host that was still at the test baud).
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_LINKTEST_H_
+#define SRC_LINKTEST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define LINKTEST_DMA_SIZE        256  ///< Each of the TX and RX circular buffers
+#define LINKTEST_LOCK_BYTES      4    ///< Correct predictions needed to lock
+#define LINKTEST_UNLOCK_ERRORS   16   ///< Bit errors in 8 bytes that drop the lock
+#define LINKTEST_BURST_GAP       16   ///< Bytes without errors that end a burst
+#define LINKTEST_ACQUIRE_MS      1000 ///< Wait for the port's console output to drain
+
+/**
+ * @brief Loopback arrangement of a test.
+ */
+typedef enum {
+  kLinktestHost = 0,   ///< Host sends and checks its own pattern
+  kLinktestLoop,       ///< Internal half-duplex loopback
+  kLinktestExternal,   ///< TX wired back to RX
+} LinktestMode;
+
+/**
+ * @brief Starts a test; the report follows when it ends.
+ *
+ * @param console Session receiving the report.
+ * @param port Console port to test ("usart2", "usart1", "lpuart1").
+ * @param baud Test baud rate.
+ * @param order PRBS order: 7, 15 or 31.
+ * @param duration_ms Test length.
+ * @param mode Loopback arrangement.
+ * @return kOk, kFull if a test is running, kInvalidArgument for a bad
+ *     order or duration.
+ */
+ReturnCode LinktestStart(Console* console, const char* port, uint32_t baud, uint8_t order,
+                         uint32_t duration_ms, LinktestMode mode);
+
+/**
+ * @brief Ends the running test early (the report follows).
+ *
+ * @return kOk, or kEmpty if no test is running.
+ */
+ReturnCode LinktestStop(void);
+
+/**
+ * @brief Prints the report of the last test.
+ *
+ * @param console Destination session.
+ */
+void LinktestReport(Console* console);
+
+/**
+ * @brief Starts and ends tests. Call from the main loop.
+ */
+void LinktestProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_LINKTEST_H_
@@ -0,0 +1,112 @@
+/**
+ * @file loop_monitor.h
+ * @brief Main loop latency histogram, stall capture and watchdog.
+ *
+ * LoopMonitorTick() runs once per main loop pass. It files the time since
+ * the previous pass into a log2 histogram (microseconds, from the
+ * timesync timebase) and refreshes the independent watchdog, so the IWDG
+ * only bites when the loop stops coming round: a command blocked on
+ * HAL_MAX_DELAY, an interrupt storm, a fault loop.
+ *
+ * Commands are bracketed by LoopMonitorEnter()/LoopMonitorLeave(). One
+ * that runs for the stall threshold or longer is recorded by name with its
+ * count, worst and total time; a slow pass with no slow command in it is
+ * charged to "(main loop)". The table keeps the LOOP_MONITOR_OFFENDERS
+ * worst names.
+ *
+ * The name of the running command is also kept in RAM that the startup
+ * code does not clear (section .noinit). After a watchdog reset it is
+ * recorded as an offender with the watchdog timeout as its time, and
+ * reported by `stall`.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_LOOP_MONITOR_H_
+#define SRC_LOOP_MONITOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Default stall threshold (see LoopMonitorSetThreshold()).
+ */
+#ifndef LOOP_MONITOR_STALL_MS
+#define LOOP_MONITOR_STALL_MS 100
+#endif
+
+/**
+ * @brief Watchdog timeout; 0 leaves the IWDG off. Up to about 7000 ms.
+ * Once started the IWDG cannot be stopped until the next reset.
+ */
+#ifndef LOOP_MONITOR_WDG_MS
+#define LOOP_MONITOR_WDG_MS 2000
+#endif
+
+#define LOOP_MONITOR_OFFENDERS  6
+#define LOOP_MONITOR_BUCKETS    14  ///< <16 us, then one per power of two
+
+/**
+ * @brief Checks the reset cause and starts the watchdog. Call last in the
+ * initialization, just before the main loop.
+ */
+void LoopMonitorInit(void);
+
+/**
+ * @brief Records one main loop pass and refreshes the watchdog. Call at
+ * the top of the main loop.
+ */
+void LoopMonitorTick(void);
+
+/**
+ * @brief Marks the start of a command.
+ *
+ * @param name Command name (copied).
+ */
+void LoopMonitorEnter(const char* name);
+
+/**
+ * @brief Marks the end of the command started with LoopMonitorEnter().
+ *
+ * @return Time the command took, in microseconds.
+ */
+uint32_t LoopMonitorLeave(void);
+
+/**
+ * @brief Total time spent in commands, in microseconds. Wraps; callers
+ * take differences.
+ */
+uint32_t LoopMonitorBusyMicros(void);
+
+/**
+ * @brief Sets the stall threshold.
+ *
+ * @param ms Threshold in milliseconds.
+ * @return kOk, or kInvalidArgument for 0.
+ */
+ReturnCode LoopMonitorSetThreshold(uint32_t ms);
+
+/**
+ * @brief Clears the histogram and the offender table.
+ */
+void LoopMonitorReset(void);
+
+/**
+ * @brief Prints the histogram, the offenders (worst first) and the last
+ * watchdog reset.
+ *
+ * @param console Destination session.
+ */
+void LoopMonitorReport(Console* console);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_LOOP_MONITOR_H_
@@ -0,0 +1,100 @@
+/**
+ * @file lz.h
+ * @brief Streaming LZSS compressor with a fixed, small RAM footprint.
+ *
+ * The compressor keeps the last LZ_WINDOW bytes of input as the
+ * dictionary and up to LZ_MAX_MATCH bytes of lookahead in one ring of
+ * LZ_RING_SIZE bytes; nothing else is allocated, so an LzEncoder is a
+ * little over 512 bytes whatever the stream length. Output goes to a sink
+ * callback in groups as they complete.
+ *
+ * Stream format: a flag byte announces the next eight items, LSB first;
+ * a 1 bit is one literal byte, a 0 bit a two-byte match:
+ *
+ *   distance - 1 (1..LZ_WINDOW) | length - LZ_MIN_MATCH (LZ_MIN_MATCH..LZ_MAX_MATCH)
+ *
+ * copying @c length bytes starting @c distance bytes back in the output
+ * (the copy may overlap what it produces, which turns runs into one
+ * match). The last group may announce fewer items than its flag bits;
+ * the decoder stops at the end of the stream.
+ *
+ * Zero-filled and repeated areas shrink to about 2 bytes per LZ_MAX_MATCH
+ * input bytes; incompressible data grows by 1/8.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_LZ_H_
+#define SRC_LZ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define LZ_WINDOW     256
+#define LZ_MIN_MATCH  3
+#define LZ_MAX_MATCH  256
+#define LZ_RING_SIZE  512  ///< Power of two, at least LZ_WINDOW + LZ_MAX_MATCH
+
+/**
+ * @brief Receives compressed bytes.
+ *
+ * @param context Value given to LzInit().
+ * @param data Compressed bytes.
+ * @param len Number of bytes (up to 17).
+ */
+typedef void (*LzSink)(void* context, const uint8_t* data, uint16_t len);
+
+/**
+ * @struct LzEncoder
+ * @brief Compressor state.
+ */
+typedef struct {
+  uint8_t ring[LZ_RING_SIZE];  ///< Window followed by lookahead
+  uint32_t pos;                ///< Stream offset of the next byte to encode
+  uint32_t end;                ///< Stream offset of the next byte to store
+  uint8_t group[1 + 8 * 2];    ///< Flag byte and up to eight items
+  uint8_t group_len;
+  uint8_t items;
+  LzSink sink;
+  void* context;
+} LzEncoder;
+
+/**
+ * @brief Starts a new stream.
+ *
+ * @param lz Encoder state.
+ * @param sink Output callback.
+ * @param context Passed to @p sink.
+ */
+void LzInit(LzEncoder* lz, LzSink sink, void* context);
+
+/**
+ * @brief Compresses input; output is produced as lookahead fills up, at
+ * most one group (17 bytes) per input byte.
+ *
+ * @param lz Encoder state.
+ * @param data Input bytes.
+ * @param len Number of bytes.
+ */
+void LzWrite(LzEncoder* lz, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Encodes the remaining lookahead and flushes the last group. Emits
+ * at most one group per call, so a caller with a small output buffer can
+ * drain it in between.
+ *
+ * @param lz Encoder state.
+ * @return 1 once the stream is complete, 0 if it must be called again.
+ */
+uint8_t LzFinish(LzEncoder* lz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_LZ_H_
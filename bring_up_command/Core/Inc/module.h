@@ -0,0 +1,153 @@
+/**
+ * @file module.h
+ * @brief Loader for command modules executed from RAM.
+ *
+ * Modules (see module_api.h) are linked at address 0 by tools/modlink.py
+ * into an image that the loader places in the reserved .modules RAM area
+ * and relocates to its actual address:
+ *
+ *   | ModuleImageHeader | image[image_size] | relocs | imports |
+ *
+ * - relocs:  uint16 image offsets of 32-bit words that hold image-relative
+ *            addresses; the load address is added to each.
+ * - imports: {uint16 offset, uint16 export index} pairs; the address of
+ *            the MODULE_EXPORTS entry is added to the word at offset.
+ *
+ * After linking, @c bss_size bytes following the image are zeroed (they
+ * reuse the space of the tables) and the module commands are looked up
+ * after the built-in ones. Modules are stacked in the area: only the
+ * most recently loaded one can be unloaded.
+ *
+ * Images are uploaded over the mux data channel (MUX_CH_DATA), one
+ * message per frame:
+ *
+ *   host to device:  MODULE_MSG_BEGIN | size_le16
+ *                    MODULE_MSG_DATA  | offset_le16 | bytes
+ *                    MODULE_MSG_END   | crc16_le (CRC-16/CCITT-FALSE of the image file)
+ *   device to host:  MODULE_MSG_ACK   | message | ReturnCode | value_le16
+ *
+ * The ACK value is the next expected offset for BEGIN/DATA and the number
+ * of commands added for END.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_MODULE_H_
+#define SRC_MODULE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "module_api.h"
+
+/**
+ * @brief Size of the .modules RAM area (must match the linker script).
+ */
+#ifndef MODULE_AREA_SIZE
+#define MODULE_AREA_SIZE  4096
+#endif
+
+#define MODULE_MAX_LOADED 4
+#define MODULE_IMAGE_MAGIC 0x444F4D42UL  ///< "BMOD"
+
+/**
+ * @brief Upload messages on MUX_CH_DATA (first payload byte).
+ */
+#define MODULE_MSG_BEGIN  0x10
+#define MODULE_MSG_DATA   0x11
+#define MODULE_MSG_END    0x12
+#define MODULE_MSG_ACK    0x13
+
+/**
+ * @struct ModuleImageHeader
+ * @brief Header of a module image file.
+ */
+typedef struct {
+  uint32_t magic;         ///< MODULE_IMAGE_MAGIC
+  uint16_t api_version;   ///< MODULE_API_VERSION the module was built for
+  uint16_t image_size;    ///< Code and initialized data
+  uint16_t bss_size;      ///< Zero-initialized data after the image
+  uint16_t num_relocs;    ///< Entries in the relocation table
+  uint16_t num_imports;   ///< Entries in the import table
+  uint16_t descriptor;    ///< Image offset of the ModuleDescriptor
+} ModuleImageHeader;
+
+/**
+ * @brief Initializes the loader and attaches it to the mux data channel.
+ */
+void ModuleInit(void);
+
+/**
+ * @brief Looks up a command provided by a loaded module.
+ *
+ * @param name Command name.
+ * @return The command, or NULL if no loaded module provides it.
+ */
+const Command* ModuleFindCommand(const char* name);
+
+/**
+ * @brief Returns the number of loaded modules.
+ */
+uint8_t ModuleCount(void);
+
+/**
+ * @brief Returns the descriptor of a loaded module.
+ *
+ * @param index 0 for the first loaded module.
+ * @return The descriptor, or NULL if @p index is out of range.
+ */
+const ModuleDescriptor* ModuleAt(uint8_t index);
+
+/**
+ * @brief Unloads the most recently loaded module.
+ *
+ * @param name Expected module name, or NULL for whichever is last.
+ * @return kOk, kEmpty if nothing is loaded, kInvalidArgument if the last
+ *     module is not @p name.
+ */
+ReturnCode ModuleUnload(const char* name);
+
+/**
+ * @brief Returns how many bytes of the module area are in use.
+ */
+uint16_t ModuleAreaUsed(void);
+
+/**
+ * @brief Returns the unused part of the module area as scratch memory.
+ *
+ * The contents are only valid until the next upload. Use it within one
+ * command; across main loop passes, hold it with ModuleAreaClaim().
+ *
+ * @param size Receives the number of free bytes (a multiple of 8).
+ * @return Start of the free space, or NULL while an upload is in progress
+ *     or the space is claimed.
+ */
+uint8_t* ModuleAreaFree(uint16_t* size);
+
+/**
+ * @brief Takes the unused part of the module area until
+ * ModuleAreaRelease(): meanwhile ModuleAreaFree() returns NULL and module
+ * uploads are refused (kFull), so nothing else writes to it.
+ *
+ * Unloading a module is still allowed; it frees space below the claim.
+ *
+ * @param size Receives the number of bytes claimed (a multiple of 8).
+ * @return Start of the space, or NULL while an upload is in progress or
+ *     another user holds the claim.
+ */
+uint8_t* ModuleAreaClaim(uint16_t* size);
+
+/**
+ * @brief Ends the claim taken with ModuleAreaClaim().
+ */
+void ModuleAreaRelease(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_MODULE_H_
@@ -0,0 +1,111 @@
+/**
+ * @file module_api.h
+ * @brief Firmware interface available to loadable command modules.
+ *
+ * A module is a set of console commands built separately from the
+ * firmware and loaded into RAM at run time (see module.h). Its source
+ * includes this header, defines its commands with the usual Command
+ * structure and declares them with MODULE_DESCRIPTOR():
+ *
+ * @code
+ *   static void CmdHello(Console* console, int argc, char* argv[]) {
+ *     ConsolePrint(console, "Hello from a module\r\n");
+ *   }
+ *
+ *   static const Command kHelloCommands[] = {
+ *       {"hello", CmdHello, "Say hello."},
+ *   };
+ *
+ *   MODULE_DESCRIPTOR("hello", kHelloCommands, NULL);
+ * @endcode
+ *
+ * Modules may only call the firmware functions listed in MODULE_EXPORTS.
+ * Each export has a fixed index that is part of the module format: new
+ * entries are appended, existing ones are never renumbered or removed
+ * without bumping MODULE_API_VERSION. Peripheral registers are used
+ * directly, as in the firmware.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_MODULE_API_H_
+#define SRC_MODULE_API_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "command.h"
+
+#define MODULE_API_VERSION       1
+#define MODULE_DESCRIPTOR_MAGIC  0x4353444DUL  ///< "MDSC"
+
+/**
+ * @brief Firmware functions modules may import, as X(index, symbol).
+ *
+ * tools/modlink.py reads this list to resolve a module's imports, so keep
+ * one entry per line.
+ */
+#define MODULE_EXPORTS(X)           \
+  X(0, ConsolePrint)                \
+  X(1, ConsoleWrite)                \
+  X(2, CommandParserProcess)        \
+  X(3, HAL_GetTick)                 \
+  X(4, HAL_Delay)                   \
+  X(5, HAL_GPIO_ReadPin)            \
+  X(6, HAL_GPIO_WritePin)           \
+  X(7, HAL_GPIO_TogglePin)          \
+  X(8, snprintf)                    \
+  X(9, strtol)                      \
+  X(10, strtoul)                    \
+  X(11, strcmp)                     \
+  X(12, strncmp)                    \
+  X(13, strlen)                     \
+  X(14, memcpy)                     \
+  X(15, memmove)                    \
+  X(16, memset)                     \
+  X(17, memcmp)                     \
+  X(18, __aeabi_idiv)               \
+  X(19, __aeabi_uidiv)              \
+  X(20, __aeabi_idivmod)            \
+  X(21, __aeabi_uidivmod)           \
+  X(22, __aeabi_ldivmod)            \
+  X(23, __aeabi_uldivmod)           \
+  X(24, __aeabi_lmul)               \
+  X(25, __aeabi_llsl)               \
+  X(26, __aeabi_llsr)               \
+  X(27, __aeabi_lasr)
+
+/**
+ * @struct ModuleDescriptor
+ * @brief Describes the commands of a module (one per module).
+ */
+typedef struct {
+  uint32_t magic;             ///< MODULE_DESCRIPTOR_MAGIC
+  const char* name;           ///< Module name, unique among loaded modules
+  const Command* commands;    ///< Commands added to the console
+  uint16_t num_commands;      ///< Entries in @c commands
+  void (*init)(void);         ///< Called once after loading (optional)
+} ModuleDescriptor;
+
+/**
+ * @brief Declares the descriptor of a module. Use exactly once per module.
+ *
+ * @param name Module name (string literal).
+ * @param commands Array of Command.
+ * @param init Initialization function, or NULL.
+ */
+#define MODULE_DESCRIPTOR(name, commands, init)                            \
+  const ModuleDescriptor module_descriptor __attribute__((used)) = {       \
+      MODULE_DESCRIPTOR_MAGIC, (name), (commands),                         \
+      (uint16_t)(sizeof(commands) / sizeof((commands)[0])), (init)}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_MODULE_API_H_
@@ -0,0 +1,138 @@
+/**
+ * @file mux.h
+ * @brief Virtual channel multiplexer over a single console link.
+ *
+ * Once started with the `mux` command, the link carries COBS-encoded frames
+ * instead of text:
+ *
+ *   COBS( channel | payload[0..MUX_MAX_PAYLOAD] | crc16_le ) 0x00
+ *
+ * where crc16 is CRC-16/CCITT-FALSE over channel and payload. Each logical
+ * channel has its own TX queue, a priority and a bandwidth share (quantum).
+ * The scheduler is a deficit round robin visited in priority order: the
+ * highest-priority backlogged channel with credit goes next, and credit is
+ * refilled once every backlogged channel has spent its quantum. Command
+ * responses therefore wait at most for the frame already on the wire, while
+ * bulk channels still get their share when the console is busy.
+ *
+ * Channel MUX_CH_CONSOLE carries a full console session. Frames the host
+ * sends on other channels go to the receiver registered for the channel
+ * with MuxSetReceiver(), if any. A frame to
+ * MUX_CH_CONTROL with payload MUX_CTRL_EXIT returns the link to text mode.
+ * The host side is tools/vchan_demux.py, which exposes each channel as a PTY.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_MUX_H_
+#define SRC_MUX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Largest payload carried by one frame.
+ */
+#define MUX_MAX_PAYLOAD 64
+
+/**
+ * @brief Logical channel identifiers.
+ */
+#define MUX_CH_CONSOLE   0     ///< Commands and responses (console session)
+#define MUX_CH_LOG       1     ///< Log messages
+#define MUX_CH_TRACE     2     ///< Trace records
+#define MUX_CH_DATA      3     ///< Bulk data streams
+#define MUX_NUM_CHANNELS 4
+#define MUX_CH_CONTROL   0xFF  ///< Link control (host to device only)
+
+/**
+ * @brief Control channel commands.
+ */
+#define MUX_CTRL_EXIT    0x00  ///< Leave mux mode, back to the text console
+
+/**
+ * @brief Handler for frames the host sends on a channel.
+ *
+ * @param payload Frame payload.
+ * @param len Payload length.
+ */
+typedef void (*MuxReceiveFn)(const uint8_t* payload, uint16_t len);
+
+/**
+ * @brief Switches a console link to multiplexed mode.
+ *
+ * The link stays detached from its own line discipline until the host
+ * sends MUX_CTRL_EXIT. Input received before the first frame delimiter
+ * is discarded.
+ *
+ * @param link Console whose transport becomes the mux link.
+ * @return kOk on success, kError if a mux is already active.
+ */
+ReturnCode MuxStart(Console* link);
+
+/**
+ * @brief Leaves multiplexed mode and hands the link back to its console.
+ */
+void MuxStop(void);
+
+/**
+ * @brief Tells whether multiplexed mode is active.
+ *
+ * @return 1 if active, 0 otherwise.
+ */
+uint8_t MuxIsActive(void);
+
+/**
+ * @brief Returns the console session on MUX_CH_CONSOLE, for output that
+ * belongs to the host side of the mux (valid while the mux is active).
+ */
+Console* MuxGetConsole(void);
+
+/**
+ * @brief Decodes received frames, runs the channel console and schedules
+ * queued output. Call from the main loop.
+ */
+void MuxProcess(void);
+
+/**
+ * @brief Queues data on a channel without blocking.
+ *
+ * @param channel Channel identifier (< MUX_NUM_CHANNELS).
+ * @param data Bytes to queue.
+ * @param len Number of bytes.
+ * @return kOk if queued, kFull if the channel queue has no room for all of
+ *     it (nothing is queued), kError if the mux is not active,
+ *     kInvalidArgument for a bad channel.
+ */
+ReturnCode MuxWrite(uint8_t channel, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Registers the handler of host frames on a channel. Handlers run
+ * from MuxProcess() and stay registered across mux sessions.
+ *
+ * @param channel Channel identifier, other than MUX_CH_CONSOLE.
+ * @param receive Handler, or NULL to drop the channel input again.
+ * @return kOk, or kInvalidArgument for a bad channel.
+ */
+ReturnCode MuxSetReceiver(uint8_t channel, MuxReceiveFn receive);
+
+/**
+ * @brief Returns the handler registered on a channel, so that a protocol
+ * sharing the channel can pass on the messages it does not own.
+ *
+ * @param channel Channel identifier.
+ * @return The handler, or NULL if none.
+ */
+MuxReceiveFn MuxGetReceiver(uint8_t channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_MUX_H_
@@ -0,0 +1,122 @@
+/**
+ * @file profiler.h
+ * @brief Statistical PC-sampling profiler.
+ *
+ * The Cortex-M0+ has no DWT or ITM, so the profiler samples instead: TIM6
+ * interrupts at a fixed rate, and its handler reads the program counter
+ * the core stacked on entry, i.e. where the interrupted code was. The PCs,
+ * rounded down to PROFILER_GRANULE bytes so that a tight loop takes one
+ * bucket rather than one per instruction, are counted in an
+ * open-addressing hash table of PROFILER_BUCKETS buckets; a sample that
+ * finds no bucket within PROFILER_PROBES probes counts as dropped.
+ * Mapping the PCs to functions is left to the host (tools/pcprofile.py,
+ * with the firmware ELF).
+ *
+ * Every other interrupt runs at priority 0 too, so a sample due while a
+ * handler runs is taken when it returns: time in handlers is charged to
+ * the code they interrupted. Time the main loop spends polling with
+ * nothing to do shows up as the loop and the Process functions it calls.
+ *
+ * `profile dump` stops sampling and streams the table on the mux data
+ * channel (dump.h), tag PROFILER_TAG:
+ *
+ *   samples_le32 | dropped_le32 | rate_hz_le32 | buckets_le32 |
+ *   shift_le32 | granule_le32
+ *   then per bucket: pc_le32 | count_le16   (pc 0: empty)
+ *
+ * When a count would overflow, every count is halved and from then on
+ * only every second sample is recorded; @c shift is the number of times
+ * that happened, so count << shift estimates the samples of a bucket.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_PROFILER_H_
+#define SRC_PROFILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Sampling rate when `profile start` gives none.
+ */
+#ifndef PROFILER_DEFAULT_HZ
+#define PROFILER_DEFAULT_HZ 1000
+#endif
+
+#define PROFILER_MAX_HZ  10000
+
+/**
+ * @brief Distinct PCs kept; a power of two. Six bytes each.
+ */
+#ifndef PROFILER_BUCKETS
+#define PROFILER_BUCKETS 256
+#endif
+
+/**
+ * @brief Address resolution of the histogram; a power of two, 2 for exact
+ * Thumb PCs.
+ */
+#ifndef PROFILER_GRANULE
+#define PROFILER_GRANULE 8
+#endif
+
+#define PROFILER_PROBES  8
+#define PROFILER_TAG     0x464F5250U  ///< "PROF", the address of the dump stream
+
+/**
+ * @brief Starts sampling, or changes the rate. Counts add to those so far.
+ *
+ * @param rate_hz Samples per second, 1 to PROFILER_MAX_HZ.
+ * @return kOk, or kInvalidArgument.
+ */
+ReturnCode ProfilerStart(uint32_t rate_hz);
+
+/**
+ * @brief Stops sampling; the counts are kept.
+ */
+void ProfilerStop(void);
+
+/**
+ * @brief Clears the counts.
+ */
+void ProfilerReset(void);
+
+/**
+ * @brief Stops sampling and streams the table on the mux data channel.
+ *
+ * @param flags DUMP_FLAG_...
+ * @return As DumpStartSource().
+ */
+ReturnCode ProfilerDump(uint8_t flags);
+
+/**
+ * @brief Prints the state and the most frequent PCs.
+ */
+void ProfilerReport(Console* console);
+
+/**
+ * @brief Reprograms the timer for the new clock, keeping the rate. Called
+ * by the governor after a clock change.
+ */
+void ProfilerClockChanged(void);
+
+/**
+ * @brief TIM6 interrupt handler body.
+ *
+ * @param frame Exception stack frame of the interrupted code (r0-r3, r12,
+ *     lr, pc, xPSR).
+ */
+void ProfilerTimerIrq(const uint32_t* frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_PROFILER_H_
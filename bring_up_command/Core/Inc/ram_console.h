@@ -0,0 +1,75 @@
+/**
+ * @file ram_console.h
+ * @brief RAM mailbox console for debug probe / emulator access.
+ *
+ * A control block at the start of RAM (section .mailbox, placed by the
+ * linker script at 0x20000000) holds one ring buffer per direction. A
+ * debug probe or an emulator reads and writes it through memory accesses
+ * while the core runs, so the console works without any UART pins and at
+ * whatever rate the probe can sustain.
+ *
+ * Both rings use the RingBuffer layout and single-producer/single-consumer
+ * discipline of the UART path:
+ *
+ * - up   (device to host): the device moves @c head, the host moves @c tail.
+ * - down (host to device): the host moves @c head, the device moves @c tail.
+ *
+ * Each side writes the data before publishing the index it owns. The block
+ * is valid once @c id reads RAM_CONSOLE_ID; the id is written last during
+ * initialization. The host side is tools/mbox_console.py.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_RAM_CONSOLE_H_
+#define SRC_RAM_CONSOLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ring_buffer.h"
+
+#define RAM_CONSOLE_ID      "BRINGUP MAILBOX"  ///< 15 chars + NUL
+#define RAM_CONSOLE_VERSION 1
+
+/**
+ * @brief How long output waits for the host to drain the up ring before
+ * the mailbox is considered unattended and output is dropped.
+ */
+#define RAM_CONSOLE_WRITE_TIMEOUT_MS 100
+
+/**
+ * @struct RamMailbox
+ * @brief Control block shared with the host (layout is part of the protocol).
+ *
+ * Offsets: id 0, version 16, ring_size 20, up 24, down 24 + sizeof(RingBuffer).
+ * Within a RingBuffer: buffer 0, head RING_BUFFER_SIZE, tail RING_BUFFER_SIZE + 2.
+ */
+typedef struct {
+  char id[16];          ///< RAM_CONSOLE_ID once the block is ready
+  uint32_t version;     ///< RAM_CONSOLE_VERSION
+  uint32_t ring_size;   ///< RING_BUFFER_SIZE
+  RingBuffer up;        ///< Device to host
+  RingBuffer down;      ///< Host to device
+} RamMailbox;
+
+/**
+ * @brief Initializes the mailbox and publishes it to the host.
+ */
+void RamConsoleInit(void);
+
+/**
+ * @brief Moves host input into the console session and runs it.
+ * Call from the main loop.
+ */
+void RamConsoleProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_RAM_CONSOLE_H_
@@ -0,0 +1,111 @@
+/**
+ * @file record_queue.h
+ * @brief Queue of variable-length records in one contiguous ring.
+ *
+ * Every record is a 2-byte little-endian length followed by its bytes,
+ * and never wraps: when a record does not fit before the end of the
+ * storage, the producer writes a padding record (length
+ * RECORD_QUEUE_PADDING) over the rest, or leaves a single spare byte,
+ * and starts again at offset 0. The consumer therefore always gets a
+ * record as one span it can use in place.
+ *
+ * Like RingBuffer it is safe for one producer and one consumer: only the
+ * producer moves @c head and only the consumer moves @c tail. A record is
+ * written in place between RecordQueueReserve() and RecordQueueCommit()
+ * and becomes visible only when committed, so a half-built record is
+ * never seen; it is read in place between RecordQueuePeek() and
+ * RecordQueueRelease().
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_RECORD_QUEUE_H_
+#define SRC_RECORD_QUEUE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ring_buffer.h"
+
+#define RECORD_QUEUE_HEADER   2U
+#define RECORD_QUEUE_PADDING  0xFFFFU
+
+/**
+ * @brief Storage that always leaves room to reserve a record of @p len
+ * bytes while @p count such records are queued, whatever the wrap
+ * position.
+ */
+#define RECORD_QUEUE_STORAGE(count, len) \
+  (((count) + 2U) * ((len) + RECORD_QUEUE_HEADER) + 1U)
+
+/**
+ * @struct RecordQueue
+ * @brief Queue state; the storage is provided by the owner.
+ */
+typedef struct {
+  uint8_t* storage;
+  uint16_t size;
+  volatile uint16_t head;  ///< End of the committed records (producer)
+  volatile uint16_t tail;  ///< Oldest record (consumer)
+  uint16_t reserved;       ///< Offset of the reserved record header
+  uint16_t reserved_max;   ///< Its capacity, 0 when nothing is reserved
+} RecordQueue;
+
+/**
+ * @brief Initializes an empty queue.
+ *
+ * @param queue Queue to initialize.
+ * @param storage Record storage.
+ * @param size Bytes of @p storage (at least RECORD_QUEUE_HEADER + 2).
+ * @return kOk, or kInvalidArgument.
+ */
+ReturnCode RecordQueueInit(RecordQueue* queue, uint8_t* storage, uint16_t size);
+
+/**
+ * @brief Reserves room for a record of up to @p max_len bytes (producer).
+ *
+ * @return Where to write the record, or NULL if there is not enough
+ *     contiguous room. A new reservation replaces an uncommitted one.
+ */
+uint8_t* RecordQueueReserve(RecordQueue* queue, uint16_t max_len);
+
+/**
+ * @brief Publishes the reserved record (producer).
+ *
+ * @param len Bytes actually written, at most the reserved size.
+ * @return kOk, or kInvalidArgument if nothing (or less) was reserved.
+ */
+ReturnCode RecordQueueCommit(RecordQueue* queue, uint16_t len);
+
+/**
+ * @brief Copies a record in (producer): reserve, copy and commit.
+ *
+ * @return kOk, kFull, or kInvalidArgument.
+ */
+ReturnCode RecordQueuePush(RecordQueue* queue, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Returns the oldest record without removing it (consumer).
+ *
+ * @param data Set to the first byte of the record.
+ * @param len Set to its length.
+ * @return kOk, or kEmpty.
+ */
+ReturnCode RecordQueuePeek(RecordQueue* queue, const uint8_t** data, uint16_t* len);
+
+/**
+ * @brief Removes the record returned by RecordQueuePeek() (consumer).
+ *
+ * @return kOk, or kEmpty.
+ */
+ReturnCode RecordQueueRelease(RecordQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_RECORD_QUEUE_H_
@@ -0,0 +1,206 @@
+/**
+ * @file reg.h
+ * @brief Typed register access for GPIO pins and USART fields.
+ *
+ * HAL_GPIO_WritePin() is a call, parameter checks and a branch for what
+ * is one store to BSRR, and HAL_UART_IRQHandler() walks every event a
+ * UART can raise to find the one that fired. The functions here are
+ * static inline and always inlined, so with constant arguments they
+ * compile to the load or store the hardware needs and nothing else.
+ *
+ * Pins are RegPin values, not a port and a mask passed separately:
+ *
+ *   #define LED_PIN REG_PIN(LD2_GPIO_Port, LD2_Pin)   // CubeMX names
+ *   RegPinSet(LED_PIN);                           // GPIOA->BSRR = 0x20
+ *
+ * REG_PIN() checks at compile time that the mask is a single pin;
+ * RegPinMake() builds one from a pin number at run time.
+ *
+ * Fields are named after the CMSIS device header, which already defines a
+ * _Pos and a _Msk for each of them: REG_GET(usart->ISR, USART_ISR, BUSY)
+ * uses USART_ISR_BUSY_Pos and USART_ISR_BUSY_Msk. Every field the header
+ * knows is available without a table here, and a misspelt or wrong
+ * register/field pair does not compile. REG_VALUE() also rejects a
+ * constant that does not fit its field.
+ *
+ * RegBenchmark() compares the cycle counts with the HAL on the target.
+ * For code size, compare the RegBench* functions with
+ * `arm-none-eabi-nm -S --size-sort` on the firmware ELF.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_REG_H_
+#define SRC_REG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "main.h"
+#include "console.h"
+
+#define REG_INLINE static inline __attribute__((always_inline))
+
+// -----------------------------------------------------------------------------
+// Fields
+// -----------------------------------------------------------------------------
+/**
+ * @brief Called only for a constant too wide for its field, which fails
+ * the build.
+ */
+void RegValueTooWide(void) __attribute__((error("value does not fit the register field")));
+
+REG_INLINE uint32_t RegFieldValue(uint32_t value, uint32_t mask, uint32_t pos) {
+  if (__builtin_constant_p(value) && (((value << pos) & ~mask) != 0U)) {
+    RegValueTooWide();
+  }
+  return (value << pos) & mask;
+}
+
+/**
+ * @brief Value of field @p FIELD of register value @p reg (REG: the CMSIS
+ * register prefix, e.g. USART_ISR).
+ */
+#define REG_GET(reg, REG, FIELD) (((reg) & REG##_##FIELD##_Msk) >> REG##_##FIELD##_Pos)
+
+/**
+ * @brief Non-zero when any bit of the field is set.
+ */
+#define REG_TEST(reg, REG, FIELD) (((reg) & REG##_##FIELD##_Msk) != 0U)
+
+/**
+ * @brief @p value placed in the field, for building register values.
+ */
+#define REG_VALUE(REG, FIELD, value) \
+  RegFieldValue((uint32_t)(value), REG##_##FIELD##_Msk, REG##_##FIELD##_Pos)
+
+/**
+ * @brief Read-modify-write of one field of register @p reg.
+ */
+#define REG_MODIFY(reg, REG, FIELD, value) \
+  ((reg) = ((reg) & ~REG##_##FIELD##_Msk) | REG_VALUE(REG, FIELD, value))
+
+// -----------------------------------------------------------------------------
+// GPIO pins
+// -----------------------------------------------------------------------------
+/**
+ * @struct RegPin
+ * @brief One GPIO pin.
+ */
+typedef struct {
+  GPIO_TypeDef* port;
+  uint16_t mask;              ///< Single bit, as the HAL GPIO_PIN_x
+} RegPin;
+
+/**
+ * @brief Pin from a port and a constant GPIO_PIN_x mask.
+ */
+#define REG_PIN(port, pin_mask)                                                  \
+  ((RegPin){(port), (uint16_t)((pin_mask) + 0U * sizeof(struct {                 \
+               _Static_assert(((pin_mask) != 0U) && ((pin_mask) <= 0x8000U) &&   \
+                                  (((pin_mask) & ((pin_mask) - 1U)) == 0U),       \
+                              "REG_PIN: not a single GPIO_PIN_x");               \
+               int unused;                                                       \
+             }))})
+
+/**
+ * @brief Pin from a pin number (0-15) known only at run time.
+ */
+REG_INLINE RegPin RegPinMake(GPIO_TypeDef* port, uint32_t number) {
+  RegPin pin = {port, (uint16_t)(1U << (number & 15U))};
+  return pin;
+}
+
+REG_INLINE void RegPinSet(RegPin pin) {
+  pin.port->BSRR = pin.mask;
+}
+
+REG_INLINE void RegPinClear(RegPin pin) {
+  pin.port->BRR = pin.mask;
+}
+
+/**
+ * @brief Drives the pin to @p level (0 or not) with one BSRR store.
+ */
+REG_INLINE void RegPinWrite(RegPin pin, uint32_t level) {
+  pin.port->BSRR = (uint32_t)pin.mask << ((level != 0U) ? 0U : 16U);
+}
+
+/**
+ * @brief Inverts an output. Not atomic against an interrupt that drives
+ * the same port.
+ */
+REG_INLINE void RegPinToggle(RegPin pin) {
+  uint32_t odr = pin.port->ODR;
+  pin.port->BSRR = ((odr & pin.mask) << 16) | (~odr & pin.mask);
+}
+
+/**
+ * @brief Input level, 0 or 1.
+ */
+REG_INLINE uint32_t RegPinRead(RegPin pin) {
+  return (pin.port->IDR & pin.mask) != 0U;
+}
+
+// -----------------------------------------------------------------------------
+// USART
+// -----------------------------------------------------------------------------
+#define REG_USART_ERRORS (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE | USART_ISR_ORE)
+
+/**
+ * @brief Transmitter drained and receiver not busy: the port may be
+ * reconfigured.
+ */
+REG_INLINE uint32_t RegUsartQuiet(const USART_TypeDef* usart) {
+  uint32_t isr = usart->ISR;
+  return REG_TEST(isr, USART_ISR, TC) && !REG_TEST(isr, USART_ISR, BUSY);
+}
+
+/**
+ * @brief Events that are both flagged in ISR and enabled in CR1/CR3
+ * (reception errors always count), as ISR bits.
+ */
+REG_INLINE uint32_t RegUsartPending(const USART_TypeDef* usart) {
+  uint32_t isr = usart->ISR;
+  uint32_t cr1 = usart->CR1;
+  uint32_t cr3 = usart->CR3;
+  // IDLE, RXNE, TC and TXE sit at the same positions as their enables
+  uint32_t pending = isr & cr1 & (USART_ISR_IDLE | USART_ISR_RXNE | USART_ISR_TC | USART_ISR_TXE);
+
+  pending |= isr & REG_USART_ERRORS;
+  if (REG_TEST(cr1, USART_CR1, RTOIE)) {
+    pending |= isr & USART_ISR_RTOF;
+  }
+  if (REG_TEST(cr1, USART_CR1, CMIE)) {
+    pending |= isr & USART_ISR_CMF;
+  }
+  if (REG_TEST(cr3, USART_CR3, WUFIE)) {
+    pending |= isr & USART_ISR_WUF;
+  }
+  if (REG_TEST(cr3, USART_CR3, CTSIE)) {
+    pending |= isr & USART_ISR_CTSIF;
+  }
+  return pending;
+}
+
+/**
+ * @brief Times pin and flag accesses through the HAL and through this
+ * header on the target and prints the cycle counts.
+ *
+ * Each figure is the best of a few runs with interrupts masked, measured
+ * with SysTick, less the cost of an empty measurement.
+ *
+ * @param console Destination session.
+ * @return kOk.
+ */
+ReturnCode RegBenchmark(Console* console);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_REG_H_
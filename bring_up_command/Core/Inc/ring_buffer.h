@@ -25,15 +25,17 @@ extern "C" {
 /**
  * @brief Circular ring buffer structure.
  *
- * @details Implements a FIFO (First-In-First-Out) circular buffer with thread-safe
- * volatile members. The buffer uses the common technique of always keeping one
- * position empty to distinguish between full and empty states.
+ * @details Implements a FIFO (First-In-First-Out) circular buffer that is safe for
+ * a single producer and a single consumer (e.g. a DMA/UART interrupt on one side
+ * and the main loop on the other). Only the producer writes @c head and only the
+ * consumer writes @c tail; the fill level is always derived from both, so there is
+ * no shared counter to race on. The buffer uses the common technique of always
+ * keeping one position empty to distinguish between full and empty states.
  */
 typedef struct {
   uint8_t buffer[RING_BUFFER_SIZE]; ///< Storage array for buffer elements
-  volatile uint16_t head;           ///< Write index (incremented on push operations)
-  volatile uint16_t tail;           ///< Read index (incremented on pop operations)
-  volatile uint16_t items;          ///< Current number of elements in the buffer
+  volatile uint16_t head;           ///< Write index (only moved by the producer)
+  volatile uint16_t tail;           ///< Read index (only moved by the consumer)
 } RingBuffer;
 
 /**
@@ -160,6 +162,31 @@ ReturnCode RingBufferStreamPush(RingBuffer* rb, uint8_t* data, uint16_t items);
  */
 ReturnCode RingBufferStreamPop(RingBuffer* rb, uint8_t* data, uint16_t items);
 
+/**
+ * @brief Returns the longest contiguous block of data that can be read
+ * without wrapping, leaving it in the buffer.
+ *
+ * @details Meant for handing buffer memory straight to a DMA channel: the
+ * consumer transmits the block and then releases it with RingBufferDiscard().
+ *
+ * @param rb Pointer to the RingBuffer instance.
+ * @param data Pointer to store the address of the first readable element.
+ * @param items Pointer to store the number of contiguous readable elements.
+ * @return kOk if data is available, kEmpty if buffer is empty,
+ *         kInvalidArgument if parameters invalid.
+ */
+ReturnCode RingBufferPeekLinear(const RingBuffer* rb, const uint8_t** data, uint16_t* items);
+
+/**
+ * @brief Drops a number of elements from the read side of the buffer.
+ *
+ * @param rb Pointer to the RingBuffer instance.
+ * @param items Number of items to release.
+ * @return kOk if items released, kEmpty if fewer items are stored,
+ *         kInvalidArgument if parameters invalid.
+ */
+ReturnCode RingBufferDiscard(RingBuffer* rb, uint16_t items);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,108 @@
+/**
+ * @file rs485.h
+ * @brief Addressed multi-drop console on an RS-485 bus.
+ *
+ * With the bus mode on, the RS485_PORT console runs the USART's hardware
+ * driver enable (DE pin asserted around every transmission) and
+ * address-mark mute mode: a byte with bit 7 set is an address, and a
+ * board whose 7-bit address does not match mutes its receiver until its
+ * own address comes by. Muted boards receive nothing, so no DMA transfer
+ * or interrupt happens on them whatever the traffic on the bus.
+ *
+ * A host talks to board N by sending the byte 0x80 | N and then ordinary
+ * command lines; the address byte itself is dropped by the console line
+ * discipline. Console output is line based (the echo follows the complete
+ * line), so the board only drives the bus after the host has finished
+ * sending. Only 7-bit text can be used on the bus (no mux mode).
+ *
+ * The address and the on/off setting are stored in the data EEPROM and
+ * applied at boot; configure each board over another console before
+ * connecting it to the bus:
+ *
+ *   rs485 addr 12
+ *   rs485 on
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_RS485_H_
+#define SRC_RS485_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Console port wired to the transceiver, and its DE pin.
+ */
+#ifndef RS485_PORT
+#define RS485_PORT        "usart1"
+#define RS485_DE_PORT     GPIOA
+#define RS485_DE_PIN      GPIO_PIN_12
+#define RS485_DE_AF       GPIO_AF4_USART1
+#endif
+
+/**
+ * @brief DE assertion before the start bit and deassertion after the stop
+ * bit, in sample times (1/16 bit); up to 31.
+ */
+#ifndef RS485_DE_ASSERT_TIME
+#define RS485_DE_ASSERT_TIME    8
+#define RS485_DE_DEASSERT_TIME  8
+#endif
+
+/**
+ * @brief Data EEPROM word holding the settings.
+ */
+#ifndef RS485_EEPROM_ADDRESS
+#define RS485_EEPROM_ADDRESS DATA_EEPROM_BASE
+#endif
+
+#define RS485_MAX_ADDRESS 0x7F
+
+/**
+ * @brief Loads the settings from the data EEPROM; the bus mode is applied
+ * from Rs485Process() once the port's pending output is sent.
+ */
+void Rs485Init(void);
+
+/**
+ * @brief Sets and stores the board address (applied at once if the bus
+ * mode is on).
+ *
+ * @param address 0..RS485_MAX_ADDRESS.
+ * @return kOk, kInvalidArgument for an address out of range, kError if the
+ *     EEPROM could not be written.
+ */
+ReturnCode Rs485SetAddress(uint32_t address);
+
+/**
+ * @brief Turns the bus mode on or off and stores the setting.
+ *
+ * @param on 1 for addressed RS-485 mode, 0 for a plain console port.
+ * @return kOk, or kError if the EEPROM could not be written.
+ */
+ReturnCode Rs485Enable(uint8_t on);
+
+/**
+ * @brief Prints the settings and the state of the port.
+ *
+ * @param console Destination session.
+ */
+void Rs485Report(Console* console);
+
+/**
+ * @brief Applies a changed setting. Call from the main loop.
+ */
+void Rs485Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_RS485_H_
@@ -0,0 +1,137 @@
+/**
+ * @file selftest.h
+ * @brief Board self-test sequencer with a timing report.
+ *
+ * `selftest` runs a table of test steps from the main loop and prints one
+ * line per step when all of them have finished:
+ *
+ *   led    pass        31 us
+ *   pin    pass       118 us
+ *   uart   pass      1502 us
+ *   ram    pass       856 us  4096 B
+ *   flash  pass      2417 us  crc 5C0D81E2
+ *   clock  pass       290 us  32.00 MHz LSI
+ *   selftest: 6 pass, 0 fail, 0 skip in 2.6 ms
+ *
+ * Each step declares the resources it touches (SELFTEST_RES_*). A step
+ * starts as soon as no running step holds any of its resources, so steps
+ * on different peripherals run interleaved and the whole check takes about
+ * as long as the slowest step. Steps are polled state machines and never
+ * block; a step still pending after its timeout fails with "timeout".
+ *
+ * A step that cannot check anything on this board (missing reference
+ * clock, flash CRC not provisioned, pin in use) reports "skip".
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_SELFTEST_H_
+#define SRC_SELFTEST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Console port borrowed for the UART loopback. The port is put in
+ * half-duplex mode so its receiver hears its own transmitter; anything
+ * attached to the TX pin sees the test pattern.
+ */
+#ifndef SELFTEST_UART_PORT
+#define SELFTEST_UART_PORT "lpuart1"
+#endif
+
+/**
+ * @brief Unconnected pin checked with the internal pull-up and pull-down
+ * (PA0, Arduino A0 on the Nucleo board).
+ */
+#ifndef SELFTEST_PIN_PORT
+#define SELFTEST_PIN_PORT GPIOA
+#define SELFTEST_PIN      0
+#endif
+
+/**
+ * @brief Allowed deviation of the measured system clock (percent) when
+ * measured against the LSE crystal. The LSI reference is only good to
+ * about +/-40%.
+ */
+#ifndef SELFTEST_CLOCK_TOLERANCE_PCT
+#define SELFTEST_CLOCK_TOLERANCE_PCT 2
+#endif
+
+/**
+ * @brief Resources a step may use; steps sharing none run concurrently.
+ */
+#define SELFTEST_RES_LED    (1U << 0)
+#define SELFTEST_RES_PIN    (1U << 1)
+#define SELFTEST_RES_UART   (1U << 2)
+#define SELFTEST_RES_RAM    (1U << 3)
+#define SELFTEST_RES_CRC    (1U << 4)
+#define SELFTEST_RES_TIM21  (1U << 5)
+
+/**
+ * @brief Outcome of a step poll.
+ */
+typedef enum {
+  kSelftestPending = 0,
+  kSelftestPass,
+  kSelftestFail,
+  kSelftestSkip,
+} SelftestResult;
+
+/**
+ * @struct SelftestContext
+ * @brief Per-run state of a step, zeroed before its first poll.
+ */
+typedef struct {
+  uint32_t state;      ///< Step-defined progress, 0 on the first poll
+  uint32_t value;      ///< Step-defined scratch
+  uint32_t mark;       ///< Step-defined scratch (e.g. a timestamp)
+  char detail[24];     ///< Measurement or failure reason for the report
+} SelftestContext;
+
+/**
+ * @struct SelftestStep
+ * @brief Entry of the step table.
+ */
+typedef struct {
+  const char* name;
+  uint16_t resources;                             ///< SELFTEST_RES_* bits held while running
+  uint16_t timeout_ms;
+  SelftestResult (*poll)(SelftestContext* ctx);   ///< Called until it returns a final result
+  void (*cleanup)(SelftestContext* ctx);          ///< Optional; restores the hardware after any outcome
+} SelftestStep;
+
+/**
+ * @brief Starts a self-test run.
+ *
+ * @param console Session receiving the report.
+ * @param names Steps to run, NULL to run all of them.
+ * @param count Number of entries in @p names.
+ * @return kOk, kFull if a run is already in progress, kInvalidArgument for
+ *     an unknown step name.
+ */
+ReturnCode SelftestStart(Console* console, char* const names[], int count);
+
+/**
+ * @brief Lists the steps with their resources and timeouts.
+ *
+ * @param console Destination session.
+ */
+void SelftestList(Console* console);
+
+/**
+ * @brief Advances the running steps. Call from the main loop.
+ */
+void SelftestProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_SELFTEST_H_
@@ -0,0 +1,79 @@
+/**
+ * @file spi_console.h
+ * @brief SPI-slave console transport (SPI1 + DMA).
+ *
+ * Serves a console session over SPI1 in slave mode using the frame protocol
+ * in spi_link.h, for fixtures that need more than a UART can carry. Both
+ * directions run through DMA; the end of each transaction is detected on
+ * the NSS rising edge, which also resynchronizes after a short transaction.
+ *
+ * Pins (Arduino header): PB3 SCK (D3), PB4 MISO (D5), PB5 MOSI (D4),
+ * PA15 NSS. SPI1 uses DMA1 channels 2 and 3, which otherwise belong to
+ * USART1, so enabling this transport removes the USART1 console.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_SPI_CONSOLE_H_
+#define SRC_SPI_CONSOLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Build option: 1 serves a console over SPI1 instead of USART1.
+ */
+#ifndef SPI_CONSOLE_ENABLED
+#define SPI_CONSOLE_ENABLED 0
+#endif
+
+/**
+ * @brief How long console output waits for the master to poll before it
+ * is dropped.
+ */
+#define SPI_CONSOLE_WRITE_TIMEOUT_MS 100
+
+/**
+ * @brief Highest SCK the master drives (tools/spi_master_sim.c defaults
+ * to 8 MHz). A slave keeps up to PCLK/4.
+ */
+#ifndef SPI_CONSOLE_SCK_HZ
+#define SPI_CONSOLE_SCK_HZ 8000000U
+#endif
+
+#define SPI_CONSOLE_PCLK_PER_SCK 4U
+
+/**
+ * @brief Configures SPI1, its DMA channels and NSS edge detection, and
+ * arms the first transaction.
+ */
+void SpiConsoleInit(void);
+
+/**
+ * @brief Services the SPI console session. Call from the main loop.
+ */
+void SpiConsoleProcess(void);
+
+/**
+ * @brief NSS rising edge handler (end of transaction). Called from the
+ * EXTI interrupt.
+ */
+void SpiConsoleEndOfTransaction(void);
+
+/**
+ * @brief Returns 1 if the SPI console keeps up with SPI_CONSOLE_SCK_HZ at
+ * the given system clock, with the APB buses undivided (always 1 when the
+ * transport is disabled).
+ */
+uint8_t SpiConsoleClockReachable(uint32_t sysclk_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_SPI_CONSOLE_H_
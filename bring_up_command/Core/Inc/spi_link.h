@@ -0,0 +1,100 @@
+/**
+ * @file spi_link.h
+ * @brief Frame and status protocol of the SPI-slave console transport.
+ *
+ * The SPI master drives fixed-size, full-duplex transactions of
+ * SPI_LINK_FRAME_SIZE bytes (one per NSS assertion). Both directions use
+ * the same layout:
+ *
+ *   | magic | flags | len | credit | payload[SPI_LINK_PAYLOAD] |
+ *
+ * - magic:  SPI_LINK_MAGIC; anything else marks an idle/garbage frame.
+ * - flags:  device to host status (SPI_LINK_FLAG_*), 0 from the host.
+ * - len:    number of valid payload bytes.
+ * - credit: device to host only: payload bytes the device accepts in the
+ *           next host frame. The host must never send more than that.
+ *
+ * The device frame for a transaction is prepared when the previous one
+ * ends, so the master must leave a short gap between transactions and
+ * simply keeps polling while SPI_LINK_FLAG_MORE is set.
+ *
+ * This part is hardware independent so that it can be exercised on the host
+ * (tools/spi_master_sim.c); spi_console.c binds it to SPI1 and DMA.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_SPI_LINK_H_
+#define SRC_SPI_LINK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define SPI_LINK_MAGIC       0xA5
+#define SPI_LINK_HEADER_SIZE 4
+#define SPI_LINK_PAYLOAD     124
+#define SPI_LINK_FRAME_SIZE  (SPI_LINK_HEADER_SIZE + SPI_LINK_PAYLOAD)
+
+#define SPI_LINK_FLAG_MORE    0x01  ///< Device has more output queued
+#define SPI_LINK_FLAG_DROPPED 0x02  ///< Host data was dropped since last frame
+
+typedef struct SpiLink SpiLink;
+
+/**
+ * @brief Called while output waits for the master to drain the TX queue.
+ *
+ * @param link Link being written.
+ * @return Non-zero to keep waiting, 0 to drop the remaining output.
+ */
+typedef uint8_t (*SpiLinkWaitFn)(SpiLink* link);
+
+/**
+ * @struct SpiLink
+ * @brief State of one SPI console link.
+ */
+struct SpiLink {
+  Console console;                        ///< Session served over the link
+  RingBuffer tx;                          ///< Output waiting for the master
+  uint8_t tx_frame[SPI_LINK_FRAME_SIZE];  ///< Frame shifted out next
+  uint8_t rx_frame[SPI_LINK_FRAME_SIZE];  ///< Frame shifted in
+  uint8_t flags;                          ///< Sticky flags for the next frame
+  SpiLinkWaitFn wait;                     ///< Back-pressure hook
+  volatile uint32_t frames;               ///< Complete transactions seen
+  volatile uint32_t bad_frames;           ///< Short or malformed transactions
+};
+
+/**
+ * @brief Initializes a link and its console session.
+ *
+ * @param link Link to initialize.
+ * @param name Console session name.
+ * @param wait Back-pressure hook (NULL drops output when the queue is full).
+ */
+void SpiLinkInit(SpiLink* link, const char* name, SpiLinkWaitFn wait);
+
+/**
+ * @brief Builds the next device frame in @c tx_frame from queued output.
+ *
+ * Called between transactions (interrupt context on the target).
+ */
+void SpiLinkPrepare(SpiLink* link);
+
+/**
+ * @brief Handles the frame received in @c rx_frame.
+ *
+ * @param link Link that completed a transaction.
+ * @param received Number of bytes the master clocked in.
+ */
+void SpiLinkComplete(SpiLink* link, uint16_t received);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_SPI_LINK_H_
@@ -0,0 +1,156 @@
+/**
+ * @file timesync.h
+ * @brief Microsecond timebase synchronized to a host reference clock.
+ *
+ * TIM2 counts microseconds (extended to 64 bits by its update interrupt)
+ * and captures rising edges of the sync input on TIMESYNC_PIN. The host
+ * pairs local times with its own clock in one of two ways:
+ *
+ *   time sync <ref_us>    sync frame: the reference time is paired with
+ *                         the local time the command line is run at
+ *                         (serial/USB latency, jitter of ~1 ms)
+ *   time pulse <ref_us>   the reference time of the last sync pulse, sent
+ *                         after it: paired with the captured edge (1 us)
+ *
+ * The pulse is one wire shared by every board (driven by the host adapter
+ * or a spare GPIO), so all boards capture the same instant. The last
+ * TIMESYNC_WINDOW pairs are fitted with a least-squares line, giving the
+ * offset and the drift (ppb) of the local clock against the reference;
+ * TimesyncNow() returns local time mapped through that fit, so records
+ * stamped on different boards land on one timebase. A pair that misses
+ * the current fit by more than TIMESYNC_STEP_US is taken as a step of
+ * the reference clock and restarts the fit.
+ *
+ * `time` prints the state: local and reference time, offset, drift,
+ * number of pairs and the worst residual of the fit.
+ *
+ * When the system clock changes, TimesyncClockChanged() reloads the TIM2
+ * prescaler without a jump in local time. A timer clock that is not a
+ * whole number of MHz (MSI) gives a tick near 1 us that is scaled to
+ * microseconds. Each oscillator has its own error, so when the system
+ * clock moves to another one (MSI or HSI16; the PLL counts as its input)
+ * the pairs and the drift are dropped: reference time continues from the value the old fit gave
+ * at the switch, at the local rate, until new pairs come in.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_TIMESYNC_H_
+#define SRC_TIMESYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "console.h"
+
+/**
+ * @brief Sync pulse input: a TIM2 channel 2 pin (PA1 on the Nucleo CN8).
+ */
+#ifndef TIMESYNC_PIN
+#define TIMESYNC_PORT GPIOA
+#define TIMESYNC_PIN  GPIO_PIN_1
+#define TIMESYNC_AF   GPIO_AF2_TIM2
+#endif
+
+#ifndef TIMESYNC_WINDOW
+#define TIMESYNC_WINDOW     8         ///< Pairs kept for the fit
+#endif
+#ifndef TIMESYNC_STEP_US
+#define TIMESYNC_STEP_US    100000    ///< Residual that restarts the fit
+#endif
+#ifndef TIMESYNC_PULSE_AGE_US
+#define TIMESYNC_PULSE_AGE_US 1000000 ///< Oldest capture a `time pulse` may use
+#endif
+
+/**
+ * @brief Starts the microsecond timer and the sync pulse capture.
+ */
+void TimesyncInit(void);
+
+/**
+ * @brief Reloads the timer prescaler for the current APB1 clock, keeping
+ * local time continuous, and restarts the fit if the oscillator changed.
+ * Call after every system clock change.
+ */
+void TimesyncClockChanged(void);
+
+/**
+ * @brief Local time since TimesyncInit(), in microseconds. Safe to call
+ * from interrupt handlers.
+ */
+uint64_t TimesyncLocalMicros(void);
+
+/**
+ * @brief Converts a local time to the reference timebase.
+ *
+ * @param local_us Value from TimesyncLocalMicros().
+ * @return Reference time in microseconds, or @c local_us before the first
+ *     pair.
+ */
+int64_t TimesyncToReference(uint64_t local_us);
+
+/**
+ * @brief Current time on the reference timebase, in microseconds.
+ */
+int64_t TimesyncNow(void);
+
+/**
+ * @brief Returns 1 once at least one pair is fitted.
+ */
+uint8_t TimesyncIsSynced(void);
+
+/**
+ * @brief Adds a (local, reference) pair to the fit.
+ *
+ * @param local_us Local time of the sync event.
+ * @param ref_us Reference time of the same event.
+ * @return kOk, or kInvalidArgument if @c local_us is not after the last
+ *     pair.
+ */
+ReturnCode TimesyncAddPair(uint64_t local_us, int64_t ref_us);
+
+/**
+ * @brief Local time of the last captured sync pulse.
+ *
+ * @param local_us Receives the capture time.
+ * @return kOk, or kEmpty if no pulse was captured in the last
+ *     TIMESYNC_PULSE_AGE_US.
+ */
+ReturnCode TimesyncLastPulse(uint64_t* local_us);
+
+/**
+ * @brief Formats microseconds as seconds with six decimals.
+ *
+ * @param out Destination buffer (22 bytes hold any value).
+ * @param size Size of @c out.
+ * @param us Time to format.
+ */
+void TimesyncFormat(char* out, size_t size, int64_t us);
+
+/**
+ * @brief Forgets every pair (TimesyncNow() returns local time again).
+ */
+void TimesyncReset(void);
+
+/**
+ * @brief Prints the synchronization state.
+ *
+ * @param console Destination session.
+ */
+void TimesyncReport(Console* console);
+
+/**
+ * @brief TIM2 interrupt handler body (counter overflow and pulse capture).
+ */
+void TimesyncTimerIrq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_TIMESYNC_H_
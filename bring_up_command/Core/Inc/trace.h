@@ -0,0 +1,66 @@
+/**
+ * @file trace.h
+ * @brief Timestamped log lines and trace records on the mux channels.
+ *
+ * Both are stamped with TimesyncNow(), so once every board is synchronized
+ * to the same reference the streams of several boards merge into one
+ * timeline (tools/timesync.py merge). Nothing is sent while the mux is not
+ * active; records that do not fit in the channel queue are dropped and
+ * counted.
+ *
+ * MUX_CH_LOG carries text lines, the time in seconds first:
+ *
+ *   1760781234.123456 run gpio
+ *
+ * MUX_CH_TRACE carries fixed-size binary records, little endian:
+ *
+ *   int64 time_us | uint16 id | uint32 value     (TRACE_RECORD_SIZE bytes)
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define TRACE_RECORD_SIZE 14
+#define TRACE_LINE_SIZE   64  ///< Longest log line, time stamp included
+
+/**
+ * @brief Trace record identifiers.
+ */
+#define TRACE_ID_SYNC     1  ///< Sync pair accepted; value = residual in us
+#define TRACE_ID_COMMAND  2  ///< Command started; value = index in the table
+
+/**
+ * @brief Queues a formatted log line on MUX_CH_LOG.
+ *
+ * @param format printf format of the message (no line ending).
+ */
+void TraceLog(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Queues a trace record on MUX_CH_TRACE.
+ *
+ * @param id Record identifier (TRACE_ID_...).
+ * @param value Record argument.
+ */
+void TraceEvent(uint16_t id, uint32_t value);
+
+/**
+ * @brief Number of log lines and trace records dropped for lack of room.
+ */
+uint32_t TraceDropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_TRACE_H_
@@ -0,0 +1,146 @@
+/**
+ * @file uart_console.h
+ * @brief UART transport for console sessions.
+ *
+ * Runs one independent console session per UART (USART1, USART2 and
+ * LPUART1). Each port receives through a circular DMA buffer with idle-line
+ * detection and transmits from its own ring buffer through a dedicated DMA
+ * channel, so a busy port never stalls the others.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_UART_CONSOLE_H_
+#define SRC_UART_CONSOLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "console.h"
+
+/**
+ * @brief Size of the circular DMA reception buffer of each port.
+ */
+#define UART_CONSOLE_RX_DMA_SIZE 128
+
+/**
+ * @brief Largest baud rate error accepted after a clock change.
+ */
+#ifndef UART_CONSOLE_BAUD_ERROR_PERMILLE
+#define UART_CONSOLE_BAUD_ERROR_PERMILLE 20
+#endif
+
+/**
+ * @struct UartConsoleHooks
+ * @brief HAL events of an acquired port forwarded to its borrower (either
+ * handler may be NULL). Both run in interrupt context.
+ */
+typedef struct {
+  void (*tx_complete)(UART_HandleTypeDef* huart);
+  void (*error)(UART_HandleTypeDef* huart);
+} UartConsoleHooks;
+
+/**
+ * @struct UartConsole
+ * @brief Console session bound to a UART.
+ */
+typedef struct {
+  Console console;                                 ///< Session state
+  UART_HandleTypeDef* huart;                       ///< HAL handle of the port
+  uint8_t rx_dma_buf[UART_CONSOLE_RX_DMA_SIZE];    ///< Circular DMA target
+  uint16_t rx_last_pos;                            ///< Last DMA position consumed
+  RingBuffer tx;                                   ///< Pending output
+  volatile uint16_t tx_inflight;                   ///< Bytes owned by TX DMA (0 = idle)
+  volatile uint8_t acquired;                       ///< Port lent out by UartConsoleAcquire()
+  const UartConsoleHooks* hooks;                   ///< Borrower's handlers while acquired
+} UartConsole;
+
+/**
+ * @brief Initializes every UART console and starts DMA reception.
+ *
+ * The UART peripherals must already be initialized (MX_*_Init).
+ */
+void UartConsoleInit(void);
+
+/**
+ * @brief Services all UART consoles. Call from the main loop.
+ */
+void UartConsoleProcess(void);
+
+/**
+ * @brief Takes a port away from its console, e.g. for a loopback test.
+ *
+ * Reception is stopped and output is held in the TX buffer until
+ * UartConsoleRelease(); the caller owns the UART registers meanwhile.
+ *
+ * @param name Port name ("usart2", "usart1", "lpuart1").
+ * @param hooks Handlers for TX complete and errors, or NULL.
+ * @param huart Receives the HAL handle of the port.
+ * @return kOk, kInvalidArgument for an unknown port, kFull while output is
+ *     still being transmitted (try again later).
+ */
+ReturnCode UartConsoleAcquire(const char* name, const UartConsoleHooks* hooks,
+                              UART_HandleTypeDef** huart);
+
+/**
+ * @brief Gives a port back to its console and restarts reception.
+ *
+ * @param huart Handle returned by UartConsoleAcquire().
+ */
+void UartConsoleRelease(UART_HandleTypeDef* huart);
+
+/**
+ * @brief Largest number of bytes waiting on one port, received but not
+ * yet processed plus queued for transmission.
+ */
+uint16_t UartConsoleBacklog(void);
+
+/**
+ * @brief Holds back or resumes console output, so that no frame is on
+ * the wire while the UART clocks change.
+ *
+ * @param hold 1 to stop starting transmissions, 0 to resume them.
+ * @return With @p hold set, 1 once no port (acquired ones included) is
+ *     transmitting or receiving a frame; 1 when resuming.
+ */
+uint8_t UartConsoleHoldTx(uint8_t hold);
+
+/**
+ * @brief Returns 1 if every port can keep its baud rate within
+ * UART_CONSOLE_BAUD_ERROR_PERMILLE at the given system clock, with the
+ * APB buses undivided.
+ */
+uint8_t UartConsoleBaudReachable(uint32_t sysclk_hz);
+
+/**
+ * @brief Reprograms the baud rate divider of every port for the current
+ * kernel clocks. Call with output held, after a system clock change.
+ *
+ * A port is disabled for the few cycles the divider takes to write: a
+ * frame that starts meanwhile is lost. A port in mute mode is put back
+ * into it.
+ */
+void UartConsoleRetune(void);
+
+/**
+ * @brief Handles the idle line interrupt of a console port without
+ * HAL_UART_IRQHandler(), which tests every event a UART can raise first.
+ *
+ * Call at the top of the port's interrupt handler. Anything else pending,
+ * an acquired port or a reception the console did not start is left to
+ * the HAL.
+ *
+ * @param huart HAL handle of the interrupting UART.
+ * @return 1 if the interrupt was handled, 0 to call HAL_UART_IRQHandler().
+ */
+uint8_t UartConsoleIrq(UART_HandleTypeDef* huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_UART_CONSOLE_H_
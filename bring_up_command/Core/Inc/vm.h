@@ -0,0 +1,178 @@
+/**
+ * @file vm.h
+ * @brief Bytecode interpreter for bring-up test scripts.
+ *
+ * Scripts are compiled on the host (tools/vmc.py), uploaded into a fixed
+ * code buffer with the `vm load` command and run from the main loop. The
+ * machine is a 32-bit stack machine with a few variables; it can call any
+ * registered console command, so a loop that drives a pin and reads it
+ * back runs on the target instead of costing a host round trip per step.
+ *
+ * Every VmProcess() call executes at most VM_SLICE_BUDGET cost units
+ * (most instructions cost 1, instructions that produce output or call a
+ * command cost VM_IO_COST) and waits never block, so the consoles keep
+ * running while a script does.
+ *
+ * Encoding: one opcode byte followed by its operands, little endian.
+ *
+ *   HALT                      stop
+ *   PUSH8 i8 / PUSH16 i16 / PUSH32 i32
+ *                             push a sign-extended constant
+ *   DUP, DROP, SWAP, OVER     stack manipulation
+ *   LOAD n / STORE n          push / pop variable n
+ *   ADD SUB MUL DIV MOD NEG AND OR XOR NOT SHL SHR
+ *                             arithmetic and bitwise (NOT is logical)
+ *   EQ NE LT LE GT GE         comparisons, push 1 or 0
+ *   JMP a16 / JZ a16 / JNZ a16
+ *                             absolute jumps (JZ/JNZ pop the condition)
+ *   WAIT                      pop a delay in ms and sleep
+ *   TICKS                     push HAL_GetTick()
+ *   CALL n s[n]               run command line s; each '%' in it is
+ *                             replaced by a popped value (deepest first),
+ *                             then the command result is pushed
+ *   PRINT                     pop and print a decimal number
+ *   PRINTS n s[n]             print a string
+ *   EMIT                      pop and print one character
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_VM_H_
+#define SRC_VM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define VM_CODE_SIZE    256  ///< Bytes of bytecode
+#define VM_STACK_DEPTH  16   ///< 32-bit stack entries
+#define VM_NUM_VARS     8    ///< 32-bit variables
+
+/**
+ * @brief Cost units executed per VmProcess() call.
+ */
+#ifndef VM_SLICE_BUDGET
+#define VM_SLICE_BUDGET 64
+#endif
+
+/**
+ * @brief Cost of instructions that print or call a command.
+ */
+#define VM_IO_COST      8
+
+/**
+ * @brief Instruction opcodes (see the encoding table above).
+ */
+typedef enum {
+  kVmHalt = 0x00,
+  kVmPush8 = 0x01,
+  kVmPush16 = 0x02,
+  kVmPush32 = 0x03,
+  kVmDup = 0x04,
+  kVmDrop = 0x05,
+  kVmSwap = 0x06,
+  kVmOver = 0x07,
+  kVmLoad = 0x08,
+  kVmStore = 0x09,
+  kVmAdd = 0x10,
+  kVmSub = 0x11,
+  kVmMul = 0x12,
+  kVmDiv = 0x13,
+  kVmMod = 0x14,
+  kVmNeg = 0x15,
+  kVmAnd = 0x16,
+  kVmOr = 0x17,
+  kVmXor = 0x18,
+  kVmNot = 0x19,
+  kVmShl = 0x1A,
+  kVmShr = 0x1B,
+  kVmEq = 0x20,
+  kVmNe = 0x21,
+  kVmLt = 0x22,
+  kVmLe = 0x23,
+  kVmGt = 0x24,
+  kVmGe = 0x25,
+  kVmJmp = 0x30,
+  kVmJz = 0x31,
+  kVmJnz = 0x32,
+  kVmWait = 0x40,
+  kVmTicks = 0x41,
+  kVmCall = 0x50,
+  kVmPrint = 0x51,
+  kVmPrints = 0x52,
+  kVmEmit = 0x53
+} VmOpcode;
+
+/**
+ * @brief Execution state.
+ */
+typedef enum {
+  kVmIdle = 0,   ///< Not running (never started, halted, stopped or failed)
+  kVmRunning,    ///< Executing instructions
+  kVmWaiting     ///< Sleeping in a WAIT instruction
+} VmState;
+
+/**
+ * @struct VmStatus
+ * @brief Snapshot reported by the `vm` command.
+ */
+typedef struct {
+  VmState state;        ///< Current state
+  uint16_t length;      ///< Bytes of code loaded
+  uint16_t crc;         ///< CRC-16/CCITT-FALSE of the loaded code
+  uint16_t pc;          ///< Next instruction
+  uint8_t sp;           ///< Stack entries in use
+  uint32_t steps;       ///< Instructions executed by the last run
+  const char* error;    ///< Why the last run failed, NULL if it did not
+} VmStatus;
+
+/**
+ * @brief Stores bytecode in the code buffer.
+ *
+ * A load at offset 0 starts a new program; later loads extend it.
+ *
+ * @param offset Position of @p data in the code buffer.
+ * @param data Bytecode.
+ * @param len Number of bytes.
+ * @return kOk, kInvalidArgument if the data does not fit, kError while a
+ *     script is running.
+ */
+ReturnCode VmLoad(uint16_t offset, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Starts the loaded program from its first byte.
+ *
+ * @param console Session receiving the script output and running its
+ *     commands.
+ * @return kOk, kEmpty if no program is loaded, kError if already running.
+ */
+ReturnCode VmRun(Console* console);
+
+/**
+ * @brief Stops a running script.
+ */
+void VmStop(void);
+
+/**
+ * @brief Executes the next slice of the running script. Call from the
+ * main loop.
+ */
+void VmProcess(void);
+
+/**
+ * @brief Returns a snapshot of the interpreter state.
+ *
+ * @param status Destination.
+ */
+void VmGetStatus(VmStatus* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_VM_H_
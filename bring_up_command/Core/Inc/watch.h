@@ -0,0 +1,78 @@
+/**
+ * @file watch.h
+ * @brief Periodic re-execution of a command with change-only output.
+ *
+ * `watch <ms> <command...>` runs the command every @c ms milliseconds from
+ * the main loop with its output captured instead of sent. Each output line
+ * is compared with the last one sent for the same watch, and only lines
+ * that changed are sent, prefixed with the HAL tick of the sample:
+ *
+ *   [120533] PA5 = 1
+ *
+ * When the output gets shorter, each line it lost is reported with
+ * WATCH_REMOVED_MARK and its 1-based line number:
+ *
+ *   [120533] (removed) line 3
+ *
+ * Sampling can therefore run far faster than a host could poll, while the
+ * link only carries changes. When the link has no room for the changes
+ * the sample is skipped and the next one is compared against the last
+ * output actually sent, so changes are coalesced, never lost.
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_WATCH_H_
+#define SRC_WATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define WATCH_MAX          2    ///< Watches active at the same time
+#define WATCH_OUTPUT_SIZE  160  ///< Command output kept per watch
+#define WATCH_REMOVED_MARK "(removed) line"
+
+/**
+ * @brief Starts watching a command.
+ *
+ * @param console Session receiving the changes.
+ * @param period_ms Sampling period (at least 1 ms).
+ * @param command_line Command to run, as typed on the console.
+ * @return kOk, kFull if all watches are in use, kInvalidArgument for a bad
+ *     period or command line, or for a command that finishes after it
+ *     returns (selftest, linktest, vm run, dump, profile dump) or takes
+ *     over the session (watch, mux).
+ */
+ReturnCode WatchStart(Console* console, uint32_t period_ms, const char* command_line);
+
+/**
+ * @brief Stops the watches of a session.
+ *
+ * @param console Session whose watches are cancelled.
+ * @return Number of watches stopped.
+ */
+uint8_t WatchStop(const Console* console);
+
+/**
+ * @brief Lists the active watches on a session.
+ *
+ * @param console Destination session.
+ */
+void WatchReport(Console* console);
+
+/**
+ * @brief Runs the watches that are due. Call from the main loop.
+ */
+void WatchProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_WATCH_H_
@@ -0,0 +1,96 @@
+/**
+ * @file xfer.h
+ * @brief Windowed, selectively acknowledged bulk transfer into RAM or
+ * flash over the mux data channel.
+ *
+ * The host splits a blob into numbered chunks and keeps up to
+ * XFER_MAX_WINDOW of them in flight. Every chunk carries its own CRC; a
+ * chunk that fails it, or arrives with no room to take it, is dropped and
+ * simply not acknowledged. Acknowledgements are selective: the first
+ * chunk still missing plus a bitmap of the XFER_MAX_WINDOW chunks after
+ * it, so the host resends exactly the holes (tools/xfer.py). Acks are
+ * coalesced to one per main loop pass.
+ *
+ * Targets:
+ * - XFER_TARGET_RAM: the scratch RAM left free in the module area; the
+ *   address is an offset into it. Chunks are copied straight to their
+ *   place, in any order. The transfer claims the area (ModuleAreaClaim())
+ *   from OPEN until the CLOSE check or the next OPEN, so module uploads
+ *   and other users wait for it.
+ * - XFER_TARGET_FLASH: program memory after the firmware image. The
+ *   pages are erased when the transfer opens; chunks are assembled into
+ *   half-page buffers that are programmed from XferProcess() (64 bytes
+ *   per 3.2 ms flash cycle) as they fill up.
+ *
+ * Messages on MUX_CH_DATA (first payload byte):
+ *
+ *   host to device:  XFER_MSG_OPEN  | target | address_le32 | length_le32 | chunk_size
+ *                    XFER_MSG_CHUNK | seq_le16 | crc16_le | data[chunk_size]
+ *                    XFER_MSG_CLOSE | crc16_le (of the whole blob)
+ *   device to host:  XFER_MSG_ACK   | message | ReturnCode | next_le16 | bitmap_le32
+ *
+ * @c next is the first chunk not received yet and bit i of @c bitmap
+ * stands for chunk next + 1 + i. The OPEN ack comes once the flash is
+ * erased and carries the absolute start address in @c bitmap; the CLOSE
+ * ack comes once everything is programmed and the CRC of the target
+ * memory has been checked. CRCs are CRC-16/CCITT-FALSE. Other messages on
+ * the channel go on to the handler registered before XferInit().
+ *
+ * @date Oct 18, 2025
+ * @author
+ *   Rodrigo Che
+ */
+
+#ifndef SRC_XFER_H_
+#define SRC_XFER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "console.h"
+
+#define XFER_MSG_OPEN    0x30
+#define XFER_MSG_CHUNK   0x31
+#define XFER_MSG_CLOSE   0x32
+#define XFER_MSG_ACK     0x33
+
+#define XFER_TARGET_RAM   0
+#define XFER_TARGET_FLASH 1
+
+#define XFER_MAX_CHUNK    56  ///< Mux payload less the CHUNK header
+#define XFER_MAX_WINDOW   32  ///< Chunks acknowledged beyond the first hole
+
+/**
+ * @brief Half-page buffers for flash transfers; chunks that need a buffer
+ * while all are waiting to be programmed are dropped (and resent).
+ */
+#ifndef XFER_FLASH_BUFFERS
+#define XFER_FLASH_BUFFERS 8
+#endif
+
+/**
+ * @brief Attaches the protocol to the mux data channel. Call after every
+ * other user of the channel has registered.
+ */
+void XferInit(void);
+
+/**
+ * @brief Prints the state of the current or last transfer.
+ *
+ * @param console Destination session.
+ */
+void XferReport(Console* console);
+
+/**
+ * @brief Erases, programs flash and sends acknowledgements. Call from the
+ * main loop.
+ */
+void XferProcess(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_XFER_H_
@@ -0,0 +1,202 @@
+// clock_gate.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Reference-counted RCC clock gating with residency statistics
+// (see clock_gate.h).
+
+#include "clock_gate.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CLOCK_GATE_MAX_REFS  255U
+
+typedef enum {
+  kBusIop = 0,
+  kBusAhb,
+  kBusApb2,
+  kBusApb1
+} ClockGateBus;
+
+typedef struct {
+  const char* name;
+  uint8_t bus;
+  uint32_t bit;    ///< Same position in the enable and sleep enable registers
+  uint8_t owned;   ///< Referenced by its driver: stopped, not adopted, at init
+} ClockGateEntry;
+
+static const ClockGateEntry kClocks[kClockGateCount] = {
+    [kClockGateGpioA]   = {"gpioa",   kBusIop,  RCC_IOPENR_GPIOAEN},
+    [kClockGateGpioB]   = {"gpiob",   kBusIop,  RCC_IOPENR_GPIOBEN},
+    [kClockGateGpioC]   = {"gpioc",   kBusIop,  RCC_IOPENR_GPIOCEN},
+    [kClockGateGpioD]   = {"gpiod",   kBusIop,  RCC_IOPENR_GPIODEN},
+    [kClockGateGpioE]   = {"gpioe",   kBusIop,  RCC_IOPENR_GPIOEEN},
+    [kClockGateGpioH]   = {"gpioh",   kBusIop,  RCC_IOPENR_GPIOHEN},
+    [kClockGateDma1]    = {"dma1",    kBusAhb,  RCC_AHBENR_DMA1EN, 1},
+    [kClockGateCrc]     = {"crc",     kBusAhb,  RCC_AHBENR_CRCEN},
+    [kClockGateUsart1]  = {"usart1",  kBusApb2, RCC_APB2ENR_USART1EN, 1},
+    [kClockGateUsart2]  = {"usart2",  kBusApb1, RCC_APB1ENR_USART2EN, 1},
+    [kClockGateLpuart1] = {"lpuart1", kBusApb1, RCC_APB1ENR_LPUART1EN, 1},
+    [kClockGateTim2]    = {"tim2",    kBusApb1, RCC_APB1ENR_TIM2EN},
+    [kClockGateTim6]    = {"tim6",    kBusApb1, RCC_APB1ENR_TIM6EN},
+    [kClockGateTim21]   = {"tim21",   kBusApb2, RCC_APB2ENR_TIM21EN},
+    [kClockGateSpi1]    = {"spi1",    kBusApb2, RCC_APB2ENR_SPI1EN},
+    [kClockGateI2c1]    = {"i2c1",    kBusApb1, RCC_APB1ENR_I2C1EN},
+    [kClockGateSyscfg]  = {"syscfg",  kBusApb2, RCC_APB2ENR_SYSCFGEN},
+    [kClockGatePwr]     = {"pwr",     kBusApb1, RCC_APB1ENR_PWREN},
+    [kClockGateDbgmcu]  = {"dbgmcu",  kBusApb2, RCC_APB2ENR_DBGMCUEN},
+};
+
+typedef struct {
+  uint8_t run_refs;
+  uint8_t sleep_refs;
+  uint8_t boot;          ///< Adopted from the CubeMX initialization
+  uint32_t on_since_ms;  ///< Tick of the last enable
+  uint32_t on_total_ms;  ///< Time on before it, since the stats start
+} ClockGateState;
+
+static struct {
+  uint32_t stats_start_ms;
+  ClockGateState clocks[kClockGateCount];
+} gate;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static volatile uint32_t* ClockGateEnableReg(uint8_t bus) {
+  switch (bus) {
+    case kBusIop:  return &RCC->IOPENR;
+    case kBusAhb:  return &RCC->AHBENR;
+    case kBusApb2: return &RCC->APB2ENR;
+    default:       return &RCC->APB1ENR;
+  }
+}
+
+static volatile uint32_t* ClockGateSleepReg(uint8_t bus) {
+  switch (bus) {
+    case kBusIop:  return &RCC->IOPSMENR;
+    case kBusAhb:  return &RCC->AHBSMENR;
+    case kBusApb2: return &RCC->APB2SMENR;
+    default:       return &RCC->APB1SMENR;
+  }
+}
+
+/**
+ * @brief Time @p state has been on since the stats start, up to @p now.
+ */
+static uint32_t ClockGateOnTime(const ClockGateState* state, uint32_t now) {
+  return state->on_total_ms + ((state->run_refs != 0) ? (now - state->on_since_ms) : 0U);
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void ClockGateInit(void) {
+  uint32_t now = HAL_GetTick();
+
+  memset(&gate, 0, sizeof(gate));
+  gate.stats_start_ms = now;
+  for (int i = 0; i < kClockGateCount; ++i) {
+    const ClockGateEntry* entry = &kClocks[i];
+    ClockGateState* state = &gate.clocks[i];
+
+    if (entry->owned) {
+      // Registers keep their contents while the clock is off
+      *ClockGateEnableReg(entry->bus) &= ~entry->bit;
+      *ClockGateSleepReg(entry->bus) &= ~entry->bit;
+    } else if (*ClockGateEnableReg(entry->bus) & entry->bit) {
+      state->run_refs = 1;
+      state->sleep_refs = 1;
+      state->boot = 1;
+      state->on_since_ms = now;
+      *ClockGateSleepReg(entry->bus) |= entry->bit;
+    } else {
+      *ClockGateSleepReg(entry->bus) &= ~entry->bit;
+    }
+  }
+}
+
+ReturnCode ClockGateAcquire(ClockGateId id, uint8_t in_sleep) {
+  if ((unsigned)id >= kClockGateCount) {
+    return kInvalidArgument;
+  }
+  const ClockGateEntry* entry = &kClocks[id];
+  ClockGateState* state = &gate.clocks[id];
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ((state->run_refs == CLOCK_GATE_MAX_REFS) || (state->sleep_refs == CLOCK_GATE_MAX_REFS)) {
+    __set_PRIMASK(primask);
+    return kFull;
+  }
+  if (state->run_refs++ == 0) {
+    state->on_since_ms = HAL_GetTick();
+    *ClockGateEnableReg(entry->bus) |= entry->bit;
+    (void)*ClockGateEnableReg(entry->bus);  // Read back: the clock is on before first use
+  }
+  if (in_sleep && (state->sleep_refs++ == 0)) {
+    *ClockGateSleepReg(entry->bus) |= entry->bit;
+  }
+  __set_PRIMASK(primask);
+  return kOk;
+}
+
+ReturnCode ClockGateRelease(ClockGateId id, uint8_t in_sleep) {
+  if ((unsigned)id >= kClockGateCount) {
+    return kInvalidArgument;
+  }
+  const ClockGateEntry* entry = &kClocks[id];
+  ClockGateState* state = &gate.clocks[id];
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ((state->run_refs == 0) || (in_sleep && (state->sleep_refs == 0))) {
+    __set_PRIMASK(primask);
+    return kInvalidArgument;
+  }
+  if (in_sleep && (--state->sleep_refs == 0)) {
+    *ClockGateSleepReg(entry->bus) &= ~entry->bit;
+  }
+  if (--state->run_refs == 0) {
+    *ClockGateEnableReg(entry->bus) &= ~entry->bit;
+    state->on_total_ms += HAL_GetTick() - state->on_since_ms;
+  }
+  __set_PRIMASK(primask);
+  return kOk;
+}
+
+void ClockGateResetStats(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t now = HAL_GetTick();
+
+  gate.stats_start_ms = now;
+  for (int i = 0; i < kClockGateCount; ++i) {
+    gate.clocks[i].on_total_ms = 0;
+    gate.clocks[i].on_since_ms = now;
+  }
+  __set_PRIMASK(primask);
+}
+
+void ClockGateReport(Console* console) {
+  uint32_t now = HAL_GetTick();
+  uint32_t elapsed = now - gate.stats_start_ms;
+  char line[64];
+
+  snprintf(line, sizeof(line), "Over the last %lu ms:\r\n", (unsigned long)elapsed);
+  ConsolePrint(console, line);
+  ConsolePrint(console, "  clock    refs  sleep       on ms     %\r\n");
+  for (int i = 0; i < kClockGateCount; ++i) {
+    const ClockGateState* state = &gate.clocks[i];
+    uint32_t on_ms = ClockGateOnTime(state, now);
+    uint32_t percent = (elapsed == 0) ? ((state->run_refs != 0) ? 100U : 0U)
+                                      : (uint32_t)((uint64_t)on_ms * 100U / elapsed);
+
+    snprintf(line, sizeof(line), "  %-7s  %4u%c %5u  %10lu  %3lu\r\n", kClocks[i].name,
+             (unsigned)state->run_refs, state->boot ? '*' : ' ', (unsigned)state->sleep_refs,
+             (unsigned long)on_ms, (unsigned long)percent);
+    ConsolePrint(console, line);
+  }
+  ConsolePrint(console, "(* includes the boot reference)\r\n");
+}
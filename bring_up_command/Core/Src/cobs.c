@@ -0,0 +1,54 @@
+// cobs.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Consistent Overhead Byte Stuffing encoder/decoder.
+
+#include "cobs.h"
+
+uint16_t CobsEncode(const uint8_t* src, uint16_t len, uint8_t* dst) {
+  uint16_t code_pos = 0;  // Where the current block's code byte goes
+  uint16_t out = 1;
+  uint8_t code = 1;
+
+  for (uint16_t i = 0; i < len; ++i) {
+    if (src[i] == 0) {
+      dst[code_pos] = code;
+      code_pos = out++;
+      code = 1;
+    } else {
+      dst[out++] = src[i];
+      if (++code == 0xFF) {
+        // Maximum block length reached, start a new block
+        dst[code_pos] = code;
+        code_pos = out++;
+        code = 1;
+      }
+    }
+  }
+  dst[code_pos] = code;
+
+  return out;
+}
+
+int CobsDecode(uint8_t* buf, uint16_t len, uint16_t* out_len) {
+  uint16_t in = 0;
+  uint16_t out = 0;
+
+  while (in < len) {
+    uint8_t code = buf[in++];
+    if ((code == 0) || ((uint16_t)(in + code - 1) > len)) {
+      return -1;
+    }
+    for (uint8_t i = 1; i < code; ++i) {
+      buf[out++] = buf[in++];
+    }
+    // A short block stands for a zero, except at the very end
+    if ((code < 0xFF) && (in < len)) {
+      buf[out++] = 0;
+    }
+  }
+
+  *out_len = out;
+  return 0;
+}
@@ -2,24 +2,194 @@
 // Created on: Sep 30, 2025
 // Author: Rodrigo Che
 //
-// Command parser implementation for UART console commands.
+// Command parser implementation for console commands.
 
 #include "command.h"
-#include "main.h"       // For HAL_GPIO_WritePin, etc.
+#include "main.h"       // For LD2_Pin, GPIOx, etc.
+#include "clock_gate.h"
+#include "command_args.h"
+#include "dma_copy.h"
+#include "dump.h"
+#include "fastmem.h"
 #include "fw_version.h"
+#include "governor.h"
+#include "linktest.h"
+#include "loop_monitor.h"
+#include "module.h"
+#include "mux.h"
+#include "profiler.h"
+#include "reg.h"
+#include "rs485.h"
+#include "selftest.h"
+#include "timesync.h"
+#include "trace.h"
+#include "vm.h"
+#include "watch.h"
+#include "xfer.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-extern UART_HandleTypeDef huart2;  // Declared in main.c
-
 // -----------------------------------------------------------------------------
 // Internal function prototypes
 // -----------------------------------------------------------------------------
-static void CmdLedOn();
-static void CmdLedOff();
-static void CmdVersion();
-static void CmdHelp();
-static void ConsolePrint(const char* str);
+static void CmdLedOn(Console* console, int argc, char* argv[]);
+static void CmdLedOff(Console* console, int argc, char* argv[]);
+static void CmdVersion(Console* console, int argc, char* argv[]);
+static void CmdHelp(Console* console, int argc, char* argv[]);
+static void CmdMux(Console* console, int argc, char* argv[]);
+static void CmdModule(Console* console, int argc, char* argv[]);
+static void CmdSelftest(Console* console, int argc, char* argv[]);
+static void CmdXfer(Console* console, int argc, char* argv[]);
+static void CmdMembench(Console* console, int argc, char* argv[]);
+static void CmdDmabench(Console* console, int argc, char* argv[]);
+static void CmdRegbench(Console* console, int argc, char* argv[]);
+static void CmdClocks(Console* console, int argc, char* argv[]);
+
+// -----------------------------------------------------------------------------
+// Typed commands: argument structs, decoders and usage generated from the
+// lists below (see command_args.h)
+// -----------------------------------------------------------------------------
+static const char* const kDumpModes[] = {"raw", "lz", NULL};
+static const char* const kWidths[] = {"w", "h", "b", NULL};  // 4 >> index bytes
+static const char* const kPerfOrders[] = {"total", "count", "max", "bytes", "reset", NULL};
+static const char* const kProfileOps[] = {"show", "start", "stop", "dump", "reset", NULL};
+static const char* const kStopWord[] = {"stop", NULL};
+static const char* const kVmOps[] = {"status", "load", "run", "stop", NULL};
+static const char* const kPrbsOrders[] = {"7", "15", "31", NULL};       // (8 << index) - 1
+static const char* const kLinktestModes[] = {"host", "loop", "ext", NULL};  // LinktestMode
+static const char* const kRs485Ops[] = {"show", "addr", "on", "off", NULL};
+static const char* const kTimeOps[] = {"show", "sync", "pulse", "reset", NULL};
+static const char* const kStallOps[] = {"show", "reset", "threshold", NULL};
+static const char* const kGovOps[] = {"show", "auto", "fixed", "tune", "boost", NULL};
+static const char* const kGovPoints[] = {"msi4", "hsi16", "pll32", NULL};  // GovernorPoint
+
+typedef enum {
+  kPerfByTotal = 0,
+  kPerfByCount,
+  kPerfByMax,
+  kPerfByBytes,
+  kPerfReset
+} PerfOrder;
+
+typedef enum {
+  kProfileShow = 0,
+  kProfileStart,
+  kProfileStop,
+  kProfileDump,
+  kProfileReset
+} ProfileOp;
+
+typedef enum {
+  kVmOpStatus = 0,
+  kVmOpLoad,
+  kVmOpRun,
+  kVmOpStop
+} VmOp;
+
+typedef enum {
+  kRs485OpShow = 0,
+  kRs485OpAddr,
+  kRs485OpOn,
+  kRs485OpOff
+} Rs485Op;
+
+typedef enum {
+  kTimeOpShow = 0,
+  kTimeOpSync,
+  kTimeOpPulse,
+  kTimeOpReset
+} TimeOp;
+
+typedef enum {
+  kStallOpShow = 0,
+  kStallOpReset,
+  kStallOpThreshold
+} StallOp;
+
+typedef enum {
+  kGovOpShow = 0,
+  kGovOpAuto,
+  kGovOpFixed,
+  kGovOpTune,
+  kGovOpBoost
+} GovOp;
+
+#define GPIO_ARGS(ARG, T)                             \
+  ARG(T, REQ, pin,   Str,  0, 0,          NULL)       \
+  ARG(T, OPT, level, U8,   0, 1,          NULL)
+#define DUMP_ARGS(ARG, T)                             \
+  ARG(T, REQ, addr,  U32,  0, UINT32_MAX, NULL)       \
+  ARG(T, REQ, len,   U32,  1, UINT32_MAX, NULL)       \
+  ARG(T, OPT, mode,  Enum, 0, 0,          kDumpModes)
+#define PEEK_ARGS(ARG, T)                             \
+  ARG(T, REQ, addr,  U32,  0, UINT32_MAX, NULL)       \
+  ARG(T, REQ, count, U16,  1, 16,         NULL)       \
+  ARG(T, OPT, width, Enum, 0, 0,          kWidths)
+#define POKE_ARGS(ARG, T)                             \
+  ARG(T, REQ, addr,  U32,  0, UINT32_MAX, NULL)       \
+  ARG(T, REQ, value, U32,  0, UINT32_MAX, NULL)       \
+  ARG(T, OPT, width, Enum, 0, 0,          kWidths)
+
+#define PERF_ARGS(ARG, T)                             \
+  ARG(T, OPT, by,    Enum, 0, 0,          kPerfOrders)
+#define PROFILE_ARGS(ARG, T)                          \
+  ARG(T, OPT, op,    Enum, 0, 0,          kProfileOps) \
+  ARG(T, OPT, hz,    U16,  1, PROFILER_MAX_HZ, NULL)
+
+#define VM_ARGS(ARG, T)                                   \
+  ARG(T, OPT, op,      Enum, 0, 0,            kVmOps)     \
+  ARG(T, OPT, offset,  U16,  0, VM_CODE_SIZE, NULL)       \
+  ARG(T, OPT, hex,     Str,  0, 0,            NULL)
+#define WATCH_ARGS(ARG, T)                                \
+  ARG(T, KEY, stop,    Enum, 0, 0,            kStopWord)  \
+  ARG(T, OPT, ms,      U32,  1, UINT32_MAX,   NULL)       \
+  ARG(T, OPT, command, Line, 0, 0,            NULL)
+#define LINKTEST_ARGS(ARG, T)                             \
+  ARG(T, KEY, stop,    Enum, 0, 0,            kStopWord)  \
+  ARG(T, OPT, port,    Str,  0, 0,            NULL)       \
+  ARG(T, OPT, baud,    U32,  1, UINT32_MAX,   NULL)       \
+  ARG(T, OPT, order,   Enum, 0, 0,            kPrbsOrders) \
+  ARG(T, OPT, ms,      U32,  1, UINT32_MAX,   NULL)       \
+  ARG(T, OPT, mode,    Enum, 0, 0,            kLinktestModes)
+#define RS485_ARGS(ARG, T)                                \
+  ARG(T, OPT, op,      Enum, 0, 0,            kRs485Ops)  \
+  ARG(T, OPT, addr,    U8,   0, RS485_MAX_ADDRESS, NULL)
+#define TIME_ARGS(ARG, T)                                 \
+  ARG(T, OPT, op,      Enum, 0, 0,            kTimeOps)   \
+  ARG(T, OPT, ref_us,  I64,  INT64_MIN, INT64_MAX, NULL)
+#define STALL_ARGS(ARG, T)                                \
+  ARG(T, OPT, op,      Enum, 0, 0,            kStallOps)  \
+  ARG(T, OPT, ms,      U32,  1, UINT32_MAX,   NULL)
+// value: up% for tune, ms for boost
+#define GOV_ARGS(ARG, T)                                  \
+  ARG(T, OPT, op,      Enum, 0, 0,            kGovOps)    \
+  ARG(T, KEY, point,   Enum, 0, 0,            kGovPoints) \
+  ARG(T, OPT, value,   U32,  1, UINT32_MAX,   NULL)       \
+  ARG(T, OPT, down,    U8,   0, 100,          NULL)       \
+  ARG(T, OPT, windows, U16,  1, UINT16_MAX,   NULL)
+
+#define TYPED_COMMANDS(X)                                                        \
+  X(Gpio, "gpio", GPIO_ARGS, "read or drive a pin (e.g. a5).")                   \
+  X(Dump, "dump", DUMP_ARGS, "stream memory on the mux data channel.")           \
+  X(Peek, "peek", PEEK_ARGS, "read 1-16 values, width w|h|b (default w).")       \
+  X(Poke, "poke", POKE_ARGS, "write RAM or a register, width w|h|b.")            \
+  X(Perf, "perf", PERF_ARGS, "time and output per command, by total|count|max|bytes, or reset.") \
+  X(Profile, "profile", PROFILE_ARGS, "PC sampling: show|start [hz]|stop|dump|reset.") \
+  X(Vm, "vm", VM_ARGS, "bytecode scripts: load <off> <hex>|run|stop|status.")      \
+  X(Watch, "watch", WATCH_ARGS, "rerun a command every ms showing changes only, or stop.") \
+  X(Linktest, "linktest", LINKTEST_ARGS, "PRBS test: <port> <baud> <7|15|31> <ms> "  \
+    "[host|loop|ext], or stop.")                                                     \
+  X(Rs485, "rs485", RS485_ARGS, "multi-drop bus mode: show|addr <0-127>|on|off.")  \
+  X(Time, "time", TIME_ARGS, "timebase: show|sync <ref_us>|pulse <ref_us>|reset.") \
+  X(Stall, "stall", STALL_ARGS, "loop timing, slowest commands: show|reset|threshold <ms>.") \
+  X(Gov, "gov", GOV_ARGS, "clock governor: show|auto|fixed <point>|"                \
+    "tune <up%> <down%> <windows>|boost <ms>.")
+
+TYPED_COMMANDS(COMMAND_TYPED_DECLARE)
+TYPED_COMMANDS(COMMAND_TYPED_DEFINE)
+
+static const CommandTyped* const kTypedCommands[] = {TYPED_COMMANDS(COMMAND_TYPED_REF)};
 
 // -----------------------------------------------------------------------------
 // Command table (acts as the "registry" for the command pattern)
@@ -28,60 +198,841 @@ static const Command kCommands[] = {
     {"led-on",   CmdLedOn,   "Turn on the user LED (LD2)."},
     {"led-off",  CmdLedOff,  "Turn off the user LED (LD2)."},
     {"version",  CmdVersion, "Show firmware version."},
+    {"mux",      CmdMux,     "Switch this port to multiplexed channels."},
+    {"module",   CmdModule,  "module [list] | unload [name]: loaded modules."},
+    {"selftest", CmdSelftest, "selftest [list | <step...>]: run board checks."},
+    {"xfer",     CmdXfer,    "Show the state of the last bulk transfer."},
+    {"membench", CmdMembench, "membench <memcpy|memset|strlen|strcmp>: cycles vs newlib."},
+    {"dmabench", CmdDmabench, "Compare CPU and DMA copy cycles by size."},
+    {"regbench", CmdRegbench, "Compare HAL and register layer cycles for pins and flags."},
+    {"clocks",   CmdClocks,  "clocks [reset]: peripheral clock references and on-time."},
+    TYPED_COMMANDS(COMMAND_TYPED_ENTRY)  // Last but one: see COMMAND_TYPED_FIRST
     {"help",     CmdHelp,    "Show this help message."}
 };
 
 static const int kNumCommands = sizeof(kCommands) / sizeof(kCommands[0]);
 
+/**
+ * @brief Index in kCommands of the first typed command, so a binary call
+ * finds its perf slot without a name search. The typed entries come in
+ * kTypedCommands order just before "help".
+ */
+#define COMMAND_TYPED_FIRST                         \
+  (sizeof(kCommands) / sizeof(kCommands[0]) - 1U - \
+   sizeof(kTypedCommands) / sizeof(kTypedCommands[0]))
+
+/**
+ * @brief Counter slots: one per table entry, then one shared by the
+ * commands of loaded modules.
+ */
+#define COMMAND_PERF_SLOTS (sizeof(kCommands) / sizeof(kCommands[0]) + 1U)
+
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t bytes;     ///< Output written to the issuing session
+  uint64_t total_us;
+} CommandPerf;
+
+static CommandPerf perf[COMMAND_PERF_SLOTS];
+
+static MuxReceiveFn next_receiver;  ///< Earlier user of the data channel
+
+static struct {
+  uint8_t valid;
+  uint8_t reply[7];  ///< REPLY message of the last binary call or line
+} last_call;
+
 // -----------------------------------------------------------------------------
 // Internal helper functions
 // -----------------------------------------------------------------------------
 /**
- * @brief Sends a string over UART (blocking).
- *
- * @param str Null-terminated string to send.
+ * @brief Adds one run to the counters of a command (on every dispatch).
  */
-static void ConsolePrint(const char* str) {
-  HAL_UART_Transmit(&huart2, (uint8_t*)str, strlen(str), HAL_MAX_DELAY);
+static inline void CommandPerfCharge(uint32_t slot, uint32_t elapsed_us, uint32_t bytes) {
+  CommandPerf* entry = &perf[slot];
+
+  if ((entry->count == 0) || (elapsed_us < entry->min_us)) {
+    entry->min_us = elapsed_us;
+  }
+  if (elapsed_us > entry->max_us) {
+    entry->max_us = elapsed_us;
+  }
+  entry->count++;
+  entry->total_us += elapsed_us;
+  entry->bytes += bytes;
 }
 
 /**
  * @brief Command: Turn LED on.
  */
-static void CmdLedOn() {
-  HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, GPIO_PIN_SET);
-  ConsolePrint("LED ON\r\n");
+static void CmdLedOn(Console* console, int argc, char* argv[]) {
+  RegPinSet(REG_PIN(LD2_GPIO_Port, LD2_Pin));
+  ConsolePrint(console, "LED ON\r\n");
 }
 
 /**
  * @brief Command: Turn LED off.
  */
-static void CmdLedOff() {
-  HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, GPIO_PIN_RESET);
-  ConsolePrint("LED OFF\r\n");
+static void CmdLedOff(Console* console, int argc, char* argv[]) {
+  RegPinClear(REG_PIN(LD2_GPIO_Port, LD2_Pin));
+  ConsolePrint(console, "LED OFF\r\n");
 }
 
 /**
  * @brief Command: Show firmware version.
  */
-static void CmdVersion() {
+static void CmdVersion(Console* console, int argc, char* argv[]) {
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "Firmware V%s\r\n", FW_VERSION);
-  ConsolePrint(buffer);
+  ConsolePrint(console, buffer);
+}
+
+/**
+ * @brief Prints the help line of one command.
+ */
+static void PrintHelpLine(Console* console, const Command* command) {
+  char buffer[128];
+  snprintf(buffer, sizeof(buffer), "%-10s: %s\r\n", command->name, command->help_text);
+  ConsolePrint(console, buffer);
 }
 
 /**
  * @brief Command: Show list of available commands.
  */
-static void CmdHelp() {
-  ConsolePrint("--- Available Commands ---\r\n");
+static void CmdHelp(Console* console, int argc, char* argv[]) {
+  ConsolePrint(console, "--- Available Commands ---\r\n");
   for (int i = 0; i < kNumCommands; ++i) {
-    char buffer[128];
-    snprintf(buffer, sizeof(buffer), "%-10s: %s\r\n",
-             kCommands[i].name, kCommands[i].help_text);
-    ConsolePrint(buffer);
+    PrintHelpLine(console, &kCommands[i]);
+  }
+  for (uint8_t i = 0; i < ModuleCount(); ++i) {
+    const ModuleDescriptor* module = ModuleAt(i);
+    for (uint16_t k = 0; k < module->num_commands; ++k) {
+      PrintHelpLine(console, &module->commands[k]);
+    }
+  }
+  ConsolePrint(console, "---------------------------\r\n");
+}
+
+/**
+ * @brief Command: Switch the issuing link to virtual channel frames.
+ *
+ * The acknowledgement is the last text sent on the link; everything after
+ * it is framed (see mux.h).
+ */
+static void CmdMux(Console* console, int argc, char* argv[]) {
+  if (MuxIsActive()) {
+    ConsolePrint(console, "Mux already active.\r\n");
+    return;
+  }
+  ConsolePrint(console, "MUX ON\r\n");
+  MuxStart(console);
+}
+
+/**
+ * @brief Parses a pin name such as "a5" or "PC13".
+ *
+ * @return 1 on success, 0 if the name is not a pin of this device.
+ */
+static uint8_t ParsePin(const char* name, GPIO_TypeDef** port, uint8_t* pin,
+                        uint8_t* port_index) {
+  static GPIO_TypeDef* const kPorts[] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOE,
+                                         NULL, NULL, GPIOH};
+  // Port H has only the oscillator pins PH0 and PH1 on this part
+  static const uint16_t kPins[] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0, 0, 0x0003};
+  char* end = NULL;
+
+  if ((name[0] == 'p') || (name[0] == 'P')) {
+    name++;
+  }
+  uint8_t index = (uint8_t)((name[0] | 0x20) - 'a');
+  if ((index >= sizeof(kPorts) / sizeof(kPorts[0])) || (kPorts[index] == NULL)) {
+    return 0;
+  }
+  unsigned long number = strtoul(&name[1], &end, 10);
+  if ((end == &name[1]) || (*end != '\0') || (number > 15) ||
+      !(kPins[index] & (1U << number))) {
+    return 0;
+  }
+
+  *port = kPorts[index];
+  *pin = (uint8_t)number;
+  *port_index = index;
+  return 1;
+}
+
+/**
+ * @brief Command: Read a pin, or drive it as an output.
+ *
+ * Pins in alternate function mode belong to a peripheral and are only
+ * read. The level read back is the command result.
+ */
+static void CmdGpio(Console* console, const GpioArgs* args) {
+  static const ClockGateId kPortClocks[] = {kClockGateGpioA, kClockGateGpioB, kClockGateGpioC,
+                                            kClockGateGpioD, kClockGateGpioE, kClockGateCount,
+                                            kClockGateCount, kClockGateGpioH};
+  static uint8_t ports_held;  // One reference per port, kept for good
+  GPIO_TypeDef* port = NULL;
+  uint8_t pin = 0;
+  uint8_t port_index = 0;
+  char buffer[32];
+
+  if (!ParsePin(args->pin, &port, &pin, &port_index)) {
+    ConsolePrint(console, "Unknown pin (a0-e15, h0, h1).\r\n");
+    return;
+  }
+  if ((ports_held & (1U << port_index)) == 0) {
+    ClockGateAcquire(kPortClocks[port_index], 0);
+    ports_held |= (uint8_t)(1U << port_index);
+  }
+
+  if (args->argc == 2) {
+    uint32_t mode = (port->MODER >> (pin * 2U)) & 3U;
+    if (mode == 2U) {
+      ConsolePrint(console, "Pin is used by a peripheral.\r\n");
+      return;
+    }
+    RegPinWrite(RegPinMake(port, pin), args->level);
+    port->MODER = (port->MODER & ~(3UL << (pin * 2U))) | (1UL << (pin * 2U));
+  }
+
+  console->result = (int32_t)RegPinRead(RegPinMake(port, pin));
+  snprintf(buffer, sizeof(buffer), "P%c%u = %ld\r\n", 'A' + port_index, pin,
+           (long)console->result);
+  ConsolePrint(console, buffer);
+}
+
+static int HexNibble(char c) {
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  c = (char)(c | 0x20);  // Lower case
+  return ((c >= 'a') && (c <= 'f')) ? (c - 'a' + 10) : -1;
+}
+
+/**
+ * @brief Decodes a hex string into @p out.
+ *
+ * @return Number of bytes, or -1 if the string is not valid hex or does
+ *     not fit @p size bytes.
+ */
+static int ParseHex(const char* hex, uint8_t* out, size_t size) {
+  size_t len = strlen(hex);
+
+  if (((len % 2) != 0) || ((len / 2) > size)) {
+    return -1;
+  }
+  for (size_t i = 0; i < len; i += 2) {
+    int high = HexNibble(hex[i]);
+    int low = HexNibble(hex[i + 1]);
+    if ((high < 0) || (low < 0)) {
+      return -1;
+    }
+    out[i / 2] = (uint8_t)((high << 4) | low);
+  }
+  return (int)(len / 2);
+}
+
+/**
+ * @brief Command: Load, run and inspect bytecode scripts (see vm.h).
+ */
+static void CmdVm(Console* console, const VmArgs* args) {
+  char buffer[96];
+  uint8_t code[CONSOLE_LINE_SIZE / 2];
+
+  if ((args->op == kVmOpLoad) ? (args->argc != 3) : (args->argc > 1)) {
+    CommandTypedUsage(console, &kVmTyped);
+    return;
+  }
+  switch (args->op) {
+    case kVmOpLoad: {
+      int len = ParseHex(args->hex, code, sizeof(code));
+      ReturnCode rc = (len < 0) ? kInvalidArgument : VmLoad(args->offset, code, (uint16_t)len);
+      if (rc == kOk) {
+        VmStatus status;
+        VmGetStatus(&status);
+        snprintf(buffer, sizeof(buffer), "VM loaded %d bytes, %u total\r\n",
+                 len, status.length);
+        ConsolePrint(console, buffer);
+      } else {
+        ConsolePrint(console, (rc == kError) ? "VM is running.\r\n" : "Bad load.\r\n");
+      }
+      break;
+    }
+    case kVmOpRun: {
+      ReturnCode rc = VmRun(console);
+      ConsolePrint(console, (rc == kOk) ? "VM running.\r\n" :
+                            (rc == kEmpty) ? "No program loaded.\r\n" :
+                                             "VM is running.\r\n");
+      break;
+    }
+    case kVmOpStop:
+      VmStop();
+      ConsolePrint(console, "VM stopped.\r\n");
+      break;
+    default: {
+      static const char* const kStates[] = {"idle", "running", "waiting"};
+      VmStatus status;
+      VmGetStatus(&status);
+      snprintf(buffer, sizeof(buffer),
+               "VM %s, %u bytes, crc 0x%04X, pc 0x%04X, sp %u, steps %lu%s%s\r\n",
+               kStates[status.state], status.length, status.crc, status.pc, status.sp,
+               (unsigned long)status.steps, status.error ? ", error: " : "",
+               status.error ? status.error : "");
+      ConsolePrint(console, buffer);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Command: List or unload command modules (see module.h).
+ */
+static void CmdModule(Console* console, int argc, char* argv[]) {
+  char buffer[64];
+  const char* sub = (argc > 1) ? argv[1] : "list";
+
+  if (strcmp(sub, "list") == 0) {
+    for (uint8_t i = 0; i < ModuleCount(); ++i) {
+      const ModuleDescriptor* module = ModuleAt(i);
+      snprintf(buffer, sizeof(buffer), "%-10s: %u commands\r\n", module->name,
+               module->num_commands);
+      ConsolePrint(console, buffer);
+    }
+    snprintf(buffer, sizeof(buffer), "Module area: %u of %u bytes used\r\n",
+             ModuleAreaUsed(), MODULE_AREA_SIZE);
+    ConsolePrint(console, buffer);
+  } else if ((strcmp(sub, "unload") == 0) && (argc <= 3)) {
+    ReturnCode rc = ModuleUnload((argc == 3) ? argv[2] : NULL);
+    ConsolePrint(console, (rc == kOk) ? "Module unloaded.\r\n" :
+                          (rc == kEmpty) ? "No module loaded.\r\n" :
+                                           "Only the last loaded module can be unloaded.\r\n");
+  } else {
+    ConsolePrint(console, "Usage: module [list] | unload [name]\r\n");
+  }
+}
+
+/**
+ * @brief Command: Rerun a command periodically, showing only changes
+ * (see watch.h).
+ */
+static void CmdWatch(Console* console, const WatchArgs* args) {
+  if (args->stop != 0) {
+    if (args->argc != 1) {
+      CommandTypedUsage(console, &kWatchTyped);
+      return;
+    }
+    ConsolePrint(console, (WatchStop(console) > 0) ? "Watch stopped.\r\n" :
+                                                     "No active watch.\r\n");
+    return;
+  }
+  if (args->argc == 0) {
+    WatchReport(console);
+    return;
+  }
+  if (args->argc != 2) {
+    CommandTypedUsage(console, &kWatchTyped);
+    return;
+  }
+
+  ReturnCode rc = WatchStart(console, args->ms, args->command);
+  ConsolePrint(console, (rc == kOk) ? "Watching; 'watch stop' to cancel.\r\n" :
+                        (rc == kFull) ? "Too many watches.\r\n" :
+                                        "Cannot watch that.\r\n");
+}
+
+/**
+ * @brief Command: Run the board self-test (the report follows when done).
+ */
+static void CmdSelftest(Console* console, int argc, char* argv[]) {
+  if ((argc == 2) && (strcmp(argv[1], "list") == 0)) {
+    SelftestList(console);
+    return;
+  }
+
+  ReturnCode rc = SelftestStart(console, (argc > 1) ? &argv[1] : NULL, argc - 1);
+  if (rc == kFull) {
+    ConsolePrint(console, "Self-test already running.\r\n");
+  } else if (rc != kOk) {
+    ConsolePrint(console, "Unknown step (see 'selftest list').\r\n");
+  }
+}
+
+/**
+ * @brief Command: PRBS bit error rate test of a UART link (see linktest.h).
+ */
+static void CmdLinktest(Console* console, const LinktestArgs* args) {
+  if (args->stop != 0) {
+    if (args->argc != 1) {
+      CommandTypedUsage(console, &kLinktestTyped);
+      return;
+    }
+    ConsolePrint(console, (LinktestStop() == kOk) ? "Link test stopping.\r\n" :
+                                                    "No link test running.\r\n");
+    return;
+  }
+  if (args->argc == 0) {
+    LinktestReport(console);
+    return;
+  }
+  if (args->argc < 4) {
+    CommandTypedUsage(console, &kLinktestTyped);
+    return;
+  }
+
+  // Mode defaults to host (index 0) when absent
+  ReturnCode rc = LinktestStart(console, args->port, args->baud,
+                                (uint8_t)((8U << args->order) - 1U), args->ms,
+                                (LinktestMode)args->mode);
+  if (rc == kOk) {
+    ConsolePrint(console, "Link test started.\r\n");
+  } else if (rc == kFull) {
+    ConsolePrint(console, "Link test already running.\r\n");
+  } else {
+    ConsolePrint(console, "Unknown port or baud rate.\r\n");
+  }
+}
+
+/**
+ * @brief Command: Show or change the RS-485 bus settings (see rs485.h).
+ */
+static void CmdRs485(Console* console, const Rs485Args* args) {
+  ReturnCode rc;
+
+  if ((args->op == kRs485OpAddr) ? (args->argc != 2) : (args->argc > 1)) {
+    CommandTypedUsage(console, &kRs485Typed);
+    return;
+  }
+  switch (args->op) {
+    case kRs485OpAddr:
+      rc = Rs485SetAddress(args->addr);  // Range checked already
+      break;
+    case kRs485OpOn:
+    case kRs485OpOff:
+      rc = Rs485Enable(args->op == kRs485OpOn);
+      break;
+    default:
+      rc = kOk;
+      break;
+  }
+
+  if (rc == kOk) {
+    Rs485Report(console);
+  } else {
+    ConsolePrint(console, "EEPROM write failed.\r\n");
+  }
+}
+
+/**
+ * @brief Command: Show or synchronize the timebase.
+ */
+static void CmdTime(Console* console, const TimeArgs* args) {
+  uint64_t local = TimesyncLocalMicros();  // Sync frame: the line was just received
+  uint8_t pair = (args->op == kTimeOpSync) || (args->op == kTimeOpPulse);
+
+  if (pair ? (args->argc != 2) : (args->argc > 1)) {
+    CommandTypedUsage(console, &kTimeTyped);
+    return;
+  }
+  if (args->op == kTimeOpReset) {
+    TimesyncReset();
+    ConsolePrint(console, "Timebase reset.\r\n");
+    return;
+  }
+  if ((args->op == kTimeOpPulse) && (TimesyncLastPulse(&local) != kOk)) {
+    ConsolePrint(console, "No recent sync pulse.\r\n");
+    return;
+  }
+  if (pair && (TimesyncAddPair(local, args->ref_us) != kOk)) {
+    CommandTypedUsage(console, &kTimeTyped);
+    return;
+  }
+  TimesyncReport(console);
+}
+
+/**
+ * @brief Command: Stream a memory range to the host.
+ */
+static void CmdDump(Console* console, const DumpArgs* args) {
+  ReturnCode rc = DumpStart(args->addr, args->len, (args->mode != 0) ? DUMP_FLAG_LZ : 0U);
+  if (rc == kOk) {
+    ConsolePrint(console, "Dump started.\r\n");
+  } else if (rc == kError) {
+    ConsolePrint(console, "Dump needs mux mode (data channel).\r\n");
+  } else if (rc == kFull) {
+    ConsolePrint(console, "A dump is already running.\r\n");
+  } else {
+    ConsolePrint(console, "Range not readable (peripherals: word aligned).\r\n");
+  }
+}
+
+/**
+ * @brief Checks an access of @p count values of @p size bytes: aligned,
+ * within one region, words only on peripherals, and writable if @p write.
+ */
+static uint8_t MemoryAccessAllowed(uint32_t address, uint32_t count, uint8_t size, uint8_t write) {
+  uint8_t access = 0;
+
+  if (((address & (size - 1U)) != 0) || (DumpCheckRange(address, count * size, &access) != kOk)) {
+    return 0;
+  }
+  if ((access & DUMP_ACCESS_WORDS) && (size != 4U)) {
+    return 0;
+  }
+  return (!write || (access & DUMP_ACCESS_WRITE)) ? 1U : 0U;
+}
+
+static uint32_t MemoryRead(uint32_t address, uint8_t size) {
+  if (size == 4U) {
+    return *(const volatile uint32_t*)(uintptr_t)address;
+  }
+  if (size == 2U) {
+    return *(const volatile uint16_t*)(uintptr_t)address;
+  }
+  return *(const volatile uint8_t*)(uintptr_t)address;
+}
+
+/**
+ * @brief Command: Read memory or registers. The first value is the
+ * command result.
+ */
+static void CmdPeek(Console* console, const PeekArgs* args) {
+  uint8_t size = (uint8_t)(4U >> args->width);
+  char buffer[16];
+
+  if (!MemoryAccessAllowed(args->addr, args->count, size, 0)) {
+    ConsolePrint(console, "Range not readable (aligned; peripherals: words).\r\n");
+    return;
+  }
+  for (uint16_t i = 0; i < args->count; ++i) {
+    uint32_t address = args->addr + (uint32_t)i * size;
+    uint32_t value = MemoryRead(address, size);
+
+    if (i == 0) {
+      console->result = (int32_t)value;
+    }
+    if ((i % 4U) == 0) {
+      snprintf(buffer, sizeof(buffer), "%s%08lX:", (i == 0) ? "" : "\r\n", (unsigned long)address);
+      ConsolePrint(console, buffer);
+    }
+    snprintf(buffer, sizeof(buffer), " %0*lX", size * 2, (unsigned long)value);
+    ConsolePrint(console, buffer);
+  }
+  ConsolePrint(console, "\r\n");
+}
+
+/**
+ * @brief Command: Write one value to RAM or a register. The value read
+ * back is the command result.
+ */
+static void CmdPoke(Console* console, const PokeArgs* args) {
+  uint8_t size = (uint8_t)(4U >> args->width);
+  char buffer[32];
+
+  if ((size < 4U) && ((args->value >> (size * 8U)) != 0)) {
+    ConsolePrint(console, "Value does not fit the width.\r\n");
+    return;
+  }
+  if (!MemoryAccessAllowed(args->addr, 1, size, 1)) {
+    ConsolePrint(console, "Address not writable (RAM, or peripheral words).\r\n");
+    return;
+  }
+  if (size == 4U) {
+    *(volatile uint32_t*)(uintptr_t)args->addr = args->value;
+  } else if (size == 2U) {
+    *(volatile uint16_t*)(uintptr_t)args->addr = (uint16_t)args->value;
+  } else {
+    *(volatile uint8_t*)(uintptr_t)args->addr = (uint8_t)args->value;
+  }
+  console->result = (int32_t)MemoryRead(args->addr, size);
+  snprintf(buffer, sizeof(buffer), "%08lX: %0*lX\r\n", (unsigned long)args->addr, size * 2,
+           (unsigned long)(uint32_t)console->result);
+  ConsolePrint(console, buffer);
+}
+
+/**
+ * @brief Command: Show the bulk transfer state.
+ */
+static void CmdXfer(Console* console, int argc, char* argv[]) {
+  XferReport(console);
+}
+
+static void CmdMembench(Console* console, int argc, char* argv[]) {
+  GovernorBoost(GOVERNOR_BOOST_MS);  // Cycle counts at the full clock
+  if ((argc != 2) || (FastmemBenchmark(console, argv[1]) != kOk)) {
+    ConsolePrint(console, "Usage: membench <memcpy|memset|strlen|strcmp>\r\n");
+  }
+}
+
+static void CmdDmabench(Console* console, int argc, char* argv[]) {
+  GovernorBoost(GOVERNOR_BOOST_MS);
+  if (DmaCopyBenchmark(console) != kOk) {
+    ConsolePrint(console, "Module area or DMA channel busy.\r\n");
+  }
+}
+
+static void CmdRegbench(Console* console, int argc, char* argv[]) {
+  GovernorBoost(GOVERNOR_BOOST_MS);
+  RegBenchmark(console);
+}
+
+static void CmdStall(Console* console, const StallArgs* args) {
+  if ((args->op == kStallOpThreshold) ? (args->argc != 2) : (args->argc > 1)) {
+    CommandTypedUsage(console, &kStallTyped);
+    return;
+  }
+  switch (args->op) {
+    case kStallOpReset:
+      LoopMonitorReset();
+      ConsolePrint(console, "Loop statistics cleared.\r\n");
+      break;
+    case kStallOpThreshold:
+      LoopMonitorSetThreshold(args->ms);  // ms > 0 checked already
+      break;
+    default:
+      LoopMonitorReport(console);
+      break;
+  }
+}
+
+static void CmdClocks(Console* console, int argc, char* argv[]) {
+  if ((argc == 2) && (strcmp(argv[1], "reset") == 0)) {
+    ClockGateResetStats();
+    ConsolePrint(console, "Clock statistics cleared.\r\n");
+    return;
+  }
+  if (argc != 1) {
+    ConsolePrint(console, "Usage: clocks [reset]\r\n");
+    return;
+  }
+  ClockGateReport(console);
+}
+
+static void CmdGov(Console* console, const GovArgs* args) {
+  static const uint8_t kGovArgc[] = {1, 1, 2, 4, 2};  // Words each op takes, by GovOp
+  ReturnCode rc = kOk;
+
+  if (((args->argc != 0) && (args->argc != kGovArgc[args->op])) ||
+      ((args->op == kGovOpFixed) != (args->point != 0))) {
+    CommandTypedUsage(console, &kGovTyped);
+    return;
+  }
+  switch (args->op) {
+    case kGovOpAuto:
+      GovernorSetAuto();
+      break;
+    case kGovOpFixed:
+      rc = GovernorSetFixed(kGovPoints[args->point - 1]);
+      if (rc == kInvalidArgument) {
+        ConsolePrint(console, "A port baud rate is not reachable at that point.\r\n");
+      } else if (rc != kOk) {
+        ConsolePrint(console, "Switch pending: ports busy or clock failed.\r\n");
+      }
+      return;
+    case kGovOpTune:
+      if (GovernorTune(args->value, args->down, args->windows) != kOk) {
+        ConsolePrint(console, "Tune needs down < up <= 100.\r\n");
+      }
+      return;
+    case kGovOpBoost:
+      rc = GovernorBoost(args->value);
+      break;
+    default:
+      break;
+  }
+  if (rc != kOk) {
+    ConsolePrint(console, "Switch pending: ports busy or clock failed.\r\n");
+  }
+  GovernorReport(console);
+}
+
+static uint64_t CommandPerfKey(const CommandPerf* entry, uint8_t by) {
+  switch (by) {
+    case kPerfByCount: return entry->count;
+    case kPerfByMax:   return entry->max_us;
+    case kPerfByBytes: return entry->bytes;
+    default:           return entry->total_us;
+  }
+}
+
+/**
+ * @brief Command: Per-command counters, largest first, or reset them.
+ */
+static void CmdPerf(Console* console, const PerfArgs* args) {
+  uint8_t order[COMMAND_PERF_SLOTS];
+  uint8_t used = 0;
+  char line[81];  // Widest row: 10-character name, every number at 10 digits
+
+  if (args->by == kPerfReset) {
+    memset(perf, 0, sizeof(perf));
+    ConsolePrint(console, "Command counters cleared.\r\n");
+    return;
+  }
+  for (uint8_t slot = 0; slot < COMMAND_PERF_SLOTS; ++slot) {
+    if (perf[slot].count == 0) {
+      continue;
+    }
+    uint64_t key = CommandPerfKey(&perf[slot], args->by);
+    uint8_t at = used++;
+    while ((at > 0) && (CommandPerfKey(&perf[order[at - 1]], args->by) < key)) {
+      order[at] = order[at - 1];
+      --at;
+    }
+    order[at] = slot;
+  }
+  if (used == 0) {
+    ConsolePrint(console, "No commands run.\r\n");
+    return;
+  }
+
+  ConsolePrint(console, "  command      count   total ms   mean us    min us    max us     bytes\r\n");
+  for (uint8_t i = 0; i < used; ++i) {
+    const CommandPerf* entry = &perf[order[i]];
+    const char* name = (order[i] < kNumCommands) ? kCommands[order[i]].name : "(modules)";
+
+    snprintf(line, sizeof(line), "  %-10s %7lu %10lu %9lu %9lu %9lu %9lu\r\n", name,
+             (unsigned long)entry->count, (unsigned long)(uint32_t)(entry->total_us / 1000U),
+             (unsigned long)(uint32_t)(entry->total_us / entry->count), (unsigned long)entry->min_us,
+             (unsigned long)entry->max_us, (unsigned long)entry->bytes);
+    ConsolePrint(console, line);
+  }
+  console->result = used;
+}
+
+/**
+ * @brief Command: PC-sampling profiler; `dump` streams the table for
+ * tools/pcprofile.py.
+ */
+static void CmdProfile(Console* console, const ProfileArgs* args) {
+  ReturnCode rc;
+
+  switch (args->op) {
+    case kProfileStart:
+      ProfilerStart((args->argc > 1) ? args->hz : PROFILER_DEFAULT_HZ);  // hz checked already
+      break;
+    case kProfileStop:
+      ProfilerStop();
+      break;
+    case kProfileReset:
+      ProfilerReset();
+      ConsolePrint(console, "Profile cleared.\r\n");
+      return;
+    case kProfileDump:
+      rc = ProfilerDump(DUMP_FLAG_LZ);
+      if (rc == kOk) {
+        ConsolePrint(console, "Profile dump started.\r\n");
+      } else {
+        ConsolePrint(console, (rc == kError) ? "Dump needs mux mode (data channel).\r\n"
+                                             : "A dump is already running.\r\n");
+      }
+      return;
+    default:
+      break;
+  }
+  ProfilerReport(console);
+}
+
+/**
+ * @brief Sends the REPLY of a binary call or line, keeping it for a
+ * resend.
+ */
+static void CommandReply(uint8_t seq, ReturnCode rc, uint32_t result) {
+  last_call.reply[0] = COMMAND_MSG_REPLY;
+  last_call.reply[1] = seq;
+  last_call.reply[2] = (uint8_t)rc;
+  for (int i = 0; i < 4; ++i) {
+    last_call.reply[3 + i] = (uint8_t)(result >> (8 * i));
+  }
+  last_call.valid = 1;
+  MuxWrite(MUX_CH_DATA, last_call.reply, sizeof(last_call.reply));
+}
+
+/**
+ * @brief Returns 1 after resending the reply if @p seq is that of the last
+ * call: its reply was lost, the command is not run again.
+ */
+static uint8_t CommandIsRepeat(uint8_t seq) {
+  if (last_call.valid && (last_call.reply[1] == seq)) {
+    MuxWrite(MUX_CH_DATA, last_call.reply, sizeof(last_call.reply));
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Runs a binary call (COMMAND_MSG_CALL) and answers it.
+ */
+static void CommandCall(const uint8_t* payload, uint16_t len) {
+  uint8_t args[COMMAND_ARGS_MAX_SIZE] __attribute__((aligned(8)));
+  uint8_t seq = payload[1];
+  const uint8_t* name = &payload[2];
+  const uint8_t* nul = memchr(name, '\0', len - 2U);
+  const CommandTyped* command = NULL;
+  uint32_t slot = 0;
+  ReturnCode rc = kInvalidArgument;
+  uint32_t result = 0;
+
+  if (CommandIsRepeat(seq)) {
+    return;
+  }
+  for (size_t i = 0; (nul != NULL) && (i < sizeof(kTypedCommands) / sizeof(kTypedCommands[0])); ++i) {
+    if (FastStrcmp((const char*)name, kTypedCommands[i]->name) == 0) {
+      command = kTypedCommands[i];
+      slot = (uint32_t)(COMMAND_TYPED_FIRST + i);
+      break;
+    }
+  }
+  if (command != NULL) {
+    CommandArgSource source = {NULL, 0, nul + 1, (uint16_t)(len - (uint16_t)(nul + 1 - payload))};
+    uint8_t bad = 0;
+
+    rc = CommandArgsDecode(command, &source, args, &bad);
+    if (rc == kOk) {
+      Console* console = MuxGetConsole();
+      uint32_t tx_start = console->tx_bytes;
+      TraceLog("%s: call %s", console->name, command->name);
+      console->result = 0;
+      LoopMonitorEnter(command->name);
+      command->run(console, args);
+      uint32_t elapsed_us = LoopMonitorLeave();
+      CommandPerfCharge(slot, elapsed_us, console->tx_bytes - tx_start);
+      result = (uint32_t)console->result;
+    } else {
+      result = bad;
+    }
+  }
+  CommandReply(seq, rc, result);
+}
+
+/**
+ * @brief Runs a command line (COMMAND_MSG_LINE) on the mux console and
+ * answers it.
+ */
+static void CommandLine(const uint8_t* payload, uint16_t len) {
+  uint8_t seq = payload[1];
+  ReturnCode rc = kInvalidArgument;
+  uint32_t result = 0;
+
+  if (CommandIsRepeat(seq)) {
+    return;
+  }
+  if (memchr(&payload[2], '\0', len - 2U) != NULL) {
+    Console* console = MuxGetConsole();
+    rc = CommandParserProcess(console, &payload[2]);
+    result = (rc == kOk) ? (uint32_t)console->result : 0U;
+  }
+  CommandReply(seq, rc, result);
+}
+
+static void CommandReceive(const uint8_t* payload, uint16_t len) {
+  if ((len >= 3U) && (payload[0] == COMMAND_MSG_CALL)) {
+    CommandCall(payload, len);
+  } else if ((len >= 3U) && (payload[0] == COMMAND_MSG_LINE)) {
+    CommandLine(payload, len);
+  } else if (next_receiver != NULL) {
+    next_receiver(payload, len);
   }
-  ConsolePrint("---------------------------\r\n");
 }
 
 // -----------------------------------------------------------------------------
@@ -90,19 +1041,62 @@ static void CmdHelp() {
 /**
  * @brief Parses a command string and executes the associated action.
  *
+ * @param console Session that issued the command.
  * @param command_string Null-terminated string with command input.
+ * @return kOk if a command ran, kEmpty for a blank line, kInvalidArgument
+ *     otherwise.
  */
-void CommandParserProcess(const uint8_t* command_string) {
-  if (strlen((const char*)command_string) == 0) {
-    return;
+ReturnCode CommandParserProcess(Console* console, const uint8_t* command_string) {
+  char line[CONSOLE_LINE_SIZE];
+  char* argv[COMMAND_MAX_ARGS];
+  int argc = 0;
+
+  // Split a copy of the line into words
+  strncpy(line, (const char*)command_string, sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  for (char* word = strtok(line, " "); word != NULL; word = strtok(NULL, " ")) {
+    if (argc == COMMAND_MAX_ARGS) {
+      ConsolePrint(console, "Too many arguments.\r\n");
+      return kInvalidArgument;
+    }
+    argv[argc++] = word;
+  }
+  if (argc == 0) {
+    return kEmpty;
   }
 
+  const Command* command = NULL;
+  uint32_t index = UINT32_MAX;
   for (int i = 0; i < kNumCommands; ++i) {
-    if (strcmp((const char*)command_string, kCommands[i].name) == 0) {
-      kCommands[i].action();  // Execute associated function
-      return;
+    if (FastStrcmp(argv[0], kCommands[i].name) == 0) {
+      command = &kCommands[i];
+      index = (uint32_t)i;
+      break;
     }
   }
+  if (command == NULL) {
+    command = ModuleFindCommand(argv[0]);  // Built-in commands take precedence
+  }
+
+  if (command != NULL) {
+    TraceEvent(TRACE_ID_COMMAND, index);
+    TraceLog("%s: run %s", console->name, argv[0]);
+    uint32_t tx_start = console->tx_bytes;
+    console->result = 0;
+    LoopMonitorEnter(argv[0]);
+    command->action(console, argc, argv);  // Execute associated function
+    uint32_t elapsed_us = LoopMonitorLeave();
+    CommandPerfCharge((index == UINT32_MAX) ? (uint32_t)kNumCommands : index, elapsed_us,
+                      console->tx_bytes - tx_start);
+    return kOk;
+  }
+
+  ConsolePrint(console, "Unrecognized command. Type 'help' for a list.\r\n");
+  return kInvalidArgument;
+}
 
-  ConsolePrint("Unrecognized command. Type 'help' for a list.\r\n");
+void CommandBinaryInit(void) {
+  last_call.valid = 0;
+  next_receiver = MuxGetReceiver(MUX_CH_DATA);
+  MuxSetReceiver(MUX_CH_DATA, CommandReceive);
 }
@@ -0,0 +1,256 @@
+// command_args.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Shared decoder of typed command arguments, text and binary
+// (see command_args.h).
+
+#include "command_args.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMMAND_ARG_SIZE(kind, ctype, size, label) size,
+static const uint8_t kTypeSizes[kCommandArgTypes] = {COMMAND_ARG_TYPES(COMMAND_ARG_SIZE)};
+#undef COMMAND_ARG_SIZE
+
+#define COMMAND_ARG_LABEL(kind, ctype, size, label) label,
+static const char* const kTypeLabels[kCommandArgTypes] = {COMMAND_ARG_TYPES(COMMAND_ARG_LABEL)};
+#undef COMMAND_ARG_LABEL
+
+/**
+ * @brief A value on its way from the reader to the argument struct.
+ */
+typedef struct {
+  int64_t number;
+  const char* text;
+} CommandArgValue;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint8_t CommandArgCountNames(const char* const* names) {
+  uint8_t count = 0;
+
+  while ((names != NULL) && (names[count] != NULL)) {
+    ++count;
+  }
+  return count;
+}
+
+/**
+ * @brief Reads value @p index from a command line.
+ *
+ * @return kOk, kEmpty if there are no more words, kInvalidArgument if the
+ *     word is not a value of the type.
+ */
+static ReturnCode CommandArgReadText(CommandArgSource* source, const CommandArgSpec* spec,
+                                     int index, CommandArgValue* value) {
+  if (index >= source->argc) {
+    return kEmpty;
+  }
+  const char* word = source->argv[index];
+  char* end = NULL;
+
+  switch (spec->type) {
+    case kCommandArgStr:
+      value->text = word;
+      return kOk;
+    case kCommandArgLine:
+      for (int i = index; i < source->argc - 1; ++i) {
+        source->argv[i][strlen(source->argv[i])] = ' ';  // Where the tokenizer cut
+      }
+      source->argc = index + 1;
+      value->text = word;
+      return kOk;
+    case kCommandArgEnum:
+      for (uint8_t i = 0; (spec->names != NULL) && (spec->names[i] != NULL); ++i) {
+        if (strcmp(word, spec->names[i]) == 0) {
+          value->number = i;
+          return kOk;
+        }
+      }
+      return kInvalidArgument;
+    case kCommandArgI32:
+      value->number = strtol(word, &end, 0);
+      break;
+    case kCommandArgI64:
+      value->number = strtoll(word, &end, 0);
+      break;
+    default:
+      if (word[0] == '-') {
+        return kInvalidArgument;
+      }
+      value->number = (int64_t)strtoul(word, &end, 0);
+      break;
+  }
+  return ((end != word) && (*end == '\0')) ? kOk : kInvalidArgument;
+}
+
+/**
+ * @brief Reads the next value from the argument bytes of a binary call.
+ */
+static ReturnCode CommandArgReadBinary(CommandArgSource* source, const CommandArgSpec* spec,
+                                       CommandArgValue* value) {
+  uint8_t size = kTypeSizes[spec->type];
+
+  if (source->len == 0) {
+    return kEmpty;
+  }
+  if ((spec->type == kCommandArgStr) || (spec->type == kCommandArgLine)) {
+    const uint8_t* nul = memchr(source->data, '\0', source->len);
+    if (nul == NULL) {
+      return kInvalidArgument;
+    }
+    value->text = (const char*)source->data;
+    size = (uint8_t)(nul - source->data + 1);
+  } else {
+    uint64_t raw = 0;
+    if (source->len < size) {
+      return kInvalidArgument;
+    }
+    for (uint8_t i = 0; i < size; ++i) {
+      raw |= (uint64_t)source->data[i] << (8 * i);
+    }
+    value->number = (spec->type == kCommandArgI32) ? (int64_t)(int32_t)(uint32_t)raw
+                                                   : (int64_t)raw;
+  }
+  source->data += size;
+  source->len -= size;
+  return kOk;
+}
+
+static void CommandArgStore(const CommandArgSpec* spec, const CommandArgValue* value,
+                            uint8_t* args) {
+  uint8_t* field = &args[spec->offset];
+
+  switch (spec->type) {
+    case kCommandArgU8:
+    case kCommandArgEnum: {
+      CommandArgU8 v = (CommandArgU8)value->number;
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case kCommandArgU16: {
+      CommandArgU16 v = (CommandArgU16)value->number;
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case kCommandArgU32: {
+      CommandArgU32 v = (CommandArgU32)value->number;
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case kCommandArgI32: {
+      CommandArgI32 v = (CommandArgI32)value->number;
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case kCommandArgI64: {
+      CommandArgI64 v = value->number;
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    default:
+      memcpy(field, &value->text, sizeof(value->text));
+      break;
+  }
+}
+
+/**
+ * @brief Prints what an argument accepts: "addr: u32 0..4294967295" or
+ * "width: b|h|w".
+ */
+static void CommandArgPrintSpec(Console* console, const CommandArgSpec* spec) {
+  char line[64];
+  int n = snprintf(line, sizeof(line), "  %s: ", spec->name);
+
+  if (spec->type == kCommandArgEnum) {
+    for (uint8_t i = 0; (spec->names != NULL) && (spec->names[i] != NULL); ++i) {
+      if ((n > 0) && ((size_t)n < sizeof(line))) {
+        n += snprintf(&line[n], sizeof(line) - n, "%s%s", (i == 0) ? "" : "|", spec->names[i]);
+      }
+    }
+  } else if ((spec->type == kCommandArgStr) || (spec->type == kCommandArgLine) ||
+             (spec->type == kCommandArgI64)) {
+    n += snprintf(&line[n], sizeof(line) - n, "%s", kTypeLabels[spec->type]);
+  } else {
+    n += snprintf(&line[n], sizeof(line) - n,
+                  (spec->type == kCommandArgI32) ? "%s %ld..%ld" : "%s %lu..%lu",
+                  kTypeLabels[spec->type], (long)spec->min, (long)spec->max);
+  }
+  ConsolePrint(console, line);
+  ConsolePrint(console, "\r\n");
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode CommandArgsDecode(const CommandTyped* command, const CommandArgSource* source,
+                             void* args, uint8_t* bad) {
+  CommandArgSource input = *source;
+  uint8_t* out = (uint8_t*)args;
+  uint8_t given = 0;
+
+  memset(args, 0, command->args_size);
+  *bad = command->num_args;
+  for (uint8_t i = 0; i < command->num_args; ++i) {
+    const CommandArgSpec* spec = &command->args[i];
+    CommandArgValue value = {0, NULL};
+    ReturnCode rc = (input.argv != NULL) ? CommandArgReadText(&input, spec, given, &value)
+                                         : CommandArgReadBinary(&input, spec, &value);
+    if (rc == kEmpty) {
+      if (spec->optional == COMMAND_OPTIONAL_REQ) {
+        return kInvalidArgument;
+      }
+      break;  // Only optional arguments follow
+    }
+    uint8_t key = (spec->optional == COMMAND_OPTIONAL_KEY);
+    if (key && (input.argv != NULL)) {
+      if (rc != kOk) {
+        continue;  // Not the keyword: the word is the next argument's
+      }
+      value.number += 1;  // 0 stands for absent
+    }
+    if (spec->type == kCommandArgEnum) {
+      if (value.number >= CommandArgCountNames(spec->names) + key) {
+        rc = kInvalidArgument;
+      }
+    } else if ((spec->type != kCommandArgStr) && (spec->type != kCommandArgLine) &&
+               ((value.number < spec->min) || (value.number > spec->max))) {
+      rc = kInvalidArgument;
+    }
+    if (rc != kOk) {
+      *bad = i;
+      return kInvalidArgument;
+    }
+    CommandArgStore(spec, &value, out);
+    given += (!key || (value.number != 0)) ? 1U : 0U;  // An absent keyword is not given
+  }
+  if ((input.argv != NULL) ? (given < input.argc) : (input.len != 0)) {
+    return kInvalidArgument;  // Surplus
+  }
+  out[0] = given;  // argc leads every argument struct
+  return kOk;
+}
+
+void CommandTypedRunText(Console* console, const CommandTyped* command, int argc, char* argv[]) {
+  uint8_t args[COMMAND_ARGS_MAX_SIZE] __attribute__((aligned(8)));
+  CommandArgSource source = {&argv[1], argc - 1, NULL, 0};
+  uint8_t bad = 0;
+
+  if (CommandArgsDecode(command, &source, args, &bad) == kOk) {
+    command->run(console, args);
+    return;
+  }
+  CommandTypedUsage(console, command);
+  if (bad < command->num_args) {
+    CommandArgPrintSpec(console, &command->args[bad]);
+  }
+}
+
+void CommandTypedUsage(Console* console, const CommandTyped* command) {
+  ConsolePrint(console, "Usage: ");
+  ConsolePrint(console, command->usage);
+  ConsolePrint(console, "\r\n");
+}
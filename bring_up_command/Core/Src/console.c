@@ -0,0 +1,124 @@
+// console.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Transport-independent console session: RX buffering, line discipline and
+// output routing.
+
+#include "console.h"
+#include "command.h"
+#include "fastmem.h"
+
+#define ASCII_BS  0x08
+#define ASCII_DEL 0x7F
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Queues the assembled line (with its terminator) and resets the
+ * line state.
+ */
+static void ConsoleEndLine(Console* console) {
+  if (console->line_overflow) {
+    ConsolePrint(console, "Line too long.\r\n");
+  } else if (console->line_len > 0) {
+    console->line[console->line_len] = '\0';
+    RecordQueueCommit(&console->lines, console->line_len + 1U);
+  }
+
+  console->line = NULL;
+  console->line_len = 0;
+  console->line_overflow = 0;
+}
+
+/**
+ * @brief Executes the queued lines where they are.
+ */
+static void ConsoleRunLines(Console* console) {
+  const uint8_t* line;
+  uint16_t len;
+
+  while (!console->detached && (RecordQueuePeek(&console->lines, &line, &len) == kOk)) {
+    // Echo the command back before its output
+    ConsoleWrite(console, line, len - 1U);
+    ConsolePrint(console, "\r\n");
+
+    CommandParserProcess(console, line);
+    RecordQueueRelease(&console->lines);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void ConsoleInit(Console* console, const char* name, ConsoleWriteFn write,
+                 void* transport) {
+  console->name = name;
+  console->write = write;
+  console->writable = NULL;
+  console->transport = transport;
+  RecordQueueInit(&console->lines, console->line_storage, sizeof(console->line_storage));
+  console->line = NULL;
+  console->line_len = 0;
+  console->line_overflow = 0;
+  console->detached = 0;
+  console->result = 0;
+  console->tx_bytes = 0;
+  RingBufferInit(&console->rx);
+}
+
+void ConsoleReceive(Console* console, const uint8_t* data, uint16_t len) {
+  for (uint16_t i = 0; i < len; ++i) {
+    if (RingBufferPush(&console->rx, data[i]) != kOk) {
+      return;  // Buffer full, drop the rest
+    }
+  }
+}
+
+void ConsoleProcess(Console* console) {
+  uint8_t c;
+
+  // A command may detach the session, so each line runs before the next
+  // byte is taken and the check is repeated for every byte
+  while (!console->detached && (RingBufferPop(&console->rx, &c) == kOk)) {
+    if ((c == '\r') || (c == '\n')) {
+      ConsoleEndLine(console);
+      ConsoleRunLines(console);
+    } else if ((c == ASCII_BS) || (c == ASCII_DEL)) {
+      if (console->line_len > 0) {
+        console->line_len--;
+      }
+    } else if ((c & 0x80) || console->line_overflow) {
+      // Not command input (e.g. RS-485 address marks, see rs485.h), or the
+      // rest of an overlong line
+    } else {
+      if (console->line == NULL) {
+        console->line = RecordQueueReserve(&console->lines, CONSOLE_LINE_SIZE);
+      }
+      if ((console->line != NULL) && (console->line_len < (CONSOLE_LINE_SIZE - 1))) {
+        console->line[console->line_len++] = c;
+      } else {
+        console->line_overflow = 1;  // Too long (the queue always has room for one line)
+      }
+    }
+  }
+}
+
+uint16_t ConsoleWritable(const Console* console) {
+  if (console->writable == NULL) {
+    return UINT16_MAX;
+  }
+  return console->writable(console);
+}
+
+void ConsoleWrite(Console* console, const uint8_t* data, uint16_t len) {
+  if ((console->write != NULL) && (len > 0)) {
+    console->tx_bytes += len;
+    console->write(console, data, len);
+  }
+}
+
+void ConsolePrint(Console* console, const char* str) {
+  ConsoleWrite(console, (const uint8_t*)str, (uint16_t)FastStrlen(str));
+}
@@ -0,0 +1,18 @@
+// crc.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Bitwise CRC implementations. Table-free to keep flash usage small; the
+// console protocols only checksum short frames.
+
+#include "crc.h"
+
+uint16_t Crc16Ccitt(uint16_t crc, const uint8_t* data, uint16_t len) {
+  for (uint16_t i = 0; i < len; ++i) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,260 @@
+// dma_copy.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Queued memory-to-memory copies and fills on DMA1 channel 1
+// (see dma_copy.h).
+
+#include "dma_copy.h"
+#include "clock_gate.h"
+#include "cycle_count.h"
+#include "fastmem.h"
+#include "main.h"
+#include "module.h"
+#include <stdio.h>
+
+#define DMA_COPY_CHANNEL    DMA1_Channel1
+#define DMA_COPY_MAX_UNITS  0xFFFFU  ///< CNDTR is 16 bits
+
+#define BENCH_MIN_SIZE      16U
+#define BENCH_MAX_SIZE      1024U
+#define BENCH_RUNS          4
+
+typedef struct {
+  uint32_t dst;
+  uint32_t src;
+  uint32_t len;             ///< Bytes still to move
+  uint8_t fill;             ///< memset: src holds the byte pattern
+  DmaCopyDoneFn done;
+  void* context;
+} DmaCopyJob;
+
+static struct {
+  DmaCopyJob jobs[DMA_COPY_QUEUE_SIZE];
+  volatile uint8_t head;    ///< Next free slot
+  volatile uint8_t tail;    ///< Running job
+  uint32_t segment;         ///< Bytes of the running transfer
+  uint32_t pattern;         ///< Fill source
+} dma_copy;
+
+static volatile uint8_t bench_done;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Programs the channel for the next segment of @p job.
+ */
+static void DmaCopyStart(const DmaCopyJob* job) {
+  uint32_t align = job->dst | job->len | (job->fill ? 0U : job->src);
+  uint32_t size_bits;
+  uint32_t width;
+
+  if ((align & 3U) == 0) {
+    width = 4;
+    size_bits = DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1;
+  } else if ((align & 1U) == 0) {
+    width = 2;
+    size_bits = DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0;
+  } else {
+    width = 1;
+    size_bits = 0;
+  }
+  uint32_t units = job->len / width;
+  if (units > DMA_COPY_MAX_UNITS) {
+    units = DMA_COPY_MAX_UNITS;
+  }
+  dma_copy.segment = units * width;
+
+  // Memory-to-memory: the "peripheral" side is the source
+  DMA_COPY_CHANNEL->CCR = 0;
+  if (job->fill) {
+    dma_copy.pattern = job->src;
+    DMA_COPY_CHANNEL->CPAR = (uint32_t)(uintptr_t)&dma_copy.pattern;
+  } else {
+    DMA_COPY_CHANNEL->CPAR = job->src;
+  }
+  DMA_COPY_CHANNEL->CMAR = job->dst;
+  DMA_COPY_CHANNEL->CNDTR = units;
+  DMA_COPY_CHANNEL->CCR = DMA_CCR_MEM2MEM | DMA_CCR_MINC | (job->fill ? 0U : DMA_CCR_PINC) |
+                          size_bits | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_EN;
+}
+
+/**
+ * @brief Queues a job; small ones on an idle queue are done right away.
+ *
+ * @param allow_cpu 0 to always use the DMA (benchmark).
+ */
+static ReturnCode DmaCopySubmit(const DmaCopyJob* job, uint8_t allow_cpu) {
+  if ((job->len == 0) || (job->dst == 0)) {
+    return kInvalidArgument;
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint8_t idle = (dma_copy.head == dma_copy.tail) ? 1U : 0U;
+  if (allow_cpu && idle && (job->len < DMA_COPY_MIN_SIZE)) {
+    __set_PRIMASK(primask);
+    if (job->fill) {
+      FastMemset((void*)(uintptr_t)job->dst, (int)(job->src & 0xFFU), job->len);
+    } else {
+      FastMemcpy((void*)(uintptr_t)job->dst, (const void*)(uintptr_t)job->src, job->len);
+    }
+    if (job->done != NULL) {
+      job->done(job->context, kOk);
+    }
+    return kOk;
+  }
+
+  uint8_t next = (uint8_t)((dma_copy.head + 1U) % DMA_COPY_QUEUE_SIZE);
+  if (next == dma_copy.tail) {
+    __set_PRIMASK(primask);
+    return kFull;
+  }
+  dma_copy.jobs[dma_copy.head] = *job;
+  dma_copy.head = next;
+  if (idle) {
+    // The clock runs while the queue is busy, in sleep too
+    ClockGateAcquire(kClockGateDma1, 1);
+    DmaCopyStart(&dma_copy.jobs[dma_copy.tail]);
+  }
+  __set_PRIMASK(primask);
+  return kOk;
+}
+
+static void BenchDone(void* context, ReturnCode rc) {
+  (void)context;
+  (void)rc;
+  bench_done = 1;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void DmaCopyInit(void) {
+  ClockGateAcquire(kClockGateDma1, 0);
+  DMA_COPY_CHANNEL->CCR = 0;
+  DMA1->IFCR = DMA_IFCR_CGIF1;
+  ClockGateRelease(kClockGateDma1, 0);
+  dma_copy.head = 0;
+  dma_copy.tail = 0;
+
+  // Lowest priority: completions are never urgent
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
+ReturnCode DmaCopyMemcpy(void* dst, const void* src, size_t len, DmaCopyDoneFn done,
+                         void* context) {
+  DmaCopyJob job = {(uint32_t)(uintptr_t)dst, (uint32_t)(uintptr_t)src, len, 0, done, context};
+
+  return (src == NULL) ? kInvalidArgument : DmaCopySubmit(&job, 1);
+}
+
+ReturnCode DmaCopyMemset(void* dst, uint8_t value, size_t len, DmaCopyDoneFn done,
+                         void* context) {
+  DmaCopyJob job = {(uint32_t)(uintptr_t)dst, value * 0x01010101UL, len, 1, done, context};
+
+  return DmaCopySubmit(&job, 1);
+}
+
+uint8_t DmaCopyIsIdle(void) {
+  return (dma_copy.head == dma_copy.tail) ? 1U : 0U;
+}
+
+ReturnCode DmaCopyBenchmark(Console* console) {
+  uint16_t size = 0;
+  uint8_t* area = ModuleAreaFree(&size);
+  uint32_t first_faster = 0;
+  uint32_t first_cheaper = 0;
+  char line[96];
+
+  if ((area == NULL) || (size < 2U * BENCH_MIN_SIZE + 4U) || !DmaCopyIsIdle()) {
+    return kFull;
+  }
+  uint8_t* src = (uint8_t*)(((uintptr_t)area + 3U) & ~(uintptr_t)3U);
+  uint32_t max_len = (size - 4U) / 2U;
+  uint8_t* dst = src + max_len;
+
+  ConsolePrint(console, "   size      cpu  dma_done  dma_submit  (cycles, best of 4)\r\n");
+  for (uint32_t len = BENCH_MIN_SIZE; (len <= BENCH_MAX_SIZE) && (len <= max_len); len *= 2U) {
+    uint32_t cpu = UINT32_MAX;
+    uint32_t total = UINT32_MAX;
+    uint32_t submit = UINT32_MAX;
+
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      uint32_t start = CycleCountStart();
+      FastMemcpy(dst, src, len);
+      uint32_t cycles = CycleCountElapsed(start);
+      __set_PRIMASK(primask);
+      cpu = (cycles < cpu) ? cycles : cpu;
+
+      // Completion needs the DMA interrupt, so interrupts stay enabled
+      DmaCopyJob job = {(uint32_t)(uintptr_t)dst, (uint32_t)(uintptr_t)src, len, 0, BenchDone,
+                        NULL};
+      bench_done = 0;
+      start = CycleCountStart();
+      DmaCopySubmit(&job, 0);
+      cycles = CycleCountElapsed(start);
+      submit = (cycles < submit) ? cycles : submit;
+      while (!bench_done) {
+      }
+      cycles = CycleCountElapsed(start);
+      total = (cycles < total) ? cycles : total;
+    }
+
+    if ((first_faster == 0) && (total < cpu)) {
+      first_faster = len;
+    }
+    if ((first_cheaper == 0) && (submit < cpu)) {
+      first_cheaper = len;
+    }
+    snprintf(line, sizeof(line), "  %5lu  %7lu  %8lu  %10lu\r\n", (unsigned long)len,
+             (unsigned long)cpu, (unsigned long)total, (unsigned long)submit);
+    ConsolePrint(console, line);
+  }
+
+  snprintf(line, sizeof(line), "DMA done first from %lu B, frees the CPU from %lu B "
+           "(0: not in range).\r\n", (unsigned long)first_faster, (unsigned long)first_cheaper);
+  ConsolePrint(console, line);
+  return kOk;
+}
+
+void DmaCopyIrq(void) {
+  uint32_t isr = DMA1->ISR;
+
+  if (!(isr & (DMA_ISR_TCIF1 | DMA_ISR_TEIF1))) {
+    return;
+  }
+  DMA1->IFCR = DMA_IFCR_CGIF1;
+  DMA_COPY_CHANNEL->CCR = 0;
+
+  DmaCopyJob* job = &dma_copy.jobs[dma_copy.tail];
+  ReturnCode rc = kOk;
+  if (isr & DMA_ISR_TEIF1) {
+    rc = kError;
+  } else {
+    job->dst += dma_copy.segment;
+    job->src += job->fill ? 0U : dma_copy.segment;
+    job->len -= dma_copy.segment;
+    if (job->len > 0) {
+      DmaCopyStart(job);
+      return;
+    }
+  }
+
+  // Start the next job before the callback, which may queue another
+  DmaCopyDoneFn done = job->done;
+  void* context = job->context;
+  dma_copy.tail = (uint8_t)((dma_copy.tail + 1U) % DMA_COPY_QUEUE_SIZE);
+  if (dma_copy.head != dma_copy.tail) {
+    DmaCopyStart(&dma_copy.jobs[dma_copy.tail]);
+  } else {
+    ClockGateRelease(kClockGateDma1, 1);
+  }
+  if (done != NULL) {
+    done(context, rc);
+  }
+}
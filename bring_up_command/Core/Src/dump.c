@@ -0,0 +1,253 @@
+// dump.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Bulk output streams on the mux data channel with optional LZSS
+// compression (see dump.h).
+
+#include "dump.h"
+#include "crc.h"
+#include "lz.h"
+#include "main.h"
+#include "mux.h"
+#include <string.h>
+
+#define DUMP_READ_SIZE  16                    ///< Source bytes per step
+#define DUMP_MAX_STEPS  16                    ///< Steps per DumpProcess() call
+#define DUMP_CHUNK      (MUX_MAX_PAYLOAD - 1) ///< Stream bytes per DATA message
+#define DUMP_OUT_SIZE   (DUMP_CHUNK + 2 * sizeof(((LzEncoder*)0)->group))
+
+typedef enum {
+  kDumpIdle = 0,
+  kDumpBegin,
+  kDumpStream,
+  kDumpFinish,  ///< Source read, compressor being drained
+  kDumpEnd,
+} DumpState;
+
+/**
+ * @brief Readable memory regions; peripherals are read as words.
+ */
+typedef struct {
+  uint32_t start;
+  uint32_t end;  ///< Last byte
+  uint8_t access;
+} DumpRegion;
+
+static const DumpRegion kRegions[] = {
+    {FLASH_BASE, FLASH_BASE + 192U * 1024U - 1U, 0},  // STM32L073xZ
+    {DATA_EEPROM_BASE, DATA_EEPROM_BANK2_END, 0},
+    {SRAM_BASE, SRAM_BASE + SRAM_SIZE_MAX - 1U, DUMP_ACCESS_WRITE},
+    {APBPERIPH_BASE, APBPERIPH_BASE + 0x7FFFU, DUMP_ACCESS_WORDS | DUMP_ACCESS_WRITE},
+    {APBPERIPH_BASE + 0x10000U, APBPERIPH_BASE + 0x17FFFU, DUMP_ACCESS_WORDS | DUMP_ACCESS_WRITE},
+    {AHBPERIPH_BASE, AHBPERIPH_BASE + 0x63FFU, DUMP_ACCESS_WORDS | DUMP_ACCESS_WRITE},
+    {IOPPERIPH_BASE, IOPPERIPH_BASE + 0x1FFFU, DUMP_ACCESS_WORDS | DUMP_ACCESS_WRITE},
+};
+
+static struct {
+  DumpState state;
+  uint8_t flags;
+  uint8_t words;          ///< Memory source needs word reads
+  ReturnCode rc;
+  DumpReadFn read;
+  uint32_t address;       ///< Memory source base, or the tag of the source
+  uint32_t length;
+  uint32_t offset;        ///< Source bytes consumed
+  uint32_t sent;          ///< Stream bytes sent
+  uint16_t crc;           ///< Over the source bytes
+  uint8_t out[DUMP_OUT_SIZE];
+  uint16_t out_len;
+  LzEncoder lz;
+} dump;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static ReturnCode DumpReadMemory(uint32_t offset, uint8_t* out, uint16_t len) {
+  uint32_t address = dump.address + offset;
+
+  if (!dump.words) {
+    memcpy(out, (const void*)(uintptr_t)address, len);
+    return kOk;
+  }
+  for (uint16_t i = 0; i < len; i += 4U) {
+    uint32_t word = *(const volatile uint32_t*)(uintptr_t)(address + i);
+    memcpy(&out[i], &word, 4);
+  }
+  return kOk;
+}
+
+static void DumpSink(void* context, const uint8_t* data, uint16_t len) {
+  (void)context;
+  memcpy(&dump.out[dump.out_len], data, len);
+  dump.out_len += len;
+}
+
+static ReturnCode DumpSendMessage(uint8_t message, const uint8_t* data, uint16_t len) {
+  uint8_t payload[MUX_MAX_PAYLOAD];
+
+  payload[0] = message;
+  memcpy(&payload[1], data, len);
+  return MuxWrite(MUX_CH_DATA, payload, len + 1U);
+}
+
+static void PutLe32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+/**
+ * @brief Sends staged stream bytes, whole chunks only unless @p all.
+ *
+ * @return 1 if everything that should go out went out.
+ */
+static uint8_t DumpDrain(uint8_t all) {
+  while ((dump.out_len >= DUMP_CHUNK) || (all && (dump.out_len > 0))) {
+    uint16_t n = (dump.out_len < DUMP_CHUNK) ? dump.out_len : DUMP_CHUNK;
+    if (DumpSendMessage(DUMP_MSG_DATA, dump.out, n) != kOk) {
+      return 0;
+    }
+    dump.sent += n;
+    dump.out_len -= n;
+    memmove(dump.out, &dump.out[n], dump.out_len);
+  }
+  return 1;
+}
+
+/**
+ * @brief Moves one step of source data into the staging buffer.
+ */
+static void DumpStep(void) {
+  uint8_t data[DUMP_READ_SIZE];
+  uint32_t left = dump.length - dump.offset;
+  uint16_t n = (left < DUMP_READ_SIZE) ? (uint16_t)left : DUMP_READ_SIZE;
+
+  ReturnCode rc = dump.read(dump.offset, data, n);
+  if (rc != kOk) {
+    dump.rc = rc;
+    dump.length = dump.offset;  // End the stream here
+    return;
+  }
+  dump.crc = Crc16Ccitt(dump.crc, data, n);
+  dump.offset += n;
+  if (dump.flags & DUMP_FLAG_LZ) {
+    LzWrite(&dump.lz, data, n);
+  } else {
+    DumpSink(NULL, data, n);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode DumpStart(uint32_t address, uint32_t length, uint8_t flags) {
+  uint8_t access = 0;
+
+  if (DumpCheckRange(address, length, &access) != kOk) {
+    return kInvalidArgument;
+  }
+
+  ReturnCode rc = DumpStartSource(DumpReadMemory, address, length, flags);
+  if (rc == kOk) {
+    dump.words = (access & DUMP_ACCESS_WORDS) ? 1U : 0U;
+  }
+  return rc;
+}
+
+ReturnCode DumpCheckRange(uint32_t address, uint32_t length, uint8_t* access) {
+  const DumpRegion* region = NULL;
+
+  for (size_t i = 0; i < sizeof(kRegions) / sizeof(kRegions[0]); ++i) {
+    if ((address >= kRegions[i].start) && (length > 0) &&
+        (length - 1U <= kRegions[i].end - address) && (address <= kRegions[i].end)) {
+      region = &kRegions[i];
+      break;
+    }
+  }
+  if ((region == NULL) ||
+      ((region->access & DUMP_ACCESS_WORDS) && (((address | length) & 3U) != 0))) {
+    return kInvalidArgument;
+  }
+  if (access != NULL) {
+    *access = region->access;
+  }
+  return kOk;
+}
+
+ReturnCode DumpStartSource(DumpReadFn read, uint32_t tag, uint32_t length, uint8_t flags) {
+  if (!MuxIsActive()) {
+    return kError;
+  }
+  if (dump.state != kDumpIdle) {
+    return kFull;
+  }
+  dump.flags = flags;
+  dump.words = 0;
+  dump.rc = kOk;
+  dump.read = read;
+  dump.address = tag;
+  dump.length = length;
+  dump.offset = 0;
+  dump.sent = 0;
+  dump.crc = CRC16_CCITT_INIT;
+  dump.out_len = 0;
+  LzInit(&dump.lz, DumpSink, NULL);
+  dump.state = kDumpBegin;
+  return kOk;
+}
+
+uint8_t DumpIsActive(void) {
+  return (dump.state != kDumpIdle) ? 1U : 0U;
+}
+
+void DumpProcess(void) {
+  uint8_t header[9];
+
+  if (dump.state == kDumpIdle) {
+    return;
+  }
+  if (!MuxIsActive()) {
+    dump.state = kDumpIdle;  // Host left mux mode: nobody to send to
+    return;
+  }
+
+  if (dump.state == kDumpBegin) {
+    header[0] = dump.flags;
+    PutLe32(&header[1], dump.address);
+    PutLe32(&header[5], dump.length);
+    if (DumpSendMessage(DUMP_MSG_BEGIN, header, 9) != kOk) {
+      return;
+    }
+    dump.state = kDumpStream;
+  }
+
+  // Refill the staging buffer only once its full chunks are out, so it
+  // always has room for what one step can produce. Highly compressible
+  // data hardly fills the queue, hence the step budget.
+  for (int steps = 0; (dump.state == kDumpStream) || (dump.state == kDumpFinish); ++steps) {
+    if (!DumpDrain(0) || (steps == DUMP_MAX_STEPS)) {
+      return;
+    }
+    if (dump.state == kDumpStream) {
+      if (dump.offset < dump.length) {
+        DumpStep();
+      } else {
+        dump.state = kDumpFinish;
+      }
+    } else if (!(dump.flags & DUMP_FLAG_LZ) || LzFinish(&dump.lz)) {
+      dump.state = kDumpEnd;
+    }
+  }
+
+  if (!DumpDrain(1)) {
+    return;
+  }
+  header[0] = (uint8_t)dump.rc;
+  header[1] = (uint8_t)(dump.crc & 0xFF);
+  header[2] = (uint8_t)(dump.crc >> 8);
+  PutLe32(&header[3], dump.sent);
+  if (DumpSendMessage(DUMP_MSG_END, header, 7) == kOk) {
+    dump.state = kDumpIdle;
+  }
+}
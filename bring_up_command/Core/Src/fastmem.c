@@ -0,0 +1,194 @@
+// fastmem.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Word and block based memory and string routines for the Cortex-M0+
+// (see fastmem.h).
+
+#include "fastmem.h"
+#include <string.h>
+
+#define FASTMEM_MIN_LEN  8U  ///< Shorter calls take the byte loop
+
+#define HAS_ZERO_BYTE(w) (((w) - 0x01010101UL) & ~(w) & 0x80808080UL)
+
+/**
+ * @brief Word access to byte buffers without breaking aliasing rules.
+ */
+typedef uint32_t __attribute__((__may_alias__)) FastWord;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Copies @p blocks (at least one) 16-byte blocks between word-aligned
+ * buffers and advances both pointers.
+ */
+static inline void CopyBlocks(FastWord** dst, const FastWord** src, size_t blocks) {
+  FastWord* d = *dst;
+  const FastWord* s = *src;
+
+  do {
+#if defined(__ARM_ARCH_6M__)
+    __asm volatile("ldmia %1!, {r3, r4, r5, r6}\n\t"
+                   "stmia %0!, {r3, r4, r5, r6}"
+                   : "+l"(d), "+l"(s)
+                   :
+                   : "r3", "r4", "r5", "r6", "memory");
+#else
+    d[0] = s[0];
+    d[1] = s[1];
+    d[2] = s[2];
+    d[3] = s[3];
+    d += 4;
+    s += 4;
+#endif
+  } while (--blocks != 0);
+  *dst = d;
+  *src = s;
+}
+
+/**
+ * @brief Stores @p pattern over @p blocks (at least one) 16-byte blocks of a
+ * word-aligned buffer and advances the pointer.
+ */
+static inline void FillBlocks(FastWord** dst, uint32_t pattern, size_t blocks) {
+  FastWord* d = *dst;
+
+#if defined(__ARM_ARCH_6M__)
+  register uint32_t w0 __asm("r3") = pattern;
+  register uint32_t w1 __asm("r4") = pattern;
+  register uint32_t w2 __asm("r5") = pattern;
+  register uint32_t w3 __asm("r6") = pattern;
+  do {
+    __asm volatile("stmia %0!, {%1, %2, %3, %4}"
+                   : "+l"(d)
+                   : "l"(w0), "l"(w1), "l"(w2), "l"(w3)
+                   : "memory");
+  } while (--blocks != 0);
+#else
+  do {
+    d[0] = d[1] = d[2] = d[3] = pattern;
+    d += 4;
+  } while (--blocks != 0);
+#endif
+  *dst = d;
+}
+
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void* FastMemcpy(void* dst, const void* src, size_t len) {
+  uint8_t* d = dst;
+  const uint8_t* s = src;
+
+  if (len >= FASTMEM_MIN_LEN) {
+    while ((uintptr_t)d & 3U) {
+      *d++ = *s++;
+      --len;
+    }
+    FastWord* dw = (FastWord*)d;
+    size_t words = len / 4U;
+    uint32_t shift = ((uintptr_t)s & 3U) * 8U;
+
+    if (shift == 0) {
+      const FastWord* sw = (const FastWord*)s;
+      if (words >= 4U) {
+        CopyBlocks(&dw, &sw, words / 4U);
+      }
+      for (size_t i = 0; i < words % 4U; ++i) {
+        *dw++ = *sw++;
+      }
+    } else {
+      // Aligned loads, each output word merged from two source words
+      const FastWord* sw = (const FastWord*)(s - shift / 8U);
+      uint32_t low = *sw++;
+      for (size_t i = 0; i < words; ++i) {
+        uint32_t high = *sw++;
+        *dw++ = (low >> shift) | (high << (32U - shift));
+        low = high;
+      }
+    }
+    d = (uint8_t*)dw;
+    s += words * 4U;
+    len %= 4U;
+  }
+  while (len-- > 0) {
+    *d++ = *s++;
+  }
+  return dst;
+}
+
+void* FastMemset(void* dst, int value, size_t len) {
+  uint8_t* d = dst;
+  uint8_t byte = (uint8_t)value;
+
+  if (len >= FASTMEM_MIN_LEN) {
+    while ((uintptr_t)d & 3U) {
+      *d++ = byte;
+      --len;
+    }
+    FastWord* dw = (FastWord*)d;
+    uint32_t pattern = byte * 0x01010101UL;
+    if (len >= 16U) {
+      FillBlocks(&dw, pattern, len / 16U);
+    }
+    for (size_t i = 0; i < (len % 16U) / 4U; ++i) {
+      *dw++ = pattern;
+    }
+    d = (uint8_t*)dw;
+    len %= 4U;
+  }
+  while (len-- > 0) {
+    *d++ = byte;
+  }
+  return dst;
+}
+
+size_t FastStrlen(const char* str) {
+  const char* p = str;
+
+  while ((uintptr_t)p & 3U) {
+    if (*p == '\0') {
+      return (size_t)(p - str);
+    }
+    ++p;
+  }
+  const FastWord* w = (const FastWord*)p;
+  while (!HAS_ZERO_BYTE(*w)) {
+    ++w;
+  }
+  for (p = (const char*)w; *p != '\0'; ++p) {
+  }
+  return (size_t)(p - str);
+}
+
+int FastStrcmp(const char* a, const char* b) {
+  const uint8_t* pa = (const uint8_t*)a;
+  const uint8_t* pb = (const uint8_t*)b;
+
+  if ((((uintptr_t)pa ^ (uintptr_t)pb) & 3U) == 0) {
+    while ((uintptr_t)pa & 3U) {
+      if ((*pa == '\0') || (*pa != *pb)) {
+        return *pa - *pb;
+      }
+      ++pa;
+      ++pb;
+    }
+    // Equal words without a zero byte mean neither string ends there
+    const FastWord* wa = (const FastWord*)pa;
+    const FastWord* wb = (const FastWord*)pb;
+    while ((*wa == *wb) && !HAS_ZERO_BYTE(*wa)) {
+      ++wa;
+      ++wb;
+    }
+    pa = (const uint8_t*)wa;
+    pb = (const uint8_t*)wb;
+  }
+  while ((*pa != '\0') && (*pa == *pb)) {
+    ++pa;
+    ++pb;
+  }
+  return *pa - *pb;
+}
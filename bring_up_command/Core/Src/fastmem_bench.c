@@ -0,0 +1,171 @@
+// fastmem_bench.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Cycle count comparison of the fastmem routines with newlib-nano
+// (see fastmem.h). Kept apart from fastmem.c, which has no target
+// dependency and is also built natively by the host tools.
+
+#include "fastmem.h"
+#include "cycle_count.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_MAX_SIZE   256U
+#define BENCH_RUNS       4
+
+typedef size_t (*BenchFn)(void* dst, const void* src, size_t len);
+
+typedef struct {
+  const char* name;
+  BenchFn newlib;
+  BenchFn fast;
+} BenchEntry;
+
+// Called through volatile pointers so the compiler cannot expand them inline
+static void* (*volatile newlib_memcpy)(void*, const void*, size_t) = memcpy;
+static void* (*volatile newlib_memset)(void*, int, size_t) = memset;
+static size_t (*volatile newlib_strlen)(const char*) = strlen;
+static int (*volatile newlib_strcmp)(const char*, const char*) = strcmp;
+
+static const uint16_t kBenchSizes[] = {4, 16, 64, 256};
+
+static uint32_t bench_src[(BENCH_MAX_SIZE + 8U) / 4U];
+static uint32_t bench_dst[(BENCH_MAX_SIZE + 8U) / 4U];
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static size_t BenchNothing(void* dst, const void* src, size_t len) {
+  (void)dst;
+  (void)src;
+  return len;
+}
+
+static size_t BenchNewlibMemcpy(void* dst, const void* src, size_t len) {
+  newlib_memcpy(dst, src, len);
+  return 0;
+}
+
+static size_t BenchFastMemcpy(void* dst, const void* src, size_t len) {
+  FastMemcpy(dst, src, len);
+  return 0;
+}
+
+// memset fills the source buffer, so that the offset applies to it too
+static size_t BenchNewlibMemset(void* dst, const void* src, size_t len) {
+  (void)dst;
+  newlib_memset((void*)(uintptr_t)src, 0x5A, len);
+  return 0;
+}
+
+static size_t BenchFastMemset(void* dst, const void* src, size_t len) {
+  (void)dst;
+  FastMemset((void*)(uintptr_t)src, 0x5A, len);
+  return 0;
+}
+
+static size_t BenchNewlibStrlen(void* dst, const void* src, size_t len) {
+  (void)dst;
+  (void)len;
+  return newlib_strlen(src);
+}
+
+static size_t BenchFastStrlen(void* dst, const void* src, size_t len) {
+  (void)dst;
+  (void)len;
+  return FastStrlen(src);
+}
+
+static size_t BenchNewlibStrcmp(void* dst, const void* src, size_t len) {
+  (void)len;
+  return (size_t)newlib_strcmp(dst, src);
+}
+
+static size_t BenchFastStrcmp(void* dst, const void* src, size_t len) {
+  (void)len;
+  return (size_t)FastStrcmp(dst, src);
+}
+
+static const BenchEntry kBenchEntries[] = {
+    {"memcpy", BenchNewlibMemcpy, BenchFastMemcpy},
+    {"memset", BenchNewlibMemset, BenchFastMemset},
+    {"strlen", BenchNewlibStrlen, BenchFastStrlen},
+    {"strcmp", BenchNewlibStrcmp, BenchFastStrcmp},
+};
+
+/**
+ * @brief Best SysTick cycle count of @p fn over BENCH_RUNS runs.
+ */
+static uint32_t BenchCycles(BenchFn fn, void* dst, const void* src, size_t len) {
+  uint32_t best = UINT32_MAX;
+
+  for (int run = 0; run < BENCH_RUNS; ++run) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = CycleCountStart();
+    fn(dst, src, len);
+    uint32_t cycles = CycleCountElapsed(start);
+    __set_PRIMASK(primask);
+
+    if (cycles < best) {
+      best = cycles;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Prepares the buffers for one measurement: a string of @p len
+ * 'a's at the source (and a copy at the destination, for strcmp).
+ */
+static void BenchSetup(uint8_t* dst, uint8_t* src, size_t len) {
+  memset(src, 'a', len);
+  src[len] = '\0';
+  memcpy(dst, src, len + 1U);
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode FastmemBenchmark(Console* console, const char* function) {
+  const BenchEntry* entry = NULL;
+  char line[96];
+
+  for (size_t i = 0; i < sizeof(kBenchEntries) / sizeof(kBenchEntries[0]); ++i) {
+    if (strcmp(function, kBenchEntries[i].name) == 0) {
+      entry = &kBenchEntries[i];
+      break;
+    }
+  }
+  if (entry == NULL) {
+    return kInvalidArgument;
+  }
+
+  uint8_t* dst = (uint8_t*)bench_dst;
+  uint8_t* src = (uint8_t*)bench_src;
+  uint32_t overhead = BenchCycles(BenchNothing, dst, src, 0);
+
+  snprintf(line, sizeof(line), "%s cycles (newlib/fast) by source offset:\r\n"
+           "  size        +0        +1        +2        +3\r\n", entry->name);
+  ConsolePrint(console, line);
+  for (size_t i = 0; i < sizeof(kBenchSizes) / sizeof(kBenchSizes[0]); ++i) {
+    size_t len = kBenchSizes[i];
+    int pos = snprintf(line, sizeof(line), "  %4u", (unsigned)len);
+
+    for (uint32_t offset = 0; offset < 4U; ++offset) {
+      uint32_t cycles[2];
+      for (int impl = 0; impl < 2; ++impl) {
+        BenchSetup(dst, src + offset, len);
+        cycles[impl] = BenchCycles(impl ? entry->fast : entry->newlib, dst, src + offset, len);
+        cycles[impl] = (cycles[impl] > overhead) ? cycles[impl] - overhead : 0U;
+      }
+      pos += snprintf(&line[pos], sizeof(line) - (size_t)pos, "  %4lu/%-4lu",
+                      (unsigned long)cycles[0], (unsigned long)cycles[1]);
+    }
+    snprintf(&line[pos], sizeof(line) - (size_t)pos, "\r\n");
+    ConsolePrint(console, line);
+  }
+  return kOk;
+}
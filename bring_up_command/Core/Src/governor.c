@@ -0,0 +1,333 @@
+// governor.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Operating point selection from command load and console backlog
+// (see governor.h).
+
+#include "governor.h"
+#include "loop_monitor.h"
+#include "main.h"
+#include "profiler.h"
+#include "spi_console.h"
+#include "timesync.h"
+#include "uart_console.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+  const char* name;
+  uint32_t sysclk_hz;
+  uint32_t source;   ///< RCC_SYSCLKSOURCE_*
+  uint32_t vos;      ///< PWR_REGULATOR_VOLTAGE_SCALE*: larger is lower voltage
+  uint32_t latency;  ///< FLASH_LATENCY_*
+  uint8_t range;     ///< Voltage range number, for the report
+} GovernorPointInfo;
+
+static const GovernorPointInfo kPoints[kGovernorPoints] = {
+    [kGovernorMsi4]  = {"msi4",  4194304U,  RCC_SYSCLKSOURCE_MSI,    PWR_REGULATOR_VOLTAGE_SCALE3,
+                        FLASH_LATENCY_0, 3},
+    [kGovernorHsi16] = {"hsi16", 16000000U, RCC_SYSCLKSOURCE_HSI,    PWR_REGULATOR_VOLTAGE_SCALE2,
+                        FLASH_LATENCY_1, 2},
+    [kGovernorPll32] = {"pll32", 32000000U, RCC_SYSCLKSOURCE_PLLCLK, PWR_REGULATOR_VOLTAGE_SCALE1,
+                        FLASH_LATENCY_1, 1},
+};
+
+static struct {
+  uint8_t point;
+  uint8_t automatic;
+  uint8_t fixed;           ///< Point kept outside automatic mode
+  uint8_t up_pct;
+  uint8_t down_pct;
+  uint16_t hold_windows;
+  uint16_t idle_windows;   ///< Idle windows in a row
+  uint32_t window_start_ms;
+  uint32_t window_busy_us; ///< LoopMonitorBusyMicros() at the window start
+  uint32_t boost_until_ms;
+  uint8_t boosted;
+  uint8_t load_pct;        ///< Of the last window
+  uint16_t backlog;        ///< At the end of the last window
+  uint32_t switches;
+  uint32_t deferred;       ///< Switches given up because a port stayed busy
+  uint32_t failures;       ///< Oscillator or clock switch errors
+  uint32_t point_since_ms;
+  uint32_t residency_ms[kGovernorPoints];
+} governor;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static void GovernorSetVoltage(uint32_t vos) {
+  __HAL_PWR_VOLTAGESCALING_CONFIG(vos);
+  while (__HAL_PWR_GET_FLAG(PWR_FLAG_VOS)) {
+  }
+}
+
+/**
+ * @brief Moves the clock tree and the regulator to @p to.
+ */
+static ReturnCode GovernorApply(uint8_t to) {
+  const GovernorPointInfo* target = &kPoints[to];
+  RCC_OscInitTypeDef osc = {0};
+  RCC_ClkInitTypeDef clk = {0};
+
+  // Up: raise the voltage before the clock
+  if (target->vos < (PWR->CR & PWR_CR_VOS)) {
+    GovernorSetVoltage(target->vos);
+  }
+
+  osc.PLL.PLLState = RCC_PLL_NONE;
+  if (to == kGovernorMsi4) {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+    osc.MSIState = RCC_MSI_ON;
+    osc.MSIClockRange = RCC_MSIRANGE_6;
+    osc.MSICalibrationValue = RCC_MSICALIBRATION_DEFAULT;
+  } else {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_ON;
+    osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    if (to == kGovernorPll32) {
+      osc.PLL.PLLState = RCC_PLL_ON;
+      osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+      osc.PLL.PLLMUL = RCC_PLLMUL_4;
+      osc.PLL.PLLDIV = RCC_PLLDIV_2;
+    }
+  }
+  if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+    return kError;
+  }
+
+  // Also reloads SysTick for the new HCLK
+  clk.ClockType = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 |
+                  RCC_CLOCKTYPE_PCLK2;
+  clk.SYSCLKSource = target->source;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = RCC_HCLK_DIV1;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  if (HAL_RCC_ClockConfig(&clk, target->latency) != HAL_OK) {
+    return kError;
+  }
+
+  // Stop the oscillators left unused
+  memset(&osc, 0, sizeof(osc));
+  osc.PLL.PLLState = (to == kGovernorPll32) ? RCC_PLL_NONE : RCC_PLL_OFF;
+  if (to == kGovernorMsi4) {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_OFF;
+  } else {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+    osc.MSIState = RCC_MSI_OFF;
+  }
+  HAL_RCC_OscConfig(&osc);
+
+  // Down: lower the voltage after the clock
+  if (target->vos > (PWR->CR & PWR_CR_VOS)) {
+    GovernorSetVoltage(target->vos);
+  }
+  return kOk;
+}
+
+/**
+ * @brief Switches to @p to once the UART ports are quiet.
+ *
+ * @return kOk, kFull if they stayed busy for GOVERNOR_QUIET_MS, kError if
+ *     the clock change failed.
+ */
+static ReturnCode GovernorSwitch(uint8_t to) {
+  uint32_t start = HAL_GetTick();
+
+  while (!UartConsoleHoldTx(1)) {
+    if (HAL_GetTick() - start >= GOVERNOR_QUIET_MS) {
+      UartConsoleHoldTx(0);
+      ++governor.deferred;
+      return kFull;
+    }
+  }
+
+  ReturnCode rc = GovernorApply(to);
+  UartConsoleRetune();
+  TimesyncClockChanged();
+  ProfilerClockChanged();
+  UartConsoleHoldTx(0);
+  if (rc != kOk) {
+    ++governor.failures;
+    return rc;
+  }
+
+  uint32_t now = HAL_GetTick();
+  governor.residency_ms[governor.point] += now - governor.point_since_ms;
+  governor.point_since_ms = now;
+  governor.point = to;
+  ++governor.switches;
+  return kOk;
+}
+
+/**
+ * @brief Lowest point at or above @p point where every UART port keeps its
+ * baud rate and the SPI console its SCK.
+ */
+static uint8_t GovernorReachable(uint8_t point) {
+  while ((point < kGovernorPll32) && (!UartConsoleBaudReachable(kPoints[point].sysclk_hz) ||
+                                      !SpiConsoleClockReachable(kPoints[point].sysclk_hz))) {
+    ++point;
+  }
+  return point;
+}
+
+/**
+ * @brief Closes the current window: takes the load and the backlog and
+ * returns the point wanted in automatic mode.
+ */
+static uint8_t GovernorEvaluate(uint32_t now) {
+  uint32_t busy = LoopMonitorBusyMicros();
+  uint32_t window_us = (now - governor.window_start_ms) * 1000U;
+  uint32_t busy_us = busy - governor.window_busy_us;
+
+  governor.load_pct = (uint8_t)((busy_us >= window_us) ? 100U
+                                                       : ((uint64_t)busy_us * 100U / window_us));
+  governor.backlog = UartConsoleBacklog();
+  governor.window_start_ms = now;
+  governor.window_busy_us = busy;
+
+  if ((governor.load_pct >= governor.up_pct) || (governor.backlog >= GOVERNOR_BACKLOG_BYTES)) {
+    governor.idle_windows = 0;
+    return kGovernorPll32;  // Fast up
+  }
+  if ((governor.load_pct > governor.down_pct) || (governor.backlog != 0)) {
+    governor.idle_windows = 0;
+    return governor.point;
+  }
+  if (++governor.idle_windows < governor.hold_windows) {
+    return governor.point;
+  }
+  governor.idle_windows = 0;
+  return (governor.point > kGovernorMsi4) ? (uint8_t)(governor.point - 1U) : governor.point;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void GovernorInit(void) {
+  uint32_t now = HAL_GetTick();
+
+  memset(&governor, 0, sizeof(governor));
+  governor.point = kGovernorPll32;
+  governor.fixed = kGovernorPll32;
+  governor.automatic = GOVERNOR_AUTO;
+  governor.up_pct = GOVERNOR_UP_PCT;
+  governor.down_pct = GOVERNOR_DOWN_PCT;
+  governor.hold_windows = GOVERNOR_HOLD_WINDOWS;
+  governor.window_start_ms = now;
+  governor.window_busy_us = LoopMonitorBusyMicros();
+  governor.point_since_ms = now;
+}
+
+void GovernorProcess(void) {
+  uint32_t now = HAL_GetTick();
+  uint8_t target;
+
+  if (governor.boosted && ((int32_t)(now - governor.boost_until_ms) >= 0)) {
+    governor.boosted = 0;
+  }
+  if (governor.boosted) {
+    // Keep trying every pass until the boost point is reached
+    if (governor.point != kGovernorPll32) {
+      GovernorSwitch(kGovernorPll32);
+    }
+    return;
+  }
+  if (now - governor.window_start_ms < GOVERNOR_WINDOW_MS) {
+    return;
+  }
+
+  target = GovernorEvaluate(now);
+  if (!governor.automatic) {
+    target = governor.fixed;
+  }
+  target = GovernorReachable(target);
+  if (target != governor.point) {
+    GovernorSwitch(target);
+  }
+}
+
+ReturnCode GovernorBoost(uint32_t ms) {
+  uint32_t until = HAL_GetTick() + ms;
+
+  if (!governor.boosted || ((int32_t)(until - governor.boost_until_ms) > 0)) {
+    governor.boost_until_ms = until;
+  }
+  governor.boosted = 1;
+  governor.idle_windows = 0;
+  if (governor.point == kGovernorPll32) {
+    return kOk;
+  }
+  return (GovernorSwitch(kGovernorPll32) == kOk) ? kOk : kFull;
+}
+
+void GovernorSetAuto(void) {
+  governor.automatic = 1;
+  governor.idle_windows = 0;
+}
+
+ReturnCode GovernorSetFixed(const char* name) {
+  uint8_t point = kGovernorPoints;
+
+  for (uint8_t i = 0; i < kGovernorPoints; ++i) {
+    if (strcmp(kPoints[i].name, name) == 0) {
+      point = i;
+    }
+  }
+  if ((point == kGovernorPoints) || (GovernorReachable(point) != point)) {
+    return kInvalidArgument;
+  }
+  governor.automatic = 0;
+  governor.fixed = point;
+  if (governor.boosted || (point == governor.point)) {
+    return kOk;  // Reached when the boost ends
+  }
+  return GovernorSwitch(point);
+}
+
+ReturnCode GovernorTune(uint32_t up_pct, uint32_t down_pct, uint32_t hold_windows) {
+  if ((up_pct > 100U) || (down_pct >= up_pct) || (hold_windows == 0) ||
+      (hold_windows > UINT16_MAX)) {
+    return kInvalidArgument;
+  }
+  governor.up_pct = (uint8_t)up_pct;
+  governor.down_pct = (uint8_t)down_pct;
+  governor.hold_windows = (uint16_t)hold_windows;
+  return kOk;
+}
+
+void GovernorReport(Console* console) {
+  const GovernorPointInfo* point = &kPoints[governor.point];
+  uint32_t now = HAL_GetTick();
+  uint32_t total = 0;
+  uint32_t residency[kGovernorPoints];
+  char line[80];
+
+  snprintf(line, sizeof(line), "%s: %lu Hz, range %u, %s%s\r\n", point->name,
+           (unsigned long)HAL_RCC_GetSysClockFreq(), point->range,
+           governor.automatic ? "auto" : "fixed", governor.boosted ? ", boosted" : "");
+  ConsolePrint(console, line);
+  snprintf(line, sizeof(line), "load %u%%, backlog %u B; up at %u%%, down at %u%% for %u x %u ms\r\n",
+           governor.load_pct, governor.backlog, governor.up_pct, governor.down_pct,
+           governor.hold_windows, (unsigned)GOVERNOR_WINDOW_MS);
+  ConsolePrint(console, line);
+  snprintf(line, sizeof(line), "%lu switches, %lu deferred, %lu failed\r\n",
+           (unsigned long)governor.switches, (unsigned long)governor.deferred,
+           (unsigned long)governor.failures);
+  ConsolePrint(console, line);
+
+  for (uint8_t i = 0; i < kGovernorPoints; ++i) {
+    residency[i] = governor.residency_ms[i] +
+                   ((i == governor.point) ? (now - governor.point_since_ms) : 0U);
+    total += residency[i];
+  }
+  for (uint8_t i = 0; i < kGovernorPoints; ++i) {
+    snprintf(line, sizeof(line), "  %-6s %10lu ms  %3lu%%\r\n", kPoints[i].name,
+             (unsigned long)residency[i],
+             (unsigned long)((total == 0) ? 0U : (uint64_t)residency[i] * 100U / total));
+    ConsolePrint(console, line);
+  }
+}
@@ -0,0 +1,514 @@
+// linktest.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// PRBS generator and checker streaming through a borrowed console UART
+// with circular DMA (see linktest.h).
+
+#include "linktest.h"
+#include "governor.h"
+#include "main.h"
+#include "uart_console.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LINKTEST_HALF (LINKTEST_DMA_SIZE / 2)
+
+typedef enum {
+  kLinktestIdle = 0,
+  kLinktestAcquiring,   ///< Waiting for the port's console output to drain
+  kLinktestRunning,
+} LinktestState;
+
+/**
+ * @brief Fibonacci PRBS register; bit 0 holds the newest bit.
+ */
+typedef struct {
+  uint32_t state;
+  uint32_t mask;
+  uint8_t order;
+  uint8_t tap;
+} Prbs;
+
+typedef struct {
+  Prbs ref;
+  uint8_t locked;
+  uint8_t seeded;          ///< Bytes shifted in since the checker was reset
+  uint8_t good;            ///< Correct predictions while unlocked
+  uint8_t window;          ///< Bytes in the current unlock window
+  uint16_t window_errors;
+} Checker;
+
+typedef struct {
+  char port[8];
+  uint32_t baud;
+  uint8_t order;
+  LinktestMode mode;
+  const char* status;      ///< Why the test did not run, NULL if it did
+  uint32_t elapsed_ms;
+  uint32_t tx_bytes;
+  uint32_t rx_raw;         ///< Bytes received, locked or not
+  uint32_t rx_bytes;       ///< Bytes compared while locked
+  uint32_t errors;         ///< Bit errors
+  uint32_t bursts;
+  uint32_t longest_burst;  ///< Bytes from first to last error of a burst
+  uint32_t resyncs;
+  uint32_t uart_errors;
+  uint8_t locked_once;
+  uint32_t lock_ms;
+  uint32_t last_rx_ms;
+} LinktestResult;
+
+static const char* const kModeNames[] = {"host", "loop", "ext"};
+static const uint8_t kBitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+static uint8_t tx_buf[LINKTEST_DMA_SIZE];
+static uint8_t rx_buf[LINKTEST_DMA_SIZE];
+
+static struct {
+  volatile LinktestState state;
+  Console* console;
+  uint32_t duration_ms;
+  uint32_t start_ms;
+  volatile uint8_t stop;
+  UART_HandleTypeDef* huart;
+  UART_InitTypeDef saved_init;
+  Prbs gen;
+  Checker check;
+  uint16_t rx_pos;         ///< Next RX buffer byte to check
+  uint32_t last_error;     ///< rx_bytes at the last error
+  uint32_t burst_start;    ///< rx_bytes at the first error of the burst
+} test;
+
+static LinktestResult result;
+
+static void LinktestTxComplete(UART_HandleTypeDef* huart);
+static void LinktestUartError(UART_HandleTypeDef* huart);
+
+static const UartConsoleHooks kHooks = {LinktestTxComplete, LinktestUartError};
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static void PrbsInit(Prbs* prbs, uint8_t order) {
+  prbs->order = order;
+  prbs->tap = (order == 7) ? 6 : ((order == 15) ? 14 : 28);
+  prbs->mask = (order == 31) ? 0x7FFFFFFFUL : ((1UL << order) - 1U);
+  prbs->state = prbs->mask;
+}
+
+/**
+ * @brief Returns the next 8 bits of the sequence, oldest in bit 7.
+ *
+ * b[k] = b[k - order] ^ b[k - tap] gives as many bits per step as the
+ * shorter tap: 8 for PRBS-15/31, two nibbles for PRBS-7.
+ */
+static inline uint8_t PrbsNext(Prbs* prbs) {
+  uint32_t s = prbs->state;
+  uint32_t out;
+
+  if (prbs->tap >= 8) {
+    out = ((s >> (prbs->order - 8)) ^ (s >> (prbs->tap - 8))) & 0xFFU;
+    s = (s << 8) | out;
+  } else {
+    uint32_t high = ((s >> (prbs->order - 4)) ^ (s >> (prbs->tap - 4))) & 0xFU;
+    s = (s << 4) | high;
+    uint32_t low = ((s >> (prbs->order - 4)) ^ (s >> (prbs->tap - 4))) & 0xFU;
+    s = (s << 4) | low;
+    out = (high << 4) | low;
+  }
+  prbs->state = s & prbs->mask;
+  return (uint8_t)out;
+}
+
+static void LinktestFill(uint8_t* half) {
+  for (uint16_t i = 0; i < LINKTEST_HALF; ++i) {
+    half[i] = PrbsNext(&test.gen);
+  }
+  result.tx_bytes += LINKTEST_HALF;
+}
+
+static void CheckerReset(Checker* checker) {
+  checker->locked = 0;
+  checker->seeded = 0;
+  checker->good = 0;
+}
+
+/**
+ * @brief Unlocked checker: loads received bytes into the reference until
+ * LINKTEST_LOCK_BYTES consecutive bytes are predicted correctly.
+ */
+static void CheckerSeed(Checker* checker, uint8_t byte) {
+  Prbs* ref = &checker->ref;
+
+  if (checker->seeded < (ref->order + 7) / 8) {
+    ref->state = ((ref->state << 8) | byte) & ref->mask;
+    checker->seeded++;
+    return;
+  }
+  if (PrbsNext(ref) == byte) {
+    if (++checker->good == LINKTEST_LOCK_BYTES) {
+      checker->locked = 1;
+      checker->window = 0;
+      checker->window_errors = 0;
+      if (!result.locked_once) {
+        result.locked_once = 1;
+        result.lock_ms = HAL_GetTick();
+      }
+    }
+    return;
+  }
+  // PrbsNext() shifted in its prediction; use the received byte instead
+  ref->state = ((ref->state & ~0xFFUL) | byte) & ref->mask;
+  checker->good = 0;
+}
+
+static void CheckerError(uint8_t diff) {
+  uint32_t bits = kBitCount[diff & 0xFU] + kBitCount[diff >> 4];
+  uint32_t at = result.rx_bytes;
+
+  test.check.window_errors += bits;
+  result.errors += bits;
+  if ((result.bursts == 0) || (at - test.last_error > LINKTEST_BURST_GAP)) {
+    result.bursts++;
+    test.burst_start = at;
+  }
+  test.last_error = at;
+  if (at - test.burst_start + 1U > result.longest_burst) {
+    result.longest_burst = at - test.burst_start + 1U;
+  }
+}
+
+static void LinktestCheck(const uint8_t* data, uint16_t len) {
+  Checker* checker = &test.check;
+
+  result.rx_raw += len;
+  for (uint16_t i = 0; i < len; ++i) {
+    if (!checker->locked) {
+      CheckerSeed(checker, data[i]);
+      continue;
+    }
+
+    uint8_t diff = data[i] ^ PrbsNext(&checker->ref);
+    result.rx_bytes++;
+    if (diff != 0) {
+      CheckerError(diff);
+    }
+    if (++checker->window == 8) {
+      if (checker->window_errors > LINKTEST_UNLOCK_ERRORS) {
+        CheckerReset(checker);
+        result.resyncs++;
+      }
+      checker->window = 0;
+      checker->window_errors = 0;
+    }
+  }
+  if (checker->locked) {
+    result.last_rx_ms = HAL_GetTick();
+  }
+}
+
+static void LinktestStartRx(void) {
+  test.rx_pos = 0;
+  HAL_UART_Receive_DMA(test.huart, rx_buf, LINKTEST_DMA_SIZE);
+}
+
+/**
+ * @brief TX DMA reached the end of the buffer: refill the second half.
+ */
+static void LinktestTxComplete(UART_HandleTypeDef* huart) {
+  if (test.state == kLinktestRunning) {
+    LinktestFill(&tx_buf[LINKTEST_HALF]);
+  }
+}
+
+/**
+ * @brief HAL stops DMA reception on any receive error; count and restart.
+ */
+static void LinktestUartError(UART_HandleTypeDef* huart) {
+  if (test.state != kLinktestRunning) {
+    return;
+  }
+  result.uart_errors++;
+  if (huart->RxState == HAL_UART_STATE_READY) {
+    CheckerReset(&test.check);
+    LinktestStartRx();
+  }
+}
+
+/**
+ * @brief Applies the test baud rate, falling back to 8x oversampling when
+ * 16x cannot reach it.
+ */
+static HAL_StatusTypeDef LinktestConfigure(UART_HandleTypeDef* huart, uint32_t baud,
+                                           LinktestMode mode) {
+  HAL_StatusTypeDef status = HAL_ERROR;
+
+  huart->Init.BaudRate = baud;
+  for (uint8_t attempt = 0; (attempt < 2) && (status != HAL_OK); ++attempt) {
+    if (attempt == 1) {
+      if (IS_LPUART_INSTANCE(huart->Instance)) {
+        break;  // No oversampling choice on the LPUART
+      }
+      huart->Init.OverSampling = UART_OVERSAMPLING_8;
+    }
+    status = (mode == kLinktestLoop) ? HAL_HalfDuplex_Init(huart) : HAL_UART_Init(huart);
+  }
+  return status;
+}
+
+static void LinktestRestore(void) {
+  test.huart->hdmatx->Init.Mode = DMA_NORMAL;
+  HAL_DMA_Init(test.huart->hdmatx);
+  test.huart->Init = test.saved_init;
+  HAL_UART_Init(test.huart);  // Also leaves half-duplex mode
+  UartConsoleRelease(test.huart);
+}
+
+/**
+ * @brief Takes the port and starts both DMA streams.
+ *
+ * @return 1 once the test runs or has failed, 0 to try again later.
+ */
+static uint8_t LinktestBegin(void) {
+  // Full clock for the highest rates, and no switch retuning the port
+  // during the test
+  ReturnCode rc = GovernorBoost(GOVERNOR_BOOST_MS);
+  if (rc == kOk) {
+    rc = UartConsoleAcquire(result.port, &kHooks, &test.huart);
+  }
+
+  if (rc == kFull) {
+    if (HAL_GetTick() - test.start_ms < LINKTEST_ACQUIRE_MS) {
+      return 0;
+    }
+    result.status = "port busy";
+    return 1;
+  }
+  if (rc != kOk) {
+    result.status = "no such port";
+    return 1;
+  }
+
+  test.saved_init = test.huart->Init;
+  if (LinktestConfigure(test.huart, result.baud, result.mode) != HAL_OK) {
+    result.status = "baud rate not reachable";
+    test.huart->Init = test.saved_init;
+    HAL_UART_Init(test.huart);
+    UartConsoleRelease(test.huart);
+    return 1;
+  }
+  test.huart->hdmatx->Init.Mode = DMA_CIRCULAR;
+  HAL_DMA_Init(test.huart->hdmatx);
+
+  PrbsInit(&test.gen, result.order);
+  PrbsInit(&test.check.ref, result.order);
+  CheckerReset(&test.check);
+  LinktestFill(&tx_buf[0]);
+  LinktestFill(&tx_buf[LINKTEST_HALF]);
+  result.tx_bytes = 0;  // Counted as halves are refilled, i.e. sent
+
+  test.start_ms = HAL_GetTick();
+  test.state = kLinktestRunning;
+  LinktestStartRx();
+  HAL_UART_Transmit_DMA(test.huart, tx_buf, LINKTEST_DMA_SIZE);
+  return 1;
+}
+
+/**
+ * @brief Stops both streams, checks the last received bytes and gives the
+ * port back to its console.
+ */
+static void LinktestEnd(void) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  uint16_t dma_pos = LINKTEST_DMA_SIZE - __HAL_DMA_GET_COUNTER(test.huart->hdmarx);
+  uint16_t tx_pos = LINKTEST_DMA_SIZE - __HAL_DMA_GET_COUNTER(test.huart->hdmatx);
+  uint16_t rx_pos = test.rx_pos;
+  test.state = kLinktestIdle;
+  HAL_UART_Abort(test.huart);
+  __set_PRIMASK(primask);
+
+  result.elapsed_ms = HAL_GetTick() - test.start_ms;
+  result.tx_bytes += tx_pos % LINKTEST_HALF;  // Part of the half being sent
+  if (dma_pos < rx_pos) {
+    LinktestCheck(&rx_buf[rx_pos], LINKTEST_DMA_SIZE - rx_pos);
+    rx_pos = 0;
+  }
+  LinktestCheck(&rx_buf[rx_pos], dma_pos - rx_pos);
+
+  LinktestRestore();
+}
+
+/**
+ * @brief Formats errors / bits as "2.1e-7" ("<" and 1 / bits without
+ * errors), with integer arithmetic only.
+ */
+static void FormatBer(char* out, size_t size, uint32_t errors, uint32_t bytes) {
+  uint64_t bits = (uint64_t)bytes * 8U;
+  uint64_t scaled = (errors > 0) ? errors : 1U;
+  int exponent = 0;
+
+  if (bits == 0) {
+    snprintf(out, size, "n/a");
+    return;
+  }
+  while (scaled < bits) {  // Until errors / bits is scaled into [1, 10)
+    scaled *= 10U;
+    exponent--;
+  }
+  uint32_t mantissa = (uint32_t)((scaled * 10U) / bits);  // 10..99
+  snprintf(out, size, "%s%c.%ce%s%u", (errors > 0) ? "" : "<", (char)('0' + mantissa / 10U % 10U),
+           (char)('0' + mantissa % 10U), (exponent < 0) ? "-" : "", (unsigned)(uint8_t)-exponent);
+}
+
+static uint32_t PerSecond(uint32_t bytes, uint32_t ms) {
+  return (ms > 0) ? (uint32_t)(((uint64_t)bytes * 1000U) / ms) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode LinktestStart(Console* console, const char* port, uint32_t baud, uint8_t order,
+                         uint32_t duration_ms, LinktestMode mode) {
+  if (test.state != kLinktestIdle) {
+    return kFull;
+  }
+  if (((order != 7) && (order != 15) && (order != 31)) || (duration_ms == 0) ||
+      (baud == 0) || (mode > kLinktestExternal) || (strlen(port) >= sizeof(result.port))) {
+    return kInvalidArgument;
+  }
+
+  memset(&result, 0, sizeof(result));
+  strcpy(result.port, port);
+  result.baud = baud;
+  result.order = order;
+  result.mode = mode;
+  test.console = console;
+  test.duration_ms = duration_ms;
+  test.start_ms = HAL_GetTick();
+  test.stop = 0;
+  test.last_error = 0;
+  test.burst_start = 0;
+  test.state = kLinktestAcquiring;
+  return kOk;
+}
+
+ReturnCode LinktestStop(void) {
+  if (test.state == kLinktestIdle) {
+    return kEmpty;
+  }
+  test.stop = 1;
+  return kOk;
+}
+
+void LinktestReport(Console* console) {
+  char buffer[96];
+  char ber[16];
+
+  if (result.baud == 0) {
+    ConsolePrint(console, "No link test run yet.\r\n");
+    return;
+  }
+  snprintf(buffer, sizeof(buffer), "linktest %s %lu baud prbs%u %s", result.port,
+           (unsigned long)result.baud, result.order, kModeNames[result.mode]);
+  ConsolePrint(console, buffer);
+  if (test.state != kLinktestIdle) {
+    ConsolePrint(console, ": running\r\n");
+    return;
+  }
+  if (result.status != NULL) {
+    ConsolePrint(console, ": ");
+    ConsolePrint(console, result.status);
+    ConsolePrint(console, "\r\n");
+    return;
+  }
+
+  uint32_t tx_rate = PerSecond(result.tx_bytes, result.elapsed_ms);
+  snprintf(buffer, sizeof(buffer), ", %lu ms\r\ntx %lu B, %lu B/s (%lu%% of line)\r\n",
+           (unsigned long)result.elapsed_ms, (unsigned long)result.tx_bytes,
+           (unsigned long)tx_rate, (unsigned long)(tx_rate * 1000U / result.baud));
+  ConsolePrint(console, buffer);
+
+  if (!result.locked_once) {
+    snprintf(buffer, sizeof(buffer), "rx no lock (%lu B received)\r\n",
+             (unsigned long)result.rx_raw);
+    ConsolePrint(console, buffer);
+  } else {
+    FormatBer(ber, sizeof(ber), result.errors, result.rx_bytes);
+    snprintf(buffer, sizeof(buffer), "rx %lu B, %lu B/s, %lu bit errors, BER %s\r\n",
+             (unsigned long)result.rx_bytes,
+             (unsigned long)PerSecond(result.rx_bytes, result.last_rx_ms - result.lock_ms),
+             (unsigned long)result.errors, ber);
+    ConsolePrint(console, buffer);
+  }
+  snprintf(buffer, sizeof(buffer), "%lu bursts (longest %lu B), %lu resyncs, %lu uart errors\r\n",
+           (unsigned long)result.bursts, (unsigned long)result.longest_burst,
+           (unsigned long)result.resyncs, (unsigned long)result.uart_errors);
+  ConsolePrint(console, buffer);
+}
+
+void LinktestProcess(void) {
+  if (test.state == kLinktestAcquiring) {
+    if (!LinktestBegin()) {
+      return;
+    }
+    if (test.state != kLinktestRunning) {
+      test.state = kLinktestIdle;
+      LinktestReport(test.console);
+    }
+    return;
+  }
+
+  if (test.state == kLinktestRunning) {
+    GovernorBoost(GOVERNOR_BOOST_MS);
+  }
+  if ((test.state == kLinktestRunning) &&
+      (test.stop || (HAL_GetTick() - test.start_ms >= test.duration_ms))) {
+    LinktestEnd();
+    LinktestReport(test.console);
+    test.console->result = (int32_t)result.errors;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// HAL callbacks
+// -----------------------------------------------------------------------------
+/**
+  * @brief  TX half complete callback: refills the half the DMA just left.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  if ((test.state == kLinktestRunning) && (huart == test.huart)) {
+    LinktestFill(&tx_buf[0]);
+  }
+}
+
+/**
+  * @brief  RX half complete callback: checks the first half.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  if ((test.state == kLinktestRunning) && (huart == test.huart)) {
+    LinktestCheck(&rx_buf[test.rx_pos], LINKTEST_HALF - test.rx_pos);
+    test.rx_pos = LINKTEST_HALF;
+  }
+}
+
+/**
+  * @brief  RX complete callback: checks the second half.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if ((test.state == kLinktestRunning) && (huart == test.huart)) {
+    LinktestCheck(&rx_buf[test.rx_pos], LINKTEST_DMA_SIZE - test.rx_pos);
+    test.rx_pos = 0;
+  }
+}
@@ -0,0 +1,252 @@
+// loop_monitor.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Main loop timing, stalled command capture and IWDG refresh
+// (see loop_monitor.h).
+
+#include "loop_monitor.h"
+#include "clock_gate.h"
+#include "main.h"
+#include "timesync.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOOP_MONITOR_NAME_SIZE  16
+#define LOOP_MONITOR_MAGIC      0x4C4F4F50UL  // "LOOP"
+#define LOOP_MONITOR_IDLE_NAME  "(main loop)"
+
+#define IWDG_KEY_START    0xCCCCU
+#define IWDG_KEY_ACCESS   0x5555U
+#define IWDG_KEY_REFRESH  0xAAAAU
+#define IWDG_PRESCALER    4U      ///< LSI / 64
+#define IWDG_LSI_HZ       37000U  ///< Typical; the real LSI is within +-40%
+
+typedef struct {
+  char name[LOOP_MONITOR_NAME_SIZE];  ///< Empty when the slot is free
+  uint32_t count;
+  uint32_t worst_us;
+  uint32_t total_us;
+} LoopOffender;
+
+/**
+ * @brief Survives resets: the command running when the watchdog bit.
+ */
+typedef struct {
+  uint32_t magic;
+  char running[LOOP_MONITOR_NAME_SIZE];  ///< Empty between commands
+} LoopMonitorPersist;
+
+static LoopMonitorPersist persist __attribute__((section(".noinit")));
+
+static struct {
+  uint8_t started;
+  uint8_t command_charged;  ///< A slow command was recorded during this pass
+  uint32_t threshold_us;
+  uint32_t last_us;         ///< Start of the current pass
+  uint32_t enter_us;        ///< Start of the running command
+  uint32_t passes;
+  uint32_t max_us;
+  uint32_t busy_us;         ///< Total time in commands (wraps)
+  uint32_t histogram[LOOP_MONITOR_BUCKETS];
+  LoopOffender offenders[LOOP_MONITOR_OFFENDERS];
+  char wdg_reset[LOOP_MONITOR_NAME_SIZE];  ///< Running at the last watchdog reset
+} monitor;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint32_t LoopMonitorNow(void) {
+  return (uint32_t)TimesyncLocalMicros();
+}
+
+static uint32_t LoopMonitorBucket(uint32_t elapsed_us) {
+  uint32_t bucket = 0;
+
+  for (uint32_t v = elapsed_us >> 4; (v != 0) && (bucket < LOOP_MONITOR_BUCKETS - 1U); v >>= 1) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+/**
+ * @brief Charges @p elapsed_us to @p name, replacing the entry with the
+ * smallest worst time when the table is full and this one is worse.
+ */
+static void LoopMonitorCharge(const char* name, uint32_t elapsed_us) {
+  LoopOffender* slot = NULL;
+
+  for (int i = 0; (i < LOOP_MONITOR_OFFENDERS) && (slot == NULL); ++i) {
+    LoopOffender* entry = &monitor.offenders[i];
+    if ((entry->name[0] != '\0') &&
+        (strncmp(entry->name, name, LOOP_MONITOR_NAME_SIZE - 1) == 0)) {
+      slot = entry;
+    }
+  }
+  if (slot == NULL) {
+    // Free slots have a worst time of 0, so they go first
+    slot = &monitor.offenders[0];
+    for (int i = 1; i < LOOP_MONITOR_OFFENDERS; ++i) {
+      if (monitor.offenders[i].worst_us < slot->worst_us) {
+        slot = &monitor.offenders[i];
+      }
+    }
+    if ((slot->name[0] != '\0') && (slot->worst_us >= elapsed_us)) {
+      return;  // Milder than everything kept
+    }
+    memset(slot, 0, sizeof(*slot));
+    snprintf(slot->name, sizeof(slot->name), "%s", name);
+  }
+  ++slot->count;
+  slot->total_us += elapsed_us;
+  if (elapsed_us > slot->worst_us) {
+    slot->worst_us = elapsed_us;
+  }
+}
+
+static void LoopMonitorStartWatchdog(void) {
+#if LOOP_MONITOR_WDG_MS > 0
+  uint32_t reload = (uint32_t)LOOP_MONITOR_WDG_MS * (IWDG_LSI_HZ / 1000U) / (4U << IWDG_PRESCALER);
+
+  if (reload > IWDG_RLR_RL) {
+    reload = IWDG_RLR_RL;
+  }
+  // Stop the counter while the core is halted by a debugger
+  ClockGateAcquire(kClockGateDbgmcu, 0);
+  DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;
+
+  IWDG->KR = IWDG_KEY_START;  // Also starts the LSI
+  IWDG->KR = IWDG_KEY_ACCESS;
+  IWDG->PR = IWDG_PRESCALER;
+  IWDG->RLR = reload;
+  while (IWDG->SR != 0) {
+  }
+  IWDG->KR = IWDG_KEY_REFRESH;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void LoopMonitorInit(void) {
+  memset(&monitor, 0, sizeof(monitor));
+  monitor.threshold_us = LOOP_MONITOR_STALL_MS * 1000U;
+
+  if (RCC->CSR & RCC_CSR_IWDGRSTF) {
+    uint8_t valid = (persist.magic == LOOP_MONITOR_MAGIC) &&
+                    (memchr(persist.running, '\0', sizeof(persist.running)) != NULL);
+    const char* name = (valid && (persist.running[0] != '\0')) ? persist.running
+                                                               : LOOP_MONITOR_IDLE_NAME;
+    snprintf(monitor.wdg_reset, sizeof(monitor.wdg_reset), "%s", name);
+    LoopMonitorCharge(name, LOOP_MONITOR_WDG_MS * 1000U);
+  }
+  RCC->CSR |= RCC_CSR_RMVF;
+  persist.magic = LOOP_MONITOR_MAGIC;
+  persist.running[0] = '\0';
+
+  LoopMonitorStartWatchdog();
+}
+
+void LoopMonitorTick(void) {
+  uint32_t now = LoopMonitorNow();
+
+  if (monitor.started) {
+    uint32_t elapsed = now - monitor.last_us;
+    ++monitor.histogram[LoopMonitorBucket(elapsed)];
+    ++monitor.passes;
+    if (elapsed > monitor.max_us) {
+      monitor.max_us = elapsed;
+    }
+    if ((elapsed >= monitor.threshold_us) && !monitor.command_charged) {
+      LoopMonitorCharge(LOOP_MONITOR_IDLE_NAME, elapsed);
+    }
+  }
+  monitor.started = 1;
+  monitor.command_charged = 0;
+  monitor.last_us = now;
+#if LOOP_MONITOR_WDG_MS > 0
+  IWDG->KR = IWDG_KEY_REFRESH;
+#endif
+}
+
+void LoopMonitorEnter(const char* name) {
+  snprintf(persist.running, sizeof(persist.running), "%s", name);
+  monitor.enter_us = LoopMonitorNow();
+}
+
+uint32_t LoopMonitorLeave(void) {
+  uint32_t elapsed = LoopMonitorNow() - monitor.enter_us;
+
+  monitor.busy_us += elapsed;
+  if (elapsed >= monitor.threshold_us) {
+    LoopMonitorCharge(persist.running, elapsed);
+    monitor.command_charged = 1;
+  }
+  persist.running[0] = '\0';
+  return elapsed;
+}
+
+uint32_t LoopMonitorBusyMicros(void) {
+  return monitor.busy_us;
+}
+
+ReturnCode LoopMonitorSetThreshold(uint32_t ms) {
+  if ((ms == 0) || (ms > UINT32_MAX / 1000U)) {
+    return kInvalidArgument;
+  }
+  monitor.threshold_us = ms * 1000U;
+  return kOk;
+}
+
+void LoopMonitorReset(void) {
+  monitor.passes = 0;
+  monitor.max_us = 0;
+  memset(monitor.histogram, 0, sizeof(monitor.histogram));
+  memset(monitor.offenders, 0, sizeof(monitor.offenders));
+}
+
+void LoopMonitorReport(Console* console) {
+  const LoopOffender* sorted[LOOP_MONITOR_OFFENDERS];
+  int count = 0;
+  char line[96];
+
+  snprintf(line, sizeof(line), "%lu passes, max %lu us, stall at %lu ms, watchdog %u ms\r\n",
+           (unsigned long)monitor.passes, (unsigned long)monitor.max_us,
+           (unsigned long)(monitor.threshold_us / 1000U), (unsigned)LOOP_MONITOR_WDG_MS);
+  ConsolePrint(console, line);
+  for (uint32_t i = 0; i < LOOP_MONITOR_BUCKETS; ++i) {
+    if (monitor.histogram[i] != 0) {
+      snprintf(line, sizeof(line), "  %s%7lu us: %lu\r\n", (i == 0) ? "< " : ">=",
+               (unsigned long)((i == 0) ? 16U : (8UL << i)), (unsigned long)monitor.histogram[i]);
+      ConsolePrint(console, line);
+    }
+  }
+
+  // Worst first (insertion sort of a handful of entries)
+  for (int i = 0; i < LOOP_MONITOR_OFFENDERS; ++i) {
+    const LoopOffender* entry = &monitor.offenders[i];
+    if (entry->name[0] == '\0') {
+      continue;
+    }
+    int j = count++;
+    for (; (j > 0) && (sorted[j - 1]->worst_us < entry->worst_us); --j) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = entry;
+  }
+  if (count == 0) {
+    ConsolePrint(console, "No stalls.\r\n");
+  } else {
+    ConsolePrint(console, "  command          count  worst ms  total ms\r\n");
+  }
+  for (int i = 0; i < count; ++i) {
+    snprintf(line, sizeof(line), "  %-15s %6lu  %8lu  %8lu\r\n", sorted[i]->name,
+             (unsigned long)sorted[i]->count, (unsigned long)(sorted[i]->worst_us / 1000U),
+             (unsigned long)(sorted[i]->total_us / 1000U));
+    ConsolePrint(console, line);
+  }
+  if (monitor.wdg_reset[0] != '\0') {
+    snprintf(line, sizeof(line), "Last reset by the watchdog, during %s.\r\n", monitor.wdg_reset);
+    ConsolePrint(console, line);
+  }
+}
@@ -0,0 +1,116 @@
+// lz.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Streaming LZSS compressor over a 512-byte ring (see lz.h).
+
+#include "lz.h"
+
+#define LZ_RING_MASK (LZ_RING_SIZE - 1U)
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static void LzFlushGroup(LzEncoder* lz) {
+  if (lz->items > 0) {
+    lz->sink(lz->context, lz->group, lz->group_len);
+  }
+  lz->group[0] = 0;
+  lz->group_len = 1;
+  lz->items = 0;
+}
+
+/**
+ * @brief Finds the longest match for the lookahead at lz->pos.
+ *
+ * Searches nearest distances first so that runs (distance 1) are found
+ * at once and stop the search at LZ_MAX_MATCH.
+ */
+static uint16_t LzLongestMatch(const LzEncoder* lz, uint16_t* distance) {
+  uint32_t available = lz->end - lz->pos;
+  uint32_t max_distance = (lz->pos < LZ_WINDOW) ? lz->pos : LZ_WINDOW;
+  uint16_t limit = (available < LZ_MAX_MATCH) ? (uint16_t)available : LZ_MAX_MATCH;
+  uint16_t best = 0;
+  const uint8_t* ring = lz->ring;
+  uint32_t pos = lz->pos;
+
+  if (limit < LZ_MIN_MATCH) {
+    return 0;
+  }
+  uint8_t first = ring[pos & LZ_RING_MASK];
+  for (uint32_t d = 1; d <= max_distance; ++d) {
+    uint32_t from = pos - d;
+    if ((ring[from & LZ_RING_MASK] != first) ||
+        (ring[(from + best) & LZ_RING_MASK] != ring[(pos + best) & LZ_RING_MASK])) {
+      continue;  // Cannot beat the current best
+    }
+    uint16_t n = 1;
+    while ((n < limit) && (ring[(from + n) & LZ_RING_MASK] == ring[(pos + n) & LZ_RING_MASK])) {
+      ++n;
+    }
+    if (n > best) {
+      best = n;
+      *distance = (uint16_t)d;
+      if (best == limit) {
+        break;
+      }
+    }
+  }
+  return (best >= LZ_MIN_MATCH) ? best : 0;
+}
+
+/**
+ * @brief Encodes one item from the lookahead.
+ */
+static void LzEncodeOne(LzEncoder* lz) {
+  uint16_t distance = 0;
+  uint16_t length = LzLongestMatch(lz, &distance);
+
+  if (length == 0) {
+    lz->group[0] |= (uint8_t)(1U << lz->items);
+    lz->group[lz->group_len++] = lz->ring[lz->pos & LZ_RING_MASK];
+    lz->pos += 1;
+  } else {
+    lz->group[lz->group_len++] = (uint8_t)(distance - 1U);
+    lz->group[lz->group_len++] = (uint8_t)(length - LZ_MIN_MATCH);
+    lz->pos += length;
+  }
+  if (++lz->items == 8) {
+    LzFlushGroup(lz);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void LzInit(LzEncoder* lz, LzSink sink, void* context) {
+  lz->pos = 0;
+  lz->end = 0;
+  lz->sink = sink;
+  lz->context = context;
+  lz->group[0] = 0;
+  lz->group_len = 1;
+  lz->items = 0;
+}
+
+void LzWrite(LzEncoder* lz, const uint8_t* data, uint16_t len) {
+  for (uint16_t i = 0; i < len; ++i) {
+    // A full lookahead would overwrite the oldest window byte next
+    if (lz->end - lz->pos == LZ_MAX_MATCH) {
+      LzEncodeOne(lz);
+    }
+    lz->ring[lz->end & LZ_RING_MASK] = data[i];
+    lz->end += 1;
+  }
+}
+
+uint8_t LzFinish(LzEncoder* lz) {
+  do {
+    if (lz->pos == lz->end) {
+      LzFlushGroup(lz);
+      return 1;
+    }
+    LzEncodeOne(lz);
+  } while (lz->items != 0);
+  return 0;
+}
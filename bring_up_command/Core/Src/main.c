@@ -21,8 +21,23 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "ring_buffer.h"
-#include "command.h"
+#include "uart_console.h"
+#include "mux.h"
+#include "spi_console.h"
+#include "ram_console.h"
+#include "vm.h"
+#include "module.h"
+#include "watch.h"
+#include "selftest.h"
+#include "linktest.h"
+#include "rs485.h"
+#include "timesync.h"
+#include "dump.h"
+#include "xfer.h"
+#include "dma_copy.h"
+#include "loop_monitor.h"
+#include "clock_gate.h"
+#include "governor.h"
 #include "string.h"
 /* USER CODE END Includes */
 
@@ -42,8 +57,15 @@
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
+UART_HandleTypeDef hlpuart1;
+UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_lpuart1_rx;
+DMA_HandleTypeDef hdma_lpuart1_tx;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -54,61 +76,14 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_USART1_UART_Init(void);
+static void MX_LPUART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-//TODO: add commands using parameters
-#define RX_DMA_BUF_SIZE 128
-uint8_t rx_dma_buf[RX_DMA_BUF_SIZE];
-
-#define CMD_BUF_SIZE 64
-uint8_t cmd_buf[CMD_BUF_SIZE];
-
-RingBuffer ring_buf;
-
-/**
-  * @brief  UART receive event callback.
-  * This function is called by HAL when data is received via DMA
-  * @param  huart UART handle.
-  * @param  Size  Number of data received.
-  * @retval None
-  */
-
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t dma_pos)
-{
-    static uint16_t last_pos = 0;
-    uint16_t i;
-
-    if (huart->Instance == USART2) {
-    	// Store the previous DMA read position across multiple calls.
-        uint16_t start_pos = last_pos;
-
-        // If the new DMA position (Size) is smaller than the previous one,
-        // it means the circular DMA buffer has wrapped around.
-        // Size is DMA position
-        if (dma_pos < last_pos) {
-        	// Copy data from the old (last) position up to the end of the DMA buffer.
-            for (i = start_pos; i < RX_DMA_BUF_SIZE; i++) {
-                RingBufferPush(&ring_buf, rx_dma_buf[i]);
-            }
-            // After wrap, continue copying from the beginning of the DMA buffer.
-            start_pos = 0;
-        }
-
-        // Copy the newly received data between start_pos and the current DMA position.
-        for (i = start_pos; i < dma_pos; i++) {
-        	RingBufferPush(&ring_buf, rx_dma_buf[i]);
-
-        }
-
-        // Update previous position for the next callback.
-        last_pos = dma_pos;
-    }
-}
-
 static void print_tx(const char* str) {
     HAL_UART_Transmit(&huart2, (uint8_t*)str, strlen(str), HAL_MAX_DELAY);
 }
@@ -132,8 +107,7 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-  uint16_t num_byte;
-  uint32_t update_freq = 0;
+
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -147,25 +121,29 @@ int main(void)
   MX_GPIO_Init();
   MX_DMA_Init();
   MX_USART2_UART_Init();
+  MX_USART1_UART_Init();
+  MX_LPUART1_UART_Init();
   /* USER CODE BEGIN 2 */
   const char* msg = "Firmware initializing \r\n";
   /*Commum mode for  TX*/
   //HAL_UART_Transmit(&huart2, (uint8_t*)msg, strlen(msg), HAL_MAX_DELAY);
   print_tx(msg);
 
-  ReturnCode ret = kError;
-
-  ret = RingBufferInit(&ring_buf);
-
-  if(ret != kOk) {
-	  msg = "Failed in buffers initialization!\r\n";
-      //HAL_UART_Transmit(&huart2, (uint8_t*)msg, strlen(msg), HAL_MAX_DELAY);
-	  print_tx(msg);
-  }
-
-  print_tx("Test Console Initialized. \r\n Type 'help'.\r\n");
-
-  HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, RX_DMA_BUF_SIZE);
+  // From here on all output goes through the console sessions (DMA TX)
+  ClockGateInit();
+  UartConsoleInit();
+  RamConsoleInit();
+  ModuleInit();
+  Rs485Init();
+  TimesyncInit();
+  CommandBinaryInit();
+  XferInit();
+  DmaCopyInit();
+#if SPI_CONSOLE_ENABLED
+  SpiConsoleInit();
+#endif
+  GovernorInit();
+  LoopMonitorInit();
 
   /* USER CODE END 2 */
 
@@ -174,28 +152,22 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	    /* USER CODE BEGIN 3 */
-	  update_freq++;
-	  //TODO: move to a static function ReceiveCommand()
-	  if(update_freq == 500000){
-	    //HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-	    if(RingBufferIsEmpty(&ring_buf) != kEmpty){
-
-	      RingBufferCurrentSize(&ring_buf, &num_byte);
-
-	      RingBufferStreamPop(&ring_buf, cmd_buf, num_byte);
-
-	      //HAL_UART_Transmit(&huart2, cmd_buf, num_byte, HAL_MAX_DELAY);
-	      print_tx((char*)cmd_buf);
-	      print_tx("\r\n");
-
-	      CommandParserProcess(cmd_buf); // Processa o comando
-
-	      memset(cmd_buf, '\0', sizeof(cmd_buf));
-	    }
-	    update_freq = 0;
-	  }
-
+    /* USER CODE BEGIN 3 */
+    LoopMonitorTick();
+    UartConsoleProcess();
+    MuxProcess();
+    RamConsoleProcess();
+    VmProcess();
+    WatchProcess();
+    SelftestProcess();
+    LinktestProcess();
+    Rs485Process();
+    DumpProcess();
+    XferProcess();
+    GovernorProcess();
+#if SPI_CONSOLE_ENABLED
+    SpiConsoleProcess();
+#endif
   }
   /* USER CODE END 3 */
 }
@@ -242,14 +214,86 @@ void SystemClock_Config(void)
   {
     Error_Handler();
   }
-  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART2;
+  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART1|RCC_PERIPHCLK_USART2
+                              |RCC_PERIPHCLK_LPUART1;
+  PeriphClkInit.Usart1ClockSelection = RCC_USART1CLKSOURCE_PCLK2;
   PeriphClkInit.Usart2ClockSelection = RCC_USART2CLKSOURCE_PCLK1;
+  PeriphClkInit.Lpuart1ClockSelection = RCC_LPUART1CLKSOURCE_PCLK1;
   if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
   {
     Error_Handler();
   }
 }
 
+/**
+  * @brief LPUART1 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_LPUART1_UART_Init(void)
+{
+
+  /* USER CODE BEGIN LPUART1_Init 0 */
+
+  /* USER CODE END LPUART1_Init 0 */
+
+  /* USER CODE BEGIN LPUART1_Init 1 */
+
+  /* USER CODE END LPUART1_Init 1 */
+  hlpuart1.Instance = LPUART1;
+  hlpuart1.Init.BaudRate = 115200;
+  hlpuart1.Init.WordLength = UART_WORDLENGTH_8B;
+  hlpuart1.Init.StopBits = UART_STOPBITS_1;
+  hlpuart1.Init.Parity = UART_PARITY_NONE;
+  hlpuart1.Init.Mode = UART_MODE_TX_RX;
+  hlpuart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  hlpuart1.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+  hlpuart1.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+  if (HAL_UART_Init(&hlpuart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN LPUART1_Init 2 */
+
+  /* USER CODE END LPUART1_Init 2 */
+
+}
+
+/**
+  * @brief USART1 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_USART1_UART_Init(void)
+{
+
+  /* USER CODE BEGIN USART1_Init 0 */
+
+  /* USER CODE END USART1_Init 0 */
+
+  /* USER CODE BEGIN USART1_Init 1 */
+
+  /* USER CODE END USART1_Init 1 */
+  huart1.Instance = USART1;
+  huart1.Init.BaudRate = 115200;
+  huart1.Init.WordLength = UART_WORDLENGTH_8B;
+  huart1.Init.StopBits = UART_STOPBITS_1;
+  huart1.Init.Parity = UART_PARITY_NONE;
+  huart1.Init.Mode = UART_MODE_TX_RX;
+  huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+  huart1.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+  huart1.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+  if (HAL_UART_Init(&huart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN USART1_Init 2 */
+
+  /* USER CODE END USART1_Init 2 */
+
+}
+
 /**
   * @brief USART2 Initialization Function
   * @param None
@@ -295,6 +339,9 @@ static void MX_DMA_Init(void)
   __HAL_RCC_DMA1_CLK_ENABLE();
 
   /* DMA interrupt init */
+  /* DMA1_Channel2_3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
   /* DMA1_Channel4_5_6_7_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Channel4_5_6_7_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel4_5_6_7_IRQn);
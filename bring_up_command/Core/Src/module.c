@@ -0,0 +1,280 @@
+// module.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Upload, link and lookup of command modules executed from RAM
+// (see module.h).
+
+#include "module.h"
+#include "crc.h"
+#include "main.h"  // For the exported HAL functions
+#include "mux.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Run-time helpers called by compiler-generated code; only their addresses
+// are needed here
+extern void __aeabi_idiv(void);
+extern void __aeabi_uidiv(void);
+extern void __aeabi_idivmod(void);
+extern void __aeabi_uidivmod(void);
+extern void __aeabi_ldivmod(void);
+extern void __aeabi_uldivmod(void);
+extern void __aeabi_lmul(void);
+extern void __aeabi_llsl(void);
+extern void __aeabi_llsr(void);
+extern void __aeabi_lasr(void);
+
+#define MODULE_EXPORT_ADDRESS(index, symbol) [index] = (uintptr_t)&symbol,
+
+static const uintptr_t kExports[] = {MODULE_EXPORTS(MODULE_EXPORT_ADDRESS)};
+static const uint16_t kNumExports = sizeof(kExports) / sizeof(kExports[0]);
+
+static uint8_t module_area[MODULE_AREA_SIZE]
+    __attribute__((section(".modules"), aligned(8)));
+
+typedef struct {
+  uint16_t size;                          ///< Bytes of the area reserved
+  const ModuleDescriptor* descriptor;     ///< Descriptor inside the image
+} Module;
+
+static struct {
+  Module loaded[MODULE_MAX_LOADED];
+  uint8_t count;
+  uint16_t used;          ///< Area bytes taken by loaded modules
+  uint16_t upload_size;   ///< Size announced by BEGIN, 0 when idle
+  uint16_t received;      ///< Upload bytes received so far
+  uint8_t claimed;        ///< Free area held by ModuleAreaClaim()
+} modules;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint16_t ReadLe16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Adds a value to a 32-bit word of the image (which may be unaligned).
+ */
+static void AddToWord(uint8_t* p, uint32_t value) {
+  uint32_t word;
+  memcpy(&word, p, sizeof(word));
+  word += value;
+  memcpy(p, &word, sizeof(word));
+}
+
+static const ModuleDescriptor* FindModule(const char* name) {
+  for (uint8_t i = 0; i < modules.count; ++i) {
+    if (strcmp(modules.loaded[i].descriptor->name, name) == 0) {
+      return modules.loaded[i].descriptor;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Relocates and validates the uploaded image at the top of the area.
+ *
+ * @param module Filled in on success.
+ * @return kOk, kFull if the zeroed data does not fit, kInvalidArgument for
+ *     a malformed image, kError if a module of the same name is loaded.
+ */
+static ReturnCode ModuleLink(Module* module) {
+  uint8_t* base = &module_area[modules.used];
+  uint8_t* image = base + sizeof(ModuleImageHeader);
+  ModuleImageHeader header;
+
+  memcpy(&header, base, sizeof(header));
+  uint32_t tables = (uint32_t)header.num_relocs * 2U + (uint32_t)header.num_imports * 4U;
+  if ((header.magic != MODULE_IMAGE_MAGIC) || (header.api_version != MODULE_API_VERSION) ||
+      (sizeof(header) + header.image_size + tables != modules.upload_size) ||
+      ((header.descriptor & 3U) != 0) ||
+      ((uint32_t)header.descriptor + sizeof(ModuleDescriptor) > header.image_size)) {
+    return kInvalidArgument;
+  }
+
+  // The zeroed data reuses the space of the tables
+  uint32_t tail = (header.bss_size > tables) ? header.bss_size : tables;
+  uint32_t size = (sizeof(header) + header.image_size + tail + 7U) & ~7U;
+  if (modules.used + size > MODULE_AREA_SIZE) {
+    return kFull;
+  }
+
+  // Check both tables before changing anything
+  const uint8_t* relocs = image + header.image_size;
+  const uint8_t* imports = relocs + header.num_relocs * 2U;
+  for (uint16_t i = 0; i < header.num_relocs; ++i) {
+    if (ReadLe16(&relocs[i * 2U]) + 4U > header.image_size) {
+      return kInvalidArgument;
+    }
+  }
+  for (uint16_t i = 0; i < header.num_imports; ++i) {
+    if ((ReadLe16(&imports[i * 4U]) + 4U > header.image_size) ||
+        (ReadLe16(&imports[i * 4U + 2U]) >= kNumExports)) {
+      return kInvalidArgument;
+    }
+  }
+
+  for (uint16_t i = 0; i < header.num_relocs; ++i) {
+    AddToWord(&image[ReadLe16(&relocs[i * 2U])], (uint32_t)(uintptr_t)image);
+  }
+  for (uint16_t i = 0; i < header.num_imports; ++i) {
+    AddToWord(&image[ReadLe16(&imports[i * 4U])],
+              (uint32_t)kExports[ReadLe16(&imports[i * 4U + 2U])]);
+  }
+  memset(&image[header.image_size], 0, header.bss_size);
+
+  // Code was written as data; make sure it is visible before running it
+  __DSB();
+  __ISB();
+
+  const ModuleDescriptor* descriptor = (const ModuleDescriptor*)&image[header.descriptor];
+  const uint8_t* commands = (const uint8_t*)descriptor->commands;
+  if ((descriptor->magic != MODULE_DESCRIPTOR_MAGIC) || (commands < image) ||
+      (commands + descriptor->num_commands * sizeof(Command) > image + header.image_size)) {
+    return kInvalidArgument;
+  }
+  if (FindModule(descriptor->name) != NULL) {
+    return kError;
+  }
+
+  module->size = (uint16_t)size;
+  module->descriptor = descriptor;
+  return kOk;
+}
+
+static void ModuleAck(uint8_t message, ReturnCode rc, uint16_t value) {
+  uint8_t ack[5] = {MODULE_MSG_ACK, message, (uint8_t)rc, (uint8_t)(value & 0xFF),
+                    (uint8_t)(value >> 8)};
+  MuxWrite(MUX_CH_DATA, ack, sizeof(ack));
+}
+
+/**
+ * @brief Handles upload messages from the mux data channel.
+ */
+static void ModuleReceive(const uint8_t* payload, uint16_t len) {
+  if (len < 3) {
+    return;
+  }
+  uint8_t message = payload[0];
+  uint16_t value = ReadLe16(&payload[1]);
+
+  if (message == MODULE_MSG_BEGIN) {
+    modules.upload_size = 0;
+    if (value < sizeof(ModuleImageHeader)) {
+      ModuleAck(message, kInvalidArgument, 0);
+    } else if (modules.claimed || (modules.count == MODULE_MAX_LOADED) ||
+               (value > MODULE_AREA_SIZE - modules.used)) {
+      ModuleAck(message, kFull, 0);
+    } else {
+      modules.upload_size = value;
+      modules.received = 0;
+      ModuleAck(message, kOk, 0);
+    }
+  } else if (message == MODULE_MSG_DATA) {
+    uint16_t n = len - 3;
+    if (modules.upload_size == 0) {
+      ModuleAck(message, kError, 0);
+    } else if ((value != modules.received) || (n > modules.upload_size - value)) {
+      ModuleAck(message, kInvalidArgument, modules.received);  // Host resends from here
+    } else {
+      memcpy(&module_area[modules.used + value], &payload[3], n);
+      modules.received += n;
+      ModuleAck(message, kOk, modules.received);
+    }
+  } else if (message == MODULE_MSG_END) {
+    Module module;
+    ReturnCode rc = kError;
+
+    if ((modules.upload_size != 0) && (modules.received == modules.upload_size)) {
+      uint16_t crc = Crc16Ccitt(CRC16_CCITT_INIT, &module_area[modules.used],
+                                modules.upload_size);
+      rc = (crc == value) ? ModuleLink(&module) : kInvalidArgument;
+    }
+    modules.upload_size = 0;
+
+    if (rc != kOk) {
+      ModuleAck(message, rc, 0);
+      return;
+    }
+    modules.loaded[modules.count++] = module;
+    modules.used += module.size;
+    if (module.descriptor->init != NULL) {
+      module.descriptor->init();
+    }
+    ModuleAck(message, kOk, module.descriptor->num_commands);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void ModuleInit(void) {
+  modules.count = 0;
+  modules.used = 0;
+  modules.upload_size = 0;
+  modules.claimed = 0;
+  MuxSetReceiver(MUX_CH_DATA, ModuleReceive);
+}
+
+const Command* ModuleFindCommand(const char* name) {
+  for (uint8_t i = 0; i < modules.count; ++i) {
+    const ModuleDescriptor* descriptor = modules.loaded[i].descriptor;
+    for (uint16_t k = 0; k < descriptor->num_commands; ++k) {
+      if (strcmp(descriptor->commands[k].name, name) == 0) {
+        return &descriptor->commands[k];
+      }
+    }
+  }
+  return NULL;
+}
+
+uint8_t ModuleCount(void) {
+  return modules.count;
+}
+
+const ModuleDescriptor* ModuleAt(uint8_t index) {
+  return (index < modules.count) ? modules.loaded[index].descriptor : NULL;
+}
+
+ReturnCode ModuleUnload(const char* name) {
+  if (modules.count == 0) {
+    return kEmpty;
+  }
+  Module* last = &modules.loaded[modules.count - 1];
+  if ((name != NULL) && (strcmp(last->descriptor->name, name) != 0)) {
+    return kInvalidArgument;
+  }
+
+  modules.used -= last->size;
+  modules.count--;
+  modules.upload_size = 0;  // An upload in progress was placed above it
+  return kOk;
+}
+
+uint16_t ModuleAreaUsed(void) {
+  return modules.used;
+}
+
+uint8_t* ModuleAreaFree(uint16_t* size) {
+  if ((modules.upload_size != 0) || modules.claimed) {
+    *size = 0;
+    return NULL;
+  }
+  *size = MODULE_AREA_SIZE - modules.used;
+  return &module_area[modules.used];
+}
+
+uint8_t* ModuleAreaClaim(uint16_t* size) {
+  uint8_t* area = ModuleAreaFree(size);
+  if (area != NULL) {
+    modules.claimed = 1;
+  }
+  return area;
+}
+
+void ModuleAreaRelease(void) {
+  modules.claimed = 0;
+}
@@ -0,0 +1,300 @@
+// mux.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Virtual channel multiplexer: COBS framing, per-channel TX queues and a
+// priority-ordered deficit round robin scheduler.
+
+#include "mux.h"
+#include "cobs.h"
+#include "crc.h"
+#include <stddef.h>
+
+#define MUX_FRAME_OVERHEAD 3  // channel + crc16
+#define MUX_MAX_RAW        (MUX_MAX_PAYLOAD + MUX_FRAME_OVERHEAD)
+#define MUX_MAX_ENCODED    (COBS_MAX_ENCODED(MUX_MAX_RAW) + 1)  // + delimiter
+
+// -----------------------------------------------------------------------------
+// Channel configuration
+// -----------------------------------------------------------------------------
+typedef struct {
+  uint8_t priority;  ///< 0 is served first
+  uint8_t quantum;   ///< Bytes of credit per round (bandwidth share)
+} MuxChannelConfig;
+
+static const MuxChannelConfig kChannelConfig[MUX_NUM_CHANNELS] = {
+    [MUX_CH_CONSOLE] = {0, MUX_MAX_PAYLOAD},
+    [MUX_CH_LOG]     = {1, 32},
+    [MUX_CH_TRACE]   = {2, 32},
+    [MUX_CH_DATA]    = {3, MUX_MAX_PAYLOAD},
+};
+
+typedef struct {
+  RingBuffer tx;    ///< Pending payload bytes
+  int16_t deficit;  ///< Remaining credit in the current round
+} MuxChannel;
+
+static struct {
+  Console* link;                          ///< Console whose transport is muxed
+  Console console;                        ///< Session on MUX_CH_CONSOLE
+  MuxChannel channels[MUX_NUM_CHANNELS];
+  uint8_t rx_frame[MUX_MAX_ENCODED];      ///< Encoded frame being received
+  uint16_t rx_len;
+  uint8_t rx_discard;                     ///< Drop input up to next delimiter
+} mux;
+
+static MuxReceiveFn receivers[MUX_NUM_CHANNELS];  ///< Host input handlers
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint16_t MuxQueued(MuxChannel* channel) {
+  uint16_t used = 0;
+  RingBufferCurrentItems(&channel->tx, &used);
+  return used;
+}
+
+/**
+ * @brief Picks the next channel to transmit, refilling credit when every
+ * backlogged channel has spent its share.
+ *
+ * @return Channel index, or -1 if nothing is queued.
+ */
+static int MuxSelect(void) {
+  for (int round = 0; round < 2; ++round) {
+    int best = -1;
+    uint8_t backlogged = 0;
+
+    for (int i = 0; i < MUX_NUM_CHANNELS; ++i) {
+      if (MuxQueued(&mux.channels[i]) == 0) {
+        continue;
+      }
+      backlogged = 1;
+      if ((mux.channels[i].deficit > 0) &&
+          ((best < 0) || (kChannelConfig[i].priority < kChannelConfig[best].priority))) {
+        best = i;
+      }
+    }
+
+    if ((best >= 0) || !backlogged) {
+      return best;
+    }
+
+    // New round: every backlogged channel earns its quantum
+    for (int i = 0; i < MUX_NUM_CHANNELS; ++i) {
+      if (MuxQueued(&mux.channels[i]) > 0) {
+        mux.channels[i].deficit += kChannelConfig[i].quantum;
+      }
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Encodes and sends one frame.
+ */
+static void MuxSendFrame(uint8_t channel, const uint8_t* payload, uint16_t len) {
+  uint8_t raw[MUX_MAX_RAW];
+  uint8_t encoded[MUX_MAX_ENCODED];
+
+  raw[0] = channel;
+  for (uint16_t i = 0; i < len; ++i) {
+    raw[1 + i] = payload[i];
+  }
+  uint16_t crc = Crc16Ccitt(CRC16_CCITT_INIT, raw, len + 1);
+  raw[len + 1] = (uint8_t)(crc & 0xFF);
+  raw[len + 2] = (uint8_t)(crc >> 8);
+
+  uint16_t n = CobsEncode(raw, len + MUX_FRAME_OVERHEAD, encoded);
+  encoded[n++] = 0x00;
+  ConsoleWrite(mux.link, encoded, n);
+}
+
+/**
+ * @brief Emits frames for as long as the link can take a full frame
+ * without blocking.
+ */
+static void MuxPumpTx(void) {
+  while (ConsoleWritable(mux.link) >= MUX_MAX_ENCODED) {
+    int index = MuxSelect();
+    if (index < 0) {
+      return;
+    }
+
+    MuxChannel* channel = &mux.channels[index];
+    uint16_t len = MuxQueued(channel);
+    if (len > MUX_MAX_PAYLOAD) {
+      len = MUX_MAX_PAYLOAD;
+    }
+    if (len > (uint16_t)channel->deficit) {
+      len = (uint16_t)channel->deficit;
+    }
+
+    uint8_t payload[MUX_MAX_PAYLOAD];
+    RingBufferStreamPop(&channel->tx, payload, len);
+    MuxSendFrame((uint8_t)index, payload, len);
+
+    channel->deficit -= len;
+    if (MuxQueued(channel) == 0) {
+      channel->deficit = 0;  // Idle channels do not bank credit
+    }
+  }
+}
+
+/**
+ * @brief Validates and dispatches one decoded frame.
+ */
+static void MuxDispatch(uint8_t* frame, uint16_t len) {
+  if (len < MUX_FRAME_OVERHEAD) {
+    return;
+  }
+
+  uint16_t crc = (uint16_t)frame[len - 2] | ((uint16_t)frame[len - 1] << 8);
+  if (Crc16Ccitt(CRC16_CCITT_INIT, frame, len - 2) != crc) {
+    return;
+  }
+
+  uint8_t channel = frame[0];
+  const uint8_t* payload = &frame[1];
+  uint16_t payload_len = len - MUX_FRAME_OVERHEAD;
+
+  if (channel == MUX_CH_CONSOLE) {
+    ConsoleReceive(&mux.console, payload, payload_len);
+  } else if ((channel == MUX_CH_CONTROL) && (payload_len > 0) &&
+             (payload[0] == MUX_CTRL_EXIT)) {
+    MuxStop();
+  } else if ((channel < MUX_NUM_CHANNELS) && (receivers[channel] != NULL)) {
+    receivers[channel](payload, payload_len);
+  }
+}
+
+/**
+ * @brief Feeds raw link input through the frame decoder.
+ */
+static void MuxPumpRx(void) {
+  uint8_t c;
+
+  while ((mux.link != NULL) && (RingBufferPop(&mux.link->rx, &c) == kOk)) {
+    if (c != 0x00) {
+      if (mux.rx_len < sizeof(mux.rx_frame)) {
+        mux.rx_frame[mux.rx_len++] = c;
+      } else {
+        mux.rx_discard = 1;
+      }
+      continue;
+    }
+
+    uint16_t len;
+    if (!mux.rx_discard && (mux.rx_len > 0) &&
+        (CobsDecode(mux.rx_frame, mux.rx_len, &len) == 0)) {
+      MuxDispatch(mux.rx_frame, len);
+    }
+    mux.rx_len = 0;
+    mux.rx_discard = 0;
+  }
+}
+
+/**
+ * @brief Console output on MUX_CH_CONSOLE; waits for queue space if needed.
+ */
+static void MuxConsoleWrite(Console* console, const uint8_t* data, uint16_t len) {
+  MuxChannel* channel = &mux.channels[MUX_CH_CONSOLE];
+
+  while ((len > 0) && (mux.link != NULL)) {
+    uint16_t free_items = 0;
+    RingBufferFreeItems(&channel->tx, &free_items);
+
+    uint16_t chunk = (len < free_items) ? len : free_items;
+    if (chunk > 0) {
+      RingBufferStreamPush(&channel->tx, (uint8_t*)data, chunk);
+      data += chunk;
+      len -= chunk;
+    }
+    MuxPumpTx();
+  }
+}
+
+static uint16_t MuxConsoleWritable(const Console* console) {
+  uint16_t free_items = 0;
+  RingBufferFreeItems(&mux.channels[MUX_CH_CONSOLE].tx, &free_items);
+  return free_items;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode MuxStart(Console* link) {
+  if ((link == NULL) || (mux.link != NULL)) {
+    return kError;
+  }
+
+  for (int i = 0; i < MUX_NUM_CHANNELS; ++i) {
+    RingBufferInit(&mux.channels[i].tx);
+    mux.channels[i].deficit = 0;
+  }
+  ConsoleInit(&mux.console, "mux", MuxConsoleWrite, NULL);
+  mux.console.writable = MuxConsoleWritable;
+
+  // Whatever follows the `mux` command line up to the first delimiter is
+  // leftover text, not a frame
+  mux.rx_len = 0;
+  mux.rx_discard = 1;
+
+  link->detached = 1;
+  mux.link = link;
+
+  return kOk;
+}
+
+void MuxStop(void) {
+  if (mux.link != NULL) {
+    mux.link->detached = 0;
+    mux.link = NULL;
+  }
+}
+
+uint8_t MuxIsActive(void) {
+  return (mux.link != NULL) ? 1 : 0;
+}
+
+Console* MuxGetConsole(void) {
+  return &mux.console;
+}
+
+void MuxProcess(void) {
+  if (mux.link == NULL) {
+    return;
+  }
+
+  MuxPumpRx();
+  ConsoleProcess(&mux.console);
+  if (mux.link != NULL) {
+    MuxPumpTx();
+  }
+}
+
+ReturnCode MuxWrite(uint8_t channel, const uint8_t* data, uint16_t len) {
+  if ((channel >= MUX_NUM_CHANNELS) || (data == NULL)) {
+    return kInvalidArgument;
+  }
+  if (mux.link == NULL) {
+    return kError;
+  }
+
+  if (RingBufferWillFull(&mux.channels[channel].tx, len) == kFull) {
+    return kFull;
+  }
+  return RingBufferStreamPush(&mux.channels[channel].tx, (uint8_t*)data, len);
+}
+
+ReturnCode MuxSetReceiver(uint8_t channel, MuxReceiveFn receive) {
+  if ((channel == MUX_CH_CONSOLE) || (channel >= MUX_NUM_CHANNELS)) {
+    return kInvalidArgument;
+  }
+  receivers[channel] = receive;
+  return kOk;
+}
+
+MuxReceiveFn MuxGetReceiver(uint8_t channel) {
+  return (channel < MUX_NUM_CHANNELS) ? receivers[channel] : NULL;
+}
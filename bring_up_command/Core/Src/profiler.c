@@ -0,0 +1,220 @@
+// profiler.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// PC sampling on TIM6 into a hashed histogram (see profiler.h).
+
+#include "profiler.h"
+#include "clock_gate.h"
+#include "dump.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PROFILER_HEADER_WORDS 6
+#define PROFILER_HEADER_SIZE  (PROFILER_HEADER_WORDS * 4U)
+#define PROFILER_ENTRY_SIZE   6U  // pc_le32 | count_le16
+#define PROFILER_REPORT_TOP   8
+
+_Static_assert((PROFILER_BUCKETS & (PROFILER_BUCKETS - 1)) == 0, "PROFILER_BUCKETS: power of two");
+_Static_assert(PROFILER_BUCKETS <= 65536, "PROFILER_BUCKETS: hash uses 16 bits");
+_Static_assert((PROFILER_GRANULE >= 2) && ((PROFILER_GRANULE & (PROFILER_GRANULE - 1)) == 0),
+               "PROFILER_GRANULE: power of two, at least 2");
+
+static struct {
+  uint32_t pcs[PROFILER_BUCKETS];     ///< 0: empty
+  uint16_t counts[PROFILER_BUCKETS];
+  volatile uint32_t samples;
+  volatile uint32_t dropped;          ///< No bucket within PROFILER_PROBES
+  volatile uint8_t shift;             ///< Halvings; one sample in 1 << shift is recorded
+  uint8_t running;
+  uint32_t rate_hz;
+  uint32_t stream_header[PROFILER_HEADER_WORDS];
+} profiler;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Loads the TIM6 prescaler and period for profiler.rate_hz at the
+ * current timer clock.
+ */
+static void ProfilerProgramTimer(void) {
+  uint32_t clock = HAL_RCC_GetPCLK1Freq() * ((RCC->CFGR & RCC_CFGR_PPRE1_2) ? 2U : 1U);
+  uint32_t ticks = clock / profiler.rate_hz;
+  uint32_t prescaler = (ticks + 0xFFFFU) / 0x10000U;
+
+  if (prescaler == 0) {
+    prescaler = 1;
+  }
+  TIM6->PSC = prescaler - 1U;
+  TIM6->ARR = (ticks / prescaler > 1U) ? (ticks / prescaler - 1U) : 1U;
+  TIM6->EGR = TIM_EGR_UG;  // Load them now; URS keeps this from raising UIF
+}
+
+/**
+ * @brief Halves every count, so the ratios survive a count that would
+ * overflow; the caller records half as many samples from then on.
+ */
+static void ProfilerHalve(void) {
+  for (uint32_t i = 0; i < PROFILER_BUCKETS; ++i) {
+    profiler.counts[i] >>= 1;
+  }
+  ++profiler.shift;
+}
+
+/**
+ * @brief Stream source: the header frozen by ProfilerDump(), then the
+ * buckets.
+ */
+static ReturnCode ProfilerRead(uint32_t offset, uint8_t* out, uint16_t len) {
+  for (uint16_t i = 0; i < len; ++i, ++offset) {
+    uint32_t word;
+    uint32_t byte;
+
+    if (offset < PROFILER_HEADER_SIZE) {
+      word = profiler.stream_header[offset / 4U];
+      byte = offset % 4U;
+    } else {
+      uint32_t index = (offset - PROFILER_HEADER_SIZE) / PROFILER_ENTRY_SIZE;
+      byte = (offset - PROFILER_HEADER_SIZE) % PROFILER_ENTRY_SIZE;
+      if (byte < 4U) {
+        word = profiler.pcs[index];
+      } else {
+        word = profiler.counts[index];
+        byte -= 4U;
+      }
+    }
+    out[i] = (uint8_t)(word >> (8U * byte));
+  }
+  return kOk;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode ProfilerStart(uint32_t rate_hz) {
+  if ((rate_hz == 0) || (rate_hz > PROFILER_MAX_HZ)) {
+    return kInvalidArgument;
+  }
+  if (!profiler.running) {
+    ClockGateAcquire(kClockGateTim6, 1);  // Keeps sampling while the core sleeps
+    TIM6->CR1 = TIM_CR1_URS;
+    TIM6->DIER = TIM_DIER_UIE;
+  }
+  profiler.rate_hz = rate_hz;
+  ProfilerProgramTimer();
+  TIM6->SR = 0;
+  if (!profiler.running) {
+    profiler.running = 1;
+    HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    TIM6->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+  }
+  return kOk;
+}
+
+void ProfilerStop(void) {
+  if (!profiler.running) {
+    return;
+  }
+  TIM6->CR1 = 0;
+  TIM6->DIER = 0;
+  HAL_NVIC_DisableIRQ(TIM6_DAC_IRQn);
+  TIM6->SR = 0;
+  HAL_NVIC_ClearPendingIRQ(TIM6_DAC_IRQn);
+  ClockGateRelease(kClockGateTim6, 1);
+  profiler.running = 0;
+}
+
+void ProfilerReset(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  memset(profiler.pcs, 0, sizeof(profiler.pcs));
+  memset(profiler.counts, 0, sizeof(profiler.counts));
+  profiler.samples = 0;
+  profiler.dropped = 0;
+  profiler.shift = 0;
+  __set_PRIMASK(primask);
+}
+
+ReturnCode ProfilerDump(uint8_t flags) {
+  ProfilerStop();
+  profiler.stream_header[0] = profiler.samples;
+  profiler.stream_header[1] = profiler.dropped;
+  profiler.stream_header[2] = profiler.rate_hz;
+  profiler.stream_header[3] = PROFILER_BUCKETS;
+  profiler.stream_header[4] = profiler.shift;
+  profiler.stream_header[5] = PROFILER_GRANULE;
+  return DumpStartSource(ProfilerRead, PROFILER_TAG,
+                         PROFILER_HEADER_SIZE + PROFILER_BUCKETS * PROFILER_ENTRY_SIZE, flags);
+}
+
+void ProfilerReport(Console* console) {
+  uint16_t top[PROFILER_REPORT_TOP];
+  uint8_t used = 0;
+  uint32_t buckets = 0;
+  char line[96];
+
+  for (uint32_t i = 0; i < PROFILER_BUCKETS; ++i) {
+    if (profiler.pcs[i] == 0) {
+      continue;
+    }
+    ++buckets;
+    uint8_t at = (used < PROFILER_REPORT_TOP) ? used++ : PROFILER_REPORT_TOP;
+    while ((at > 0) && (profiler.counts[top[at - 1]] < profiler.counts[i])) {
+      if (at < PROFILER_REPORT_TOP) {
+        top[at] = top[at - 1];
+      }
+      --at;
+    }
+    if (at < PROFILER_REPORT_TOP) {
+      top[at] = (uint16_t)i;
+    }
+  }
+
+  snprintf(line, sizeof(line), "Profiler %s, %lu Hz: %lu samples, %lu dropped, %lu/%u PCs\r\n",
+           profiler.running ? "running" : "stopped", (unsigned long)profiler.rate_hz,
+           (unsigned long)profiler.samples, (unsigned long)profiler.dropped,
+           (unsigned long)buckets, (unsigned)PROFILER_BUCKETS);
+  ConsolePrint(console, line);
+  for (uint8_t i = 0; i < used; ++i) {
+    uint32_t count = (uint32_t)profiler.counts[top[i]] << profiler.shift;
+    snprintf(line, sizeof(line), "  0x%08lx %8lu %3lu%%\r\n", (unsigned long)profiler.pcs[top[i]],
+             (unsigned long)count,
+             (unsigned long)((profiler.samples != 0) ? (100ULL * count / profiler.samples) : 0U));
+    ConsolePrint(console, line);
+  }
+  console->result = profiler.samples;
+}
+
+void ProfilerClockChanged(void) {
+  if (profiler.running) {
+    ProfilerProgramTimer();
+  }
+}
+
+void ProfilerTimerIrq(const uint32_t* frame) {
+  uint32_t pc = frame[6] & ~(PROFILER_GRANULE - 1U);
+  uint32_t index = (((pc / PROFILER_GRANULE) * 2654435761U) >> 16) & (PROFILER_BUCKETS - 1U);
+  uint32_t sample = profiler.samples++;
+
+  TIM6->SR = 0;
+  if ((sample & ((1U << profiler.shift) - 1U)) != 0) {
+    return;
+  }
+  for (uint32_t probe = 0; probe < PROFILER_PROBES; ++probe) {
+    if (profiler.pcs[index] == 0) {
+      profiler.pcs[index] = pc;
+    }
+    if (profiler.pcs[index] == pc) {
+      if (profiler.counts[index] == UINT16_MAX) {
+        ProfilerHalve();
+      }
+      ++profiler.counts[index];
+      return;
+    }
+    index = (index + 1U) & (PROFILER_BUCKETS - 1U);
+  }
+  ++profiler.dropped;
+}
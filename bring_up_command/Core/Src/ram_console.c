@@ -0,0 +1,104 @@
+// ram_console.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// RAM mailbox transport for a console session (see ram_console.h).
+
+#include "ram_console.h"
+#include "console.h"
+#include "main.h"  // For HAL_GetTick
+#include <string.h>
+
+RamMailbox ram_mailbox __attribute__((section(".mailbox"), used));
+
+static Console ram_console;
+static uint8_t host_idle;  // Host stopped draining; drop output until it resumes
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Console output function: queues data for the host, waiting for it
+ * to drain the ring while it keeps making progress.
+ */
+static void RamConsoleWrite(Console* console, const uint8_t* data, uint16_t len) {
+  RingBuffer* up = &ram_mailbox.up;
+  uint16_t last_tail = up->tail;
+  uint32_t last_progress = HAL_GetTick();
+
+  while (len > 0) {
+    uint16_t free_items = 0;
+    RingBufferFreeItems(up, &free_items);
+
+    uint16_t chunk = (len < free_items) ? len : free_items;
+    if (chunk > 0) {
+      RingBufferStreamPush(up, (uint8_t*)data, chunk);
+      data += chunk;
+      len -= chunk;
+      continue;
+    }
+
+    if (up->tail != last_tail) {
+      last_tail = up->tail;
+      last_progress = HAL_GetTick();
+      host_idle = 0;
+    } else if (host_idle ||
+               ((HAL_GetTick() - last_progress) >= RAM_CONSOLE_WRITE_TIMEOUT_MS)) {
+      host_idle = 1;
+      return;
+    }
+  }
+}
+
+static uint16_t RamConsoleWritable(const Console* console) {
+  uint16_t free_items = 0;
+  RingBufferFreeItems(&ram_mailbox.up, &free_items);
+  return free_items;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void RamConsoleInit(void) {
+  // .mailbox is not zeroed by the startup code, so hide stale contents first
+  memset(ram_mailbox.id, 0, sizeof(ram_mailbox.id));
+
+  ram_mailbox.version = RAM_CONSOLE_VERSION;
+  ram_mailbox.ring_size = RING_BUFFER_SIZE;
+  RingBufferInit(&ram_mailbox.up);
+  RingBufferInit(&ram_mailbox.down);
+  host_idle = 0;
+
+  ConsoleInit(&ram_console, "ram", RamConsoleWrite, &ram_mailbox);
+  ram_console.writable = RamConsoleWritable;
+
+  // Publish: the host only trusts the block once the id is in place
+  __DMB();
+  memcpy(ram_mailbox.id, RAM_CONSOLE_ID, sizeof(RAM_CONSOLE_ID));
+
+  ConsolePrint(&ram_console, "Test Console Initialized. \r\n Type 'help'.\r\n");
+}
+
+void RamConsoleProcess(void) {
+  uint8_t chunk[16];
+  uint16_t used = 0;
+
+  RingBufferCurrentItems(&ram_mailbox.down, &used);
+  while (used > 0) {
+    uint16_t free_items = 0;
+    RingBufferFreeItems(&ram_console.rx, &free_items);
+
+    uint16_t len = (used < sizeof(chunk)) ? used : sizeof(chunk);
+    if (len > free_items) {
+      len = free_items;
+    }
+    if (len == 0) {
+      break;  // Let the console catch up first
+    }
+    RingBufferStreamPop(&ram_mailbox.down, chunk, len);
+    ConsoleReceive(&ram_console, chunk, len);
+    used -= len;
+  }
+
+  ConsoleProcess(&ram_console);
+}
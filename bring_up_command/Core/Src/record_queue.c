@@ -0,0 +1,152 @@
+// record_queue.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Length-prefixed records in a contiguous ring, single producer and
+// single consumer (see record_queue.h).
+
+#include "record_queue.h"
+#include <string.h>
+
+// Same discipline as the ring buffer: store, then publish the index
+#if defined(__GNUC__)
+#define RQ_BARRIER() __asm volatile ("" ::: "memory")
+#else
+#define RQ_BARRIER()
+#endif
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint16_t RecordQueueGetLength(const RecordQueue* queue, uint16_t offset) {
+  return (uint16_t)(queue->storage[offset] | (queue->storage[offset + 1U] << 8));
+}
+
+static void RecordQueueSetLength(RecordQueue* queue, uint16_t offset, uint16_t len) {
+  queue->storage[offset] = (uint8_t)(len & 0xFF);
+  queue->storage[offset + 1U] = (uint8_t)(len >> 8);
+}
+
+/**
+ * @brief Moves the read position past a padding record or a spare byte
+ * at the end of the storage (consumer only).
+ *
+ * @return The read position, or @c size if the queue is empty.
+ */
+static uint16_t RecordQueueFirst(RecordQueue* queue) {
+  uint16_t tail = queue->tail;
+
+  if (tail == queue->head) {
+    return queue->size;
+  }
+  if (((uint16_t)(queue->size - tail) < RECORD_QUEUE_HEADER) ||
+      (RecordQueueGetLength(queue, tail) == RECORD_QUEUE_PADDING)) {
+    tail = 0;
+    queue->tail = 0;
+    if (tail == queue->head) {
+      return queue->size;
+    }
+  }
+  return tail;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode RecordQueueInit(RecordQueue* queue, uint8_t* storage, uint16_t size) {
+  if ((queue == NULL) || (storage == NULL) || (size < RECORD_QUEUE_HEADER + 2U) ||
+      (size >= RECORD_QUEUE_PADDING)) {
+    return kInvalidArgument;
+  }
+  queue->storage = storage;
+  queue->size = size;
+  queue->head = 0;
+  queue->tail = 0;
+  queue->reserved = 0;
+  queue->reserved_max = 0;
+  return kOk;
+}
+
+uint8_t* RecordQueueReserve(RecordQueue* queue, uint16_t max_len) {
+  uint16_t head = queue->head;
+  uint16_t tail = queue->tail;
+  uint32_t need = (uint32_t)max_len + RECORD_QUEUE_HEADER;
+
+  queue->reserved_max = 0;
+  if ((max_len == 0) || (max_len >= RECORD_QUEUE_PADDING)) {
+    return NULL;
+  }
+  // The record may not end on the read position: that would look empty
+  if (head >= tail) {
+    if ((head + need < queue->size) || ((head + need == queue->size) && (tail != 0))) {
+      queue->reserved = head;
+    } else if (need < tail) {
+      queue->reserved = 0;  // Wraps: padding goes in at commit
+    } else {
+      return NULL;
+    }
+  } else if (head + need < tail) {
+    queue->reserved = head;
+  } else {
+    return NULL;
+  }
+  queue->reserved_max = max_len;
+  return &queue->storage[queue->reserved + RECORD_QUEUE_HEADER];
+}
+
+ReturnCode RecordQueueCommit(RecordQueue* queue, uint16_t len) {
+  uint16_t head = queue->head;
+
+  if ((queue->reserved_max == 0) || (len > queue->reserved_max)) {
+    return kInvalidArgument;
+  }
+  if ((queue->reserved != head) && ((uint16_t)(queue->size - head) >= RECORD_QUEUE_HEADER)) {
+    RecordQueueSetLength(queue, head, RECORD_QUEUE_PADDING);
+  }
+  RecordQueueSetLength(queue, queue->reserved, len);
+
+  uint32_t next = (uint32_t)queue->reserved + RECORD_QUEUE_HEADER + len;
+  queue->reserved_max = 0;
+
+  // Publish the record only after it has been stored
+  RQ_BARRIER();
+  queue->head = (next == queue->size) ? 0U : (uint16_t)next;
+  return kOk;
+}
+
+ReturnCode RecordQueuePush(RecordQueue* queue, const uint8_t* data, uint16_t len) {
+  if ((queue == NULL) || (data == NULL)) {
+    return kInvalidArgument;
+  }
+  uint8_t* record = RecordQueueReserve(queue, len);
+  if (record == NULL) {
+    return kFull;
+  }
+  memcpy(record, data, len);
+  return RecordQueueCommit(queue, len);
+}
+
+ReturnCode RecordQueuePeek(RecordQueue* queue, const uint8_t** data, uint16_t* len) {
+  uint16_t tail = RecordQueueFirst(queue);
+
+  if (tail == queue->size) {
+    return kEmpty;
+  }
+  *len = RecordQueueGetLength(queue, tail);
+  *data = &queue->storage[tail + RECORD_QUEUE_HEADER];
+  return kOk;
+}
+
+ReturnCode RecordQueueRelease(RecordQueue* queue) {
+  uint16_t tail = RecordQueueFirst(queue);
+
+  if (tail == queue->size) {
+    return kEmpty;
+  }
+  uint32_t next = (uint32_t)tail + RECORD_QUEUE_HEADER + RecordQueueGetLength(queue, tail);
+
+  // Release the space only after the record has been used
+  RQ_BARRIER();
+  queue->tail = (next == queue->size) ? 0U : (uint16_t)next;
+  return kOk;
+}
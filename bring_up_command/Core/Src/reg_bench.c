@@ -0,0 +1,129 @@
+// reg_bench.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Cycle count comparison of the HAL with the register layer (see reg.h).
+// Each operation is wrapped in a function of its own, RegBenchHal* or
+// RegBenchReg*, so that the code each one produces can also be compared:
+//
+//   arm-none-eabi-nm -S --size-sort build/bring_up_command.elf | grep RegBench
+//
+// The HAL rows include the HAL function's own size, which nm lists
+// separately (HAL_GPIO_WritePin, HAL_GPIO_ReadPin).
+
+#include "reg.h"
+#include "cycle_count.h"
+#include "main.h"
+#include <stdio.h>
+
+#define BENCH_RUNS 4
+
+#define BENCH_NOINLINE __attribute__((noinline))
+
+typedef uint32_t (*BenchFn)(void);
+
+typedef struct {
+  const char* name;
+  BenchFn hal;
+  BenchFn reg;
+} BenchEntry;
+
+extern UART_HandleTypeDef huart2;  // Declared in main.c
+
+// Where the pin is not a constant: the gpio command's case
+static volatile uint32_t bench_pin_number = 5;  // LD2 is PA5
+static volatile uint32_t bench_level;           // Written back unchanged
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static BENCH_NOINLINE uint32_t RegBenchNothing(void) {
+  return 0;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchHalWrite(void) {
+  HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, bench_level ? GPIO_PIN_SET : GPIO_PIN_RESET);
+  return 0;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchRegWrite(void) {
+  RegPinWrite(REG_PIN(LD2_GPIO_Port, LD2_Pin), bench_level);
+  return 0;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchHalWriteRuntime(void) {
+  HAL_GPIO_WritePin(GPIOA, (uint16_t)(1U << bench_pin_number),
+                    bench_level ? GPIO_PIN_SET : GPIO_PIN_RESET);
+  return 0;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchRegWriteRuntime(void) {
+  RegPinWrite(RegPinMake(GPIOA, bench_pin_number), bench_level);
+  return 0;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchHalRead(void) {
+  return HAL_GPIO_ReadPin(LD2_GPIO_Port, LD2_Pin) == GPIO_PIN_SET;
+}
+
+static BENCH_NOINLINE uint32_t RegBenchRegRead(void) {
+  return RegPinRead(REG_PIN(LD2_GPIO_Port, LD2_Pin));
+}
+
+// The HAL flag macros dereference the handle for the instance first
+static BENCH_NOINLINE uint32_t RegBenchHalQuiet(void) {
+  return __HAL_UART_GET_FLAG(&huart2, UART_FLAG_TC) && !__HAL_UART_GET_FLAG(&huart2, UART_FLAG_BUSY);
+}
+
+static BENCH_NOINLINE uint32_t RegBenchRegQuiet(void) {
+  return RegUsartQuiet(USART2);
+}
+
+static const BenchEntry kBenchEntries[] = {
+    {"pin write",         RegBenchHalWrite,        RegBenchRegWrite},
+    {"pin write runtime", RegBenchHalWriteRuntime, RegBenchRegWriteRuntime},
+    {"pin read",          RegBenchHalRead,         RegBenchRegRead},
+    {"usart quiet",       RegBenchHalQuiet,        RegBenchRegQuiet},
+};
+
+// Fewest cycles of BENCH_RUNS calls, so an interrupt pending at the start
+// does not count
+static uint32_t BenchCycles(BenchFn fn) {
+  uint32_t best = UINT32_MAX;
+
+  for (int run = 0; run < BENCH_RUNS; ++run) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = CycleCountStart();
+    fn();
+    uint32_t cycles = CycleCountElapsed(start);
+    __set_PRIMASK(primask);
+
+    if (cycles < best) {
+      best = cycles;
+    }
+  }
+  return best;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode RegBenchmark(Console* console) {
+  uint32_t overhead = BenchCycles(RegBenchNothing);
+  char line[64];
+
+  bench_level = RegPinRead(REG_PIN(LD2_GPIO_Port, LD2_Pin));  // The LED keeps its state
+  ConsolePrint(console, "                     HAL   reg\r\n");
+  for (size_t i = 0; i < sizeof(kBenchEntries) / sizeof(kBenchEntries[0]); ++i) {
+    uint32_t cycles[2];
+    for (int impl = 0; impl < 2; ++impl) {
+      cycles[impl] = BenchCycles(impl ? kBenchEntries[i].reg : kBenchEntries[i].hal);
+      cycles[impl] = (cycles[impl] > overhead) ? cycles[impl] - overhead : 0U;
+    }
+    snprintf(line, sizeof(line), "  %-17s %5lu %5lu\r\n", kBenchEntries[i].name,
+             (unsigned long)cycles[0], (unsigned long)cycles[1]);
+    ConsolePrint(console, line);
+  }
+  return kOk;
+}
@@ -6,9 +6,33 @@
  */
 
 #include "ring_buffer.h"
-#include <string.h>
+#include "fastmem.h"
 #include <stdbool.h>
 
+/*
+ * Single-producer/single-consumer discipline: the element is stored before the
+ * head index is published and read before the tail index is released. The
+ * barrier keeps the compiler from moving the (non-volatile) buffer access
+ * across the (volatile) index update. The Cortex-M0+ has no write buffer
+ * reordering to worry about, so a compiler barrier is all that is needed.
+ */
+#if defined(__GNUC__)
+#define RB_BARRIER() __asm volatile ("" ::: "memory")
+#else
+#define RB_BARRIER()
+#endif
+
+/* Number of stored elements, computed from one snapshot of each index. */
+static inline uint16_t RingBufferUsed(const RingBuffer* rb) {
+  uint16_t head = rb->head;
+  uint16_t tail = rb->tail;
+
+  if(head >= tail) {
+    return (uint16_t)(head - tail);
+  }
+  return (uint16_t)(RING_BUFFER_SIZE + head - tail);
+}
+
 ReturnCode RingBufferInit(RingBuffer* rb) {
   if(rb == NULL) {
 	  /* check your buffer parameter */
@@ -17,7 +41,6 @@ ReturnCode RingBufferInit(RingBuffer* rb) {
 
   rb->head = 0;
   rb->tail = 0;
-  rb->items = 0;
 
   return kOk;
 }
@@ -28,7 +51,7 @@ ReturnCode RingBufferIsFull(const RingBuffer* rb) {
 	  return kInvalidArgument;
   }
   /*For overwrite method use this (rb->head == rb->tail) approach */
-  if(rb->items >= (RING_BUFFER_SIZE - 1)) {
+  if(RingBufferUsed(rb) >= (RING_BUFFER_SIZE - 1)) {
 	  return kFull; // Buffer is full
   } else {
 	  return kOk;
@@ -43,7 +66,7 @@ ReturnCode RingBufferIsEmpty(const RingBuffer* rb) {
 
   /*For overwrite method use this approach */
   /*(((rb->head == rb->tail) || (rb->items == 0)) == true)*/
-  if(rb->items <= 0) {
+  if(rb->head == rb->tail) {
     return kEmpty;
   } else {
     return kOk;
@@ -61,15 +84,19 @@ ReturnCode RingBufferPush(RingBuffer* rb, uint8_t data) {
     return kFull;
   }
 
-  rb->buffer[rb->head] = data;
+  uint16_t head = rb->head;
+
+  rb->buffer[head] = data;
   // Circular operator
   //rb->head = (rb->head + 1) % RING_BUFFER_SIZE;
   //circular operator less overhead
-  if((++rb->head) >= RING_BUFFER_SIZE) {
-	  rb->head = 0;
+  if((++head) >= RING_BUFFER_SIZE) {
+	  head = 0;
   }
 
-  rb->items++;
+  // Publish the element only after it has been stored
+  RB_BARRIER();
+  rb->head = head;
 
 //  // Overwrite method! (No safety)
 //  if (rb->items < RING_BUFFER_SIZE) {
@@ -96,15 +123,19 @@ ReturnCode RingBufferPop(RingBuffer* rb, uint8_t* data) {
     return kEmpty;  // Buffer is empty
   }
 
-  *data = rb->buffer[rb->tail];
+  uint16_t tail = rb->tail;
+
+  *data = rb->buffer[tail];
 
   //rb->tail = (rb->tail + 1) % RING_BUFFER_SIZE;
 
-  if((++rb->tail) >= RING_BUFFER_SIZE) {
-	  rb->tail = 0;
+  if((++tail) >= RING_BUFFER_SIZE) {
+	  tail = 0;
   }
 
-  rb->items--;
+  // Release the slot only after the element has been read
+  RB_BARRIER();
+  rb->tail = tail;
 
   return kOk;
 }
@@ -115,11 +146,10 @@ ReturnCode RingBufferFlush(RingBuffer* rb) {
 	  return kInvalidArgument;
   }
 
-  rb->items = 0;
   rb->head = 0;
   rb->tail = 0;
 
-  memset(rb->buffer, 0, sizeof(rb->buffer));
+  FastMemset(rb->buffer, 0, sizeof(rb->buffer));
 
   return kOk;
 }
@@ -130,7 +160,7 @@ ReturnCode RingBufferWillFull(RingBuffer* rb, uint16_t new_items) {
 	  return kInvalidArgument;
   }
   // For overwrite method just use the ring buffer size
-  if (rb->items  + new_items > (RING_BUFFER_SIZE - 1)) {
+  if (RingBufferUsed(rb) + new_items > (RING_BUFFER_SIZE - 1)) {
 	  return kFull;
   } else {
 	  return kOk;
@@ -143,7 +173,7 @@ ReturnCode RingBufferFreeItems(RingBuffer* rb, uint16_t* free_items) {
 	  return kInvalidArgument;
   }
 
-  *free_items = (RING_BUFFER_SIZE -1) - rb->items;
+  *free_items = (RING_BUFFER_SIZE -1) - RingBufferUsed(rb);
 
   return kOk;
 }
@@ -154,7 +184,7 @@ ReturnCode RingBufferCurrentItems(RingBuffer* rb, uint16_t* num) {
 	  return kInvalidArgument;
   }
 
-  *num = rb->items;
+  *num = RingBufferUsed(rb);
 
   return kOk;
 }
@@ -165,11 +195,7 @@ ReturnCode RingBufferCurrentSize(RingBuffer* rb, uint16_t* num){
 	  return kInvalidArgument;
   }
 
-  if(rb->head >= rb->tail) {
-    *num = (rb->head - rb->tail);
-  } else {
-	*num = (RING_BUFFER_SIZE + rb->head - rb->tail); // (overwrote)
-  }
+  *num = RingBufferUsed(rb);
 
   return kOk;
 }
@@ -216,4 +242,43 @@ ReturnCode RingBufferStreamPop(RingBuffer* rb, uint8_t* data, uint16_t items) {
 
   return kOk;
 }
+
+ReturnCode RingBufferPeekLinear(const RingBuffer* rb, const uint8_t** data, uint16_t* items) {
+  if((rb == NULL) || (data == NULL) || (items == NULL)) {
+    // check your buffer parameter
+    return kInvalidArgument;
+  }
+
+  uint16_t head = rb->head;
+  uint16_t tail = rb->tail;
+
+  if(head == tail) {
+    return kEmpty;
+  }
+
+  // Stop at the end of the storage array if the data wraps around
+  *data = &rb->buffer[tail];
+  *items = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(RING_BUFFER_SIZE - tail);
+
+  return kOk;
+}
+
+ReturnCode RingBufferDiscard(RingBuffer* rb, uint16_t items) {
+  if(rb == NULL) {
+    // check your buffer parameter
+    return kInvalidArgument;
+  }
+
+  if(items > RingBufferUsed(rb)) {
+    return kEmpty;
+  }
+
+  uint16_t tail = rb->tail + items;
+  if(tail >= RING_BUFFER_SIZE) {
+    tail -= RING_BUFFER_SIZE;
+  }
+  rb->tail = tail;
+
+  return kOk;
+}
 /*** end of file ***/
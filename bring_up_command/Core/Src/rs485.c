@@ -0,0 +1,148 @@
+// rs485.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// RS-485 driver enable and address-mark mute mode for a console UART,
+// with the settings kept in the data EEPROM (see rs485.h).
+
+#include "rs485.h"
+#include "main.h"
+#include "uart_console.h"
+#include <stdio.h>
+
+#define RS485_EEPROM_MAGIC  0x5235U   ///< "R5" in the upper half of the word
+#define RS485_FLAG_ENABLED  0x01U
+
+static struct {
+  uint8_t address;
+  uint8_t enabled;        ///< Stored setting
+  uint8_t applied;        ///< Bus mode currently configured on the port
+  volatile uint8_t pending;
+  const char* error;      ///< Last failure to apply the setting, NULL if none
+} bus;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static ReturnCode Rs485Store(void) {
+  uint32_t word = ((uint32_t)RS485_EEPROM_MAGIC << 16) |
+                  ((bus.enabled ? RS485_FLAG_ENABLED : 0U) << 8) | bus.address;
+  HAL_StatusTypeDef status;
+
+  if (*(const volatile uint32_t*)RS485_EEPROM_ADDRESS == word) {
+    return kOk;
+  }
+  HAL_FLASHEx_DATAEEPROM_Unlock();
+  status = HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, RS485_EEPROM_ADDRESS, word);
+  HAL_FLASHEx_DATAEEPROM_Lock();
+  return (status == HAL_OK) ? kOk : kError;
+}
+
+static void Rs485ConfigureDePin(uint8_t on) {
+  GPIO_InitTypeDef gpio = {0};
+
+  if (!on) {
+    HAL_GPIO_DeInit(RS485_DE_PORT, RS485_DE_PIN);
+    return;
+  }
+  gpio.Pin = RS485_DE_PIN;
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_PULLDOWN;  // Transceiver stays receiving during reset
+  gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+  gpio.Alternate = RS485_DE_AF;
+  HAL_GPIO_Init(RS485_DE_PORT, &gpio);
+}
+
+/**
+ * @brief Configures the acquired port for the stored setting.
+ */
+static HAL_StatusTypeDef Rs485Apply(UART_HandleTypeDef* huart) {
+  if (!bus.enabled) {
+    // HAL_UART_Init() leaves DEM and MME alone
+    __HAL_UART_DISABLE(huart);
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DEM);
+    CLEAR_BIT(huart->Instance->CR1, USART_CR1_MME | USART_CR1_WAKE);
+    Rs485ConfigureDePin(0);
+    return HAL_UART_Init(huart);
+  }
+
+  Rs485ConfigureDePin(1);
+  if ((HAL_RS485Ex_Init(huart, UART_DE_POLARITY_HIGH, RS485_DE_ASSERT_TIME,
+                        RS485_DE_DEASSERT_TIME) != HAL_OK) ||
+      (HAL_MultiProcessor_Init(huart, bus.address, UART_WAKEUPMETHOD_ADDRESSMARK) != HAL_OK) ||
+      (HAL_MultiProcessorEx_AddressLength_Set(huart, UART_ADDRESS_DETECT_7B) != HAL_OK) ||
+      (HAL_MultiProcessor_EnableMuteMode(huart) != HAL_OK)) {
+    return HAL_ERROR;
+  }
+  HAL_MultiProcessor_EnterMuteMode(huart);  // Until the host addresses this board
+  return HAL_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void Rs485Init(void) {
+  uint32_t word = *(const volatile uint32_t*)RS485_EEPROM_ADDRESS;
+
+  bus.address = 0;
+  bus.enabled = 0;
+  bus.applied = 0;
+  bus.error = NULL;
+  if ((word >> 16) == RS485_EEPROM_MAGIC) {
+    bus.address = (uint8_t)(word & RS485_MAX_ADDRESS);
+    bus.enabled = ((word >> 8) & RS485_FLAG_ENABLED) ? 1U : 0U;
+  }
+  bus.pending = bus.enabled;
+}
+
+ReturnCode Rs485SetAddress(uint32_t address) {
+  if (address > RS485_MAX_ADDRESS) {
+    return kInvalidArgument;
+  }
+  bus.address = (uint8_t)address;
+  bus.pending = bus.enabled;
+  return Rs485Store();
+}
+
+ReturnCode Rs485Enable(uint8_t on) {
+  bus.enabled = on ? 1U : 0U;
+  bus.pending = (bus.enabled != bus.applied);
+  return Rs485Store();
+}
+
+void Rs485Report(Console* console) {
+  char buffer[80];
+
+  snprintf(buffer, sizeof(buffer), "rs485 %s: address %u (mark 0x%02X), bus mode %s\r\n",
+           RS485_PORT, bus.address, 0x80U | bus.address,
+           bus.applied ? "on" : (bus.pending ? "pending" : "off"));
+  ConsolePrint(console, buffer);
+  if (bus.error != NULL) {
+    ConsolePrint(console, "Last change failed: ");
+    ConsolePrint(console, bus.error);
+    ConsolePrint(console, "\r\n");
+  }
+}
+
+void Rs485Process(void) {
+  UART_HandleTypeDef* huart = NULL;
+
+  if (!bus.pending) {
+    return;
+  }
+
+  // Wait until the reply to the command that changed the setting is out
+  ReturnCode rc = UartConsoleAcquire(RS485_PORT, NULL, &huart);
+  if (rc == kFull) {
+    return;
+  }
+  bus.pending = 0;
+  if (rc != kOk) {
+    bus.error = "port not available";
+    return;
+  }
+
+  bus.error = (Rs485Apply(huart) == HAL_OK) ? NULL : "UART configuration";
+  bus.applied = (bus.enabled && (bus.error == NULL)) ? 1U : 0U;
+  UartConsoleRelease(huart);
+}
@@ -0,0 +1,623 @@
+// selftest.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Self-test steps and the sequencer that interleaves them (see selftest.h).
+
+#include "selftest.h"
+#include "clock_gate.h"
+#include "cycle_count.h"
+#include "dma_copy.h"
+#include "governor.h"
+#include "main.h"
+#include "module.h"
+#include "uart_console.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SELFTEST_SETTLE_US     50    ///< Pin settling time after a pull change
+#define SELFTEST_UART_BYTES    16    ///< Loopback pattern length
+#define SELFTEST_FLASH_CHUNK   4096  ///< Flash bytes checksummed per poll
+#define SELFTEST_CLOCK_EDGES   8     ///< Reference periods per capture (IC prescaler)
+#define SELFTEST_FLASH_MAGIC   0x43524346UL  ///< "FCRC"
+
+/**
+ * @brief Reference CRC of the flash image, patched into the binary after
+ * linking by tools/flash_crc.py (left erased otherwise).
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t crc;   ///< CRC-32 of the image with this field read as 0xFFFFFFFF
+} SelftestFlashRecord;
+
+static const SelftestFlashRecord kFlashRecord __attribute__((used, aligned(4))) = {
+    SELFTEST_FLASH_MAGIC, 0xFFFFFFFFUL};
+
+extern uint32_t _sidata;  // Linker script: load address of .data
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+typedef enum {
+  kStepIdle = 0,   ///< Not selected, or finished
+  kStepWaiting,    ///< Selected, waiting for its resources
+  kStepRunning,
+} StepState;
+
+typedef struct {
+  StepState state;
+  SelftestResult result;
+  uint8_t timed_out;
+  uint32_t start_us;
+  uint32_t duration_us;
+  SelftestContext ctx;
+} StepRun;
+
+static SelftestResult StepLed(SelftestContext* ctx);
+static void StepLedCleanup(SelftestContext* ctx);
+static SelftestResult StepPin(SelftestContext* ctx);
+static void StepPinCleanup(SelftestContext* ctx);
+static SelftestResult StepUart(SelftestContext* ctx);
+static void StepUartCleanup(SelftestContext* ctx);
+static SelftestResult StepRam(SelftestContext* ctx);
+static void StepRamCleanup(SelftestContext* ctx);
+static SelftestResult StepFlash(SelftestContext* ctx);
+static void StepFlashCleanup(SelftestContext* ctx);
+static SelftestResult StepClock(SelftestContext* ctx);
+static void StepClockCleanup(SelftestContext* ctx);
+
+// -----------------------------------------------------------------------------
+// Step table
+// -----------------------------------------------------------------------------
+static const SelftestStep kSteps[] = {
+    {"led",   SELFTEST_RES_LED,   10,  StepLed,   StepLedCleanup},
+    {"pin",   SELFTEST_RES_PIN,   10,  StepPin,   StepPinCleanup},
+    {"uart",  SELFTEST_RES_UART,  50,  StepUart,  StepUartCleanup},
+    {"ram",   SELFTEST_RES_RAM,   100, StepRam,   StepRamCleanup},
+    {"flash", SELFTEST_RES_CRC,   200, StepFlash, StepFlashCleanup},
+    {"clock", SELFTEST_RES_TIM21, 50,  StepClock, StepClockCleanup},
+};
+
+#define SELFTEST_NUM_STEPS (sizeof(kSteps) / sizeof(kSteps[0]))
+
+static struct {
+  Console* console;        ///< Session of the run in progress, NULL when idle
+  uint32_t start_us;
+  uint16_t busy;           ///< Resources held by running steps
+  StepRun steps[SELFTEST_NUM_STEPS];
+} run;
+
+static UART_HandleTypeDef* uart_under_test;
+static volatile uint32_t* ram_under_test;  ///< Claimed module area, NULL if not held
+static uint32_t ram_words;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint32_t PinMode(const GPIO_TypeDef* port, uint32_t pin) {
+  return (port->MODER >> (2U * pin)) & 3U;
+}
+
+/**
+ * @brief LED: drives LD2 high and low and reads each level back.
+ */
+static SelftestResult StepLed(SelftestContext* ctx) {
+  const uint32_t pin = __builtin_ctz(LD2_Pin);
+
+  switch (ctx->state) {
+    case 0:
+      if (PinMode(LD2_GPIO_Port, pin) != 1U) {
+        strcpy(ctx->detail, "not an output");
+        return kSelftestSkip;
+      }
+      ctx->value = LD2_GPIO_Port->ODR & LD2_Pin;
+      LD2_GPIO_Port->BSRR = LD2_Pin;
+      ctx->state = 1;
+      return kSelftestPending;
+    case 1:
+      if ((LD2_GPIO_Port->IDR & LD2_Pin) == 0) {
+        strcpy(ctx->detail, "stuck low");
+        return kSelftestFail;
+      }
+      LD2_GPIO_Port->BRR = LD2_Pin;
+      ctx->state = 2;
+      return kSelftestPending;
+    default:
+      if ((LD2_GPIO_Port->IDR & LD2_Pin) != 0) {
+        strcpy(ctx->detail, "stuck high");
+        return kSelftestFail;
+      }
+      return kSelftestPass;
+  }
+}
+
+static void StepLedCleanup(SelftestContext* ctx) {
+  if (ctx->state > 0) {
+    if (ctx->value != 0) {
+      LD2_GPIO_Port->BSRR = LD2_Pin;
+    } else {
+      LD2_GPIO_Port->BRR = LD2_Pin;
+    }
+  }
+}
+
+/**
+ * @brief Pin: an unconnected pin must follow the internal pull-up and
+ * pull-down (finds shorts and external drivers).
+ */
+static SelftestResult StepPin(SelftestContext* ctx) {
+  GPIO_TypeDef* port = SELFTEST_PIN_PORT;
+  const uint32_t shift = 2U * SELFTEST_PIN;
+  uint32_t now = CycleCountMicros();
+
+  if ((ctx->state > 0) && (now - ctx->mark < SELFTEST_SETTLE_US)) {
+    return kSelftestPending;
+  }
+
+  switch (ctx->state) {
+    case 0: {
+      uint32_t mode = PinMode(port, SELFTEST_PIN);
+      if ((mode == 1U) || (mode == 2U)) {
+        strcpy(ctx->detail, "in use");
+        return kSelftestSkip;
+      }
+      // Keep the mode and pull configuration to restore them
+      ctx->value = mode | (((port->PUPDR >> shift) & 3U) << 2);
+      port->PUPDR = (port->PUPDR & ~(3U << shift)) | (1U << shift);
+      port->MODER &= ~(3U << shift);
+      ctx->state = 1;
+      break;
+    }
+    case 1:
+      if ((port->IDR & (1U << SELFTEST_PIN)) == 0) {
+        strcpy(ctx->detail, "held low");
+        return kSelftestFail;
+      }
+      port->PUPDR = (port->PUPDR & ~(3U << shift)) | (2U << shift);
+      ctx->state = 2;
+      break;
+    default:
+      if ((port->IDR & (1U << SELFTEST_PIN)) != 0) {
+        strcpy(ctx->detail, "held high");
+        return kSelftestFail;
+      }
+      return kSelftestPass;
+  }
+  ctx->mark = now;
+  return kSelftestPending;
+}
+
+static void StepPinCleanup(SelftestContext* ctx) {
+  GPIO_TypeDef* port = SELFTEST_PIN_PORT;
+  const uint32_t shift = 2U * SELFTEST_PIN;
+
+  if (ctx->state > 0) {
+    port->MODER = (port->MODER & ~(3U << shift)) | ((ctx->value & 3U) << shift);
+    port->PUPDR = (port->PUPDR & ~(3U << shift)) | (((ctx->value >> 2) & 3U) << shift);
+  }
+}
+
+static uint8_t UartPattern(uint32_t index) {
+  return (uint8_t)((index * 0x3BU) ^ 0xA5U);
+}
+
+/**
+ * @brief UART: borrows a console port, switches it to half-duplex so the
+ * receiver is wired to the transmitter, and echoes a pattern through it.
+ */
+static SelftestResult StepUart(SelftestContext* ctx) {
+  USART_TypeDef* uart;
+
+  if (ctx->state == 0) {
+    ReturnCode rc = UartConsoleAcquire(SELFTEST_UART_PORT, NULL, &uart_under_test);
+    if (rc == kFull) {
+      return kSelftestPending;  // Still sending console output
+    }
+    if (rc != kOk) {
+      strcpy(ctx->detail, "no port");
+      return kSelftestSkip;
+    }
+    uart = uart_under_test->Instance;
+    uart->CR1 &= ~USART_CR1_UE;
+    uart->CR3 |= USART_CR3_HDSEL;
+    uart->CR1 |= USART_CR1_UE;
+    uart->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF;
+    uart->RQR = USART_RQR_RXFRQ;
+    ctx->state = 1;
+  }
+
+  uart = uart_under_test->Instance;
+  if (ctx->state == 1) {
+    // Send the next byte
+    if ((uart->ISR & USART_ISR_TXE) == 0) {
+      return kSelftestPending;
+    }
+    uart->TDR = UartPattern(ctx->value);
+    ctx->state = 2;
+    return kSelftestPending;
+  }
+
+  // Wait for its echo
+  if ((uart->ISR & USART_ISR_RXNE) == 0) {
+    return kSelftestPending;
+  }
+  uint8_t expected = UartPattern(ctx->value);
+  uint8_t received = (uint8_t)uart->RDR;
+  if (received != expected) {
+    snprintf(ctx->detail, sizeof(ctx->detail), "got %02X want %02X", received, expected);
+    return kSelftestFail;
+  }
+  ctx->state = 1;
+  return (++ctx->value == SELFTEST_UART_BYTES) ? kSelftestPass : kSelftestPending;
+}
+
+static void StepUartCleanup(SelftestContext* ctx) {
+  if (ctx->state > 0) {
+    USART_TypeDef* uart = uart_under_test->Instance;
+    while ((uart->ISR & USART_ISR_TC) == 0) {
+      // Let a byte still in the shifter finish
+    }
+    uart->CR1 &= ~USART_CR1_UE;
+    uart->CR3 &= ~USART_CR3_HDSEL;
+    uart->CR1 |= USART_CR1_UE;
+    uart->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF;
+    uart->RQR = USART_RQR_RXFRQ;
+    UartConsoleRelease(uart_under_test);
+  }
+}
+
+/**
+ * @brief One element of a March C- test: addressing direction, value
+ * expected before the write (if any) and value written (if any).
+ */
+typedef struct {
+  uint8_t down;
+  uint8_t read;
+  uint8_t write;
+  uint32_t expect;
+  uint32_t value;
+} MarchElement;
+
+static const MarchElement kMarchCMinus[] = {
+    {0, 0, 1, 0,           0},
+    {0, 1, 1, 0,           0xFFFFFFFFUL},
+    {0, 1, 1, 0xFFFFFFFFUL, 0},
+    {1, 1, 1, 0,           0xFFFFFFFFUL},
+    {1, 1, 1, 0xFFFFFFFFUL, 0},
+    {0, 1, 0, 0,           0},
+};
+
+static void StepRamFilled(void* context, ReturnCode rc) {
+  *(volatile uint32_t*)context = (rc == kOk) ? 2U : 3U;
+}
+
+/**
+ * @brief RAM: March C- over the free part of the module area, one march
+ * element per poll. The area stays claimed from the fill to the last
+ * element, so uploads and transfers cannot write into it meanwhile.
+ */
+static SelftestResult StepRam(SelftestContext* ctx) {
+  volatile uint32_t* words = ram_under_test;
+  uint32_t count = ram_words;
+
+  // The first element only writes, in any order: the DMA does it while
+  // other steps run (value: 1 filling, 2 filled, 3 left to the CPU)
+  if (ctx->state == 0) {
+    volatile uint32_t* fill = &ctx->value;
+    if (*fill == 0) {
+      uint16_t size = 0;
+      words = (volatile uint32_t*)ModuleAreaClaim(&size);
+      if (words == NULL) {
+        strcpy(ctx->detail, "area in use");
+        return kSelftestSkip;
+      }
+      ram_under_test = words;
+      ram_words = count = size / sizeof(uint32_t);
+      if (count == 0) {
+        strcpy(ctx->detail, "area full");
+        return kSelftestSkip;
+      }
+      *fill = 1;
+      if (DmaCopyMemset((void*)(uintptr_t)words, 0, count * sizeof(uint32_t), StepRamFilled,
+                        &ctx->value) != kOk) {
+        *fill = 3;
+      }
+    }
+    if (*fill == 1) {
+      return kSelftestPending;
+    }
+    if (*fill == 2) {
+      ctx->state = 1;
+      return kSelftestPending;
+    }
+  }
+
+  const MarchElement* element = &kMarchCMinus[ctx->state];
+  for (uint32_t n = 0; n < count; ++n) {
+    uint32_t i = element->down ? (count - 1U - n) : n;
+    if (element->read && (words[i] != element->expect)) {
+      snprintf(ctx->detail, sizeof(ctx->detail), "at %08lX", (unsigned long)(uintptr_t)&words[i]);
+      return kSelftestFail;
+    }
+    if (element->write) {
+      words[i] = element->value;
+    }
+  }
+
+  if (++ctx->state < sizeof(kMarchCMinus) / sizeof(kMarchCMinus[0])) {
+    return kSelftestPending;
+  }
+  snprintf(ctx->detail, sizeof(ctx->detail), "%lu B", (unsigned long)(count * sizeof(uint32_t)));
+  return kSelftestPass;
+}
+
+static void StepRamCleanup(SelftestContext* ctx) {
+  while (*(volatile uint32_t*)&ctx->value == 1U) {
+    // Let the DMA fill finish before giving the area back
+  }
+  if (ram_under_test != NULL) {
+    ModuleAreaRelease();
+    ram_under_test = NULL;
+  }
+}
+
+/**
+ * @brief Flash: CRC-32 of the image with the CRC unit, compared with the
+ * reference patched in by tools/flash_crc.py.
+ */
+static SelftestResult StepFlash(SelftestContext* ctx) {
+  const uint32_t* end = (const uint32_t*)((uintptr_t)&_sidata +
+                                          ((uintptr_t)&_edata - (uintptr_t)&_sdata));
+  const uint32_t* word;
+
+  if (ctx->state == 0) {
+    ClockGateAcquire(kClockGateCrc, 0);
+    CRC->POL = 0x04C11DB7UL;
+    CRC->INIT = 0xFFFFFFFFUL;
+    CRC->CR = CRC_CR_REV_IN | CRC_CR_REV_OUT | CRC_CR_RESET;  // Reflected, as zlib
+    ctx->value = FLASH_BASE;
+    ctx->state = 1;
+  }
+
+  word = (const uint32_t*)(uintptr_t)ctx->value;
+  for (uint32_t n = 0; (n < SELFTEST_FLASH_CHUNK / 4U) && (word < end); ++n, ++word) {
+    CRC->DR = (word == &kFlashRecord.crc) ? 0xFFFFFFFFUL : *word;
+  }
+  ctx->value = (uint32_t)(uintptr_t)word;
+  if (word < end) {
+    return kSelftestPending;
+  }
+
+  // Read the reference through a volatile pointer: the compiler only knows
+  // the value before patching
+  uint32_t reference = *(const volatile uint32_t*)&kFlashRecord.crc;
+  uint32_t crc = ~CRC->DR;
+  snprintf(ctx->detail, sizeof(ctx->detail), "crc %08lX", (unsigned long)crc);
+  if (reference == 0xFFFFFFFFUL) {
+    strcat(ctx->detail, " no ref");
+    return kSelftestSkip;
+  }
+  return (crc == reference) ? kSelftestPass : kSelftestFail;
+}
+
+static void StepFlashCleanup(SelftestContext* ctx) {
+  if (ctx->state > 0) {
+    ClockGateRelease(kClockGateCrc, 0);
+  }
+}
+
+/**
+ * @brief Clock: TIM21 counts timer clock cycles over SELFTEST_CLOCK_EDGES
+ * periods of LSE (or LSI when no crystal runs) and the result is compared
+ * with the frequency the clock tree is configured for.
+ */
+static SelftestResult StepClock(SelftestContext* ctx) {
+  // ctx->value: bit 0 = LSE reference, bit 1 = LSI enabled here,
+  // bit 2 = TIM21 clock acquired
+  switch (ctx->state) {
+    case 0:
+      if (RCC->CSR & RCC_CSR_LSERDY) {
+        ctx->value = 1U;
+      } else if ((RCC->CSR & RCC_CSR_LSION) == 0) {
+        RCC->CSR |= RCC_CSR_LSION;
+        ctx->value = 2U;
+      }
+      ctx->state = 1;
+      return kSelftestPending;
+    case 1:
+      if (((ctx->value & 1U) == 0) && ((RCC->CSR & RCC_CSR_LSIRDY) == 0)) {
+        return kSelftestPending;
+      }
+      ClockGateAcquire(kClockGateTim21, 0);
+      ctx->value |= 4U;
+      TIM21->CR1 = 0;
+      TIM21->PSC = 0;
+      TIM21->ARR = 0xFFFF;
+      TIM21->OR = (ctx->value & 1U) ? TIM21_OR_TI1_RMP_2                          // LSE
+                                    : (TIM21_OR_TI1_RMP_2 | TIM21_OR_TI1_RMP_0);  // LSI
+      TIM21->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1PSC;  // TI1, capture every 8 edges
+      TIM21->CCER = TIM_CCER_CC1E;
+      TIM21->EGR = TIM_EGR_UG;
+      TIM21->SR = 0;
+      TIM21->CR1 = TIM_CR1_CEN;
+      ctx->state = 2;
+      return kSelftestPending;
+    case 2:
+      if ((TIM21->SR & TIM_SR_CC1IF) == 0) {
+        return kSelftestPending;
+      }
+      ctx->mark = TIM21->CCR1;  // Clears CC1IF
+      ctx->state = 3;
+      return kSelftestPending;
+    default:
+      break;
+  }
+
+  if ((TIM21->SR & TIM_SR_CC1IF) == 0) {
+    return kSelftestPending;
+  }
+  uint32_t cycles = (TIM21->CCR1 - ctx->mark) & 0xFFFFU;
+  uint32_t reference_hz = (ctx->value & 1U) ? LSE_VALUE : LSI_VALUE;
+  uint32_t measured = (uint32_t)(((uint64_t)cycles * reference_hz) / SELFTEST_CLOCK_EDGES);
+  uint32_t expected = HAL_RCC_GetPCLK2Freq() * ((RCC->CFGR & RCC_CFGR_PPRE2_2) ? 2U : 1U);
+  uint32_t tolerance = (ctx->value & 1U) ? SELFTEST_CLOCK_TOLERANCE_PCT : 40U;
+
+  snprintf(ctx->detail, sizeof(ctx->detail), "%lu.%02lu MHz %s",
+           (unsigned long)(measured / 1000000U), (unsigned long)(measured % 1000000U / 10000U),
+           (ctx->value & 1U) ? "LSE" : "LSI");
+  uint32_t error = (measured > expected) ? (measured - expected) : (expected - measured);
+  return ((uint64_t)error * 100U <= (uint64_t)expected * tolerance) ? kSelftestPass
+                                                                     : kSelftestFail;
+}
+
+static void StepClockCleanup(SelftestContext* ctx) {
+  if (ctx->state >= 2) {
+    TIM21->CR1 = 0;
+    TIM21->CCER = 0;
+    TIM21->OR = 0;
+  }
+  if (ctx->value & 4U) {
+    ClockGateRelease(kClockGateTim21, 0);
+  }
+  if (ctx->value & 2U) {
+    RCC->CSR &= ~RCC_CSR_LSION;
+  }
+}
+
+static int FindStep(const char* name) {
+  for (size_t i = 0; i < SELFTEST_NUM_STEPS; ++i) {
+    if (strcmp(kSteps[i].name, name) == 0) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+static const char* ResultName(const StepRun* step) {
+  if (step->timed_out) {
+    return "timeout";
+  }
+  switch (step->result) {
+    case kSelftestPass: return "pass";
+    case kSelftestSkip: return "skip";
+    default:            return "FAIL";
+  }
+}
+
+static void SelftestReport(void) {
+  char buffer[64];
+  uint8_t counts[4] = {0};
+  uint32_t total_us = CycleCountMicros() - run.start_us;
+
+  for (size_t i = 0; i < SELFTEST_NUM_STEPS; ++i) {
+    const StepRun* step = &run.steps[i];
+    if (step->duration_us == 0) {
+      continue;  // Not selected
+    }
+    snprintf(buffer, sizeof(buffer), "%-6s %-7s %6lu us  %s\r\n", kSteps[i].name,
+             ResultName(step), (unsigned long)step->duration_us, step->ctx.detail);
+    ConsolePrint(run.console, buffer);
+    counts[step->result]++;
+  }
+  snprintf(buffer, sizeof(buffer), "selftest: %u pass, %u fail, %u skip in %lu.%lu ms\r\n",
+           counts[kSelftestPass], counts[kSelftestFail], counts[kSelftestSkip],
+           (unsigned long)(total_us / 1000U), (unsigned long)(total_us % 1000U / 100U));
+  ConsolePrint(run.console, buffer);
+  run.console->result = counts[kSelftestFail];
+}
+
+/**
+ * @brief Polls a running step once and finishes it on a final result or
+ * when its timeout expires.
+ */
+static void SelftestPollStep(size_t index) {
+  const SelftestStep* desc = &kSteps[index];
+  StepRun* step = &run.steps[index];
+  SelftestResult result = desc->poll(&step->ctx);
+  uint32_t elapsed = CycleCountMicros() - step->start_us;
+
+  if ((result == kSelftestPending) && (elapsed >= desc->timeout_ms * 1000U)) {
+    result = kSelftestFail;
+    step->timed_out = 1;
+  }
+  if (result == kSelftestPending) {
+    return;
+  }
+
+  if (desc->cleanup != NULL) {
+    desc->cleanup(&step->ctx);
+  }
+  run.busy &= ~desc->resources;
+  step->result = result;
+  step->duration_us = (elapsed > 0) ? elapsed : 1;
+  step->state = kStepIdle;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode SelftestStart(Console* console, char* const names[], int count) {
+  if (run.console != NULL) {
+    return kFull;
+  }
+  for (int i = 0; i < count; ++i) {
+    if (FindStep(names[i]) < 0) {
+      return kInvalidArgument;
+    }
+  }
+
+  memset(run.steps, 0, sizeof(run.steps));
+  for (size_t i = 0; i < SELFTEST_NUM_STEPS; ++i) {
+    run.steps[i].state = (names == NULL) ? kStepWaiting : kStepIdle;
+  }
+  for (int i = 0; i < count; ++i) {
+    run.steps[FindStep(names[i])].state = kStepWaiting;
+  }
+  run.busy = 0;
+  run.start_us = CycleCountMicros();
+  run.console = console;
+  return kOk;
+}
+
+void SelftestList(Console* console) {
+  char buffer[48];
+
+  for (size_t i = 0; i < SELFTEST_NUM_STEPS; ++i) {
+    snprintf(buffer, sizeof(buffer), "%-6s resources %02X, timeout %u ms\r\n",
+             kSteps[i].name, kSteps[i].resources, kSteps[i].timeout_ms);
+    ConsolePrint(console, buffer);
+  }
+}
+
+void SelftestProcess(void) {
+  uint8_t active = 0;
+
+  if (run.console == NULL) {
+    return;
+  }
+  // Steps time the clock tree and the UARTs: run them at the nominal
+  // clock, with no switch under them
+  if (GovernorBoost(GOVERNOR_BOOST_MS) != kOk) {
+    return;
+  }
+
+  for (size_t i = 0; i < SELFTEST_NUM_STEPS; ++i) {
+    StepRun* step = &run.steps[i];
+
+    if ((step->state == kStepWaiting) && ((run.busy & kSteps[i].resources) == 0)) {
+      run.busy |= kSteps[i].resources;
+      step->start_us = CycleCountMicros();
+      step->state = kStepRunning;
+    }
+    if (step->state == kStepRunning) {
+      SelftestPollStep(i);
+    }
+    if (step->state != kStepIdle) {
+      active++;
+    }
+  }
+
+  if (active == 0) {
+    SelftestReport();
+    run.console = NULL;
+  }
+}
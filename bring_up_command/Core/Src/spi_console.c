@@ -0,0 +1,148 @@
+// spi_console.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// SPI1 slave + DMA binding of the SPI console link. The HAL SPI driver is not
+// part of this project, so SPI1 and its two DMA channels are driven at
+// register level.
+
+#include "spi_console.h"
+
+#if SPI_CONSOLE_ENABLED
+
+#include "clock_gate.h"
+#include "main.h"
+#include "spi_link.h"
+
+#define SPI_CONSOLE_NSS_Pin        GPIO_PIN_15
+#define SPI_CONSOLE_NSS_GPIO_Port  GPIOA
+#define SPI_CONSOLE_SCK_Pin        GPIO_PIN_3
+#define SPI_CONSOLE_MISO_Pin       GPIO_PIN_4
+#define SPI_CONSOLE_MOSI_Pin       GPIO_PIN_5
+#define SPI_CONSOLE_GPIO_Port      GPIOB
+
+#define SPI_CONSOLE_DMA_RX         DMA1_Channel2
+#define SPI_CONSOLE_DMA_TX         DMA1_Channel3
+#define SPI_CONSOLE_DMA_REQUEST    1U  // SPI1 request on channels 2 and 3
+
+static SpiLink spi_link;
+static volatile uint32_t last_frame_tick;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Back-pressure hook: keep waiting while the master is polling.
+ */
+static uint8_t SpiConsoleWait(SpiLink* link) {
+  return ((HAL_GetTick() - last_frame_tick) < SPI_CONSOLE_WRITE_TIMEOUT_MS) ? 1 : 0;
+}
+
+/**
+ * @brief Resets SPI1 and arms both DMA channels for the next transaction.
+ *
+ * The peripheral reset drops any byte the TX DMA already preloaded into the
+ * data register, so every transaction starts with byte 0 of the frame.
+ */
+static void SpiConsoleArm(void) {
+  SPI_CONSOLE_DMA_RX->CCR &= ~DMA_CCR_EN;
+  SPI_CONSOLE_DMA_TX->CCR &= ~DMA_CCR_EN;
+
+  RCC->APB2RSTR |= RCC_APB2RSTR_SPI1RST;
+  RCC->APB2RSTR &= ~RCC_APB2RSTR_SPI1RST;
+
+  // Slave, mode 0, 8-bit, MSB first, hardware NSS
+  SPI1->CR1 = 0;
+  SPI1->CR2 = SPI_CR2_RXDMAEN;
+
+  SPI_CONSOLE_DMA_RX->CNDTR = SPI_LINK_FRAME_SIZE;
+  SPI_CONSOLE_DMA_RX->CCR |= DMA_CCR_EN;
+
+  SPI_CONSOLE_DMA_TX->CNDTR = SPI_LINK_FRAME_SIZE;
+  SPI_CONSOLE_DMA_TX->CCR |= DMA_CCR_EN;
+
+  SPI1->CR2 |= SPI_CR2_TXDMAEN;
+  SPI1->CR1 |= SPI_CR1_SPE;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void SpiConsoleInit(void) {
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  // The link is driven by the master: it runs while the core sleeps
+  ClockGateAcquire(kClockGateSpi1, 1);
+  ClockGateAcquire(kClockGateGpioA, 1);
+  ClockGateAcquire(kClockGateGpioB, 1);
+  ClockGateAcquire(kClockGateDma1, 1);
+
+  GPIO_InitStruct.Pin = SPI_CONSOLE_SCK_Pin|SPI_CONSOLE_MISO_Pin|SPI_CONSOLE_MOSI_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+  GPIO_InitStruct.Alternate = GPIO_AF0_SPI1;
+  HAL_GPIO_Init(SPI_CONSOLE_GPIO_Port, &GPIO_InitStruct);
+
+  GPIO_InitStruct.Pin = SPI_CONSOLE_NSS_Pin;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;  // Idle high when no master is wired
+  HAL_GPIO_Init(SPI_CONSOLE_NSS_GPIO_Port, &GPIO_InitStruct);
+
+  // NSS stays in its SPI alternate function; EXTI15 watches the same input
+  // for the rising edge that ends a transaction
+  SYSCFG->EXTICR[3] = (SYSCFG->EXTICR[3] & ~SYSCFG_EXTICR4_EXTI15) | SYSCFG_EXTICR4_EXTI15_PA;
+  EXTI->RTSR |= EXTI_RTSR_RT15;
+  EXTI->FTSR &= ~EXTI_FTSR_FT15;
+  EXTI->PR = EXTI_PR_PIF15;
+  EXTI->IMR |= EXTI_IMR_IM15;
+
+  // Route SPI1 requests to channels 2 (RX) and 3 (TX)
+  DMA1_CSELR->CSELR = (DMA1_CSELR->CSELR & ~(DMA_CSELR_C2S | DMA_CSELR_C3S)) |
+                      (SPI_CONSOLE_DMA_REQUEST << DMA_CSELR_C2S_Pos) |
+                      (SPI_CONSOLE_DMA_REQUEST << DMA_CSELR_C3S_Pos);
+
+  SPI_CONSOLE_DMA_RX->CCR = DMA_CCR_MINC | DMA_CCR_PL_1;
+  SPI_CONSOLE_DMA_RX->CPAR = (uint32_t)&SPI1->DR;
+  SPI_CONSOLE_DMA_RX->CMAR = (uint32_t)spi_link.rx_frame;
+
+  SPI_CONSOLE_DMA_TX->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_PL_1;
+  SPI_CONSOLE_DMA_TX->CPAR = (uint32_t)&SPI1->DR;
+  SPI_CONSOLE_DMA_TX->CMAR = (uint32_t)spi_link.tx_frame;
+
+  last_frame_tick = HAL_GetTick();
+  SpiLinkInit(&spi_link, "spi1", SpiConsoleWait);
+  SpiConsoleArm();
+
+  HAL_NVIC_SetPriority(EXTI4_15_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(EXTI4_15_IRQn);
+}
+
+void SpiConsoleProcess(void) {
+  ConsoleProcess(&spi_link.console);
+}
+
+void SpiConsoleEndOfTransaction(void) {
+  uint16_t received = (uint16_t)(SPI_LINK_FRAME_SIZE - SPI_CONSOLE_DMA_RX->CNDTR);
+
+  SPI_CONSOLE_DMA_RX->CCR &= ~DMA_CCR_EN;
+  SPI_CONSOLE_DMA_TX->CCR &= ~DMA_CCR_EN;
+
+  SpiLinkComplete(&spi_link, received);
+  if (received == SPI_LINK_FRAME_SIZE) {
+    last_frame_tick = HAL_GetTick();
+    SpiLinkPrepare(&spi_link);
+  }
+  // A short transaction re-sends the same device frame
+  SpiConsoleArm();
+}
+
+#endif  // SPI_CONSOLE_ENABLED
+
+uint8_t SpiConsoleClockReachable(uint32_t sysclk_hz) {
+#if SPI_CONSOLE_ENABLED
+  return (sysclk_hz / SPI_CONSOLE_PCLK_PER_SCK) >= SPI_CONSOLE_SCK_HZ;
+#else
+  (void)sysclk_hz;
+  return 1;
+#endif
+}
@@ -0,0 +1,112 @@
+// spi_link.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Hardware-independent frame handling of the SPI-slave console transport.
+
+#include "spi_link.h"
+#include <stddef.h>
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Console output function: queues data for the master to collect.
+ */
+static void SpiLinkWrite(Console* console, const uint8_t* data, uint16_t len) {
+  SpiLink* link = (SpiLink*)console->transport;
+
+  while (len > 0) {
+    uint16_t free_items = 0;
+    RingBufferFreeItems(&link->tx, &free_items);
+
+    uint16_t chunk = (len < free_items) ? len : free_items;
+    if (chunk > 0) {
+      RingBufferStreamPush(&link->tx, (uint8_t*)data, chunk);
+      data += chunk;
+      len -= chunk;
+    } else if ((link->wait == NULL) || !link->wait(link)) {
+      return;  // Master is not polling, drop the rest
+    }
+  }
+}
+
+static uint16_t SpiLinkWritable(const Console* console) {
+  SpiLink* link = (SpiLink*)console->transport;
+  uint16_t free_items = 0;
+
+  RingBufferFreeItems(&link->tx, &free_items);
+  return free_items;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void SpiLinkInit(SpiLink* link, const char* name, SpiLinkWaitFn wait) {
+  RingBufferInit(&link->tx);
+  link->flags = 0;
+  link->wait = wait;
+  link->frames = 0;
+  link->bad_frames = 0;
+  ConsoleInit(&link->console, name, SpiLinkWrite, link);
+  link->console.writable = SpiLinkWritable;
+  SpiLinkPrepare(link);
+}
+
+void SpiLinkPrepare(SpiLink* link) {
+  uint16_t len = 0;
+  uint16_t credit = 0;
+
+  RingBufferCurrentItems(&link->tx, &len);
+  if (len > SPI_LINK_PAYLOAD) {
+    len = SPI_LINK_PAYLOAD;
+  }
+  if (len > 0) {
+    RingBufferStreamPop(&link->tx, &link->tx_frame[SPI_LINK_HEADER_SIZE], len);
+  }
+
+  RingBufferFreeItems(&link->console.rx, &credit);
+  if (credit > SPI_LINK_PAYLOAD) {
+    credit = SPI_LINK_PAYLOAD;
+  }
+
+  uint8_t flags = link->flags;
+  if (RingBufferIsEmpty(&link->tx) != kEmpty) {
+    flags |= SPI_LINK_FLAG_MORE;
+  }
+  link->flags = 0;
+
+  link->tx_frame[0] = SPI_LINK_MAGIC;
+  link->tx_frame[1] = flags;
+  link->tx_frame[2] = (uint8_t)len;
+  link->tx_frame[3] = (uint8_t)credit;
+}
+
+void SpiLinkComplete(SpiLink* link, uint16_t received) {
+  const uint8_t* frame = link->rx_frame;
+
+  if (received < SPI_LINK_FRAME_SIZE) {
+    if (received > 0) {
+      link->bad_frames++;
+    }
+    return;
+  }
+  link->frames++;
+
+  if ((frame[0] != SPI_LINK_MAGIC) || (frame[2] == 0)) {
+    return;  // Poll-only frame
+  }
+
+  uint16_t len = frame[2];
+  if (len > SPI_LINK_PAYLOAD) {
+    link->bad_frames++;
+    link->flags |= SPI_LINK_FLAG_DROPPED;
+    return;
+  }
+
+  if (RingBufferWillFull(&link->console.rx, len) == kFull) {
+    link->flags |= SPI_LINK_FLAG_DROPPED;  // Host ignored the credit
+    return;
+  }
+  ConsoleReceive(&link->console, &frame[SPI_LINK_HEADER_SIZE], len);
+}
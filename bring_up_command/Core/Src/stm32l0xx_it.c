@@ -22,6 +22,11 @@
 #include "stm32l0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "spi_console.h"
+#include "timesync.h"
+#include "dma_copy.h"
+#include "profiler.h"
+#include "uart_console.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,7 +60,14 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_lpuart1_rx;
+extern DMA_HandleTypeDef hdma_lpuart1_tx;
+extern DMA_HandleTypeDef hdma_usart1_rx;
+extern DMA_HandleTypeDef hdma_usart1_tx;
 extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern UART_HandleTypeDef hlpuart1;
+extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 /* USER CODE BEGIN EV */
 
@@ -141,6 +153,25 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32l0xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles DMA1 channel 2 and channel 3 interrupts.
+  */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
+#if SPI_CONSOLE_ENABLED
+  // Channels 2/3 serve SPI1, which runs without DMA interrupts
+#else
+
+  /* USER CODE END DMA1_Channel2_3_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
+#endif
+
+  /* USER CODE END DMA1_Channel2_3_IRQn 1 */
+}
+
 /**
   * @brief This function handles DMA1 channel 4, channel 5, channel 6 and channel 7 interrupts.
   */
@@ -149,19 +180,40 @@ void DMA1_Channel4_5_6_7_IRQHandler(void)
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 0 */
 
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
   HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  HAL_DMA_IRQHandler(&hdma_lpuart1_rx);
+  HAL_DMA_IRQHandler(&hdma_lpuart1_tx);
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 1 */
 
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 1 */
 }
 
+/**
+  * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXTI line 25.
+  */
+void USART1_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART1_IRQn 0 */
+  if (UartConsoleIrq(&huart1)) {
+    return;  // Idle line: console reception
+  }
+  /* USER CODE END USART1_IRQn 0 */
+  HAL_UART_IRQHandler(&huart1);
+  /* USER CODE BEGIN USART1_IRQn 1 */
+
+  /* USER CODE END USART1_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART2 global interrupt / USART2 wake-up interrupt through EXTI line 26.
   */
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  if (UartConsoleIrq(&huart2)) {
+    return;  // Idle line: console reception
+  }
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
@@ -169,6 +221,75 @@ void USART2_IRQHandler(void)
   /* USER CODE END USART2_IRQn 1 */
 }
 
+/**
+  * @brief This function handles RNG and LPUART1 Interrupts / LPUART1 wake-up interrupt through EXTI line 28.
+  */
+void RNG_LPUART1_IRQHandler(void)
+{
+  /* USER CODE BEGIN RNG_LPUART1_IRQn 0 */
+  if (UartConsoleIrq(&hlpuart1)) {
+    return;  // Idle line: console reception
+  }
+  /* USER CODE END RNG_LPUART1_IRQn 0 */
+  HAL_UART_IRQHandler(&hlpuart1);
+  /* USER CODE BEGIN RNG_LPUART1_IRQn 1 */
+
+  /* USER CODE END RNG_LPUART1_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
+#if SPI_CONSOLE_ENABLED
+/**
+  * @brief This function handles EXTI line 4 to 15 interrupts
+  * (SPI console NSS rising edge).
+  */
+void EXTI4_15_IRQHandler(void)
+{
+  if (EXTI->PR & EXTI_PR_PIF15) {
+    EXTI->PR = EXTI_PR_PIF15;
+    SpiConsoleEndOfTransaction();
+  }
+  HAL_GPIO_EXTI_IRQHandler(B1_Pin);
+}
+#endif
+
+/**
+  * @brief This function handles TIM2 global interrupt (timesync timebase
+  * and sync pulse capture).
+  */
+void TIM2_IRQHandler(void)
+{
+  TimesyncTimerIrq();
+}
+
+/**
+  * @brief This function handles DMA1 channel 1 interrupt (memory-to-memory
+  * copies).
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  DmaCopyIrq();
+}
+
+/**
+  * @brief This function handles TIM6 interrupt (profiler sampling). Naked,
+  * so that the stack still holds the exception frame of the interrupted
+  * code: EXC_RETURN bit 2 tells which stack it is on, and the body returns
+  * straight to it.
+  */
+__attribute__((naked)) void TIM6_DAC_IRQHandler(void)
+{
+  __asm volatile(
+      "mrs  r0, msp              \n"
+      "movs r1, #4               \n"
+      "mov  r2, lr               \n"
+      "tst  r1, r2               \n"
+      "beq  1f                   \n"
+      "mrs  r0, psp              \n"
+      "1:                        \n"
+      "ldr  r1, =ProfilerTimerIrq\n"
+      "bx   r1                   \n"
+      ".ltorg                    \n");
+}
 
 /* USER CODE END 1 */
@@ -0,0 +1,379 @@
+// timesync.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Microsecond timebase on TIM2, sync pulse capture and a least-squares
+// fit of the local clock against the host reference (see timesync.h).
+
+#include "timesync.h"
+#include "clock_gate.h"
+#include "main.h"
+#include "trace.h"
+#include <stdio.h>
+
+// TIM2 runs from HSI16 or MSI: HSI16 is within 1% at 25 C and -4/+2%
+// over temperature
+#define TIMESYNC_MAX_DRIFT_PPB 50000000LL
+
+typedef struct {
+  uint64_t local_us;
+  int64_t ref_us;
+} SyncPair;
+
+static struct {
+  volatile uint32_t overflows;     ///< TIM2 wraps (upper bits of the tick count)
+  // Local time = base_us + (ticks - base_ticks) * tick_num / tick_den
+  uint64_t base_ticks;
+  uint64_t base_us;
+  uint32_t tick_num;
+  uint32_t tick_den;
+  volatile uint64_t pulse_us;      ///< Local time of the last captured edge
+  volatile uint8_t pulse_valid;
+  SyncPair pairs[TIMESYNC_WINDOW]; ///< Ring of the newest pairs
+  uint8_t head;                    ///< Next slot to write
+  uint8_t count;
+  uint32_t total;                  ///< Pairs accepted since the last reset
+  uint32_t steps;                  ///< Fit restarts
+  // Fit: ref = anchor_ref + d + d * drift_ppb / 1e9, d = local - anchor_local
+  uint64_t anchor_local;
+  int64_t anchor_ref;
+  int32_t drift_ppb;
+  uint32_t residual_us;            ///< Worst |residual| of the current fit
+  uint8_t held;                    ///< Pairs dropped at an oscillator switch, anchor kept
+  uint32_t oscillator;             ///< TimesyncOscillator() the pairs were taken on
+} clock_sync;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Combines the overflow count with a 16-bit counter value read at
+ * the same time, accounting for a wrap not serviced yet.
+ */
+static uint64_t TimesyncExtend(uint16_t count) {
+  uint32_t high = clock_sync.overflows;
+
+  if ((TIM2->SR & TIM_SR_UIF) && (count < 0x8000U)) {
+    ++high;
+  }
+  return ((uint64_t)high << 16) | count;
+}
+
+static uint64_t TimesyncTicksToMicros(uint64_t ticks) {
+  uint64_t delta = ticks - clock_sync.base_ticks;
+
+  if (clock_sync.tick_num == clock_sync.tick_den) {
+    return clock_sync.base_us + delta;  // Whole MHz timer clock
+  }
+  return clock_sync.base_us + delta * clock_sync.tick_num / clock_sync.tick_den;
+}
+
+/**
+ * @brief Prescaler for a tick as close to 1 us as the timer clock allows;
+ * sets the tick to microseconds ratio.
+ */
+static uint32_t TimesyncPrescaler(void) {
+  uint32_t clock = HAL_RCC_GetPCLK1Freq() * ((RCC->CFGR & RCC_CFGR_PPRE1_2) ? 2U : 1U);
+  uint32_t prescaler = (clock + 500000U) / 1000000U;
+
+  if (prescaler == 0) {
+    prescaler = 1;
+  }
+  uint32_t a = 1000000U;
+  uint32_t b = clock / prescaler;  // Tick rate
+
+  while (b != 0) {  // GCD, to keep the scaling product small
+    uint32_t r = a % b;
+    a = b;
+    b = r;
+  }
+  clock_sync.tick_num = 1000000U / a;
+  clock_sync.tick_den = clock / prescaler / a;
+  return prescaler - 1U;
+}
+
+/**
+ * @brief Oscillator behind SYSCLK, as RCC_CFGR_SWS_*: the PLL has the
+ * error of its input.
+ */
+static uint32_t TimesyncOscillator(void) {
+  uint32_t sws = RCC->CFGR & RCC_CFGR_SWS;
+
+  if (sws == RCC_CFGR_SWS_PLL) {
+    return ((RCC->CFGR & RCC_CFGR_PLLSRC) == RCC_CFGR_PLLSRC_HSE) ? RCC_CFGR_SWS_HSE
+                                                                  : RCC_CFGR_SWS_HSI;
+  }
+  return sws;
+}
+
+static int64_t TimesyncModel(uint64_t local_us) {
+  int64_t d = (int64_t)(local_us - clock_sync.anchor_local);
+  return clock_sync.anchor_ref + d + (d * clock_sync.drift_ppb) / 1000000000LL;
+}
+
+/**
+ * @brief Slope @p num / @p den in us/ms as ppb (times 1e6), clamped to
+ * +-TIMESYNC_MAX_DRIFT_PPB.
+ *
+ * The fraction is divided out three digits at a time, so nothing larger
+ * than den * 1000 is formed: num * 1e6 overflows 64 bits for windows of
+ * a few minutes at a drift of a few percent.
+ */
+static int64_t TimesyncSlopePpb(int64_t num, int64_t den) {
+  int64_t q = num / den;
+
+  if ((q > TIMESYNC_MAX_DRIFT_PPB / 1000000) || (q < -TIMESYNC_MAX_DRIFT_PPB / 1000000)) {
+    return (q < 0) ? -TIMESYNC_MAX_DRIFT_PPB : TIMESYNC_MAX_DRIFT_PPB;
+  }
+  num %= den;
+  for (int i = 0; i < 2; ++i) {
+    num *= 1000;
+    q = q * 1000 + num / den;
+    num %= den;
+  }
+  if (q > TIMESYNC_MAX_DRIFT_PPB) {
+    q = TIMESYNC_MAX_DRIFT_PPB;
+  } else if (q < -TIMESYNC_MAX_DRIFT_PPB) {
+    q = -TIMESYNC_MAX_DRIFT_PPB;
+  }
+  return q;
+}
+
+/**
+ * @brief Fits ref - local over the window.
+ *
+ * x is the local time from the oldest pair in ms and y the change of the
+ * offset in us, so the slope in us/ms times 1e6 is the drift in ppb. At
+ * the largest drift the sums stay inside 64 bits for windows of about
+ * ten hours.
+ */
+static void TimesyncFit(void) {
+  uint8_t n = clock_sync.count;
+  uint8_t oldest = (uint8_t)((clock_sync.head + TIMESYNC_WINDOW - n) % TIMESYNC_WINDOW);
+  uint8_t newest = (uint8_t)((clock_sync.head + TIMESYNC_WINDOW - 1) % TIMESYNC_WINDOW);
+  const SyncPair* base = &clock_sync.pairs[oldest];
+  int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+  for (uint8_t i = 0; i < n; ++i) {
+    const SyncPair* p = &clock_sync.pairs[(oldest + i) % TIMESYNC_WINDOW];
+    int64_t dl = (int64_t)(p->local_us - base->local_us);
+    int64_t x = dl / 1000;
+    int64_t y = (p->ref_us - base->ref_us) - dl;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+
+  int64_t den = n * sxx - sx * sx;
+  int64_t drift = (den > 0) ? TimesyncSlopePpb(n * sxy - sx * sy, den) : 0;
+  int64_t intercept = (sy * 1000000LL - drift * sx) / (n * 1000000LL);
+
+  // Anchor at the newest pair, on the fitted line
+  const SyncPair* last = &clock_sync.pairs[newest];
+  int64_t dl_last = (int64_t)(last->local_us - base->local_us);
+  clock_sync.drift_ppb = (int32_t)drift;
+  clock_sync.anchor_local = last->local_us;
+  clock_sync.anchor_ref = base->ref_us + dl_last + intercept + (drift * (dl_last / 1000)) / 1000000LL;
+
+  clock_sync.residual_us = 0;
+  for (uint8_t i = 0; i < n; ++i) {
+    const SyncPair* p = &clock_sync.pairs[(oldest + i) % TIMESYNC_WINDOW];
+    int64_t r = p->ref_us - TimesyncModel(p->local_us);
+    uint32_t mag = (uint32_t)((r < 0) ? -r : r);
+    if (mag > clock_sync.residual_us) {
+      clock_sync.residual_us = mag;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void TimesyncInit(void) {
+  GPIO_InitTypeDef gpio = {0};
+
+  TimesyncReset();
+  clock_sync.overflows = 0;
+  clock_sync.base_ticks = 0;
+  clock_sync.base_us = 0;
+  clock_sync.pulse_valid = 0;
+  clock_sync.oscillator = TimesyncOscillator();
+
+  gpio.Pin = TIMESYNC_PIN;
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_PULLDOWN;  // No pulse while the sync wire is unconnected
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  gpio.Alternate = TIMESYNC_AF;
+  HAL_GPIO_Init(TIMESYNC_PORT, &gpio);
+
+  ClockGateAcquire(kClockGateTim2, 1);  // The timebase counts through sleep
+  TIM2->CR1 = 0;
+  TIM2->PSC = TimesyncPrescaler();
+  TIM2->ARR = 0xFFFFU;
+  // CC2 = input from TI2, rising edge, filter 4 samples against ringing
+  TIM2->CCMR1 = TIM_CCMR1_CC2S_0 | TIM_CCMR1_IC2F_1;
+  TIM2->CCER = TIM_CCER_CC2E;
+  TIM2->EGR = TIM_EGR_UG;  // Load the prescaler
+  TIM2->SR = 0;
+  TIM2->DIER = TIM_DIER_UIE | TIM_DIER_CC2IE;
+  HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM2_IRQn);
+  TIM2->CR1 = TIM_CR1_URS | TIM_CR1_CEN;  // Only overflows raise UIF
+}
+
+void TimesyncClockChanged(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint64_t ticks = TimesyncExtend((uint16_t)TIM2->CNT);
+  clock_sync.base_us = TimesyncTicksToMicros(ticks);
+  clock_sync.base_ticks = ticks;
+  TIM2->PSC = TimesyncPrescaler();
+
+  // Load the prescaler now rather than at the next wrap; the update event
+  // clears the counter, so put the count back
+  uint16_t count = (uint16_t)TIM2->CNT;
+  TIM2->EGR = TIM_EGR_UG;
+  TIM2->CNT = count;
+
+  // The drift belongs to the old oscillator: keep the reference time
+  // reached so far and start the fit over on the new one
+  uint32_t oscillator = TimesyncOscillator();
+  if (oscillator != clock_sync.oscillator) {
+    clock_sync.oscillator = oscillator;
+    if ((clock_sync.count > 0) || clock_sync.held) {
+      uint64_t now = TimesyncTicksToMicros(TimesyncExtend((uint16_t)TIM2->CNT));
+      clock_sync.anchor_ref = TimesyncModel(now);
+      clock_sync.anchor_local = now;
+      clock_sync.drift_ppb = 0;
+      clock_sync.residual_us = 0;
+      clock_sync.count = 0;
+      clock_sync.held = 1;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+uint64_t TimesyncLocalMicros(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint64_t now = TimesyncTicksToMicros(TimesyncExtend((uint16_t)TIM2->CNT));
+  __set_PRIMASK(primask);
+  return now;
+}
+
+int64_t TimesyncToReference(uint64_t local_us) {
+  return ((clock_sync.count > 0) || clock_sync.held) ? TimesyncModel(local_us)
+                                                     : (int64_t)local_us;
+}
+
+int64_t TimesyncNow(void) {
+  return TimesyncToReference(TimesyncLocalMicros());
+}
+
+uint8_t TimesyncIsSynced(void) {
+  return ((clock_sync.count > 0) || clock_sync.held) ? 1U : 0U;
+}
+
+ReturnCode TimesyncAddPair(uint64_t local_us, int64_t ref_us) {
+  if (clock_sync.count > 0) {
+    const SyncPair* last = &clock_sync.pairs[(clock_sync.head + TIMESYNC_WINDOW - 1) % TIMESYNC_WINDOW];
+    if (local_us <= last->local_us) {
+      return kInvalidArgument;
+    }
+    // One pair has no drift yet, and HSI16 alone may be percents off
+    int64_t miss = ref_us - TimesyncModel(local_us);
+    if ((clock_sync.count > 1) && ((miss > TIMESYNC_STEP_US) || (miss < -TIMESYNC_STEP_US))) {
+      clock_sync.count = 0;  // Reference clock stepped: start over
+      ++clock_sync.steps;
+    }
+  }
+
+  clock_sync.pairs[clock_sync.head].local_us = local_us;
+  clock_sync.pairs[clock_sync.head].ref_us = ref_us;
+  clock_sync.head = (uint8_t)((clock_sync.head + 1) % TIMESYNC_WINDOW);
+  if (clock_sync.count < TIMESYNC_WINDOW) {
+    ++clock_sync.count;
+  }
+  ++clock_sync.total;
+  clock_sync.held = 0;
+  TimesyncFit();
+  TraceEvent(TRACE_ID_SYNC, clock_sync.residual_us);
+  return kOk;
+}
+
+ReturnCode TimesyncLastPulse(uint64_t* local_us) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint8_t valid = clock_sync.pulse_valid;
+  uint64_t pulse = clock_sync.pulse_us;
+  __set_PRIMASK(primask);
+
+  if (!valid || (TimesyncLocalMicros() - pulse > TIMESYNC_PULSE_AGE_US)) {
+    return kEmpty;
+  }
+  *local_us = pulse;
+  return kOk;
+}
+
+void TimesyncFormat(char* out, size_t size, int64_t us) {
+  uint64_t mag = (uint64_t)((us < 0) ? -us : us);
+
+  // newlib-nano printf has no 64-bit conversions
+  snprintf(out, size, "%s%lu.%06lu", (us < 0) ? "-" : "",
+           (unsigned long)(mag / 1000000U), (unsigned long)(mag % 1000000U));
+}
+
+void TimesyncReset(void) {
+  clock_sync.head = 0;
+  clock_sync.count = 0;
+  clock_sync.total = 0;
+  clock_sync.steps = 0;
+  clock_sync.drift_ppb = 0;
+  clock_sync.residual_us = 0;
+  clock_sync.held = 0;
+}
+
+void TimesyncReport(Console* console) {
+  char local[24];
+  char ref[24];
+  char offset[24];
+  char buffer[160];
+  uint64_t now = TimesyncLocalMicros();
+
+  TimesyncFormat(local, sizeof(local), (int64_t)now);
+  TimesyncFormat(ref, sizeof(ref), TimesyncToReference(now));
+  snprintf(buffer, sizeof(buffer), "local %s s, reference %s s\r\n", local, ref);
+  ConsolePrint(console, buffer);
+  if (clock_sync.held) {
+    ConsolePrint(console, "Oscillator changed: held at the last fit, no drift, waiting for pairs.\r\n");
+    return;
+  }
+  if (clock_sync.count == 0) {
+    ConsolePrint(console, "Not synchronized.\r\n");
+    return;
+  }
+  TimesyncFormat(offset, sizeof(offset), TimesyncToReference(now) - (int64_t)now);
+  snprintf(buffer, sizeof(buffer),
+           "offset %s s, drift %ld ppb, %u/%u pairs (%lu total, %lu steps), residual %lu us\r\n",
+           offset, (long)clock_sync.drift_ppb, clock_sync.count, TIMESYNC_WINDOW,
+           (unsigned long)clock_sync.total, (unsigned long)clock_sync.steps,
+           (unsigned long)clock_sync.residual_us);
+  ConsolePrint(console, buffer);
+}
+
+void TimesyncTimerIrq(void) {
+  uint32_t sr = TIM2->SR;
+
+  if (sr & TIM_SR_CC2IF) {
+    // Reading CCR2 clears CC2IF; UIF is still pending here if the edge
+    // came just after a wrap
+    clock_sync.pulse_us = TimesyncTicksToMicros(TimesyncExtend((uint16_t)TIM2->CCR2));
+    clock_sync.pulse_valid = 1;
+  }
+  if (sr & TIM_SR_UIF) {
+    TIM2->SR = (uint32_t)~TIM_SR_UIF;
+    ++clock_sync.overflows;
+  }
+}
@@ -0,0 +1,69 @@
+// trace.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Log lines and binary trace records stamped on the synchronized
+// timebase (see trace.h).
+
+#include "trace.h"
+#include "mux.h"
+#include "timesync.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t dropped;
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void TraceLog(const char* format, ...) {
+  char line[TRACE_LINE_SIZE];
+  va_list args;
+
+  if (!MuxIsActive()) {
+    return;
+  }
+  TimesyncFormat(line, sizeof(line), TimesyncNow());
+  size_t len = strlen(line);
+  line[len++] = ' ';
+
+  va_start(args, format);
+  int n = vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+  va_end(args);
+  if (n < 0) {
+    return;
+  }
+  len += ((size_t)n < sizeof(line) - len - 1) ? (size_t)n : sizeof(line) - len - 2;
+  line[len++] = '\n';
+
+  if (MuxWrite(MUX_CH_LOG, (const uint8_t*)line, (uint16_t)len) != kOk) {
+    ++dropped;
+  }
+}
+
+void TraceEvent(uint16_t id, uint32_t value) {
+  uint8_t record[TRACE_RECORD_SIZE];
+  uint64_t now;
+
+  if (!MuxIsActive()) {
+    return;
+  }
+  now = (uint64_t)TimesyncNow();
+  for (int i = 0; i < 8; ++i) {
+    record[i] = (uint8_t)(now >> (8 * i));
+  }
+  record[8] = (uint8_t)id;
+  record[9] = (uint8_t)(id >> 8);
+  for (int i = 0; i < 4; ++i) {
+    record[10 + i] = (uint8_t)(value >> (8 * i));
+  }
+
+  if (MuxWrite(MUX_CH_TRACE, record, sizeof(record)) != kOk) {
+    ++dropped;
+  }
+}
+
+uint32_t TraceDropped(void) {
+  return dropped;
+}
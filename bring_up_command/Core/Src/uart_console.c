@@ -0,0 +1,453 @@
+// uart_console.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// UART transport for console sessions: circular DMA reception with idle-line
+// detection and DMA transmission from a per-port ring buffer.
+
+#include "uart_console.h"
+#include "clock_gate.h"
+#include "reg.h"
+#include "spi_console.h"
+#include <stddef.h>
+#include <string.h>
+
+extern UART_HandleTypeDef huart1;    // Declared in main.c
+extern UART_HandleTypeDef huart2;    // Declared in main.c
+extern UART_HandleTypeDef hlpuart1;  // Declared in main.c
+
+// -----------------------------------------------------------------------------
+// Port table
+// -----------------------------------------------------------------------------
+typedef struct {
+  const char* name;
+  UART_HandleTypeDef* huart;
+  ClockGateId clock;
+} UartConsolePort;
+
+static const UartConsolePort kPorts[] = {
+    {"usart2",  &huart2,   kClockGateUsart2},   // ST-LINK virtual COM port
+#if !SPI_CONSOLE_ENABLED
+    {"usart1",  &huart1,   kClockGateUsart1},   // DMA channels 2/3 go to SPI1 otherwise
+#endif
+    {"lpuart1", &hlpuart1, kClockGateLpuart1},
+};
+
+#define UART_CONSOLE_COUNT (sizeof(kPorts) / sizeof(kPorts[0]))
+
+static UartConsole uart_consoles[UART_CONSOLE_COUNT];
+static volatile uint8_t tx_hold;  ///< Set by UartConsoleHoldTx()
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Finds the console bound to a HAL UART handle.
+ *
+ * @return The console, or NULL if the UART does not carry a console.
+ */
+static UartConsole* UartConsoleFind(const UART_HandleTypeDef* huart) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    if (uart_consoles[i].huart == huart) {
+      return &uart_consoles[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Starts a DMA transfer of pending output if the channel is idle.
+ *
+ * Called from both the main loop and the TX complete interrupt, so the
+ * idle check and the start of the transfer run with interrupts masked.
+ */
+static void UartConsoleKickTx(UartConsole* port) {
+  const uint8_t* data;
+  uint16_t len;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if ((port->tx_inflight == 0) && !port->acquired && !tx_hold &&
+      (RingBufferPeekLinear(&port->tx, &data, &len) == kOk)) {
+    if (HAL_UART_Transmit_DMA(port->huart, (uint8_t*)data, len) == HAL_OK) {
+      port->tx_inflight = len;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Console output function: queues data and waits only when the
+ * port's own TX buffer is full (drops it while the port is acquired).
+ */
+static void UartConsoleWrite(Console* console, const uint8_t* data, uint16_t len) {
+  UartConsole* port = (UartConsole*)console->transport;
+
+  while (len > 0) {
+    uint16_t free_items = 0;
+    RingBufferFreeItems(&port->tx, &free_items);
+
+    uint16_t chunk = (len < free_items) ? len : free_items;
+    if (chunk > 0) {
+      RingBufferStreamPush(&port->tx, (uint8_t*)data, chunk);
+      data += chunk;
+      len -= chunk;
+    } else if (port->acquired) {
+      return;  // Nothing drains the buffer until the port is released
+    }
+    UartConsoleKickTx(port);
+  }
+}
+
+/**
+ * @brief Console free-space query: room left in the port's TX buffer.
+ */
+static uint16_t UartConsoleWritable(const Console* console) {
+  UartConsole* port = (UartConsole*)console->transport;
+  uint16_t free_items = 0;
+
+  RingBufferFreeItems(&port->tx, &free_items);
+  return free_items;
+}
+
+/**
+ * @brief (Re)starts circular DMA reception with idle-line detection.
+ */
+static void UartConsoleStartRx(UartConsole* port) {
+  port->rx_last_pos = 0;
+  HAL_UARTEx_ReceiveToIdle_DMA(port->huart, port->rx_dma_buf,
+                               UART_CONSOLE_RX_DMA_SIZE);
+}
+
+/**
+ * @brief Kernel clock of a port.
+ *
+ * @param sysclk_hz System clock to assume, with undivided APB buses, or 0
+ *     for the clocks currently running.
+ */
+static uint32_t UartConsoleKernelClock(UART_HandleTypeDef* huart, uint32_t sysclk_hz) {
+  UART_ClockSourceTypeDef source = UART_CLOCKSOURCE_UNDEFINED;
+
+  UART_GETCLOCKSOURCE(huart, source);
+  switch (source) {
+    case UART_CLOCKSOURCE_PCLK1:
+      return (sysclk_hz != 0) ? sysclk_hz : HAL_RCC_GetPCLK1Freq();
+    case UART_CLOCKSOURCE_PCLK2:
+      return (sysclk_hz != 0) ? sysclk_hz : HAL_RCC_GetPCLK2Freq();
+    case UART_CLOCKSOURCE_SYSCLK:
+      return (sysclk_hz != 0) ? sysclk_hz : HAL_RCC_GetSysClockFreq();
+    case UART_CLOCKSOURCE_HSI:
+      return (RCC->CR & RCC_CR_HSIDIVF) ? (HSI_VALUE / 4U) : HSI_VALUE;
+    case UART_CLOCKSOURCE_LSE:
+      return LSE_VALUE;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief BRR value for the port's baud rate at @p clock, as the HAL
+ * computes it.
+ *
+ * @return The divider, or 0 if it is out of range or the rate error is
+ *     above UART_CONSOLE_BAUD_ERROR_PERMILLE.
+ */
+static uint32_t UartConsoleDivider(const UART_HandleTypeDef* huart, uint32_t clock) {
+  uint32_t baud = huart->Init.BaudRate;
+  uint32_t brr;
+  uint64_t actual;
+
+  if ((baud == 0) || (clock == 0)) {
+    return 0;
+  }
+  if (IS_LPUART_INSTANCE(huart->Instance)) {
+    if ((clock < 3U * baud) || (clock / 4096U > baud)) {
+      return 0;
+    }
+    brr = (uint32_t)UART_DIV_LPUART(clock, baud);
+    if ((brr < 0x300U) || (brr > 0xFFFFFU)) {
+      return 0;
+    }
+    actual = ((uint64_t)clock * 256U) / brr;
+  } else {
+    uint32_t div = (huart->Init.OverSampling == UART_OVERSAMPLING_8)
+                       ? UART_DIV_SAMPLING8(clock, baud) : UART_DIV_SAMPLING16(clock, baud);
+    if ((div < 16U) || (div > 0xFFFFU)) {
+      return 0;
+    }
+    if (huart->Init.OverSampling == UART_OVERSAMPLING_8) {
+      brr = (div & 0xFFF0U) | ((div & 0x000FU) >> 1);
+      actual = (2ULL * clock) / div;
+    } else {
+      brr = div;
+      actual = clock / div;
+    }
+  }
+  uint64_t error = (actual > baud) ? (actual - baud) : (baud - actual);
+  return (error * 1000U <= (uint64_t)baud * UART_CONSOLE_BAUD_ERROR_PERMILLE) ? brr : 0U;
+}
+
+/**
+ * @brief Passes reception up to DMA position @p dma_pos to the console.
+ */
+static void UartConsoleReceived(UartConsole* port, uint16_t dma_pos) {
+  uint16_t start_pos = port->rx_last_pos;
+
+  // If the new DMA position is smaller than the previous one,
+  // the circular DMA buffer has wrapped around.
+  if (dma_pos < start_pos) {
+    // Copy data from the old (last) position up to the end of the DMA buffer.
+    ConsoleReceive(&port->console, &port->rx_dma_buf[start_pos],
+                   UART_CONSOLE_RX_DMA_SIZE - start_pos);
+    // After wrap, continue copying from the beginning of the DMA buffer.
+    start_pos = 0;
+  }
+
+  // Copy the newly received data between start_pos and the current DMA position.
+  ConsoleReceive(&port->console, &port->rx_dma_buf[start_pos], dma_pos - start_pos);
+
+  // Update previous position for the next callback.
+  port->rx_last_pos = dma_pos;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void UartConsoleInit(void) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    UartConsole* port = &uart_consoles[i];
+
+    port->huart = kPorts[i].huart;
+    port->tx_inflight = 0;
+    port->acquired = 0;
+    port->hooks = NULL;
+    RingBufferInit(&port->tx);
+    ConsoleInit(&port->console, kPorts[i].name, UartConsoleWrite, port);
+    port->console.writable = UartConsoleWritable;
+
+    // Reception never stops, and an idle line must wake the core
+    ClockGateAcquire(kPorts[i].clock, 1);
+    ClockGateAcquire(kClockGateDma1, 1);
+    UartConsoleStartRx(port);
+    ConsolePrint(&port->console, "Test Console Initialized. \r\n Type 'help'.\r\n");
+  }
+}
+
+void UartConsoleProcess(void) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    ConsoleProcess(&uart_consoles[i].console);
+  }
+}
+
+ReturnCode UartConsoleAcquire(const char* name, const UartConsoleHooks* hooks,
+                              UART_HandleTypeDef** huart) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    UartConsole* port = &uart_consoles[i];
+    if (strcmp(kPorts[i].name, name) != 0) {
+      continue;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t busy = (port->tx_inflight != 0) || port->acquired;
+    if (!busy) {
+      port->acquired = 1;  // Holds back UartConsoleKickTx()
+    }
+    __set_PRIMASK(primask);
+    if (busy) {
+      return kFull;
+    }
+
+    HAL_UART_AbortReceive(port->huart);
+    port->hooks = hooks;
+    *huart = port->huart;
+    return kOk;
+  }
+  return kInvalidArgument;
+}
+
+void UartConsoleRelease(UART_HandleTypeDef* huart) {
+  UartConsole* port = UartConsoleFind(huart);
+  if ((port == NULL) || !port->acquired) {
+    return;
+  }
+
+  port->acquired = 0;
+  port->hooks = NULL;
+  UartConsoleStartRx(port);
+  UartConsoleKickTx(port);
+}
+
+uint16_t UartConsoleBacklog(void) {
+  uint16_t backlog = 0;
+
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    uint16_t rx = 0;
+    uint16_t tx = 0;
+    RingBufferCurrentItems(&uart_consoles[i].console.rx, &rx);
+    RingBufferCurrentItems(&uart_consoles[i].tx, &tx);
+    if (rx + tx > backlog) {
+      backlog = (uint16_t)(rx + tx);
+    }
+  }
+  return backlog;
+}
+
+uint8_t UartConsoleHoldTx(uint8_t hold) {
+  tx_hold = hold;
+  if (!hold) {
+    for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+      UartConsoleKickTx(&uart_consoles[i]);
+    }
+    return 1;
+  }
+
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    UartConsole* port = &uart_consoles[i];
+    // A borrower transmits through the HAL directly
+    uint8_t sending = port->acquired ? (port->huart->gState != HAL_UART_STATE_READY)
+                                     : (port->tx_inflight != 0);
+    if (sending || !RegUsartQuiet(port->huart->Instance)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+uint8_t UartConsoleBaudReachable(uint32_t sysclk_hz) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    UART_HandleTypeDef* huart = uart_consoles[i].huart;
+    if (UartConsoleDivider(huart, UartConsoleKernelClock(huart, sysclk_hz)) == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void UartConsoleRetune(void) {
+  for (size_t i = 0; i < UART_CONSOLE_COUNT; ++i) {
+    UART_HandleTypeDef* huart = uart_consoles[i].huart;
+    USART_TypeDef* uart = huart->Instance;
+    uint32_t brr = UartConsoleDivider(huart, UartConsoleKernelClock(huart, 0));
+
+    if (brr == 0) {
+      continue;  // Checked by UartConsoleBaudReachable() before the change
+    }
+    // BRR is only writable with the UART disabled; that also ends mute mode
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t mute = REG_TEST(uart->ISR, USART_ISR, RWU);
+    REG_MODIFY(uart->CR1, USART_CR1, UE, 0);
+    uart->BRR = brr;
+    REG_MODIFY(uart->CR1, USART_CR1, UE, 1);
+    if (mute) {
+      uart->RQR = USART_RQR_MMRQ;
+    }
+    __set_PRIMASK(primask);
+  }
+}
+
+uint8_t UartConsoleIrq(UART_HandleTypeDef* huart) {
+  USART_TypeDef* usart = huart->Instance;
+
+  // Anything but a lone idle line, or a reception HAL must finish itself
+  if ((RegUsartPending(usart) != USART_ISR_IDLE) ||
+      (huart->ReceptionType != HAL_UART_RECEPTION_TOIDLE) ||
+      !REG_TEST(usart->CR3, USART_CR3, DMAR) ||
+      !REG_TEST(huart->hdmarx->Instance->CCR, DMA_CCR, CIRC)) {
+    return 0;
+  }
+  UartConsole* port = UartConsoleFind(huart);
+  if ((port == NULL) || port->acquired) {
+    return 0;
+  }
+
+  usart->ICR = USART_ICR_IDLECF;
+  uint16_t remaining = (uint16_t)REG_GET(huart->hdmarx->Instance->CNDTR, DMA_CNDTR, NDT);
+  // All received: the DMA complete callback reports it, as with HAL
+  if ((remaining > 0U) && (remaining < huart->RxXferSize)) {
+    huart->RxXferCount = remaining;
+    huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+    UartConsoleReceived(port, (uint16_t)(huart->RxXferSize - remaining));
+  }
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+// HAL callbacks
+// -----------------------------------------------------------------------------
+/**
+  * @brief  UART receive event callback.
+  * This function is called by HAL when data is received via DMA
+  * (half/full buffer or idle line).
+  * @param  huart UART handle.
+  * @param  dma_pos Current write position of the DMA in the buffer.
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t dma_pos)
+{
+  UartConsole* port = UartConsoleFind(huart);
+  if (port == NULL) {
+    return;
+  }
+
+  UartConsoleReceived(port, dma_pos);
+}
+
+/**
+  * @brief  UART TX complete callback: releases the transmitted block and
+  * starts the next one (forwarded to the borrower of an acquired port).
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  UartConsole* port = UartConsoleFind(huart);
+  if (port == NULL) {
+    return;
+  }
+
+  if (port->acquired) {
+    if ((port->hooks != NULL) && (port->hooks->tx_complete != NULL)) {
+      port->hooks->tx_complete(huart);
+    }
+    return;
+  }
+
+  RingBufferDiscard(&port->tx, port->tx_inflight);
+  port->tx_inflight = 0;
+  UartConsoleKickTx(port);
+}
+
+/**
+  * @brief  UART error callback: restarts reception if HAL aborted it
+  * (e.g. after an overrun) so the console does not go deaf, and drops a
+  * block whose TX DMA failed so output carries on with the next one
+  * (forwarded to the borrower of an acquired port).
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  UartConsole* port = UartConsoleFind(huart);
+  if (port == NULL) {
+    return;
+  }
+
+  if (port->acquired) {
+    if ((port->hooks != NULL) && (port->hooks->error != NULL)) {
+      port->hooks->error(huart);
+    }
+    return;
+  }
+
+  if (huart->RxState == HAL_UART_STATE_READY) {
+    UartConsoleStartRx(port);
+  }
+  // A TX DMA error ends the transfer without a TX complete callback
+  if ((port->tx_inflight != 0) && (huart->gState == HAL_UART_STATE_READY)) {
+    RingBufferDiscard(&port->tx, port->tx_inflight);
+    port->tx_inflight = 0;
+    UartConsoleKickTx(port);
+  }
+}
@@ -0,0 +1,361 @@
+// vm.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Stack bytecode interpreter for bring-up test scripts (see vm.h).
+
+#include "vm.h"
+#include "command.h"
+#include "crc.h"
+#include "main.h"  // For HAL_GetTick
+#include <stdio.h>
+#include <string.h>
+
+static struct {
+  uint8_t code[VM_CODE_SIZE];
+  uint16_t length;
+  int32_t stack[VM_STACK_DEPTH];
+  int32_t vars[VM_NUM_VARS];
+  uint8_t sp;
+  uint16_t pc;
+  VmState state;
+  Console* console;       ///< Output and command session of the run
+  uint32_t wait_start;
+  uint32_t wait_ms;
+  uint32_t steps;
+  const char* error;
+} vm;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Stops the run with an error reported on the script console.
+ */
+static void VmFail(uint16_t pc, const char* error) {
+  char buffer[48];
+
+  vm.error = error;
+  vm.state = kVmIdle;
+  snprintf(buffer, sizeof(buffer), "VM error at 0x%04X: %s\r\n", pc, error);
+  ConsolePrint(vm.console, buffer);
+}
+
+static uint8_t VmPush(int32_t value) {
+  if (vm.sp >= VM_STACK_DEPTH) {
+    return 0;
+  }
+  vm.stack[vm.sp++] = value;
+  return 1;
+}
+
+/**
+ * @brief Fetches operand bytes, checking they lie inside the program.
+ *
+ * On failure @p pc is moved past the end, so that VmStep() reports the
+ * instruction as truncated instead of running its operands as opcodes.
+ */
+static uint8_t VmFetch(uint16_t* pc, uint8_t* dst, uint16_t len) {
+  if ((uint32_t)*pc + len > vm.length) {
+    *pc = vm.length + 1;
+    return 0;
+  }
+  memcpy(dst, &vm.code[*pc], len);
+  *pc += len;
+  return 1;
+}
+
+/**
+ * @brief CALL: expands the command template with popped values and runs it.
+ *
+ * @return NULL on success, otherwise the error text.
+ */
+static const char* VmCall(const char* text, uint8_t text_len) {
+  char line[CONSOLE_LINE_SIZE];
+  uint8_t args = 0;
+  uint16_t out = 0;
+
+  for (uint8_t i = 0; i < text_len; ++i) {
+    args += (text[i] == '%') ? 1 : 0;
+  }
+  if (args > vm.sp) {
+    return "stack underflow";
+  }
+
+  // The deepest popped value fills the first '%'
+  uint8_t next = (uint8_t)(vm.sp - args);
+  for (uint8_t i = 0; i < text_len; ++i) {
+    int n;
+    if (text[i] == '%') {
+      n = snprintf(&line[out], sizeof(line) - out, "%ld", (long)vm.stack[next++]);
+    } else {
+      n = snprintf(&line[out], sizeof(line) - out, "%c", text[i]);
+    }
+    if ((n < 0) || ((uint16_t)n >= sizeof(line) - out)) {
+      return "command too long";
+    }
+    out += (uint16_t)n;
+  }
+  vm.sp -= args;
+
+  if (CommandParserProcess(vm.console, (const uint8_t*)line) != kOk) {
+    return "command failed";
+  }
+  return VmPush(vm.console->result) ? NULL : "stack overflow";
+}
+
+/**
+ * @brief Executes one instruction.
+ *
+ * @return Cost of the instruction, 0 if the run ended.
+ */
+static uint8_t VmStep(void) {
+  uint16_t pc = vm.pc;
+  uint16_t next = pc + 1;
+  uint8_t cost = 1;
+  int32_t a = 0;
+  int32_t b = 0;
+  uint8_t operand[4];
+
+  if (pc >= vm.length) {
+    VmFail(pc, "pc out of range");
+    return 0;
+  }
+  uint8_t op = vm.code[pc];
+  vm.steps++;
+
+  // Pop the operands of binary and unary operators up front
+  if (((op >= kVmAdd) && (op <= kVmGe) && (op != kVmNeg) && (op != kVmNot)) ||
+      (op == kVmSwap) || (op == kVmOver)) {
+    if (vm.sp < 2) {
+      VmFail(pc, "stack underflow");
+      return 0;
+    }
+    b = vm.stack[--vm.sp];
+    a = vm.stack[--vm.sp];
+  } else if ((op == kVmNeg) || (op == kVmNot) || (op == kVmDup) ||
+             (op == kVmDrop) || (op == kVmStore) || (op == kVmJz) ||
+             (op == kVmJnz) || (op == kVmWait) || (op == kVmPrint) ||
+             (op == kVmEmit)) {
+    if (vm.sp < 1) {
+      VmFail(pc, "stack underflow");
+      return 0;
+    }
+    a = vm.stack[--vm.sp];
+  }
+
+  uint8_t pushed = 1;  // Cleared when a push overflows
+  switch (op) {
+    case kVmHalt: {
+      char buffer[40];
+      vm.state = kVmIdle;
+      snprintf(buffer, sizeof(buffer), "VM done (%lu steps)\r\n", (unsigned long)vm.steps);
+      ConsolePrint(vm.console, buffer);
+      return 0;
+    }
+    case kVmPush8:
+      if (!VmFetch(&next, operand, 1)) break;
+      pushed = VmPush((int8_t)operand[0]);
+      break;
+    case kVmPush16:
+      if (!VmFetch(&next, operand, 2)) break;
+      pushed = VmPush((int16_t)(operand[0] | (operand[1] << 8)));
+      break;
+    case kVmPush32:
+      if (!VmFetch(&next, operand, 4)) break;
+      pushed = VmPush((int32_t)((uint32_t)operand[0] | ((uint32_t)operand[1] << 8) |
+                                ((uint32_t)operand[2] << 16) | ((uint32_t)operand[3] << 24)));
+      break;
+    case kVmDup:
+      pushed = VmPush(a) && VmPush(a);
+      break;
+    case kVmDrop:
+      break;
+    case kVmSwap:
+      pushed = VmPush(b) && VmPush(a);
+      break;
+    case kVmOver:
+      pushed = VmPush(a) && VmPush(b) && VmPush(a);
+      break;
+    case kVmLoad:
+    case kVmStore:
+      if (!VmFetch(&next, operand, 1)) break;
+      if (operand[0] >= VM_NUM_VARS) {
+        VmFail(pc, "bad variable");
+        return 0;
+      }
+      if (op == kVmLoad) {
+        pushed = VmPush(vm.vars[operand[0]]);
+      } else {
+        vm.vars[operand[0]] = a;
+      }
+      break;
+    case kVmAdd: pushed = VmPush((int32_t)((uint32_t)a + (uint32_t)b)); break;
+    case kVmSub: pushed = VmPush((int32_t)((uint32_t)a - (uint32_t)b)); break;
+    case kVmMul: pushed = VmPush((int32_t)((uint32_t)a * (uint32_t)b)); break;
+    case kVmDiv:
+    case kVmMod:
+      if ((b == 0) || ((a == INT32_MIN) && (b == -1))) {
+        VmFail(pc, "division error");
+        return 0;
+      }
+      pushed = VmPush((op == kVmDiv) ? (a / b) : (a % b));
+      break;
+    case kVmNeg: pushed = VmPush((int32_t)(0u - (uint32_t)a)); break;
+    case kVmAnd: pushed = VmPush(a & b); break;
+    case kVmOr:  pushed = VmPush(a | b); break;
+    case kVmXor: pushed = VmPush(a ^ b); break;
+    case kVmNot: pushed = VmPush(!a); break;
+    case kVmShl: pushed = VmPush((int32_t)((uint32_t)a << (b & 31))); break;
+    case kVmShr: pushed = VmPush((int32_t)((uint32_t)a >> (b & 31))); break;
+    case kVmEq: pushed = VmPush(a == b); break;
+    case kVmNe: pushed = VmPush(a != b); break;
+    case kVmLt: pushed = VmPush(a < b); break;
+    case kVmLe: pushed = VmPush(a <= b); break;
+    case kVmGt: pushed = VmPush(a > b); break;
+    case kVmGe: pushed = VmPush(a >= b); break;
+    case kVmJmp:
+    case kVmJz:
+    case kVmJnz: {
+      if (!VmFetch(&next, operand, 2)) break;
+      uint16_t target = (uint16_t)(operand[0] | (operand[1] << 8));
+      if (target >= vm.length) {
+        VmFail(pc, "bad jump");
+        return 0;
+      }
+      if ((op == kVmJmp) || ((op == kVmJz) && (a == 0)) || ((op == kVmJnz) && (a != 0))) {
+        next = target;
+      }
+      break;
+    }
+    case kVmWait:
+      vm.wait_start = HAL_GetTick();
+      vm.wait_ms = (a > 0) ? (uint32_t)a : 0;
+      vm.state = kVmWaiting;
+      break;
+    case kVmTicks:
+      pushed = VmPush((int32_t)HAL_GetTick());
+      break;
+    case kVmCall:
+    case kVmPrints: {
+      uint8_t text_len = 0;
+      if (!VmFetch(&next, &text_len, 1) || ((uint32_t)next + text_len > vm.length)) {
+        next = vm.length + 1;  // Reported as truncated below
+        break;
+      }
+      const char* text = (const char*)&vm.code[next];
+      next += text_len;
+      cost = VM_IO_COST;
+      if (op == kVmPrints) {
+        ConsoleWrite(vm.console, (const uint8_t*)text, text_len);
+        break;
+      }
+      vm.pc = next;  // The command may stop the script
+      const char* error = VmCall(text, text_len);
+      if (error != NULL) {
+        VmFail(pc, error);
+        return 0;
+      }
+      return (vm.state == kVmIdle) ? 0 : cost;
+    }
+    case kVmPrint: {
+      char buffer[16];
+      snprintf(buffer, sizeof(buffer), "%ld", (long)a);
+      ConsolePrint(vm.console, buffer);
+      cost = VM_IO_COST;
+      break;
+    }
+    case kVmEmit: {
+      uint8_t c = (uint8_t)a;
+      ConsoleWrite(vm.console, &c, 1);
+      cost = VM_IO_COST;
+      break;
+    }
+    default:
+      VmFail(pc, "bad opcode");
+      return 0;
+  }
+
+  if (next > vm.length) {
+    VmFail(pc, "truncated instruction");
+    return 0;
+  }
+  if (!pushed) {
+    VmFail(pc, "stack overflow");
+    return 0;
+  }
+  vm.pc = next;
+  return cost;
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode VmLoad(uint16_t offset, const uint8_t* data, uint16_t len) {
+  if (vm.state != kVmIdle) {
+    return kError;
+  }
+  if ((data == NULL) || ((uint32_t)offset + len > VM_CODE_SIZE)) {
+    return kInvalidArgument;
+  }
+
+  if (offset == 0) {
+    vm.length = 0;
+  }
+  memcpy(&vm.code[offset], data, len);
+  if (offset + len > vm.length) {
+    vm.length = offset + len;
+  }
+  vm.error = NULL;
+  return kOk;
+}
+
+ReturnCode VmRun(Console* console) {
+  if (vm.state != kVmIdle) {
+    return kError;
+  }
+  if (vm.length == 0) {
+    return kEmpty;
+  }
+
+  memset(vm.vars, 0, sizeof(vm.vars));
+  vm.sp = 0;
+  vm.pc = 0;
+  vm.steps = 0;
+  vm.error = NULL;
+  vm.console = console;
+  vm.state = kVmRunning;
+  return kOk;
+}
+
+void VmStop(void) {
+  vm.state = kVmIdle;
+}
+
+void VmProcess(void) {
+  if (vm.state == kVmWaiting) {
+    if ((HAL_GetTick() - vm.wait_start) < vm.wait_ms) {
+      return;
+    }
+    vm.state = kVmRunning;
+  }
+
+  uint16_t budget = VM_SLICE_BUDGET;
+  while (vm.state == kVmRunning) {
+    uint8_t cost = VmStep();
+    if ((cost == 0) || (cost >= budget)) {
+      return;
+    }
+    budget -= cost;
+  }
+}
+
+void VmGetStatus(VmStatus* status) {
+  status->state = vm.state;
+  status->length = vm.length;
+  status->crc = Crc16Ccitt(CRC16_CCITT_INIT, vm.code, vm.length);
+  status->pc = vm.pc;
+  status->sp = vm.sp;
+  status->steps = vm.steps;
+  status->error = vm.error;
+}
@@ -0,0 +1,255 @@
+// watch.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Periodic command sampling with change-only output (see watch.h).
+
+#include "watch.h"
+#include "command.h"
+#include "main.h"  // For HAL_GetTick
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+  Console* console;                   ///< Owner session, NULL if the slot is free
+  uint32_t period_ms;
+  uint32_t next_ms;                   ///< Tick of the next sample
+  uint32_t samples;
+  char command[CONSOLE_LINE_SIZE];
+  uint8_t sent[WATCH_OUTPUT_SIZE];    ///< Output as last sent
+  uint16_t sent_len;
+} Watch;
+
+static Watch watches[WATCH_MAX];
+
+// Commands that take over the session, or keep it and report to it after
+// they return: neither works on the capture session
+static const char* const kUnwatchable[] = {
+    "watch", "mux", "selftest", "linktest", "vm run", "dump", "profile dump", NULL,
+};
+
+// Output of the command being sampled
+static Console capture;
+static uint8_t capture_buf[WATCH_OUTPUT_SIZE];
+static uint16_t capture_len;
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+/**
+ * @brief Console output function of the capture session (truncates).
+ */
+static void CaptureWrite(Console* console, const uint8_t* data, uint16_t len) {
+  uint16_t room = sizeof(capture_buf) - capture_len;
+  if (len > room) {
+    len = room;
+  }
+  memcpy(&capture_buf[capture_len], data, len);
+  capture_len += len;
+}
+
+/**
+ * @brief Finds line @p index of a buffer (without its CR/LF).
+ *
+ * @return 1 if the line exists, 0 otherwise.
+ */
+static uint8_t GetLine(const uint8_t* buf, uint16_t len, uint16_t index,
+                       const uint8_t** line, uint16_t* line_len) {
+  uint16_t start = 0;
+
+  for (uint16_t i = 0; i <= len; ++i) {
+    if ((i < len) && (buf[i] != '\n')) {
+      continue;
+    }
+    if (index-- == 0) {
+      uint16_t end = i;
+      while ((end > start) && ((buf[end - 1] == '\r') || (buf[end - 1] == '\n'))) {
+        end--;
+      }
+      *line = &buf[start];
+      *line_len = end - start;
+      return (start < len) ? 1 : 0;
+    }
+    start = i + 1;
+  }
+  return 0;
+}
+
+static uint8_t LineChanged(const Watch* watch, uint16_t index, const uint8_t* line,
+                           uint16_t line_len) {
+  const uint8_t* old_line = NULL;
+  uint16_t old_len = 0;
+
+  if (!GetLine(watch->sent, watch->sent_len, index, &old_line, &old_len)) {
+    return 1;
+  }
+  return ((old_len != line_len) || (memcmp(old_line, line, line_len) != 0)) ? 1 : 0;
+}
+
+/**
+ * @brief Number of lines in a buffer.
+ */
+static uint16_t CountLines(const uint8_t* buf, uint16_t len) {
+  const uint8_t* line = NULL;
+  uint16_t line_len = 0;
+  uint16_t count = 0;
+
+  while (GetLine(buf, len, count, &line, &line_len)) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Returns 1 if @p command_line starts with one of kUnwatchable
+ * (whole words).
+ */
+static uint8_t IsUnwatchable(const char* command_line) {
+  for (const char* const* name = kUnwatchable; *name != NULL; ++name) {
+    size_t len = strlen(*name);
+    if ((strncmp(command_line, *name, len) == 0) &&
+        ((command_line[len] == '\0') || (command_line[len] == ' '))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Sends the lines of the captured output that changed, and a
+ * marker for each line the output no longer has.
+ *
+ * @return 1 if the changes were sent (or there were none), 0 if the link
+ *     had no room for them.
+ */
+static uint8_t WatchEmit(Watch* watch, uint32_t now) {
+  char stamp[16];
+  const uint8_t* line = NULL;
+  uint16_t line_len = 0;
+  uint16_t needed = 0;
+  uint16_t lines = 0;
+  uint16_t old_lines = CountLines(watch->sent, watch->sent_len);
+  int stamp_len = snprintf(stamp, sizeof(stamp), "[%lu] ", (unsigned long)now);
+
+  for (; GetLine(capture_buf, capture_len, lines, &line, &line_len); ++lines) {
+    if (LineChanged(watch, lines, line, line_len)) {
+      needed += (uint16_t)stamp_len + line_len + 2;
+    }
+  }
+  if (old_lines > lines) {
+    needed += (uint16_t)((old_lines - lines) * (stamp_len + sizeof(WATCH_REMOVED_MARK) + 5));
+  }
+  if (needed == 0) {
+    return 1;
+  }
+  if (watch->console->detached || (ConsoleWritable(watch->console) < needed)) {
+    return 0;
+  }
+
+  for (uint16_t i = 0; GetLine(capture_buf, capture_len, i, &line, &line_len); ++i) {
+    if (LineChanged(watch, i, line, line_len)) {
+      ConsolePrint(watch->console, stamp);
+      ConsoleWrite(watch->console, line, line_len);
+      ConsolePrint(watch->console, "\r\n");
+    }
+  }
+  for (uint16_t i = lines; i < old_lines; ++i) {
+    char marker[24];
+    snprintf(marker, sizeof(marker), WATCH_REMOVED_MARK " %u\r\n", i + 1U);
+    ConsolePrint(watch->console, stamp);
+    ConsolePrint(watch->console, marker);
+  }
+  return 1;
+}
+
+static void WatchSample(Watch* watch, uint32_t now) {
+  capture_len = 0;
+  CommandParserProcess(&capture, (const uint8_t*)watch->command);
+  watch->samples++;
+
+  if (WatchEmit(watch, now)) {
+    memcpy(watch->sent, capture_buf, capture_len);
+    watch->sent_len = capture_len;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+ReturnCode WatchStart(Console* console, uint32_t period_ms, const char* command_line) {
+  size_t len = strlen(command_line);
+
+  if ((period_ms == 0) || (len == 0) || (len >= CONSOLE_LINE_SIZE) ||
+      IsUnwatchable(command_line)) {
+    return kInvalidArgument;
+  }
+
+  for (uint8_t i = 0; i < WATCH_MAX; ++i) {
+    Watch* watch = &watches[i];
+    if (watch->console == NULL) {
+      memcpy(watch->command, command_line, len + 1);
+      watch->period_ms = period_ms;
+      watch->next_ms = HAL_GetTick();
+      watch->samples = 0;
+      watch->sent_len = 0;
+      watch->console = console;
+      if (capture.write == NULL) {
+        ConsoleInit(&capture, "watch", CaptureWrite, NULL);
+      }
+      return kOk;
+    }
+  }
+  return kFull;
+}
+
+uint8_t WatchStop(const Console* console) {
+  uint8_t stopped = 0;
+
+  for (uint8_t i = 0; i < WATCH_MAX; ++i) {
+    if (watches[i].console == console) {
+      watches[i].console = NULL;
+      stopped++;
+    }
+  }
+  return stopped;
+}
+
+void WatchReport(Console* console) {
+  char buffer[48];
+  uint8_t active = 0;
+
+  for (uint8_t i = 0; i < WATCH_MAX; ++i) {
+    const Watch* watch = &watches[i];
+    if (watch->console != NULL) {
+      snprintf(buffer, sizeof(buffer), "%s: every %lu ms, %lu samples: ",
+               watch->console->name, (unsigned long)watch->period_ms,
+               (unsigned long)watch->samples);
+      ConsolePrint(console, buffer);
+      ConsolePrint(console, watch->command);
+      ConsolePrint(console, "\r\n");
+      active++;
+    }
+  }
+  if (active == 0) {
+    ConsolePrint(console, "No active watch.\r\n");
+  }
+}
+
+void WatchProcess(void) {
+  for (uint8_t i = 0; i < WATCH_MAX; ++i) {
+    Watch* watch = &watches[i];
+    uint32_t now = HAL_GetTick();
+
+    if ((watch->console == NULL) || ((int32_t)(now - watch->next_ms) < 0)) {
+      continue;
+    }
+
+    WatchSample(watch, now);
+
+    // Keep the sampling grid, unless the loop fell a whole period behind
+    watch->next_ms += watch->period_ms;
+    if ((int32_t)(now - watch->next_ms) >= 0) {
+      watch->next_ms = now + watch->period_ms;
+    }
+  }
+}
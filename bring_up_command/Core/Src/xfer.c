@@ -0,0 +1,440 @@
+// xfer.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Windowed bulk transfer into scratch RAM or flash with selective
+// acknowledgements (see xfer.h).
+
+#include "xfer.h"
+#include "crc.h"
+#include "main.h"
+#include "module.h"
+#include "mux.h"
+#include <stdio.h>
+#include <string.h>
+
+#define XFER_HALF_PAGE  64U
+#define XFER_CHUNK_HEADER 5U  // message + seq + crc
+
+extern uint32_t _sidata;  // Linker script: load address of .data
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+typedef enum {
+  kXferIdle = 0,
+  kXferErasing,
+  kXferReceiving,
+  kXferClosing,   ///< Everything received, flash being finished
+  kXferDone,
+  kXferFailed,
+} XferState;
+
+static const char* const kStateNames[] = {"idle", "erasing", "receiving", "closing", "done",
+                                          "failed"};
+
+/**
+ * @brief A flash half page being assembled from chunks.
+ */
+typedef struct {
+  uint32_t address;                      ///< 0 when the buffer is free
+  uint32_t data[XFER_HALF_PAGE / 4U];    ///< Word aligned for the programming
+  uint8_t filled;                        ///< Bytes received
+  uint8_t expected;                      ///< Bytes of the blob in this half page
+} XferHalfPage;
+
+static struct {
+  XferState state;
+  uint8_t target;
+  uint8_t claimed;          ///< Holds the module area (RAM target)
+  uint8_t chunk_size;
+  uint32_t address;         ///< Absolute start
+  uint32_t length;
+  uint16_t chunks;
+  uint16_t next;            ///< First chunk not received
+  uint32_t bitmap;          ///< Bit i: chunk next + 1 + i received
+  uint32_t erase_at;        ///< Next page to erase
+  uint16_t blob_crc;        ///< From CLOSE
+  // Pending acknowledgement
+  uint8_t ack_message;      ///< 0 if none
+  ReturnCode ack_rc;
+  // Statistics
+  uint32_t received;
+  uint32_t duplicates;
+  uint32_t crc_errors;
+  uint32_t dropped;         ///< Out of window or no flash buffer
+  uint32_t start_ms;
+  uint32_t end_ms;
+  XferHalfPage pages[XFER_FLASH_BUFFERS];
+} xfer;
+
+static MuxReceiveFn next_receiver;  ///< Earlier user of the data channel
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+static uint16_t ReadLe16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t ReadLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void XferAck(uint8_t message, ReturnCode rc) {
+  xfer.ack_message = message;
+  xfer.ack_rc = rc;
+}
+
+static void XferSendAck(void) {
+  uint32_t value = (xfer.ack_message == XFER_MSG_OPEN) ? xfer.address : xfer.bitmap;
+  uint8_t ack[9] = {XFER_MSG_ACK, xfer.ack_message, (uint8_t)xfer.ack_rc,
+                    (uint8_t)(xfer.next & 0xFF), (uint8_t)(xfer.next >> 8),
+                    (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16),
+                    (uint8_t)(value >> 24)};
+
+  if (MuxWrite(MUX_CH_DATA, ack, sizeof(ack)) == kOk) {
+    xfer.ack_message = 0;  // Otherwise the next pass sends the newer state
+  }
+}
+
+static uint32_t XferFlashStart(void) {
+  uint32_t image_end = (uint32_t)(uintptr_t)&_sidata +
+                       ((uint32_t)(uintptr_t)&_edata - (uint32_t)(uintptr_t)&_sdata);
+  return (image_end + FLASH_PAGE_SIZE - 1U) & ~(FLASH_PAGE_SIZE - 1U);
+}
+
+static uint8_t XferPagesBusy(void) {
+  for (int i = 0; i < XFER_FLASH_BUFFERS; ++i) {
+    if (xfer.pages[i].address != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static XferHalfPage* XferFindPage(uint32_t half_page) {
+  for (int i = 0; i < XFER_FLASH_BUFFERS; ++i) {
+    if (xfer.pages[i].address == half_page) {
+      return &xfer.pages[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Copies a chunk into its half-page buffers, allocating them; takes
+ * nothing unless every buffer the chunk needs is available.
+ *
+ * Only the XFER_FLASH_BUFFERS half pages from the first missing chunk on
+ * are buffered. Half pages below it are complete, so that chunk always
+ * finds its buffers once those are programmed; chunks further ahead
+ * could otherwise hold every buffer with half pages that never fill.
+ */
+static ReturnCode XferStoreFlash(uint32_t address, const uint8_t* data, uint16_t len) {
+  uint32_t first = address & ~(XFER_HALF_PAGE - 1U);
+  uint32_t last = (address + len - 1U) & ~(XFER_HALF_PAGE - 1U);
+  uint32_t base = (xfer.address + (uint32_t)xfer.next * xfer.chunk_size) & ~(XFER_HALF_PAGE - 1U);
+  int needed = 0;
+  int free_count = 0;
+
+  if (last - base >= XFER_FLASH_BUFFERS * XFER_HALF_PAGE) {
+    return kFull;
+  }
+  for (uint32_t hp = first; hp <= last; hp += XFER_HALF_PAGE) {
+    needed += (XferFindPage(hp) == NULL) ? 1 : 0;
+  }
+  for (int i = 0; i < XFER_FLASH_BUFFERS; ++i) {
+    free_count += (xfer.pages[i].address == 0) ? 1 : 0;
+  }
+  if (needed > free_count) {
+    return kFull;
+  }
+
+  uint32_t blob_end = xfer.address + xfer.length;
+  for (uint32_t hp = first; hp <= last; hp += XFER_HALF_PAGE) {
+    XferHalfPage* page = XferFindPage(hp);
+    if (page == NULL) {
+      page = XferFindPage(0);
+      uint32_t from = (hp > xfer.address) ? hp : xfer.address;
+      uint32_t to = (hp + XFER_HALF_PAGE < blob_end) ? hp + XFER_HALF_PAGE : blob_end;
+      page->address = hp;
+      page->filled = 0;
+      page->expected = (uint8_t)(to - from);
+      memset(page->data, 0xFF, sizeof(page->data));
+    }
+    uint32_t from = (address > hp) ? address : hp;
+    uint32_t to = (address + len < hp + XFER_HALF_PAGE) ? address + len : hp + XFER_HALF_PAGE;
+    memcpy((uint8_t*)page->data + (from - hp), &data[from - address], to - from);
+    page->filled += (uint8_t)(to - from);
+  }
+  return kOk;
+}
+
+/**
+ * @brief Records chunk @p seq as received and slides the window.
+ */
+static void XferMark(uint16_t seq) {
+  if (seq != xfer.next) {
+    xfer.bitmap |= 1UL << (seq - xfer.next - 1U);
+    return;
+  }
+  ++xfer.next;
+  while (xfer.bitmap & 1U) {  // Bit 0 now stands for the new xfer.next
+    xfer.bitmap >>= 1;
+    ++xfer.next;
+  }
+  xfer.bitmap >>= 1;
+}
+
+/**
+ * @brief Gives back the module area held by a RAM transfer.
+ */
+static void XferRelease(void) {
+  if (xfer.claimed) {
+    ModuleAreaRelease();
+    xfer.claimed = 0;
+  }
+}
+
+static void XferOpen(const uint8_t* payload, uint16_t len) {
+  if (len < 11) {
+    XferAck(XFER_MSG_OPEN, kInvalidArgument);
+    return;
+  }
+  uint8_t target = payload[1];
+  uint32_t address = ReadLe32(&payload[2]);
+  uint32_t length = ReadLe32(&payload[6]);
+  uint8_t chunk_size = payload[10];
+
+  memset(xfer.pages, 0, sizeof(xfer.pages));  // A new OPEN abandons any transfer
+  XferRelease();
+  xfer.state = kXferFailed;
+  xfer.next = 0;
+  xfer.bitmap = 0;
+  xfer.received = xfer.duplicates = xfer.crc_errors = xfer.dropped = 0;
+  if ((chunk_size == 0) || (chunk_size > XFER_MAX_CHUNK) || (length == 0) ||
+      ((length + chunk_size - 1U) / chunk_size > UINT16_MAX)) {
+    XferAck(XFER_MSG_OPEN, kInvalidArgument);
+    return;
+  }
+
+  if (target == XFER_TARGET_RAM) {
+    uint16_t size = 0;
+    uint8_t* area = ModuleAreaClaim(&size);
+    if (area == NULL) {
+      XferAck(XFER_MSG_OPEN, kFull);
+      return;
+    }
+    if ((address > size) || (length > size - address)) {
+      ModuleAreaRelease();
+      XferAck(XFER_MSG_OPEN, kFull);
+      return;
+    }
+    xfer.claimed = 1;
+    address += (uint32_t)(uintptr_t)area;
+  } else if (target == XFER_TARGET_FLASH) {
+    if ((address < XferFlashStart()) || (address > FLASH_END) ||
+        (length - 1U > FLASH_END - address) || (address & (FLASH_PAGE_SIZE - 1U))) {
+      XferAck(XFER_MSG_OPEN, kInvalidArgument);
+      return;
+    }
+  } else {
+    XferAck(XFER_MSG_OPEN, kInvalidArgument);
+    return;
+  }
+
+  xfer.target = target;
+  xfer.address = address;
+  xfer.length = length;
+  xfer.chunk_size = chunk_size;
+  xfer.chunks = (uint16_t)((length + chunk_size - 1U) / chunk_size);
+  xfer.erase_at = address;
+  xfer.start_ms = HAL_GetTick();
+  xfer.state = (target == XFER_TARGET_FLASH) ? kXferErasing : kXferReceiving;
+  if (xfer.state == kXferReceiving) {
+    XferAck(XFER_MSG_OPEN, kOk);
+  }
+}
+
+static void XferChunk(const uint8_t* payload, uint16_t len) {
+  if (xfer.state != kXferReceiving) {
+    XferAck(XFER_MSG_CHUNK, kError);
+    return;
+  }
+  XferAck(XFER_MSG_CHUNK, kOk);  // Whatever happens, report the window
+  if (len < XFER_CHUNK_HEADER) {
+    return;
+  }
+  uint16_t seq = ReadLe16(&payload[1]);
+  const uint8_t* data = &payload[XFER_CHUNK_HEADER];
+  uint16_t n = len - XFER_CHUNK_HEADER;
+  uint32_t offset = (uint32_t)seq * xfer.chunk_size;
+
+  if ((seq >= xfer.chunks) ||
+      (n != ((seq == xfer.chunks - 1U) ? xfer.length - offset : xfer.chunk_size)) ||
+      (Crc16Ccitt(CRC16_CCITT_INIT, data, n) != ReadLe16(&payload[3]))) {
+    ++xfer.crc_errors;
+    return;
+  }
+  if ((seq >= xfer.next) && (seq - xfer.next > XFER_MAX_WINDOW)) {
+    ++xfer.dropped;
+    return;
+  }
+  if ((seq < xfer.next) ||
+      ((seq > xfer.next) && (xfer.bitmap & (1UL << (seq - xfer.next - 1U))))) {
+    ++xfer.duplicates;  // Its ack got lost
+    return;
+  }
+
+  if (xfer.target == XFER_TARGET_RAM) {
+    memcpy((uint8_t*)(uintptr_t)(xfer.address + offset), data, n);
+  } else if (XferStoreFlash(xfer.address + offset, data, n) != kOk) {
+    ++xfer.dropped;  // Programming is behind; the host resends it
+    return;
+  }
+  ++xfer.received;
+  XferMark(seq);
+}
+
+static void XferClose(const uint8_t* payload, uint16_t len) {
+  if (xfer.state == kXferDone) {
+    XferAck(XFER_MSG_CLOSE, kOk);  // The first ack was lost
+    return;
+  }
+  if ((len < 3) || ((xfer.state != kXferReceiving) && (xfer.state != kXferClosing))) {
+    XferAck(XFER_MSG_CLOSE, kError);
+    return;
+  }
+  if (xfer.next != xfer.chunks) {
+    XferAck(XFER_MSG_CLOSE, kEmpty);  // Chunks missing: see the bitmap
+    return;
+  }
+  xfer.blob_crc = ReadLe16(&payload[1]);
+  xfer.state = kXferClosing;  // Acknowledged once the flash is written and checked
+}
+
+/**
+ * @brief Handles the transfer messages and passes on the others.
+ */
+static void XferReceive(const uint8_t* payload, uint16_t len) {
+  uint8_t message = (len > 0) ? payload[0] : 0;
+
+  if (message == XFER_MSG_OPEN) {
+    XferOpen(payload, len);
+  } else if (message == XFER_MSG_CHUNK) {
+    XferChunk(payload, len);
+  } else if (message == XFER_MSG_CLOSE) {
+    XferClose(payload, len);
+  } else if (next_receiver != NULL) {
+    next_receiver(payload, len);
+  }
+}
+
+static void XferErasePage(void) {
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t page_error = 0;
+  const uint32_t* word = (const uint32_t*)(uintptr_t)xfer.erase_at;
+  uint8_t blank = 1;
+
+  for (uint32_t i = 0; i < FLASH_PAGE_SIZE / 4U; ++i) {
+    blank &= (word[i] == 0xFFFFFFFFUL) ? 1U : 0U;
+  }
+  if (!blank) {
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = xfer.erase_at;
+    erase.NbPages = 1;
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    if (status != HAL_OK) {
+      xfer.state = kXferFailed;
+      XferAck(XFER_MSG_OPEN, kError);
+      return;
+    }
+  }
+  xfer.erase_at += FLASH_PAGE_SIZE;
+  if (xfer.erase_at - xfer.address >= xfer.length) {
+    xfer.state = kXferReceiving;
+    XferAck(XFER_MSG_OPEN, kOk);
+  }
+}
+
+/**
+ * @brief Programs one completed half page, if any.
+ */
+static void XferProgramPage(void) {
+  for (int i = 0; i < XFER_FLASH_BUFFERS; ++i) {
+    XferHalfPage* page = &xfer.pages[i];
+    if ((page->address == 0) || (page->filled != page->expected)) {
+      continue;
+    }
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_HalfPageProgram(page->address, page->data);
+    HAL_FLASH_Lock();
+    page->address = 0;
+    if (status != HAL_OK) {
+      xfer.state = kXferFailed;
+      memset(xfer.pages, 0, sizeof(xfer.pages));
+    }
+    return;
+  }
+}
+
+static void XferFinish(void) {
+  uint16_t crc = CRC16_CCITT_INIT;
+  const uint8_t* data = (const uint8_t*)(uintptr_t)xfer.address;
+
+  for (uint32_t done = 0; done < xfer.length;) {
+    uint16_t n = (xfer.length - done > 0x8000U) ? 0x8000U : (uint16_t)(xfer.length - done);
+    crc = Crc16Ccitt(crc, &data[done], n);
+    done += n;
+  }
+  xfer.end_ms = HAL_GetTick();
+  xfer.state = (crc == xfer.blob_crc) ? kXferDone : kXferFailed;
+  XferRelease();
+  XferAck(XFER_MSG_CLOSE, (crc == xfer.blob_crc) ? kOk : kInvalidArgument);
+}
+
+// -----------------------------------------------------------------------------
+// Public function implementation
+// -----------------------------------------------------------------------------
+void XferInit(void) {
+  memset(&xfer, 0, sizeof(xfer));
+  next_receiver = MuxGetReceiver(MUX_CH_DATA);
+  MuxSetReceiver(MUX_CH_DATA, XferReceive);
+}
+
+void XferReport(Console* console) {
+  char buffer[112];
+
+  if (xfer.chunks == 0) {
+    ConsolePrint(console, "No transfer.\r\n");
+    return;
+  }
+  uint32_t elapsed = ((xfer.state == kXferDone) ? xfer.end_ms : HAL_GetTick()) - xfer.start_ms;
+  snprintf(buffer, sizeof(buffer), "xfer %s 0x%08lX %lu B: %u/%u chunks, %s, %lu ms (%lu B/s)\r\n",
+           (xfer.target == XFER_TARGET_FLASH) ? "flash" : "ram", (unsigned long)xfer.address,
+           (unsigned long)xfer.length, xfer.next, xfer.chunks, kStateNames[xfer.state],
+           (unsigned long)elapsed,
+           (unsigned long)(elapsed ? (uint64_t)xfer.chunk_size * xfer.received * 1000U / elapsed
+                                   : 0U));
+  ConsolePrint(console, buffer);
+  snprintf(buffer, sizeof(buffer), "%lu received, %lu duplicates, %lu bad, %lu dropped\r\n",
+           (unsigned long)xfer.received, (unsigned long)xfer.duplicates,
+           (unsigned long)xfer.crc_errors, (unsigned long)xfer.dropped);
+  ConsolePrint(console, buffer);
+}
+
+void XferProcess(void) {
+  if (xfer.state == kXferErasing) {
+    XferErasePage();
+  } else if ((xfer.state == kXferReceiving) || (xfer.state == kXferClosing)) {
+    XferProgramPage();
+    if ((xfer.state == kXferClosing) && !XferPagesBusy()) {
+      XferFinish();
+    }
+  }
+  if ((xfer.ack_message != 0) && MuxIsActive()) {
+    XferSendAck();
+  }
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""Compares two core_bench JSON reports (see tools/core_bench.c).
+
+    bench_compare.py before.json after.json [--threshold 5] [--noise 3]
+
+A case counts as changed when its median moved by more than --threshold
+percent and by more than --noise times the larger median absolute
+deviation of the two runs, so that a noisy case does not flag on jitter
+alone. Exits with 1 if any case got slower.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return {case["name"]: case for case in report["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent")
+    parser.add_argument("--noise", type=float, default=3.0, help="multiples of the MAD")
+    args = parser.parse_args()
+
+    before, after = load(args.before), load(args.after)
+    slower = 0
+    print(f"{'case':28} {'before ns':>10} {'after ns':>10} {'change':>8}")
+    for name, new in after.items():
+        old = before.get(name)
+        if old is None:
+            print(f"{name:28} {'':>10} {new['ns_per_op']['median']:10.2f}      new")
+            continue
+        a, b = old["ns_per_op"], new["ns_per_op"]
+        delta = b["median"] - a["median"]
+        percent = 100.0 * delta / a["median"] if a["median"] else 0.0
+        noise = args.noise * max(a["mad"], b["mad"])
+        verdict = ""
+        if abs(percent) > args.threshold and abs(delta) > noise:
+            verdict = "slower" if delta > 0 else "faster"
+            slower += delta > 0
+        print(f"{name:28} {a['median']:10.2f} {b['median']:10.2f} {percent:+7.1f}% {verdict}")
+    for name in before.keys() - after.keys():
+        print(f"{name:28} {before[name]['ns_per_op']['median']:10.2f} {'':>10}  removed")
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Calls typed board commands in binary form on the mux data channel
+(see Core/Inc/command.h and Core/Inc/command_args.h).
+
+    cmdcall.py /dev/ttyACM0 peek u32:0x20000000 u16:4 e:2
+    cmdcall.py /dev/ttyACM0 poke u32:0x20004000 u32:0xCAFE -- peek u32:0x20004000 u16:1
+
+Arguments are given as type:value, packed in order:
+
+    u8 u16 u32 i32 i64   number (any base Python accepts)
+    e                    enum index, in the order the usage lists the names;
+                         a keyword argument is 0 when absent, else 1 + index
+    s                    string, also for the rest-of-line argument
+
+Several calls are separated by `--`. Each call prints its return code,
+its result and the text the command wrote on the mux console. A call
+without an answer is resent with the same sequence number: the board
+answers it again without running it twice.
+"""
+
+import argparse
+import os
+import random
+import select
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from modlink import CH_CONSOLE, CH_DATA, MuxLink  # noqa: E402
+from vchan_demux import (BAUD_RATES, CH_CONTROL, CTRL_EXIT, decode_frame,  # noqa: E402
+                         open_serial, switch_to_mux)
+
+MSG_CALL, MSG_REPLY = 0x40, 0x41
+RETURN_CODES = ["ok", "full", "empty", "invalid argument", "error"]
+PACKERS = {"u8": "<B", "u16": "<H", "u32": "<I", "i32": "<i", "i64": "<q", "e": "<B"}
+
+
+def pack_argument(text):
+    kind, sep, value = text.partition(":")
+    if not sep:
+        raise ValueError(f"{text}: expected type:value")
+    if kind == "s":
+        return value.encode() + b"\x00"
+    if kind not in PACKERS:
+        raise ValueError(f"{text}: unknown type {kind}")
+    return struct.pack(PACKERS[kind], int(value, 0))
+
+
+def encode_call(seq, name, arguments):
+    return bytes([MSG_CALL, seq]) + name.encode() + b"\x00" + b"".join(map(pack_argument, arguments))
+
+
+def receive_frame(link, timeout):
+    """Next frame on any channel as (channel, payload), or None."""
+    deadline = time.monotonic() + timeout
+    while True:
+        while b"\x00" in link.pending:
+            encoded, _, rest = link.pending.partition(b"\x00")
+            link.pending = bytearray(rest)
+            frame = decode_frame(bytes(encoded)) if encoded else None
+            if frame:
+                return frame
+        remaining = deadline - time.monotonic()
+        ready, _, _ = select.select([link.fd], [], [], max(remaining, 0))
+        if not ready:
+            return None
+        link.pending += os.read(link.fd, 4096)
+
+
+def call(link, seq, name, arguments, retries, timeout):
+    """Returns (rc, result, console text)."""
+    message = encode_call(seq, name, arguments)
+    text = bytearray()
+    for _ in range(retries + 1):
+        link.send(CH_DATA, message)
+        while True:
+            frame = receive_frame(link, timeout)
+            if frame is None:
+                break  # Resend
+            channel, payload = frame
+            if channel == CH_CONSOLE:
+                text += payload
+            elif channel == CH_DATA and len(payload) == 7 and payload[:2] == bytes([MSG_REPLY, seq]):
+                rc, result = struct.unpack_from("<BI", payload, 2)
+                # Output queued before the reply is already here; take what trails it
+                while (frame := receive_frame(link, 0.05)) is not None:
+                    if frame[0] == CH_CONSOLE:
+                        text += frame[1]
+                return rc, result, text.decode(errors="replace")
+    raise RuntimeError(f"{name}: device did not answer")
+
+
+def split_calls(words):
+    calls, current = [], []
+    for word in words:
+        if word == "--":
+            calls.append(current)
+            current = []
+        else:
+            current.append(word)
+    calls.append(current)
+    return [c for c in calls if c]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("call", nargs=argparse.REMAINDER, help="name type:value ... [-- ...]")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--retries", type=int, default=2)
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds per attempt")
+    args = parser.parse_args()
+    calls = split_calls(args.call)
+    if not calls:
+        parser.error("no command given")
+    try:
+        for words in calls:
+            encode_call(0, words[0], words[1:])
+    except ValueError as error:
+        parser.error(str(error))
+
+    fd = open_serial(args.port, args.baud)
+    link = MuxLink(fd)
+    switch_to_mux(fd)
+    seq = random.randrange(256)  # Not the last one of an earlier session
+    status = 0
+    try:
+        for words in calls:
+            seq = (seq + 1) & 0xFF
+            rc, result, text = call(link, seq, words[0], words[1:], args.retries, args.timeout)
+            name = RETURN_CODES[rc] if rc < len(RETURN_CODES) else str(rc)
+            if rc == 0:
+                print(f"{words[0]}: ok, result {result} (0x{result:08X})")
+            elif rc == 3 and result < len(words) - 1:
+                print(f"{words[0]}: {name} ({words[1 + result]})")
+            else:
+                print(f"{words[0]}: {name}")
+            sys.stdout.write(text)
+            status |= rc != 0
+    except RuntimeError as error:
+        print(error, file=sys.stderr)
+        return 1
+    finally:
+        link.send(CH_CONTROL, bytes([CTRL_EXIT]))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
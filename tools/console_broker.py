@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""Shares one board's console among many host clients.
+
+    console_broker.py /dev/ttyACM0 --socket /tmp/board0.sock [--pty 2] [--ttl 0.5]
+
+The broker owns the serial port, switches it to mux mode and runs every
+client request on the board as a COMMAND_MSG_LINE (see Core/Inc/command.h):
+the board answers each with a REPLY tagged with the request's sequence
+number once the command has run, so the output collected from the mux
+console channel in between belongs to that request alone. One request is
+on the board at a time; the others queue in arrival order.
+
+Clients connect to the Unix socket and send one request per line:
+
+    {"seq": 7, "cmd": "peek 0x20000000 4"}
+    -> {"seq": 7, "rc": "ok", "result": 0, "text": "...", "source": "device"}
+
+"seq" is the client's own tag, returned as given. "rc" is the board's
+return code, or "timeout" / "refused" (then with "error"). "source" is
+"device", "coalesced" (answered by an identical request already queued)
+or "cache". {"seq": 1, "cmd": "@stats"} returns the broker counters, and
+{"subscribe": ["console", "log", "trace"]} asks for unsolicited output
+(`watch`, asynchronous `selftest` results, log and trace records) as
+{"event": "log", "text": "..."} lines. A line that does not start with
+"{" is a plain command line and is answered with the plain output, so
+
+    socat READLINE UNIX-CONNECT:/tmp/board0.sock
+
+is an interactive console. Each --pty is a terminal speaking the same
+plain form (screen, minicom), which also shows unsolicited console output.
+
+Read-only queries (READ_ONLY below) are shared: an identical one already
+queued or running answers every client that asks before it completes, and
+its result is served from a cache for --ttl seconds. Any other command
+empties the cache, and read-only requests that arrive after it no longer
+join those queued before it, so a client always sees the effect of its
+own earlier commands. Memory reads are only shared outside the peripheral
+space, where a read may have side effects.
+
+Unsolicited console output that arrives while a request runs is taken as
+part of that request's output; the data channel is only used for the
+replies, so streams (`dump`, `profile dump`) need the port to themselves.
+"""
+
+import argparse
+import collections
+import json
+import os
+import random
+import select
+import signal
+import socket
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from vchan_demux import (BAUD_RATES, CH_CONTROL, CTRL_EXIT, MAX_PAYLOAD,  # noqa: E402
+                         decode_frame, encode_frame, open_serial, switch_to_mux)
+
+CH_CONSOLE, CH_LOG, CH_TRACE, CH_DATA = 0, 1, 2, 3
+EVENTS = {CH_CONSOLE: "console", CH_LOG: "log", CH_TRACE: "trace"}
+MSG_REPLY, MSG_LINE = 0x41, 0x42
+MAX_LINE = MAX_PAYLOAD - 3  # Message, seq and the terminating 0
+RETURN_CODES = ["ok", "full", "empty", "invalid argument", "error"]
+PERIPHERALS = (0x40000000, 0x60000000)
+REFUSED = {"mux": "the broker owns mux mode"}
+
+
+def no_arguments(words):
+    return len(words) == 1
+
+
+def peek_memory(words):
+    try:
+        address = int(words[1], 0)
+    except (IndexError, ValueError):
+        return False
+    return not PERIPHERALS[0] <= address < PERIPHERALS[1]
+
+
+READ_ONLY = {
+    "version": lambda words: True,
+    "help": lambda words: True,
+    "xfer": lambda words: True,
+    "clocks": no_arguments,
+    "stall": no_arguments,
+    "gov": no_arguments,
+    "rs485": no_arguments,
+    "module": lambda words: words[1:] in ([], ["list"]),
+    "perf": lambda words: words[1:] in ([], ["total"], ["count"], ["max"], ["bytes"]),
+    "profile": lambda words: words[1:] in ([], ["show"]),
+    "gpio": lambda words: len(words) == 2,
+    "peek": peek_memory,
+}
+
+
+class Client:
+    def __init__(self, fd, name, plain, close):
+        self.fd = fd
+        self.name = name
+        self.plain = plain          # PTY: plain lines only
+        self.close = close
+        self.buffer = bytearray()
+        self.events = {"console"} if plain else set()
+
+    def send(self, data):
+        try:
+            os.write(self.fd, data)
+        except OSError:
+            pass  # Gone, or a PTY nobody has open; dropped at the next read
+
+    def answer(self, tag, plain, response):
+        if plain:
+            text = response.get("text", "")
+            if response["rc"] != "ok":
+                text += f"[{response['rc']}{': ' + response['error'] if 'error' in response else ''}]\r\n"
+            self.send(text.encode())
+        else:
+            self.send((json.dumps(dict(response, seq=tag)) + "\n").encode())
+
+
+class Request:
+    def __init__(self, line, read_only, generation):
+        self.line = line
+        self.read_only = read_only
+        self.generation = generation
+        self.waiters = []           # (client, client tag, plain)
+        self.text = bytearray()
+        self.seq = None
+        self.deadline = 0.0
+        self.attempts = 0
+
+
+class Broker:
+    def __init__(self, serial_fd, args):
+        self.serial_fd = serial_fd
+        self.args = args
+        self.pending = bytearray()
+        self.clients = {}
+        self.queue = collections.deque()
+        self.current = None
+        self.shared = {}            # line -> queued or running read-only Request
+        self.cache = {}             # line -> (expiry, response)
+        self.generation = 0         # Bumped by every command that is not read-only
+        self.seq = random.randrange(256)  # Not the last one of an earlier session
+        self.stats = collections.Counter()
+
+    # Clients -----------------------------------------------------------------
+    def add_client(self, client):
+        self.clients[client.fd] = client
+        self.stats["clients"] += 1
+
+    def drop_client(self, client):
+        del self.clients[client.fd]
+        client.close()
+
+    def client_input(self, client):
+        try:
+            data = os.read(client.fd, 4096)
+        except OSError:
+            return  # PTY with no terminal attached yet
+        if not data and not client.plain:
+            self.drop_client(client)
+            return
+        client.buffer += data.replace(b"\r", b"\n")
+        while b"\n" in client.buffer:
+            line, _, rest = client.buffer.partition(b"\n")
+            client.buffer = bytearray(rest)
+            text = line.decode(errors="replace").strip()
+            if text:
+                self.client_line(client, text)
+
+    def client_line(self, client, text):
+        if client.plain or not text.startswith("{"):
+            self.submit(client, None, True, text)
+            return
+        try:
+            message = json.loads(text)
+            if "subscribe" in message:
+                client.events = set(message["subscribe"]) & set(EVENTS.values())
+                return
+            tag, line = message.get("seq"), str(message["cmd"])
+        except (ValueError, KeyError, TypeError, AttributeError):
+            client.send(b'{"rc": "refused", "error": "expected {\\"seq\\": n, \\"cmd\\": \\"...\\"}"}\n')
+            return
+        self.submit(client, tag, False, line)
+
+    def submit(self, client, tag, plain, line):
+        words = line.split()
+        line = " ".join(words)
+        self.stats["requests"] += 1
+        if line == "@stats":
+            client.answer(tag, plain, {"rc": "ok", "result": 0, "source": "broker",
+                                       "text": json.dumps(self.counters()) + "\n"})
+            return
+        reason = REFUSED.get(words[0]) if words else "empty line"
+        if reason is None and len(line) > MAX_LINE:
+            reason = f"longer than {MAX_LINE} characters"
+        if reason is not None:
+            client.answer(tag, plain, {"rc": "refused", "error": reason})
+            return
+
+        read_only = words[0] in READ_ONLY and READ_ONLY[words[0]](words)
+        if read_only:
+            cached = self.cache.get(line)
+            if cached is not None and cached[0] > time.monotonic():
+                self.stats["cache hits"] += 1
+                client.answer(tag, plain, dict(cached[1], source="cache"))
+                return
+            request = self.shared.get(line)
+            if request is not None:
+                self.stats["coalesced"] += 1
+                request.waiters.append((client, tag, plain))
+                return
+        else:
+            # Whatever was read so far may be changed by this command
+            self.generation += 1
+            self.cache.clear()
+            self.shared.clear()
+        request = Request(line, read_only, self.generation)
+        request.waiters.append((client, tag, plain))
+        if read_only:
+            self.shared[line] = request
+        self.queue.append(request)
+        self.next_request()
+
+    def counters(self):
+        return dict(self.stats, connected=len(self.clients), queued=len(self.queue),
+                    cached=len(self.cache))
+
+    def broadcast(self, channel, payload):
+        event = EVENTS[channel]
+        for client in list(self.clients.values()):
+            if event in client.events:
+                if client.plain:
+                    client.send(payload)
+                else:
+                    client.send((json.dumps({"event": event,
+                                             "text": payload.decode(errors="replace")}) + "\n").encode())
+
+    # Board -------------------------------------------------------------------
+    def send_current(self):
+        request = self.current
+        request.attempts += 1
+        request.deadline = time.monotonic() + self.args.timeout
+        os.write(self.serial_fd, encode_frame(
+            CH_DATA, bytes([MSG_LINE, request.seq]) + request.line.encode() + b"\x00"))
+
+    def next_request(self):
+        if self.current is not None or not self.queue:
+            return
+        self.current = self.queue.popleft()
+        self.seq = (self.seq + 1) & 0xFF
+        self.current.seq = self.seq
+        self.stats["device requests"] += 1
+        self.send_current()
+
+    def finish(self, response):
+        request, self.current = self.current, None
+        if self.shared.get(request.line) is request:
+            del self.shared[request.line]
+        if (request.read_only and response["rc"] == "ok" and self.args.ttl > 0 and
+                request.generation == self.generation):
+            self.cache[request.line] = (time.monotonic() + self.args.ttl, response)
+        for k, (client, tag, plain) in enumerate(request.waiters):
+            if client.fd in self.clients:
+                client.answer(tag, plain, dict(response, source="coalesced" if k else "device"))
+        self.next_request()
+
+    def serial_input(self):
+        self.pending += os.read(self.serial_fd, 4096)
+        while b"\x00" in self.pending:
+            encoded, _, rest = self.pending.partition(b"\x00")
+            self.pending = bytearray(rest)
+            frame = decode_frame(bytes(encoded)) if encoded else None
+            if frame is None:
+                continue
+            channel, payload = frame
+            if channel == CH_CONSOLE and self.current is not None:
+                self.current.text += payload
+            elif channel in EVENTS:
+                self.broadcast(channel, payload)
+            elif (channel == CH_DATA and self.current is not None and len(payload) == 7 and
+                  payload[0] == MSG_REPLY and payload[1] == self.current.seq):
+                rc, result = payload[2], int.from_bytes(payload[3:7], "little")
+                self.finish({"rc": RETURN_CODES[rc] if rc < len(RETURN_CODES) else str(rc),
+                             "result": result,
+                             "text": self.current.text.decode(errors="replace")})
+
+    def check_timeout(self):
+        request = self.current
+        if request is None or time.monotonic() < request.deadline:
+            return
+        if request.attempts <= self.args.retries:
+            self.stats["resends"] += 1
+            self.send_current()  # Same seq: answered again, not run again
+        else:
+            self.stats["timeouts"] += 1
+            self.finish({"rc": "timeout", "error": "board did not answer",
+                         "text": request.text.decode(errors="replace")})
+
+    def wait_time(self):
+        if self.current is None:
+            return 1.0
+        return max(self.current.deadline - time.monotonic(), 0.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--socket", default="/tmp/bring_up_console.sock", help="Unix socket path")
+    parser.add_argument("--pty", type=int, default=0, metavar="N", help="also open N terminals")
+    parser.add_argument("--ttl", type=float, default=0.5, help="seconds read-only results are reused")
+    parser.add_argument("--timeout", type=float, default=2.0, help="seconds per attempt")
+    parser.add_argument("--retries", type=int, default=2)
+    args = parser.parse_args()
+
+    serial_fd = open_serial(args.port, args.baud)
+    switch_to_mux(serial_fd)
+    broker = Broker(serial_fd, args)
+
+    if os.path.exists(args.socket):
+        os.unlink(args.socket)
+    listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    listener.bind(args.socket)
+    listener.listen(16)
+    print(f"socket   {args.socket}", flush=True)
+    sockets = {}
+    for k in range(args.pty):
+        master, slave = os.openpty()  # Line discipline left on: it echoes and edits
+        broker.add_client(Client(master, f"pty{k}", True, lambda: None))
+        print(f"pty{k:<5d} {os.ttyname(slave)}", flush=True)
+
+    running = [True]
+    signal.signal(signal.SIGTERM, lambda *_: running.__setitem__(0, False))
+    try:
+        while running[0]:
+            fds = [serial_fd, listener.fileno()] + list(broker.clients)
+            ready, _, _ = select.select(fds, [], [], broker.wait_time())
+            for fd in ready:
+                if fd == serial_fd:
+                    broker.serial_input()
+                elif fd == listener.fileno():
+                    connection, _ = listener.accept()
+                    sockets[connection.fileno()] = connection
+                    broker.add_client(Client(connection.fileno(), "socket", False,
+                                             lambda fd=connection.fileno(): sockets.pop(fd).close()))
+                elif fd in broker.clients:
+                    broker.client_input(broker.clients[fd])
+            broker.check_timeout()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.write(serial_fd, encode_frame(CH_CONTROL, bytes([CTRL_EXIT])))
+        listener.close()
+        os.unlink(args.socket)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,484 @@
+// core_bench.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Host microbenchmarks for the console hot paths.
+//
+// ring_buffer.c, record_queue.c, console.c, command.c, command_args.c and
+// fastmem.c are compiled natively, unchanged; the modules the command
+// table refers to are replaced by core_bench_stubs.c. The cases are:
+//
+//   ring/byte                  RingBufferPush + RingBufferPop of one byte
+//   ring/stream/<n>            RingBufferStreamPush + StreamPop of n bytes
+//   record/line/<n>            RecordQueuePush + Peek + Release of an n-byte line
+//   dispatch/<command>         CommandParserProcess of a cheap command at a
+//                              given place in the table, or of an unknown one
+//   dispatch/table/<n>         the parser's name lookup (linear FastStrcmp
+//                              scan) for the last entry of an n-entry table
+//   tokenize/words/<n>         CommandParserProcess of `led-on` and n-1 words
+//   decode/text, decode/binary CommandArgsDecode of the same three arguments
+//   framing/line/<n>/chunk/<c> ConsoleReceive in c-byte chunks + ConsoleProcess
+//                              of n-byte lines, command run included
+//
+// Each case is calibrated to a batch of at least --min-time ms, run once to
+// warm up and then --reps times. The per-operation time of every batch goes
+// into the statistics: median, mean, standard deviation, median absolute
+// deviation, min and max. The report is JSON on stdout (or --json FILE) and
+// a table on stderr. For a quiet machine pin the process (--cpu) and keep
+// the frequency fixed; compare two reports with tools/bench_compare.py.
+//
+// Build and run from the repository root:
+//
+//   gcc -O2 -std=gnu11 -DSTM32L073xx -DUSE_HAL_DRIVER -Ibring_up_command/Core/Inc
+//       -isystem bring_up_command/Drivers/STM32L0xx_HAL_Driver/Inc
+//       -isystem bring_up_command/Drivers/CMSIS/Device/ST/STM32L0xx/Include
+//       -isystem bring_up_command/Drivers/CMSIS/Include -o core_bench
+//       tools/core_bench.c tools/core_bench_stubs.c
+//       bring_up_command/Core/Src/ring_buffer.c bring_up_command/Core/Src/record_queue.c
+//       bring_up_command/Core/Src/console.c bring_up_command/Core/Src/command.c
+//       bring_up_command/Core/Src/command_args.c bring_up_command/Core/Src/fastmem.c -lm
+//   ./core_bench --reps 30 --cpu 2 --json before.json
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "command.h"
+#include "command_args.h"
+#include "console.h"
+#include "fastmem.h"
+#include "record_queue.h"
+#include "ring_buffer.h"
+
+#define BENCH_MAX_REPS   1000
+#define BENCH_MAX_TABLE  128
+
+typedef struct BenchCase BenchCase;
+/**
+ * @brief Runs about @p iterations operations and returns how many it ran.
+ */
+typedef uint64_t (*BenchFn)(const BenchCase* bench, uint64_t iterations);
+
+struct BenchCase {
+  const char* name;
+  BenchFn run;
+  int a;                 ///< Case parameters, meaning depends on @c run
+  int b;
+  const char* text;
+  uint32_t bytes;        ///< Bytes moved per operation (0: not a throughput case)
+};
+
+typedef struct {
+  double median;
+  double mean;
+  double stddev;
+  double mad;
+  double min;
+  double max;
+} BenchStats;
+
+static struct {
+  int reps;
+  double min_time_ms;
+  int cpu;
+  const char* filter;
+  const char* json_path;
+} options = {20, 5.0, -1, NULL, NULL};
+
+static volatile uint32_t sink;  // Results go here so that no work is dropped
+static uint64_t console_bytes;
+
+static RingBuffer ring;
+static RecordQueue record;
+static uint8_t record_storage[RECORD_QUEUE_STORAGE(4, CONSOLE_LINE_SIZE)];
+static Console console;
+static char table_names[BENCH_MAX_TABLE][12];
+static const char* table[BENCH_MAX_TABLE];
+
+// -----------------------------------------------------------------------------
+// Typed command used by the decode cases (same shape as `peek`)
+// -----------------------------------------------------------------------------
+static const char* const kWidths[] = {"w", "h", "b", NULL};
+
+#define BENCH_ARGS(ARG, T)                          \
+  ARG(T, REQ, addr,  U32,  0, UINT32_MAX, NULL)     \
+  ARG(T, REQ, count, U16,  1, 16,         NULL)     \
+  ARG(T, OPT, width, Enum, 0, 0,          kWidths)
+
+#define BENCH_COMMANDS(X) X(Bench, "bench", BENCH_ARGS, "decoder benchmark.")
+
+BENCH_COMMANDS(COMMAND_TYPED_DECLARE)
+BENCH_COMMANDS(COMMAND_TYPED_DEFINE)
+
+static void CmdBench(Console* session, const BenchArgs* args) {
+  (void)session;
+  sink += args->addr + args->count + args->width;
+}
+
+// -----------------------------------------------------------------------------
+// Benchmarks
+// -----------------------------------------------------------------------------
+static void ConsoleSink(Console* session, const uint8_t* data, uint16_t len) {
+  (void)session;
+  (void)data;
+  console_bytes += len;
+}
+
+static uint64_t BenchRingByte(const BenchCase* bench, uint64_t iterations) {
+  uint8_t c = 0;
+
+  (void)bench;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    RingBufferPush(&ring, (uint8_t)i);
+    RingBufferPop(&ring, &c);
+    sink += c;
+  }
+  return iterations;
+}
+
+static uint64_t BenchRingStream(const BenchCase* bench, uint64_t iterations) {
+  uint8_t in[RING_BUFFER_SIZE];
+  uint8_t out[RING_BUFFER_SIZE];
+
+  memset(in, 0x5A, sizeof(in));
+  for (uint64_t i = 0; i < iterations; ++i) {
+    RingBufferStreamPush(&ring, in, (uint16_t)bench->a);
+    RingBufferStreamPop(&ring, out, (uint16_t)bench->a);
+    sink += out[0];
+  }
+  return iterations;
+}
+
+static uint64_t BenchRecordLine(const BenchCase* bench, uint64_t iterations) {
+  uint8_t line[CONSOLE_LINE_SIZE];
+  const uint8_t* data = NULL;
+  uint16_t len = 0;
+
+  memset(line, 'a', sizeof(line));
+  for (uint64_t i = 0; i < iterations; ++i) {
+    RecordQueuePush(&record, line, (uint16_t)bench->a);
+    RecordQueuePeek(&record, &data, &len);
+    sink += data[len - 1U];
+    RecordQueueRelease(&record);
+  }
+  return iterations;
+}
+
+static uint64_t BenchParser(const BenchCase* bench, uint64_t iterations) {
+  for (uint64_t i = 0; i < iterations; ++i) {
+    sink += (uint32_t)CommandParserProcess(&console, (const uint8_t*)bench->text);
+  }
+  return iterations;
+}
+
+static uint64_t BenchTableLookup(const BenchCase* bench, uint64_t iterations) {
+  const char* name = table[bench->a - 1];
+
+  for (uint64_t i = 0; i < iterations; ++i) {
+    int found = -1;
+    for (int j = 0; j < bench->a; ++j) {
+      if (FastStrcmp(name, table[j]) == 0) {
+        found = j;
+        break;
+      }
+    }
+    sink += (uint32_t)found;
+    __asm volatile("" : : "r"(name) : "memory");  // Keep the scan in the loop
+  }
+  return iterations;
+}
+
+/**
+ * @brief The generated text entry point: decode, then the handler.
+ */
+static uint64_t BenchDecodeText(const BenchCase* bench, uint64_t iterations) {
+  char w0[] = "bench", w1[] = "0x20001000", w2[] = "12", w3[] = "h";
+  char* argv[] = {w0, w1, w2, w3};
+
+  (void)bench;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    CmdBenchText(&console, 4, argv);
+  }
+  return iterations;
+}
+
+static uint64_t BenchDecodeBinary(const BenchCase* bench, uint64_t iterations) {
+  static const uint8_t kPacked[] = {0x00, 0x10, 0x00, 0x20, 12, 0, 1};
+  CommandArgSource source = {NULL, 0, kPacked, sizeof(kPacked)};
+  uint8_t args[COMMAND_ARGS_MAX_SIZE] __attribute__((aligned(8)));
+  uint8_t bad = 0;
+
+  (void)bench;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    sink += (uint32_t)CommandArgsDecode(&kBenchTyped, &source, args, &bad);
+    kBenchTyped.run(&console, args);
+  }
+  return iterations;
+}
+
+/**
+ * @brief Feeds as many whole lines as the receive buffer holds, in chunks
+ * of bench->b bytes, then runs the line discipline; one line is one
+ * operation.
+ */
+static uint64_t BenchFraming(const BenchCase* bench, uint64_t iterations) {
+  char input[RING_BUFFER_SIZE];
+  int line_len = bench->a;
+  int per_batch = (RING_BUFFER_SIZE - 1) / line_len;
+
+  for (int l = 0; l < per_batch; ++l) {
+    char* line = &input[l * line_len];
+    memset(line, ' ', (size_t)line_len);
+    memcpy(line, "led-on", 6);
+    line[line_len - 1] = '\r';
+  }
+  uint64_t done = 0;
+  for (; done < iterations; done += (uint64_t)per_batch) {
+    int bytes = per_batch * line_len;
+    for (int at = 0; at < bytes; at += bench->b) {
+      int n = (bytes - at < bench->b) ? bytes - at : bench->b;
+      ConsoleReceive(&console, (const uint8_t*)&input[at], (uint16_t)n);
+    }
+    ConsoleProcess(&console);
+  }
+  sink += (uint32_t)console.result;
+  return done;
+}
+
+// -----------------------------------------------------------------------------
+// Cases
+// -----------------------------------------------------------------------------
+static const BenchCase kCases[] = {
+    {"ring/byte", BenchRingByte, 0, 0, NULL, 1},
+    {"ring/stream/1", BenchRingStream, 1, 0, NULL, 1},
+    {"ring/stream/4", BenchRingStream, 4, 0, NULL, 4},
+    {"ring/stream/16", BenchRingStream, 16, 0, NULL, 16},
+    {"ring/stream/64", BenchRingStream, 64, 0, NULL, 64},
+    {"ring/stream/127", BenchRingStream, 127, 0, NULL, 127},
+    {"record/line/8", BenchRecordLine, 8, 0, NULL, 8},
+    {"record/line/32", BenchRecordLine, 32, 0, NULL, 32},
+    {"record/line/64", BenchRecordLine, 64, 0, NULL, 64},
+    {"dispatch/first", BenchParser, 0, 0, "led-on", 0},
+    {"dispatch/middle", BenchParser, 0, 0, "xfer", 0},
+    {"dispatch/late", BenchParser, 0, 0, "gov", 0},
+    {"dispatch/typed", BenchParser, 0, 0, "peek 0x20000000 4 h", 0},
+    {"dispatch/unknown", BenchParser, 0, 0, "nosuchcommand", 0},
+    {"dispatch/table/8", BenchTableLookup, 8, 0, NULL, 0},
+    {"dispatch/table/16", BenchTableLookup, 16, 0, NULL, 0},
+    {"dispatch/table/32", BenchTableLookup, 32, 0, NULL, 0},
+    {"dispatch/table/64", BenchTableLookup, 64, 0, NULL, 0},
+    {"dispatch/table/128", BenchTableLookup, 128, 0, NULL, 0},
+    {"tokenize/words/1", BenchParser, 0, 0, "led-on", 6},
+    {"tokenize/words/2", BenchParser, 0, 0, "led-on 0x20000000", 17},
+    {"tokenize/words/4", BenchParser, 0, 0, "led-on 0x20000000 16 word", 25},
+    {"tokenize/words/8", BenchParser, 0, 0, "led-on a bb ccc dddd eeeee ffffff ggggggg", 41},
+    {"decode/text", BenchDecodeText, 0, 0, NULL, 0},
+    {"decode/binary", BenchDecodeBinary, 0, 0, NULL, 0},
+    {"framing/line/8/chunk/1", BenchFraming, 8, 1, NULL, 8},
+    {"framing/line/8/chunk/64", BenchFraming, 8, 64, NULL, 8},
+    {"framing/line/32/chunk/1", BenchFraming, 32, 1, NULL, 32},
+    {"framing/line/32/chunk/16", BenchFraming, 32, 16, NULL, 32},
+    {"framing/line/32/chunk/64", BenchFraming, 32, 64, NULL, 32},
+    {"framing/line/63/chunk/64", BenchFraming, 63, 64, NULL, 63},
+};
+
+// -----------------------------------------------------------------------------
+// Measurement
+// -----------------------------------------------------------------------------
+static double NowNs(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void ResetState(void) {
+  RingBufferInit(&ring);
+  RecordQueueInit(&record, record_storage, sizeof(record_storage));
+  ConsoleInit(&console, "bench", ConsoleSink, NULL);
+}
+
+/**
+ * @brief Time of one batch, per operation (@p total_ns: of the batch).
+ */
+static double RunBatch(const BenchCase* bench, uint64_t iterations, double* total_ns) {
+  ResetState();
+  double start = NowNs();
+  uint64_t ops = bench->run(bench, iterations);
+  double ns = NowNs() - start;
+
+  if (total_ns != NULL) {
+    *total_ns = ns;
+  }
+  return ns / (double)ops;
+}
+
+/**
+ * @brief Doubles the iteration count until a batch takes --min-time.
+ */
+static uint64_t Calibrate(const BenchCase* bench) {
+  uint64_t iterations = 1;
+
+  for (;;) {
+    double ns = 0;
+    RunBatch(bench, iterations, &ns);
+    if ((ns >= options.min_time_ms * 1e6) || (iterations >= (1ULL << 40))) {
+      return iterations;
+    }
+    // Jump close to the target, but never by more than 100x at once
+    double scale = (ns > 0) ? options.min_time_ms * 1e6 * 1.2 / ns : 100.0;
+    scale = (scale > 100.0) ? 100.0 : ((scale < 2.0) ? 2.0 : scale);
+    iterations = (uint64_t)((double)iterations * scale);
+  }
+}
+
+static int CompareDouble(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static double Median(double* sorted, int n) {
+  return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+static BenchStats Statistics(double* samples, int n) {
+  BenchStats stats = {0};
+  double deviations[BENCH_MAX_REPS];
+  double sum = 0;
+  double sq = 0;
+
+  qsort(samples, (size_t)n, sizeof(double), CompareDouble);
+  for (int i = 0; i < n; ++i) {
+    sum += samples[i];
+  }
+  stats.mean = sum / n;
+  for (int i = 0; i < n; ++i) {
+    sq += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+  }
+  stats.stddev = (n > 1) ? sqrt(sq / (n - 1)) : 0.0;
+  stats.median = Median(samples, n);
+  for (int i = 0; i < n; ++i) {
+    deviations[i] = fabs(samples[i] - stats.median);
+  }
+  qsort(deviations, (size_t)n, sizeof(double), CompareDouble);
+  stats.mad = Median(deviations, n);
+  stats.min = samples[0];
+  stats.max = samples[n - 1];
+  return stats;
+}
+
+static void PrintJsonCase(FILE* out, const BenchCase* bench, uint64_t iterations,
+                          const BenchStats* stats, int first) {
+  fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"reps\": %d, ",
+          first ? "" : ",", bench->name, (unsigned long long)iterations, options.reps);
+  fprintf(out, "\"ns_per_op\": {\"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, "
+          "\"mad\": %.3f, \"min\": %.3f, \"max\": %.3f}",
+          stats->median, stats->mean, stats->stddev, stats->mad, stats->min, stats->max);
+  if (bench->bytes != 0) {
+    fprintf(out, ", \"bytes_per_op\": %u, \"mb_per_s\": %.2f", bench->bytes,
+            bench->bytes * 1e3 / stats->median);
+  }
+  fprintf(out, "}");
+}
+
+static void Usage(const char* argv0) {
+  fprintf(stderr,
+          "Usage: %s [--reps N] [--min-time MS] [--cpu N] [--filter TEXT] [--json FILE] [--list]\n",
+          argv0);
+}
+
+int main(int argc, char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--list") == 0) {
+      for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+        printf("%s\n", kCases[c].name);
+      }
+      return 0;
+    }
+    if (value == NULL) {
+      Usage(argv[0]);
+      return 2;
+    }
+    if (strcmp(arg, "--reps") == 0) {
+      options.reps = atoi(value);
+    } else if (strcmp(arg, "--min-time") == 0) {
+      options.min_time_ms = atof(value);
+    } else if (strcmp(arg, "--cpu") == 0) {
+      options.cpu = atoi(value);
+    } else if (strcmp(arg, "--filter") == 0) {
+      options.filter = value;
+    } else if (strcmp(arg, "--json") == 0) {
+      options.json_path = value;
+    } else {
+      Usage(argv[0]);
+      return 2;
+    }
+    ++i;
+  }
+  if ((options.reps < 1) || (options.reps > BENCH_MAX_REPS) || (options.min_time_ms <= 0)) {
+    Usage(argv[0]);
+    return 2;
+  }
+  if (options.cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(options.cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      perror("sched_setaffinity");
+      return 1;
+    }
+  }
+
+  for (int i = 0; i < BENCH_MAX_TABLE; ++i) {
+    snprintf(table_names[i], sizeof(table_names[i]), "cmd%03d", i);
+    table[i] = table_names[i];
+  }
+
+  FILE* out = stdout;
+  if ((options.json_path != NULL) && ((out = fopen(options.json_path, "w")) == NULL)) {
+    perror(options.json_path);
+    return 1;
+  }
+  fprintf(out, "{\n  \"suite\": \"core_bench\",\n  \"compiler\": \"%s\",\n"
+          "  \"reps\": %d,\n  \"min_time_ms\": %.3f,\n  \"cpu\": %d,\n  \"results\": [",
+          __VERSION__, options.reps, options.min_time_ms, options.cpu);
+  fprintf(stderr, "%-28s %12s %10s %10s %10s\n", "case", "median ns", "mad", "stddev", "MB/s");
+
+  int first = 1;
+  for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+    const BenchCase* bench = &kCases[c];
+    double samples[BENCH_MAX_REPS];
+
+    if ((options.filter != NULL) && (strstr(bench->name, options.filter) == NULL)) {
+      continue;
+    }
+    uint64_t iterations = Calibrate(bench);
+    RunBatch(bench, iterations, NULL);  // Warm-up
+    for (int r = 0; r < options.reps; ++r) {
+      samples[r] = RunBatch(bench, iterations, NULL);
+    }
+    BenchStats stats = Statistics(samples, options.reps);
+
+    PrintJsonCase(out, bench, iterations, &stats, first);
+    first = 0;
+    fprintf(stderr, "%-28s %12.2f %10.2f %10.2f", bench->name, stats.median, stats.mad,
+            stats.stddev);
+    if (bench->bytes != 0) {
+      fprintf(stderr, " %10.1f", bench->bytes * 1e3 / stats.median);
+    }
+    fprintf(stderr, "\n");
+  }
+  fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+// core_bench_stubs.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Host stand-ins for the firmware modules the command table refers to, so
+// that command.c links natively in core_bench. None of them is on a
+// measured path except where noted; they return what an idle board would.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "clock_gate.h"
+#include "dma_copy.h"
+#include "dump.h"
+#include "fastmem.h"
+#include "governor.h"
+#include "linktest.h"
+#include "loop_monitor.h"
+#include "main.h"
+#include "module.h"
+#include "mux.h"
+#include "profiler.h"
+#include "reg.h"
+#include "rs485.h"
+#include "selftest.h"
+#include "timesync.h"
+#include "trace.h"
+#include "vm.h"
+#include "watch.h"
+#include "xfer.h"
+
+static Console mux_console;
+
+// GPIO: `led-on` is the cheapest command, and the first in the table. It
+// stores to the port registers directly (reg.h), so the GPIO ports get
+// ordinary memory at their addresses.
+__attribute__((constructor)) static void StubMapGpio(void) {
+  void* ports = mmap((void*)IOPPERIPH_BASE, 0x2000, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if (ports != (void*)IOPPERIPH_BASE) {
+    fprintf(stderr, "core_bench: cannot map the GPIO ports at 0x%08lx\n",
+            (unsigned long)IOPPERIPH_BASE);
+    exit(1);
+  }
+}
+
+ReturnCode ClockGateAcquire(ClockGateId id, uint8_t in_sleep) { (void)id; (void)in_sleep; return kOk; }
+void ClockGateReport(Console* console) { (void)console; }
+void ClockGateResetStats(void) {}
+
+ReturnCode DmaCopyBenchmark(Console* console) { (void)console; return kOk; }
+
+// Nothing is accessible: `peek` runs its decoder and stops at the range check
+ReturnCode DumpCheckRange(uint32_t address, uint32_t length, uint8_t* access) {
+  (void)address;
+  (void)length;
+  (void)access;
+  return kInvalidArgument;
+}
+ReturnCode DumpStart(uint32_t address, uint32_t length, uint8_t flags) {
+  (void)address;
+  (void)length;
+  (void)flags;
+  return kError;
+}
+
+ReturnCode FastmemBenchmark(Console* console, const char* function) {
+  (void)console;
+  (void)function;
+  return kOk;
+}
+
+ReturnCode GovernorBoost(uint32_t ms) { (void)ms; return kOk; }
+void GovernorReport(Console* console) { (void)console; }
+void GovernorSetAuto(void) {}
+ReturnCode GovernorSetFixed(const char* name) { (void)name; return kOk; }
+ReturnCode GovernorTune(uint32_t up_pct, uint32_t down_pct, uint32_t hold_windows) {
+  (void)up_pct;
+  (void)down_pct;
+  (void)hold_windows;
+  return kOk;
+}
+
+void LinktestReport(Console* console) { (void)console; }
+ReturnCode LinktestStart(Console* console, const char* port, uint32_t baud, uint8_t order,
+                         uint32_t duration_ms, LinktestMode mode) {
+  (void)console;
+  (void)port;
+  (void)baud;
+  (void)order;
+  (void)duration_ms;
+  (void)mode;
+  return kError;
+}
+ReturnCode LinktestStop(void) { return kOk; }
+
+void LoopMonitorEnter(const char* name) { (void)name; }
+uint32_t LoopMonitorLeave(void) { return 0; }
+void LoopMonitorReport(Console* console) { (void)console; }
+void LoopMonitorReset(void) {}
+ReturnCode LoopMonitorSetThreshold(uint32_t ms) { (void)ms; return kOk; }
+
+uint16_t ModuleAreaUsed(void) { return 0; }
+const ModuleDescriptor* ModuleAt(uint8_t index) { (void)index; return NULL; }
+uint8_t ModuleCount(void) { return 0; }
+const Command* ModuleFindCommand(const char* name) { (void)name; return NULL; }
+ReturnCode ModuleUnload(const char* name) { (void)name; return kEmpty; }
+
+Console* MuxGetConsole(void) { return &mux_console; }
+MuxReceiveFn MuxGetReceiver(uint8_t channel) { (void)channel; return NULL; }
+uint8_t MuxIsActive(void) { return 0; }
+ReturnCode MuxSetReceiver(uint8_t channel, MuxReceiveFn receive) {
+  (void)channel;
+  (void)receive;
+  return kOk;
+}
+ReturnCode MuxStart(Console* link) { (void)link; return kError; }
+ReturnCode MuxWrite(uint8_t channel, const uint8_t* data, uint16_t len) {
+  (void)channel;
+  (void)data;
+  (void)len;
+  return kError;
+}
+
+ReturnCode ProfilerDump(uint8_t flags) { (void)flags; return kError; }
+void ProfilerReport(Console* console) { (void)console; }
+void ProfilerReset(void) {}
+ReturnCode ProfilerStart(uint32_t rate_hz) { (void)rate_hz; return kOk; }
+void ProfilerStop(void) {}
+
+ReturnCode RegBenchmark(Console* console) { (void)console; return kOk; }
+
+ReturnCode Rs485Enable(uint8_t on) { (void)on; return kOk; }
+void Rs485Report(Console* console) { (void)console; }
+ReturnCode Rs485SetAddress(uint32_t address) { (void)address; return kOk; }
+
+void SelftestList(Console* console) { (void)console; }
+ReturnCode SelftestStart(Console* console, char* const names[], int count) {
+  (void)console;
+  (void)names;
+  (void)count;
+  return kFull;
+}
+
+ReturnCode TimesyncAddPair(uint64_t local_us, int64_t ref_us) {
+  (void)local_us;
+  (void)ref_us;
+  return kOk;
+}
+ReturnCode TimesyncLastPulse(uint64_t* local_us) { (void)local_us; return kEmpty; }
+uint64_t TimesyncLocalMicros(void) { return 0; }
+void TimesyncReport(Console* console) { (void)console; }
+void TimesyncReset(void) {}
+
+void TraceEvent(uint16_t id, uint32_t value) { (void)id; (void)value; }
+void TraceLog(const char* format, ...) { (void)format; }
+
+void VmGetStatus(VmStatus* status) { memset(status, 0, sizeof(*status)); }
+ReturnCode VmLoad(uint16_t offset, const uint8_t* data, uint16_t len) {
+  (void)offset;
+  (void)data;
+  (void)len;
+  return kOk;
+}
+ReturnCode VmRun(Console* console) { (void)console; return kOk; }
+void VmStop(void) {}
+
+void WatchReport(Console* console) { (void)console; }
+ReturnCode WatchStart(Console* console, uint32_t period_ms, const char* command_line) {
+  (void)console;
+  (void)period_ms;
+  (void)command_line;
+  return kOk;
+}
+uint8_t WatchStop(const Console* console) { (void)console; return 0; }
+
+void XferReport(Console* console) { (void)console; }
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Reads memory from the board over the mux data channel (see Core/Inc/dump.h).
+
+    dump.py /dev/ttyACM0 0x20000000 0x5000 -o ram.bin --lz
+    dump.py /dev/ttyACM0 0x40013800 0x2c --hex          (USART1 registers)
+    dump.py --decompress capture.lz -o capture.bin
+
+The console is switched to mux mode, `dump` is sent on the console channel
+and the stream is collected from the data channel, decompressed when --lz
+is given and checked against the CRC the board sends at the end; the port
+returns to the text console afterwards.
+
+--lz streams through the board's LZSS compressor (Core/Inc/lz.h): a flag
+byte for every eight items, LSB first, 1 = literal byte, 0 = match of two
+bytes (distance - 1, length - 3) copied from the output already produced.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from modlink import CH_CONSOLE, CH_DATA, MuxLink  # noqa: E402
+from vchan_demux import (BAUD_RATES, CH_CONTROL, CTRL_EXIT, crc16_ccitt,  # noqa: E402
+                         open_serial, switch_to_mux)
+
+MSG_BEGIN, MSG_DATA, MSG_END = 0x20, 0x21, 0x22
+FLAG_LZ = 0x01
+MIN_MATCH = 3
+RETURN_CODES = ["ok", "full", "empty", "invalid argument", "error"]
+
+
+def lz_decompress(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        flags = data[i]
+        i += 1
+        for bit in range(8):
+            if i >= len(data):
+                break
+            if flags >> bit & 1:
+                out.append(data[i])
+                i += 1
+                continue
+            if i + 1 >= len(data):
+                raise ValueError("stream ends inside a match")
+            distance, length = data[i] + 1, data[i + 1] + MIN_MATCH
+            i += 2
+            if distance > len(out):
+                raise ValueError(f"match distance {distance} before the start at {len(out)}")
+            for _ in range(length):  # Bytewise: the copy may overlap itself
+                out.append(out[-distance])
+    return bytes(out)
+
+
+def receive_dump(link, timeout):
+    """Collects one stream; returns (flags, address, length, stream, rc, crc)."""
+    begin = None
+    stream = bytearray()
+    while True:
+        message = link.receive(CH_DATA, timeout)
+        kind = message[0]
+        if kind == MSG_BEGIN:
+            begin = struct.unpack_from("<BII", message, 1)
+            stream.clear()
+        elif kind == MSG_DATA and begin is not None:
+            stream += message[1:]
+        elif kind == MSG_END and begin is not None:
+            rc, crc, sent = struct.unpack_from("<BHI", message, 1)
+            if sent != len(stream):
+                raise RuntimeError(f"lost stream data: {len(stream)} of {sent} bytes")
+            return begin + (bytes(stream), rc, crc)
+
+
+def hexdump(address, data):
+    for offset in range(0, len(data), 16):
+        row = data[offset:offset + 16]
+        words = " ".join(f"{struct.unpack_from('<I', row, k)[0]:08x}"
+                         for k in range(0, len(row) - 3, 4))
+        print(f"{address + offset:08x}: {words}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?")
+    parser.add_argument("address", nargs="?", type=lambda v: int(v, 0))
+    parser.add_argument("length", nargs="?", type=lambda v: int(v, 0))
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--lz", action="store_true", help="compress on the board")
+    parser.add_argument("-o", "--output", help="write the data to a file")
+    parser.add_argument("--hex", action="store_true", help="print the data as 32-bit words")
+    parser.add_argument("--timeout", type=float, default=5.0, help="seconds without data")
+    parser.add_argument("--decompress", metavar="FILE", help="only decompress a saved stream")
+    args = parser.parse_args()
+
+    if args.decompress:
+        with open(args.decompress, "rb") as f:
+            data = lz_decompress(f.read())
+        with open(args.output or args.decompress + ".bin", "wb") as f:
+            f.write(data)
+        return 0
+    if args.port is None or args.address is None or args.length is None:
+        parser.error("give port, address and length (or --decompress)")
+
+    fd = open_serial(args.port, args.baud)
+    link = MuxLink(fd)
+    switch_to_mux(fd)
+    start = time.monotonic()
+    try:
+        link.send(CH_CONSOLE, f"dump {args.address:#x} {args.length:#x}"
+                              f"{' lz' if args.lz else ''}\r".encode())
+        flags, _, length, stream, rc, crc = receive_dump(link, args.timeout)
+    finally:
+        link.send(CH_CONTROL, bytes([CTRL_EXIT]))
+    elapsed = time.monotonic() - start
+
+    data = lz_decompress(stream) if flags & FLAG_LZ else stream
+    if rc != 0:
+        print(f"board ended the dump: {RETURN_CODES[rc]}", file=sys.stderr)
+    if crc16_ccitt(data) != crc:
+        print("CRC mismatch", file=sys.stderr)
+        return 1
+    print(f"{len(data)} of {length} bytes, {len(stream)} on the wire "
+          f"({len(data) / max(len(stream), 1):.1f}x), {elapsed:.2f} s", file=sys.stderr)
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+    if args.hex or not args.output:
+        hexdump(args.address, data)
+    return 0 if rc == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
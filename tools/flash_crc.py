@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Stores the flash image CRC checked by `selftest flash` (see Core/Src/selftest.c).
+
+The firmware carries a record {"FCRC", crc} with the CRC left erased. Run
+this on the linked firmware after every build, before flashing it:
+
+    flash_crc.py build/bring_up_command.elf
+    flash_crc.py build/bring_up_command.bin     (raw image at 0x08000000)
+
+The CRC is a standard CRC-32 (as zlib.crc32) of the flash image from the
+start of flash to the end of the .data initializers, with the record's CRC
+word taken as 0xFFFFFFFF. Gaps between loadable segments count as erased
+flash. With --check the file is only verified, not changed.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+FLASH_BASE = 0x08000000
+FLASH_SIZE = 192 * 1024
+MAGIC = struct.pack("<I", 0x43524346)  # "FCRC"
+PT_LOAD = 1
+
+
+def elf_segments(data):
+    """Returns (address, file offset, size) of the loadable flash segments."""
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("not a 32-bit little-endian ELF file")
+    phoff, = struct.unpack_from("<I", data, 28)
+    phentsize, phnum = struct.unpack_from("<HH", data, 42)
+    segments = []
+    for i in range(phnum):
+        p_type, p_offset, _, p_paddr, p_filesz = struct.unpack_from(
+            "<IIIII", data, phoff + i * phentsize)
+        if (p_type == PT_LOAD and p_filesz > 0 and
+                FLASH_BASE <= p_paddr < FLASH_BASE + FLASH_SIZE):
+            segments.append((p_paddr, p_offset, p_filesz))
+    return sorted(segments)
+
+
+def flash_image(data, segments):
+    end = max(address + size for address, _, size in segments)
+    image = bytearray(b"\xff" * (end - FLASH_BASE))
+    for address, offset, size in segments:
+        image[address - FLASH_BASE:address - FLASH_BASE + size] = data[offset:offset + size]
+    return image
+
+
+def find_record(image):
+    hits = [i for i in range(0, len(image) - 7, 4) if image[i:i + 4] == MAGIC]
+    if len(hits) != 1:
+        raise ValueError(f"expected one CRC record, found {len(hits)}")
+    return hits[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("firmware", help="linked firmware (.elf or .bin)")
+    parser.add_argument("--check", action="store_true", help="verify only")
+    args = parser.parse_args()
+
+    with open(args.firmware, "rb") as f:
+        data = bytearray(f.read())
+    try:
+        if data[:4] == b"\x7fELF":
+            segments = elf_segments(data)
+            if not segments:
+                raise ValueError("no loadable flash segments")
+        else:
+            segments = [(FLASH_BASE, 0, len(data))]
+        image = flash_image(data, segments)
+        record = find_record(image)
+    except ValueError as error:
+        sys.exit(f"{args.firmware}: {error}")
+
+    stored, = struct.unpack_from("<I", image, record + 4)
+    image[record + 4:record + 8] = b"\xff\xff\xff\xff"
+    crc = zlib.crc32(image) & 0xFFFFFFFF
+    print(f"{args.firmware}: {len(image)} bytes, crc {crc:08X} "
+          f"(record at 0x{FLASH_BASE + record:08x}, stored {stored:08X})")
+
+    if args.check:
+        return 0 if stored == crc else 1
+
+    # Patch the file where the record's CRC word comes from
+    address = FLASH_BASE + record + 4
+    for seg_address, offset, size in segments:
+        if seg_address <= address < seg_address + size:
+            struct.pack_into("<I", data, offset + address - seg_address, crc)
+    with open(args.firmware, "wb") as f:
+        f.write(data)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
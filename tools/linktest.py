@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+"""Host side of the firmware's PRBS link test (see Core/Inc/linktest.h).
+
+In host mode the device and this tool both send the PRBS pattern and check
+the one they receive, full duplex, on the port the tool is connected to:
+
+    linktest.py /dev/ttyACM0 --rate 2000000 --prbs 15 --time 3000
+
+The tool starts the test with the `linktest` command at the console baud
+rate, switches its own port to --rate, streams and checks for --time
+milliseconds, then switches back and fetches the device's report. Both
+directions are reported: device-to-host from this tool's checker,
+host-to-device from the device's.
+
+--mode loop / ext only start a device loopback test (internal half-duplex
+or TX jumpered to RX, --device-port naming the port under test) and print
+the device's report; the host link is not touched.
+
+Bytes carry the sequence MSB first: PRBS-7 x^7+x^6+1, PRBS-15 x^15+x^14+1,
+PRBS-31 x^31+x^28+1, starting from the all-ones state.
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from vchan_demux import BAUD_RATES, open_serial  # noqa: E402
+
+TAPS = {7: 6, 15: 14, 31: 28}
+LOCK_BYTES = 4        # LINKTEST_LOCK_BYTES
+UNLOCK_ERRORS = 16    # LINKTEST_UNLOCK_ERRORS
+BURST_GAP = 16        # LINKTEST_BURST_GAP
+CHUNK = 4096
+
+
+class Prbs:
+    """Byte-wise PRBS generator, the same algorithm as the firmware."""
+
+    def __init__(self, order):
+        self.order = order
+        self.tap = TAPS[order]
+        self.mask = (1 << order) - 1
+        self.state = self.mask
+
+    def next_byte(self):
+        s, order, tap = self.state, self.order, self.tap
+        if tap >= 8:
+            out = ((s >> (order - 8)) ^ (s >> (tap - 8))) & 0xFF
+            s = (s << 8) | out
+        else:
+            high = ((s >> (order - 4)) ^ (s >> (tap - 4))) & 0xF
+            s = (s << 4) | high
+            low = ((s >> (order - 4)) ^ (s >> (tap - 4))) & 0xF
+            s = (s << 4) | low
+            out = (high << 4) | low
+        self.state = s & self.mask
+        return out
+
+    def next_bytes(self, count):
+        return bytes(self.next_byte() for _ in range(count))
+
+
+class PatternSource:
+    """Endless pattern; PRBS-7/15 repeat every 2^n - 1 bytes, so one period
+    is generated once and then sliced."""
+
+    def __init__(self, order):
+        self.prbs = Prbs(order)
+        self.period = None
+        if order < 31:
+            self.period = self.prbs.next_bytes((1 << order) - 1)
+            self.offset = 0
+
+    def read(self, count):
+        if self.period is None:
+            return self.prbs.next_bytes(count)
+        out = bytearray()
+        while len(out) < count:
+            take = min(count - len(out), len(self.period) - self.offset)
+            out += self.period[self.offset:self.offset + take]
+            self.offset = (self.offset + take) % len(self.period)
+        return bytes(out)
+
+
+class Checker:
+    """Same lock / resync / burst rules as the firmware checker."""
+
+    def __init__(self, order):
+        self.ref = Prbs(order)
+        self.seed_bytes = (order + 7) // 8
+        self.locked = False
+        self.seeded = self.good = self.window = self.window_errors = 0
+        self.raw = self.checked = self.errors = 0
+        self.bursts = self.longest = self.resyncs = 0
+        self.last_error = self.burst_start = 0
+        self.lock_time = self.last_time = None
+
+    def reset(self):
+        self.locked = False
+        self.seeded = self.good = 0
+
+    def seed(self, byte):
+        ref = self.ref
+        if self.seeded < self.seed_bytes:
+            ref.state = ((ref.state << 8) | byte) & ref.mask
+            self.seeded += 1
+            return
+        if ref.next_byte() == byte:
+            self.good += 1
+            if self.good == LOCK_BYTES:
+                self.locked = True
+                self.window = self.window_errors = 0
+                if self.lock_time is None:
+                    self.lock_time = time.monotonic()
+            return
+        ref.state = ((ref.state & ~0xFF) | byte) & ref.mask
+        self.good = 0
+
+    def error(self, diff):
+        bits = bin(diff).count("1")
+        self.window_errors += bits
+        self.errors += bits
+        at = self.checked
+        if self.bursts == 0 or at - self.last_error > BURST_GAP:
+            self.bursts += 1
+            self.burst_start = at
+        self.last_error = at
+        self.longest = max(self.longest, at - self.burst_start + 1)
+
+    def feed(self, data):
+        self.raw += len(data)
+        for byte in data:
+            if not self.locked:
+                self.seed(byte)
+                continue
+            diff = byte ^ self.ref.next_byte()
+            self.checked += 1
+            if diff:
+                self.error(diff)
+            self.window += 1
+            if self.window == 8:
+                if self.window_errors > UNLOCK_ERRORS:
+                    self.reset()
+                    self.resyncs += 1
+                self.window = self.window_errors = 0
+        if self.locked:
+            self.last_time = time.monotonic()
+
+
+def set_baud(fd, baud):
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = BAUD_RATES[baud]
+    termios.tcsetattr(fd, termios.TCSADRAIN, attrs)
+
+
+def read_until(fd, marker, timeout):
+    seen = b""
+    deadline = time.monotonic() + timeout
+    while marker not in seen:
+        left = deadline - time.monotonic()
+        ready, _, _ = select.select([fd], [], [], max(left, 0))
+        if not ready:
+            raise RuntimeError(f"timeout waiting for {marker!r}, got {seen[-200:]!r}")
+        seen += os.read(fd, 1024)
+    return seen
+
+
+def device_report(fd, timeout=2.0):
+    """Clears the console line and asks for the last report."""
+    os.write(fd, b"\r")
+    time.sleep(0.05)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    os.write(fd, b"linktest\r")
+    text = read_until(fd, b"uart errors", timeout)
+    text += read_until(fd, b"\n", 0.5) if not text.endswith(b"\n") else b""
+    start = text.find(b"linktest ")
+    return text[start:].decode(errors="replace").strip()
+
+
+def format_ber(errors, bits):
+    if bits == 0:
+        return "n/a"
+    return f"{errors / bits:.1e}" if errors else f"<{1 / bits:.1e}"
+
+
+def run_host(fd, args):
+    source = PatternSource(args.prbs)
+    checker = Checker(args.prbs)
+    sent = 0
+
+    time.sleep(0.05)        # Device switches baud after its acknowledgement
+    set_baud(fd, args.rate)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    start = time.monotonic()
+    end = start + args.time / 1000.0
+    pending = b""
+
+    while time.monotonic() < end:
+        if not pending:
+            pending = source.read(CHUNK)
+        ready_r, ready_w, _ = select.select([fd], [fd], [], 0.05)
+        if ready_w:
+            written = os.write(fd, pending)
+            pending = pending[written:]
+            sent += written
+        if ready_r:
+            checker.feed(os.read(fd, CHUNK))
+
+    # Drain what the device sent until it stops
+    while True:
+        ready, _, _ = select.select([fd], [], [], 0.2)
+        if not ready:
+            break
+        checker.feed(os.read(fd, CHUNK))
+    elapsed = time.monotonic() - start
+
+    set_baud(fd, args.baud)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    time.sleep(0.2)
+    report = device_report(fd)
+
+    print(f"host tx {sent} B, {sent / elapsed:.0f} B/s")
+    if checker.lock_time is None:
+        print(f"host rx no lock ({checker.raw} B received)")
+    else:
+        span = (checker.last_time or checker.lock_time) - checker.lock_time
+        rate = checker.checked / span if span > 0 else 0
+        print(f"host rx {checker.checked} B, {rate:.0f} B/s, {checker.errors} bit errors, "
+              f"BER {format_ber(checker.errors, checker.checked * 8)}")
+        print(f"host {checker.bursts} bursts (longest {checker.longest} B), "
+              f"{checker.resyncs} resyncs")
+    print("device:")
+    print(report)
+    return 0 if checker.lock_time is not None and checker.errors == 0 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES),
+                        help="console baud rate")
+    parser.add_argument("--rate", type=int, default=921600, choices=sorted(BAUD_RATES),
+                        help="test baud rate")
+    parser.add_argument("--prbs", type=int, default=15, choices=sorted(TAPS))
+    parser.add_argument("--time", type=int, default=3000, help="test length in ms")
+    parser.add_argument("--mode", default="host", choices=["host", "loop", "ext"])
+    parser.add_argument("--device-port", default="usart2",
+                        help="device name of the port under test")
+    args = parser.parse_args()
+
+    fd = open_serial(args.port, args.baud)
+    os.write(fd, b"\r")
+    time.sleep(0.05)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    command = (f"linktest {args.device_port} {args.rate} {args.prbs} {args.time} "
+               f"{args.mode}\r").encode()
+    os.write(fd, command)
+    read_until(fd, b"Link test started", 2.0)
+
+    if args.mode == "host":
+        return run_host(fd, args)
+
+    time.sleep(args.time / 1000.0 + 0.2)
+    print(device_report(fd))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
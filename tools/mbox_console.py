@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Host side of the RAM mailbox console (see Core/Inc/ram_console.h).
+
+Talks to the control block in target RAM through a debug server while the
+firmware keeps running, and bridges it to the terminal (or to a PTY with
+--pty, for scripts).
+
+Backends:
+  --openocd HOST:PORT   OpenOCD Tcl RPC server (default localhost:6666);
+                        memory is accessed in the background, no halting.
+  --gdb HOST:PORT       any GDB remote stub (pyOCD, st-util, QEMU, Renode...);
+                        the target is briefly interrupted around each poll.
+
+Usage:
+    mbox_console.py [--openocd localhost:6666 | --gdb localhost:3333]
+                    [--address 0x20000000] [--pty] [--interval 0.01]
+"""
+
+import argparse
+import os
+import select
+import socket
+import struct
+import sys
+import termios
+import tty
+
+MAILBOX_ID = b"BRINGUP MAILBOX\x00"
+HEADER_SIZE = 24  # id[16], version, ring_size
+
+
+class OpenOcdBackend:
+    """OpenOCD Tcl RPC (commands terminated by 0x1a)."""
+
+    def __init__(self, endpoint):
+        host, port = endpoint.rsplit(":", 1)
+        self.sock = socket.create_connection((host, int(port)))
+
+    def _call(self, command):
+        self.sock.sendall(command.encode() + b"\x1a")
+        reply = b""
+        while not reply.endswith(b"\x1a"):
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise ConnectionError("OpenOCD closed the connection")
+            reply += chunk
+        return reply[:-1].decode()
+
+    def read(self, address, length):
+        words = self._call(f"read_memory 0x{address:08x} 8 {length}").split()
+        return bytes(int(w, 16) for w in words)
+
+    def write(self, address, data):
+        values = " ".join(f"0x{b:02x}" for b in data)
+        self._call(f"write_memory 0x{address:08x} 8 {{{values}}}")
+
+
+class GdbBackend:
+    """GDB remote serial protocol with interrupt/continue around accesses."""
+
+    def __init__(self, endpoint):
+        host, port = endpoint.rsplit(":", 1)
+        self.sock = socket.create_connection((host, int(port)))
+        self.buffer = b""
+        self.running = True
+        self._packet("?")
+
+    def _recv_packet(self):
+        while True:
+            start = self.buffer.find(b"$")
+            end = self.buffer.find(b"#", start + 1) if start >= 0 else -1
+            if start >= 0 and end >= 0 and len(self.buffer) >= end + 3:
+                payload = self.buffer[start + 1:end]
+                self.buffer = self.buffer[end + 3:]
+                self.sock.sendall(b"+")
+                return payload.decode()
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise ConnectionError("GDB server closed the connection")
+            self.buffer += chunk
+
+    def _send(self, payload):
+        checksum = sum(payload.encode()) & 0xFF
+        self.sock.sendall(f"${payload}#{checksum:02x}".encode())
+
+    def _packet(self, payload):
+        self._send(payload)
+        return self._recv_packet()
+
+    def _halt(self):
+        if self.running:
+            self.sock.sendall(b"\x03")
+            self._recv_packet()  # Stop reply
+            self.running = False
+
+    def resume(self):
+        if not self.running:
+            self._send("c")
+            self.running = True
+
+    def read(self, address, length):
+        self._halt()
+        return bytes.fromhex(self._packet(f"m{address:x},{length:x}"))
+
+    def write(self, address, data):
+        self._halt()
+        self._packet(f"M{address:x},{len(data):x}:{data.hex()}")
+
+
+class Mailbox:
+    def __init__(self, backend, address):
+        self.backend = backend
+        self.address = address
+        header = backend.read(address, HEADER_SIZE)
+        if header[:16] != MAILBOX_ID:
+            raise RuntimeError(f"no mailbox at 0x{address:08x} (firmware not running?)")
+        _, self.ring_size = struct.unpack_from("<II", header, 16)
+        self.up = address + HEADER_SIZE
+        self.down = self.up + self.ring_size + 4
+
+    def _indices(self, ring):
+        return struct.unpack("<HH", self.backend.read(ring + self.ring_size, 4))
+
+    def read_up(self):
+        head, tail = self._indices(self.up)
+        if head == tail:
+            return b""
+        if head > tail:
+            data = self.backend.read(self.up + tail, head - tail)
+        else:
+            data = self.backend.read(self.up + tail, self.ring_size - tail)
+            if head:
+                data += self.backend.read(self.up, head)
+        # Release the space only after the data has been read
+        self.backend.write(self.up + self.ring_size + 2, struct.pack("<H", head))
+        return data
+
+    def write_down(self, data):
+        head, tail = self._indices(self.down)
+        free = (tail - head - 1) % self.ring_size
+        data = data[:free]
+        for byte in data:
+            self.backend.write(self.down + head, bytes([byte]))
+            head = (head + 1) % self.ring_size
+        if data:
+            # Publish the data only after it has been stored
+            self.backend.write(self.down + self.ring_size, struct.pack("<H", head))
+        return len(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--openocd", default="localhost:6666")
+    group.add_argument("--gdb")
+    parser.add_argument("--address", type=lambda s: int(s, 0), default=0x20000000)
+    parser.add_argument("--pty", action="store_true", help="expose the console as a PTY")
+    parser.add_argument("--interval", type=float, default=0.01, help="poll period in seconds")
+    args = parser.parse_args()
+
+    backend = GdbBackend(args.gdb) if args.gdb else OpenOcdBackend(args.openocd)
+    mailbox = Mailbox(backend, args.address)
+    if hasattr(backend, "resume"):
+        backend.resume()
+
+    if args.pty:
+        in_fd, slave = os.openpty()
+        out_fd = in_fd
+        tty.setraw(slave)
+        print(f"console {os.ttyname(slave)}", flush=True)
+        saved = None
+    else:
+        in_fd, out_fd = sys.stdin.fileno(), sys.stdout.fileno()
+        saved = termios.tcgetattr(in_fd) if os.isatty(in_fd) else None
+        if saved:
+            tty.setcbreak(in_fd)
+
+    pending = b""
+    try:
+        while True:
+            ready, _, _ = select.select([in_fd], [], [], args.interval)
+            if ready:
+                data = os.read(in_fd, 256)
+                if not data and not args.pty:
+                    break
+                pending += data.replace(b"\n", b"\r")
+            if pending:
+                pending = pending[mailbox.write_down(pending):]
+            output = mailbox.read_up()
+            if output:
+                os.write(out_fd, output)
+            if hasattr(backend, "resume"):
+                backend.resume()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if saved:
+            termios.tcsetattr(in_fd, termios.TCSADRAIN, saved)
+        if hasattr(backend, "resume"):
+            backend.resume()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
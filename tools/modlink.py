@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+"""Links and uploads firmware command modules (see Core/Inc/module.h).
+
+Build the module as a relocatable Thumb object, without PIC; calls to
+firmware functions are resolved against MODULE_EXPORTS in module_api.h
+(tools/modules/hello.c is an example):
+
+    arm-none-eabi-gcc -mcpu=cortex-m0plus -mthumb -Os -fno-common \\
+        -ffunction-sections -fdata-sections -DSTM32L073xx -DUSE_HAL_DRIVER \\
+        -Ibring_up_command/Core/Inc -Ibring_up_command/Drivers/... \\
+        -c tools/modules/hello.c -o hello.o
+    (several objects: arm-none-eabi-ld -r a.o b.o -o module.o)
+
+Link it into a module image, optionally uploading it right away:
+
+    modlink.py hello.o -o hello.bmod [--map]
+    modlink.py hello.o --port /dev/ttyACM0 [--baud 115200] [--replace]
+
+The upload switches the console to mux mode, sends the image on the data
+channel, and returns the port to the text console. With --replace, a
+loaded module of the same name is unloaded first (it must be the last one
+loaded).
+
+Calls from the module into the firmware (BL) go through small veneers
+added at the end of the code, so -mlong-calls is not needed.
+"""
+
+import argparse
+import os
+import re
+import select
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from vchan_demux import (CH_CONTROL, CTRL_EXIT, crc16_ccitt, decode_frame,  # noqa: E402
+                         encode_frame, open_serial, switch_to_mux)
+
+API_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                          "..", "bring_up_command", "Core", "Inc", "module_api.h")
+
+IMAGE_MAGIC = 0x444F4D42
+HEADER = struct.Struct("<IHHHHHH")
+DESCRIPTOR_SYMBOL = "module_descriptor"
+
+CH_CONSOLE = 0
+CH_DATA = 3
+MSG_BEGIN, MSG_DATA, MSG_END, MSG_ACK = 0x10, 0x11, 0x12, 0x13
+DATA_CHUNK = 56  # Mux payload is 64 bytes: message + offset + data
+RETURN_CODES = ["ok", "full", "empty", "invalid argument", "error"]
+
+# ELF constants
+SHT_SYMTAB, SHT_NOBITS, SHT_REL, SHT_RELA = 2, 8, 9, 4
+SHF_ALLOC = 0x2
+SHN_UNDEF, SHN_ABS = 0, 0xFFF1
+R_ARM_NONE, R_ARM_ABS32, R_ARM_REL32 = 0, 2, 3
+R_ARM_THM_CALL, R_ARM_THM_JUMP24, R_ARM_TARGET1, R_ARM_V4BX = 10, 30, 38, 40
+
+# push {r0, r1}; ldr r0, [pc, #4]; str r0, [sp, #4]; pop {r0, pc}; .word target
+VENEER = struct.pack("<HHHH", 0xB403, 0x4801, 0x9001, 0xBD01)
+VENEER_SIZE = len(VENEER) + 4
+
+
+class LinkError(Exception):
+    pass
+
+
+def read_exports(path):
+    with open(path) as f:
+        text = f.read()
+    return {name: int(index) for index, name in re.findall(r"X\((\d+),\s*(\w+)\)", text)}
+
+
+class ElfObject:
+    """Just enough of an ELF32 little-endian relocatable object."""
+
+    def __init__(self, data):
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise LinkError("not a 32-bit little-endian ELF file")
+        e_type, e_machine = struct.unpack_from("<HH", data, 16)
+        if e_type != 1 or e_machine != 40:
+            raise LinkError("not an ARM relocatable object (compile with -c)")
+        shoff, = struct.unpack_from("<I", data, 32)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 46)
+
+        self.data = data
+        self.sections = []
+        for i in range(shnum):
+            fields = struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+            self.sections.append(dict(zip(
+                ("name", "type", "flags", "addr", "offset", "size", "link", "info",
+                 "align", "entsize"), fields)))
+        names = self.sections[shstrndx]
+        for section in self.sections:
+            section["name"] = self.string(names, section["name"])
+
+        self.symbols = []
+        for section in self.sections:
+            if section["type"] == SHT_SYMTAB:
+                strtab = self.sections[section["link"]]
+                for k in range(section["size"] // 16):
+                    name, value, size, info, other, shndx = struct.unpack_from(
+                        "<IIIBBH", data, section["offset"] + k * 16)
+                    self.symbols.append({"name": self.string(strtab, name), "value": value,
+                                         "type": info & 0xF, "shndx": shndx})
+
+    def string(self, section, offset):
+        start = section["offset"] + offset
+        return self.data[start:self.data.index(b"\x00", start)].decode()
+
+    def contents(self, section):
+        return bytearray(self.data[section["offset"]:section["offset"] + section["size"]])
+
+    def relocations(self, section):
+        for k in range(section["size"] // 8):
+            offset, info = struct.unpack_from("<II", self.data, section["offset"] + k * 8)
+            yield offset, info & 0xFF, info >> 8
+
+
+def encode_thumb_branch(insn, offset, is_call):
+    """Patches the 32-bit BL / B.W pair with a new byte offset."""
+    if offset & 1 or not -(1 << 24) <= offset < (1 << 24):
+        raise LinkError("branch out of range")
+    s = (offset >> 24) & 1
+    i1 = (offset >> 23) & 1
+    i2 = (offset >> 22) & 1
+    j1 = (1 - i1) ^ s
+    j2 = (1 - i2) ^ s
+    upper = 0xF000 | (s << 10) | ((offset >> 12) & 0x3FF)
+    lower = (insn[1] & 0xD000) | (j1 << 13) | (j2 << 11) | ((offset >> 1) & 0x7FF)
+    if is_call:
+        lower |= 0x1000  # BL, not BLX
+    return upper, lower
+
+
+def decode_thumb_branch(upper, lower):
+    s = (upper >> 10) & 1
+    j1 = (lower >> 13) & 1
+    j2 = (lower >> 11) & 1
+    i1 = 1 - (j1 ^ s)
+    i2 = 1 - (j2 ^ s)
+    offset = (s << 24) | (i1 << 23) | (i2 << 22) | ((upper & 0x3FF) << 12) | ((lower & 0x7FF) << 1)
+    return offset - (1 << 25) if s else offset
+
+
+def link(obj, exports):
+    """Lays out the object at address 0 and resolves its relocations.
+
+    Returns (image bytes, bss size, relocs, imports, descriptor offset, layout).
+    """
+    alloc = [i for i, s in enumerate(obj.sections)
+             if s["flags"] & SHF_ALLOC and s["size"] and not s["name"].startswith(".ARM.exidx")]
+    progbits = [i for i in alloc if obj.sections[i]["type"] != SHT_NOBITS]
+    # Code first, then read-only and initialized data, zeroed data last
+    progbits.sort(key=lambda i: (not obj.sections[i]["name"].startswith(".text"), i))
+    nobits = [i for i in alloc if obj.sections[i]["type"] == SHT_NOBITS]
+
+    base = {}
+    address = 0
+    for index in progbits + nobits:
+        # Images are loaded 8-byte aligned; nothing in the ABI needs more
+        align = min(max(obj.sections[index]["align"], 1), 8)
+        address = (address + align - 1) & ~(align - 1)
+        base[index] = address
+        address += obj.sections[index]["size"]
+
+    # Veneers for branches to firmware functions go after the initialized part
+    progbits_end = max((base[i] + obj.sections[i]["size"] for i in progbits), default=0)
+    veneer_base = (progbits_end + 3) & ~3
+    veneers = {}
+    for section in obj.sections:
+        if section["type"] == SHT_REL and section["info"] in base:
+            for _, rtype, sym in obj.relocations(section):
+                symbol = obj.symbols[sym]
+                if rtype in (R_ARM_THM_CALL, R_ARM_THM_JUMP24) and symbol["shndx"] == SHN_UNDEF:
+                    veneers.setdefault(symbol["name"], veneer_base + len(veneers) * VENEER_SIZE)
+    veneer_end = veneer_base + len(veneers) * VENEER_SIZE
+
+    # Zeroed data moves up past the veneers
+    shift = (veneer_end - progbits_end + 7) & ~7 if veneers else 0
+    for index in nobits:
+        base[index] += shift
+    image_size = veneer_end if veneers else progbits_end
+    bss_end = max((base[i] + obj.sections[i]["size"] for i in nobits), default=image_size)
+    bss_size = max(bss_end - image_size, 0)
+
+    image = bytearray(image_size)
+    for index in progbits:
+        image[base[index]:base[index] + obj.sections[index]["size"]] = \
+            obj.contents(obj.sections[index])
+
+    relocs, imports = [], []
+
+    def import_index(name):
+        if name not in exports:
+            raise LinkError(f"'{name}' is not exported by the firmware (module_api.h)")
+        return exports[name]
+
+    for name, at in veneers.items():
+        image[at:at + len(VENEER)] = VENEER
+        imports.append((at + len(VENEER), import_index(name)))
+
+    def symbol_address(symbol):
+        if symbol["shndx"] == SHN_ABS:
+            return symbol["value"]
+        if symbol["shndx"] not in base:
+            raise LinkError(f"symbol '{symbol['name']}' is in a discarded section")
+        return base[symbol["shndx"]] + symbol["value"]
+
+    for section in obj.sections:
+        if section["type"] == SHT_RELA:
+            raise LinkError("RELA relocations are not supported")
+        if section["type"] != SHT_REL or section["info"] not in base:
+            continue
+        target = section["info"]
+        if obj.sections[target]["type"] == SHT_NOBITS:
+            raise LinkError("relocation in zeroed data")
+        for offset, rtype, sym in obj.relocations(section):
+            place = base[target] + offset
+            symbol = obj.symbols[sym]
+            undefined = symbol["shndx"] == SHN_UNDEF
+
+            if rtype in (R_ARM_NONE, R_ARM_V4BX):
+                continue
+            if rtype in (R_ARM_ABS32, R_ARM_TARGET1):
+                addend, = struct.unpack_from("<I", image, place)
+                if undefined:
+                    imports.append((place, import_index(symbol["name"])))
+                else:
+                    value = (symbol_address(symbol) + addend) & 0xFFFFFFFF
+                    struct.pack_into("<I", image, place, value)
+                    if symbol["shndx"] != SHN_ABS:
+                        relocs.append(place)
+            elif rtype == R_ARM_REL32:
+                if undefined:
+                    raise LinkError(f"PC-relative reference to '{symbol['name']}'")
+                addend, = struct.unpack_from("<i", image, place)
+                struct.pack_into("<I", image, place,
+                                 (symbol_address(symbol) + addend - place) & 0xFFFFFFFF)
+            elif rtype in (R_ARM_THM_CALL, R_ARM_THM_JUMP24):
+                upper, lower = struct.unpack_from("<HH", image, place)
+                addend = decode_thumb_branch(upper, lower)
+                if undefined:
+                    destination = veneers[symbol["name"]]
+                else:
+                    destination = symbol_address(symbol) & ~1
+                upper, lower = encode_thumb_branch((upper, lower),
+                                                   destination + addend - place,
+                                                   rtype == R_ARM_THM_CALL)
+                struct.pack_into("<HH", image, place, upper, lower)
+            else:
+                raise LinkError(f"unsupported relocation type {rtype} against "
+                                f"'{symbol['name']}' (build without -fpic)")
+
+    descriptor = [s for s in obj.symbols if s["name"] == DESCRIPTOR_SYMBOL and s["shndx"] != SHN_UNDEF]
+    if not descriptor:
+        raise LinkError(f"no '{DESCRIPTOR_SYMBOL}' (use MODULE_DESCRIPTOR())")
+    descriptor_at = symbol_address(descriptor[0])
+
+    if image_size > 0xFFFF or bss_size > 0xFFFF:
+        raise LinkError("module too large")
+    layout = {obj.sections[i]["name"]: (base[i], obj.sections[i]["size"]) for i in base}
+    if veneers:
+        layout["(veneers)"] = (veneer_base, veneer_end - veneer_base)
+    return bytes(image), bss_size, sorted(relocs), sorted(imports), descriptor_at, layout
+
+
+def module_name(image, relocs, descriptor_at):
+    """Reads the name string the descriptor points to."""
+    name_at, = struct.unpack_from("<I", image, descriptor_at + 4)
+    if descriptor_at + 4 not in relocs or name_at >= len(image):
+        return None
+    return image[name_at:image.index(b"\x00", name_at)].decode()
+
+
+def build_image(image, bss_size, relocs, imports, descriptor_at):
+    header = HEADER.pack(IMAGE_MAGIC, 1, len(image), bss_size, len(relocs),
+                         len(imports), descriptor_at)
+    tables = b"".join(struct.pack("<H", r) for r in relocs)
+    tables += b"".join(struct.pack("<HH", offset, index) for offset, index in imports)
+    return header + image + tables
+
+
+# -----------------------------------------------------------------------------
+# Upload over the mux data channel
+# -----------------------------------------------------------------------------
+class MuxLink:
+    def __init__(self, fd):
+        self.fd = fd
+        self.pending = bytearray()
+
+    def send(self, channel, payload):
+        os.write(self.fd, encode_frame(channel, payload))
+
+    def receive(self, channel, timeout=2.0):
+        deadline = time.monotonic() + timeout
+        while True:
+            while b"\x00" in self.pending:
+                encoded, _, rest = self.pending.partition(b"\x00")
+                self.pending = bytearray(rest)
+                frame = decode_frame(bytes(encoded)) if encoded else None
+                if frame and frame[0] == channel:
+                    return frame[1]
+            remaining = deadline - time.monotonic()
+            ready, _, _ = select.select([self.fd], [], [], max(remaining, 0))
+            if not ready:
+                raise RuntimeError("device did not answer")
+            self.pending += os.read(self.fd, 4096)
+
+    def request(self, message, payload):
+        self.send(CH_DATA, bytes([message]) + payload)
+        while True:
+            reply = self.receive(CH_DATA)
+            if len(reply) == 5 and reply[0] == MSG_ACK and reply[1] == message:
+                value, = struct.unpack_from("<H", reply, 3)
+                return reply[2], value
+
+
+def upload(fd, blob, name, replace):
+    link = MuxLink(fd)
+    switch_to_mux(fd)
+    try:
+        if replace and name:
+            link.send(CH_CONSOLE, f"module unload {name}\r".encode())
+            time.sleep(0.2)
+
+        rc, _ = link.request(MSG_BEGIN, struct.pack("<H", len(blob)))
+        if rc != 0:
+            raise RuntimeError(f"begin refused: {RETURN_CODES[rc]}")
+        offset = 0
+        while offset < len(blob):
+            chunk = blob[offset:offset + DATA_CHUNK]
+            rc, expected = link.request(MSG_DATA, struct.pack("<H", offset) + chunk)
+            if rc not in (0, 3):
+                raise RuntimeError(f"data refused at {offset}: {RETURN_CODES[rc]}")
+            offset = expected  # Device tells where to continue
+        rc, commands = link.request(MSG_END, struct.pack("<H", crc16_ccitt(blob)))
+        if rc != 0:
+            raise RuntimeError(f"link failed: {RETURN_CODES[rc]}")
+        print(f"loaded '{name}', {commands} commands", file=sys.stderr)
+    finally:
+        link.send(CH_CONTROL, bytes([CTRL_EXIT]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("object", help="relocatable module object (.o)")
+    parser.add_argument("-o", "--output", help="write the module image to a file")
+    parser.add_argument("--map", action="store_true", help="print the section layout")
+    parser.add_argument("--api", default=API_HEADER, help="path to module_api.h")
+    parser.add_argument("--port", help="upload over this serial console")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--replace", action="store_true",
+                        help="unload a module of the same name first")
+    args = parser.parse_args()
+
+    with open(args.object, "rb") as f:
+        obj = ElfObject(f.read())
+    try:
+        image, bss_size, relocs, imports, descriptor_at, layout = link(obj, read_exports(args.api))
+    except LinkError as error:
+        sys.exit(f"{args.object}: {error}")
+    blob = build_image(image, bss_size, relocs, imports, descriptor_at)
+    name = module_name(image, relocs, descriptor_at)
+
+    print(f"module '{name}': {len(image)} bytes + {bss_size} zeroed, {len(relocs)} relocs, "
+          f"{len(imports)} imports, file {len(blob)} bytes", file=sys.stderr)
+    if args.map:
+        for section, (address, size) in sorted(layout.items(), key=lambda item: item[1]):
+            print(f"  0x{address:04x} {size:6d}  {section}")
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+    if args.port:
+        fd = open_serial(args.port, args.baud)
+        upload(fd, blob, name, args.replace)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
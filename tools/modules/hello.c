@@ -0,0 +1,44 @@
+// hello.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Example command module (see Core/Inc/module_api.h). Build and load it
+// from the repository root with the commands in tools/modlink.py.
+
+#include "module_api.h"
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t calls;
+
+/**
+ * @brief Command: Greet and count invocations.
+ */
+static void CmdHello(Console* console, int argc, char* argv[]) {
+  char buffer[48];
+
+  calls++;
+  snprintf(buffer, sizeof(buffer), "Hello from a module (%lu)\r\n", (unsigned long)calls);
+  ConsolePrint(console, buffer);
+}
+
+/**
+ * @brief Command: Blink LD2 a number of times.
+ */
+static void CmdBlink(Console* console, int argc, char* argv[]) {
+  long count = (argc > 1) ? strtol(argv[1], NULL, 0) : 3;
+
+  for (long i = 0; i < count * 2; ++i) {
+    HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
+    HAL_Delay(100);
+  }
+  console->result = (int32_t)count;
+}
+
+static const Command kHelloCommands[] = {
+    {"hello",    CmdHello,   "Say hello (loaded module)."},
+    {"blink",    CmdBlink,   "blink [n]: blink LD2 n times (loaded module)."},
+};
+
+MODULE_DESCRIPTOR("hello", kHelloCommands, NULL);
@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""Flat profile of the firmware from the board's PC sampler (see Core/Inc/profiler.h).
+
+    pcprofile.py /dev/ttyACM0 build/bring_up_command.elf --seconds 10 --rate 2000
+    pcprofile.py /dev/ttyACM0 build/bring_up_command.elf          (dump what was sampled)
+    pcprofile.py --load profile.bin build/bring_up_command.elf
+
+With --seconds the counts are cleared, sampling runs for that long and
+the table is dumped; without it the board's current table is dumped
+(`profile start` on the console beforehand, run the load, then this).
+The table streams on the mux data channel as a dump (tools/dump.py) and
+is kept with --save for later runs with --load.
+
+Each sampled address is charged to the function symbol of the ELF that
+contains it; addresses outside every function (RAM modules, the VM) are
+listed as such. --addresses prints the hottest addresses as well.
+"""
+
+import argparse
+import bisect
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from dump import FLAG_LZ, RETURN_CODES, lz_decompress, receive_dump  # noqa: E402
+from modlink import CH_CONSOLE, MuxLink  # noqa: E402
+from vchan_demux import (BAUD_RATES, CH_CONTROL, CTRL_EXIT, crc16_ccitt,  # noqa: E402
+                         open_serial, switch_to_mux)
+
+PROFILER_TAG = 0x464F5250
+HEADER = struct.Struct("<6I")  # samples, dropped, rate_hz, buckets, shift, granule
+ENTRY = struct.Struct("<IH")
+SHT_SYMTAB = 2
+STT_FUNC = 2
+STB_WEAK = 2
+
+
+def elf_functions(path):
+    """Returns the function symbols of a linked ELF as a sorted list of
+    (start, end, name). Of several names for one address, a weak one (the
+    startup code's handler aliases) gives way to the others."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError(f"{path}: not a 32-bit little-endian ELF file")
+    shoff, = struct.unpack_from("<I", data, 32)
+    shentsize, shnum = struct.unpack_from("<HH", data, 46)
+    sections = [struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+                for i in range(shnum)]
+    functions = {}
+    for _, sh_type, _, _, offset, size, link, _, _, _ in sections:
+        if sh_type != SHT_SYMTAB:
+            continue
+        strtab = sections[link][4]
+        for k in range(size // 16):
+            name, value, sym_size, info, _, shndx = struct.unpack_from(
+                "<IIIBBH", data, offset + k * 16)
+            if info & 0xF != STT_FUNC or shndx == 0:
+                continue
+            start = value & ~1  # Thumb bit
+            weak = info >> 4 == STB_WEAK
+            if start in functions and (weak or not functions[start][3]):
+                continue
+            end = data.index(b"\x00", strtab + name)
+            functions[start] = (start, start + max(sym_size, 2),
+                                data[strtab + name:end].decode(), weak)
+    if not functions:
+        raise ValueError(f"{path}: no function symbols (stripped?)")
+    return sorted(entry[:3] for entry in functions.values())
+
+
+def parse_table(data):
+    """Returns (header dict, {address: estimated samples})."""
+    samples, dropped, rate_hz, buckets, shift, granule = HEADER.unpack_from(data)
+    if len(data) != HEADER.size + buckets * ENTRY.size:
+        raise ValueError(f"{len(data)} bytes for {buckets} buckets")
+    counts = {}
+    for k in range(buckets):
+        pc, count = ENTRY.unpack_from(data, HEADER.size + k * ENTRY.size)
+        if pc != 0 and count != 0:
+            counts[pc] = count << shift
+    header = dict(samples=samples, dropped=dropped, rate_hz=rate_hz, buckets=buckets,
+                  shift=shift, granule=granule)
+    return header, counts
+
+
+def symbolize(counts, functions):
+    """Charges each address to its function: {name: samples}."""
+    starts = [start for start, _, _ in functions]
+    flat = {}
+    for pc, count in counts.items():
+        i = bisect.bisect_right(starts, pc) - 1
+        if i >= 0 and pc < functions[i][1]:
+            name = functions[i][2]
+        elif 0x20000000 <= pc < 0x20005000:
+            name = "(RAM code)"
+        else:
+            name = "(unknown)"
+        flat[name] = flat.get(name, 0) + count
+    return flat
+
+
+def read_board(args):
+    fd = open_serial(args.port, args.baud)
+    link = MuxLink(fd)
+    switch_to_mux(fd)
+    try:
+        if args.seconds:
+            link.send(CH_CONSOLE, b"profile reset\r")
+            link.send(CH_CONSOLE, f"profile start {args.rate}\r".encode())
+            time.sleep(args.seconds)
+        link.send(CH_CONSOLE, b"profile dump\r")
+        flags, tag, _, stream, rc, crc = receive_dump(link, args.timeout)
+    finally:
+        link.send(CH_CONTROL, bytes([CTRL_EXIT]))
+    if tag != PROFILER_TAG:
+        raise RuntimeError(f"stream tag {tag:#x} is not a profile")
+    data = lz_decompress(stream) if flags & FLAG_LZ else stream
+    if rc != 0:
+        raise RuntimeError(f"board ended the dump: {RETURN_CODES[rc]}")
+    if crc16_ccitt(data) != crc:
+        raise RuntimeError("CRC mismatch")
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?")
+    parser.add_argument("elf")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--seconds", type=float, help="clear, sample this long, then dump")
+    parser.add_argument("--rate", type=int, default=1000, help="samples per second")
+    parser.add_argument("--timeout", type=float, default=5.0, help="seconds without data")
+    parser.add_argument("--save", metavar="FILE", help="keep the raw table")
+    parser.add_argument("--load", metavar="FILE", help="use a saved table, not the board")
+    parser.add_argument("--top", type=int, default=30, help="functions to list")
+    parser.add_argument("--addresses", type=int, default=0, metavar="N",
+                        help="also list the N hottest addresses")
+    args = parser.parse_args()
+    if args.load is None and args.port is None:
+        parser.error("give the port, or --load")
+
+    try:
+        functions = elf_functions(args.elf)
+        if args.load:
+            with open(args.load, "rb") as f:
+                data = f.read()
+        else:
+            data = read_board(args)
+        header, counts = parse_table(data)
+    except (OSError, RuntimeError, ValueError) as error:
+        print(error, file=sys.stderr)
+        return 1
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+
+    recorded = sum(counts.values())
+    seconds = header["samples"] / header["rate_hz"] if header["rate_hz"] else 0.0
+    print(f"{header['samples']} samples at {header['rate_hz']} Hz ({seconds:.1f} s), "
+          f"{header['dropped']} dropped, {len(counts)}/{header['buckets']} buckets, "
+          f"{header['granule']}-byte granules")
+    if header["dropped"] > header["samples"] // 100:
+        print("  many samples dropped: build with a larger PROFILER_BUCKETS or PROFILER_GRANULE")
+    if not recorded:
+        return 0
+
+    flat = sorted(symbolize(counts, functions).items(), key=lambda item: -item[1])
+    print(f"\n{'samples':>9} {'%':>6} {'cum %':>6}  function")
+    cumulative = 0
+    for name, count in flat[:args.top]:
+        cumulative += count
+        print(f"{count:9} {100.0 * count / recorded:6.2f} {100.0 * cumulative / recorded:6.2f}  {name}")
+    if len(flat) > args.top:
+        print(f"{'':9} {'':6} {'':6}  ... {len(flat) - args.top} more")
+
+    if args.addresses:
+        print(f"\n{'samples':>9} {'%':>6}  address")
+        starts = [start for start, _, _ in functions]
+        for pc, count in sorted(counts.items(), key=lambda item: -item[1])[:args.addresses]:
+            i = bisect.bisect_right(starts, pc) - 1
+            where = (f"{functions[i][2]}+{pc - functions[i][0]:#x}"
+                     if i >= 0 and pc < functions[i][1] else "")
+            print(f"{count:9} {100.0 * count / recorded:6.2f}  {pc:#010x} {where}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
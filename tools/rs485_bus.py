@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Runs console commands on boards sharing one RS-485 bus (see Core/Inc/rs485.h).
+
+Every board in bus mode mutes its receiver until it sees its own address
+mark (0x80 | address); this tool sends the mark, then the command line,
+and collects the reply until the bus has been quiet for --quiet ms:
+
+    rs485_bus.py /dev/ttyUSB0 --addr 12 version
+    rs485_bus.py /dev/ttyUSB0 --addr 12 --addr 13 "gpio a5"
+    rs485_bus.py /dev/ttyUSB0 --scan              (lists responding addresses)
+
+The USB-RS485 adapter must switch its own driver automatically (most do).
+"""
+
+import argparse
+import os
+import select
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from vchan_demux import BAUD_RATES, open_serial  # noqa: E402
+
+MAX_ADDRESS = 0x7F
+
+
+def transact(fd, address, line, quiet_s, timeout_s):
+    """Addresses a board and returns its reply to one command line."""
+    os.write(fd, bytes([0x80 | address]) + line.encode() + b"\r")
+    reply = b""
+    deadline = time.monotonic() + timeout_s
+    while True:
+        wait = quiet_s if reply else max(deadline - time.monotonic(), 0)
+        ready, _, _ = select.select([fd], [], [], wait)
+        if not ready:
+            break
+        reply += os.read(fd, 1024)
+    # The board echoes the line before its output
+    text = reply.decode(errors="replace")
+    echo = line + "\r\n"
+    return text[len(echo):] if text.startswith(echo) else text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("command", nargs="?", default="version")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--addr", type=lambda v: int(v, 0), action="append", default=[],
+                        help="board address (repeat for several boards)")
+    parser.add_argument("--scan", action="store_true", help="probe every address")
+    parser.add_argument("--quiet", type=int, default=30, help="end of reply silence, ms")
+    parser.add_argument("--timeout", type=int, default=200, help="reply timeout, ms")
+    args = parser.parse_args()
+
+    addresses = range(MAX_ADDRESS + 1) if args.scan else args.addr
+    if not addresses:
+        parser.error("give --addr or --scan")
+    if any(not 0 <= a <= MAX_ADDRESS for a in addresses):
+        parser.error(f"addresses are 0..{MAX_ADDRESS}")
+
+    fd = open_serial(args.port, args.baud)
+    failures = 0
+    for address in addresses:
+        reply = transact(fd, address, args.command, args.quiet / 1000.0, args.timeout / 1000.0)
+        if not reply:
+            if not args.scan:
+                print(f"[{address}] no reply")
+                failures += 1
+            continue
+        for text in reply.splitlines():
+            print(f"[{address}] {text}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,219 @@
+// spi_master_sim.c
+// Created on: Oct 18, 2025
+// Author: Rodrigo Che
+//
+// Host-side simulation of the SPI master for the SPI console transport.
+//
+// The device half (ring_buffer.c, console.c, spi_link.c) is compiled natively
+// and driven exactly as the SPI1/DMA glue drives it on the target: one
+// SpiLinkComplete()/SpiLinkPrepare() pair per transaction. The simulated
+// master follows the protocol in spi_link.h (credit-limited writes, polling
+// while SPI_LINK_FLAG_MORE is set) and reports the payload throughput the
+// link would reach at the given SCK frequency and inter-frame gap. A
+// small command set replaces the firmware command table:
+//
+//   echo <text>   reply with <text>
+//   dump <n>      stream n bytes of a counting pattern (checked by the master)
+//
+// Build and run from the repository root:
+//
+//   gcc -O2 -Ibring_up_command/Core/Inc -o spi_master_sim tools/spi_master_sim.c
+//       bring_up_command/Core/Src/ring_buffer.c bring_up_command/Core/Src/record_queue.c
+//       bring_up_command/Core/Src/console.c bring_up_command/Core/Src/fastmem.c
+//       bring_up_command/Core/Src/spi_link.c
+//   ./spi_master_sim --sck 8000000 --gap-us 5 --short-every 50 "echo hi" "dump 100000"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "spi_link.h"
+
+static SpiLink link;
+
+static struct {
+  double sck_hz;
+  double gap_us;
+  unsigned short_every;       // Inject a short transaction every N frames (0 = never)
+  const char* pending;        // Host input not yet sent
+  size_t pending_len;
+  unsigned long transactions;
+  unsigned long short_transactions;
+  unsigned long payload_in;   // Device to host payload bytes
+  unsigned long payload_out;  // Host to device payload bytes
+  unsigned long dropped;      // Frames flagged SPI_LINK_FLAG_DROPPED
+  uint8_t more;               // Device reported more output
+  // dump pattern checking, in device output byte offsets
+  unsigned long host_total;   // Device output bytes received so far
+  unsigned long dump_start;
+  unsigned long dump_expected;
+  unsigned long dump_seen;
+  unsigned long dump_errors;
+  int quiet;
+} sim;
+
+// -----------------------------------------------------------------------------
+// Simulated master
+// -----------------------------------------------------------------------------
+static void HostConsume(const uint8_t* data, uint16_t len) {
+  for (uint16_t i = 0; i < len; ++i, ++sim.host_total) {
+    if ((sim.host_total >= sim.dump_start) && (sim.dump_seen < sim.dump_expected)) {
+      if (data[i] != (uint8_t)sim.dump_seen) {
+        sim.dump_errors++;
+      }
+      sim.dump_seen++;
+    } else if (!sim.quiet) {
+      putchar(data[i]);
+    }
+  }
+}
+
+/**
+ * @brief Runs one full-duplex transaction, as SPI1 + DMA would on target.
+ */
+static void MasterTransaction(void) {
+  uint8_t host_frame[SPI_LINK_FRAME_SIZE] = {0};
+  uint8_t device_frame[SPI_LINK_FRAME_SIZE];
+
+  // Device frame was prepared at the end of the previous transaction
+  memcpy(device_frame, link.tx_frame, sizeof(device_frame));
+
+  // The host only knows the credit from the previous device frame, which
+  // is what tx_frame carries right now
+  uint16_t credit = device_frame[3];
+  uint16_t len = (sim.pending_len < credit) ? (uint16_t)sim.pending_len : credit;
+  host_frame[0] = SPI_LINK_MAGIC;
+  host_frame[2] = (uint8_t)len;
+  memcpy(&host_frame[SPI_LINK_HEADER_SIZE], sim.pending, len);
+
+  uint16_t clocked = SPI_LINK_FRAME_SIZE;
+  sim.transactions++;
+  if (sim.short_every && (sim.transactions % sim.short_every) == 0) {
+    clocked = (uint16_t)(rand() % SPI_LINK_FRAME_SIZE);
+    sim.short_transactions++;
+  }
+
+  memcpy(link.rx_frame, host_frame, clocked);
+  SpiLinkComplete(&link, clocked);
+  if (clocked != SPI_LINK_FRAME_SIZE) {
+    return;  // Master discards the partial frame and retries
+  }
+  SpiLinkPrepare(&link);
+
+  sim.pending += len;
+  sim.pending_len -= len;
+  sim.payload_out += len;
+
+  if (device_frame[0] == SPI_LINK_MAGIC) {
+    uint16_t in_len = device_frame[2];
+    sim.more = (device_frame[1] & SPI_LINK_FLAG_MORE) ? 1 : 0;
+    if (device_frame[1] & SPI_LINK_FLAG_DROPPED) {
+      sim.dropped++;
+    }
+    HostConsume(&device_frame[SPI_LINK_HEADER_SIZE], in_len);
+    sim.payload_in += in_len;
+  }
+}
+
+/**
+ * @brief Device back-pressure hook: on the target the master keeps polling
+ * asynchronously; here the poll runs inline.
+ */
+static uint8_t SimWait(SpiLink* l) {
+  MasterTransaction();
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Device-side command stub (replaces command.c)
+// -----------------------------------------------------------------------------
+ReturnCode CommandParserProcess(Console* console, const uint8_t* command_string) {
+  const char* cmd = (const char*)command_string;
+
+  if (strncmp(cmd, "echo ", 5) == 0) {
+    ConsolePrint(console, cmd + 5);
+    ConsolePrint(console, "\r\n");
+  } else if (strncmp(cmd, "dump ", 5) == 0) {
+    unsigned long n = strtoul(cmd + 5, NULL, 0);
+    uint8_t block[64];
+    uint16_t queued = 0;
+
+    // Output already produced (the echoed command line) comes first
+    RingBufferCurrentItems(&link.tx, &queued);
+    sim.dump_start = sim.host_total + queued + link.tx_frame[2];
+    sim.dump_expected = sim.dump_seen + n;
+    for (unsigned long i = 0; i < n; i += sizeof(block)) {
+      uint16_t chunk = (n - i < sizeof(block)) ? (uint16_t)(n - i) : sizeof(block);
+      for (uint16_t k = 0; k < chunk; ++k) {
+        block[k] = (uint8_t)(sim.dump_expected - n + i + k);
+      }
+      ConsoleWrite(console, block, chunk);
+    }
+  } else {
+    ConsolePrint(console, "Unrecognized command.\r\n");
+    return kInvalidArgument;
+  }
+  return kOk;
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+static void RunCommand(const char* command) {
+  static char line[CONSOLE_LINE_SIZE + 2];
+
+  snprintf(line, sizeof(line), "%s\r", command);
+  sim.pending = line;
+  sim.pending_len = strlen(line);
+
+  // Poll until the command is delivered, executed and fully drained
+  do {
+    MasterTransaction();
+    ConsoleProcess(&link.console);
+  } while (sim.pending_len > 0 || sim.more ||
+           RingBufferIsEmpty(&link.console.rx) != kEmpty ||
+           RingBufferIsEmpty(&link.tx) != kEmpty);
+  MasterTransaction();  // Collect the frame prepared last
+}
+
+int main(int argc, char** argv) {
+  sim.sck_hz = 8e6;
+  sim.gap_us = 5.0;
+
+  int first_command = argc;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--sck") == 0 && i + 1 < argc) {
+      sim.sck_hz = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--gap-us") == 0 && i + 1 < argc) {
+      sim.gap_us = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--short-every") == 0 && i + 1 < argc) {
+      sim.short_every = (unsigned)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      sim.quiet = 1;
+    } else {
+      first_command = i;
+      break;
+    }
+  }
+
+  SpiLinkInit(&link, "spi-sim", SimWait);
+  for (int i = first_command; i < argc; ++i) {
+    RunCommand(argv[i]);
+  }
+
+  double frame_s = (SPI_LINK_FRAME_SIZE * 8.0) / sim.sck_hz + sim.gap_us * 1e-6;
+  double elapsed_s = sim.transactions * frame_s;
+  double mbps = elapsed_s > 0 ? (sim.payload_in * 8.0) / elapsed_s / 1e6 : 0.0;
+
+  fprintf(stderr,
+          "\ntransactions %lu (short %lu, device bad %lu), dropped flags %lu\n"
+          "payload device->host %lu B, host->device %lu B\n"
+          "dump bytes checked %lu, errors %lu\n"
+          "modeled time %.3f ms at %.2f MHz SCK, %.1f us gap -> %.2f Mbit/s payload\n",
+          sim.transactions, sim.short_transactions, (unsigned long)link.bad_frames,
+          sim.dropped, sim.payload_in, sim.payload_out, sim.dump_seen,
+          sim.dump_errors, elapsed_s * 1e3, sim.sck_hz / 1e6, sim.gap_us, mbps);
+
+  return (sim.dump_errors == 0 && sim.dump_seen == sim.dump_expected) ? 0 : 1;
+}
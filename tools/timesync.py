@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Synchronizes boards to the host clock and merges their traces
+(see Core/Inc/timesync.h and Core/Inc/trace.h).
+
+sync: every --period seconds, sends each board the host time (us since the
+epoch) with the `time` command:
+
+    timesync.py sync /dev/ttyACM0 /tmp/board1/console
+    timesync.py sync --pulse /dev/ttyUSB0 /tmp/board0/console /tmp/board1/console
+
+Without --pulse the host time rides on the command itself (`time sync`),
+stamped for when its last byte reaches the board; USB scheduling limits
+this to about a millisecond. With --pulse, the RTS line of that adapter is
+wired to the sync input of every board: the tool toggles it, stamps the
+edge and then sends `time pulse` with that time, and each board pairs it
+with its own hardware capture of the edge. The residual the boards report
+(`time`) shows what the host side achieves; drivers that defer the modem
+control request add their latency to every board alike, so the boards
+stay aligned with each other even then.
+
+Ports may be serial devices or the console PTYs of vchan_demux.py.
+
+merge: combines the log and trace streams saved from several boards (for
+instance `cat /tmp/board0/log > board0.log` while vchan_demux.py runs)
+into one timeline, in microseconds:
+
+    timesync.py merge b0=board0.log b1=board1.log --trace b0=board0.trc
+
+Log lines are "<seconds.micros> <text>"; trace records are 14 bytes,
+int64 time_us | uint16 id | uint32 value, little endian.
+"""
+
+import argparse
+import fcntl
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from vchan_demux import BAUD_RATES, open_serial  # noqa: E402
+
+TRACE_RECORD = struct.Struct("<qHI")
+TRACE_IDS = {1: "sync", 2: "command"}  # TRACE_ID_...
+
+
+def now_us():
+    return time.time_ns() // 1000
+
+
+def drain(fd, quiet_s=0.05):
+    """Reads and returns whatever the board sends until it goes quiet."""
+    data = b""
+    while True:
+        ready, _, _ = select.select([fd], [], [], quiet_s)
+        if not ready:
+            return data
+        data += os.read(fd, 1024)
+
+
+def set_rts(fd, on):
+    request = termios.TIOCMBIS if on else termios.TIOCMBIC
+    fcntl.ioctl(fd, request, struct.pack("I", termios.TIOCM_RTS))
+
+
+def pulse(fd, edge):
+    """Makes one edge on RTS and returns its host time. TTL adapters drive
+    the pin low while RTS is asserted, so the rising edge is the deassert."""
+    set_rts(fd, edge != "deassert")
+    time.sleep(0.01)
+    before = now_us()
+    set_rts(fd, edge == "deassert")
+    after = now_us()
+    return (before + after) // 2
+
+
+def run_sync(args):
+    boards = [open_serial(path, args.baud) for path in args.port]
+    pulser = open_serial(args.pulse, args.baud) if args.pulse else None
+    byte_us = 10 * 1000000 // args.baud
+
+    for fd in boards:
+        os.write(fd, b"\rtime reset\r")
+    time.sleep(0.1)
+    for fd in boards:
+        drain(fd)
+
+    count = 0
+    while args.count == 0 or count < args.count:
+        if pulser is not None:
+            edge = pulse(pulser, args.edge)
+            for fd in boards:
+                os.write(fd, f"time pulse {edge}\r".encode())
+        else:
+            for fd in boards:
+                # The board stamps the line when its last byte arrives
+                length = len(f"time sync {now_us()}\r")
+                os.write(fd, f"time sync {now_us() + length * byte_us}\r".encode())
+        count += 1
+        time.sleep(0.05)
+        for path, fd in zip(args.port, boards):
+            reply = drain(fd).decode(errors="replace")
+            status = [l for l in reply.splitlines() if l.startswith(("offset", "No recent"))]
+            if args.verbose and status:
+                print(f"{path}: {status[-1]}")
+        time.sleep(max(args.period - 0.05, 0))
+    return 0
+
+
+def parse_source(text):
+    name, sep, path = text.partition("=")
+    if not sep:
+        raise argparse.ArgumentTypeError(f"expected NAME=PATH, got {text!r}")
+    return name, path
+
+
+def parse_seconds(token):
+    """'1760781234.123456' -> microseconds, exactly."""
+    sign = -1 if token.startswith("-") else 1
+    whole, _, frac = token.lstrip("-").partition(".")
+    return sign * (int(whole) * 1000000 + int((frac + "000000")[:6]))
+
+
+def read_log(name, path):
+    events = []
+    with open(path, errors="replace") as log:
+        for line in log:
+            stamp, _, text = line.rstrip("\r\n").partition(" ")
+            try:
+                events.append((parse_seconds(stamp), name, text))
+            except ValueError:
+                continue  # Partial line at the start of a capture
+    return events
+
+
+def read_trace(name, path):
+    with open(path, "rb") as trace:
+        data = trace.read()
+    events = []
+    for offset in range(0, len(data) - TRACE_RECORD.size + 1, TRACE_RECORD.size):
+        stamp, ident, value = TRACE_RECORD.unpack_from(data, offset)
+        label = TRACE_IDS.get(ident, f"id {ident}")
+        events.append((stamp, name, f"[trace] {label} {value}"))
+    return events
+
+
+def format_us(us):
+    sign = "-" if us < 0 else ""
+    return f"{sign}{abs(us) // 1000000}.{abs(us) % 1000000:06d}"
+
+
+def run_merge(args):
+    events = []
+    for name, path in args.log:
+        events += read_log(name, path)
+    for name, path in args.trace:
+        events += read_trace(name, path)
+    events.sort(key=lambda event: event[0])
+    if not events:
+        return 1
+
+    origin = events[0][0] if args.relative else 0
+    width = max(len(name) for _, name, _ in events)
+    last = None
+    for stamp, name, text in events:
+        delta = "" if last is None else f" (+{stamp - last} us)"
+        print(f"{format_us(stamp - origin)} {name:<{width}} {text}{delta if args.deltas else ''}")
+        last = stamp
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    sync = commands.add_parser("sync", help="send the host time to boards")
+    sync.add_argument("port", nargs="+")
+    sync.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    sync.add_argument("--pulse", help="adapter whose RTS drives the sync wire")
+    sync.add_argument("--edge", default="deassert", choices=["assert", "deassert"],
+                      help="RTS change that makes the rising edge on the wire")
+    sync.add_argument("--period", type=float, default=1.0, help="seconds between syncs")
+    sync.add_argument("--count", type=int, default=0, help="syncs to send, 0 for ever")
+    sync.add_argument("-v", "--verbose", action="store_true", help="print each board's fit")
+
+    merge = commands.add_parser("merge", help="merge saved log/trace streams")
+    merge.add_argument("log", nargs="*", type=parse_source, help="NAME=PATH log capture")
+    merge.add_argument("--trace", type=parse_source, action="append", default=[],
+                       help="NAME=PATH trace capture")
+    merge.add_argument("--relative", action="store_true", help="times from the first event")
+    merge.add_argument("--deltas", action="store_true", help="show time since previous event")
+
+    args = parser.parse_args()
+    return run_sync(args) if args.command == "sync" else run_merge(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Host demultiplexer for the firmware's virtual channel mode.
+
+Opens the board's serial port, switches the console to multiplexed mode
+with the `mux` command and exposes every logical channel as its own PTY:
+
+    console  <->  channel 0 (commands and responses, bidirectional)
+    log       <-  channel 1
+    trace     <-  channel 2
+    data      <-  channel 3
+
+Frame format (see Core/Inc/mux.h):
+
+    COBS( channel | payload | crc16_le ) 0x00
+
+crc16 is CRC-16/CCITT-FALSE over channel and payload. On exit the device is
+sent MUX_CTRL_EXIT so the port returns to the plain text console.
+
+Usage:
+    vchan_demux.py /dev/ttyACM0 [--baud 115200] [--link-dir /tmp/board0]
+
+With --link-dir, symlinks named after the channels are created there so
+scripts can open stable paths.
+"""
+
+import argparse
+import os
+import select
+import signal
+import sys
+import termios
+import tty
+
+MAX_PAYLOAD = 64
+CH_CONTROL = 0xFF
+CTRL_EXIT = 0x00
+CHANNELS = {0: "console", 1: "log", 2: "trace", 3: "data"}
+
+BAUD_RATES = {
+    9600: termios.B9600,
+    19200: termios.B19200,
+    38400: termios.B38400,
+    57600: termios.B57600,
+    115200: termios.B115200,
+    230400: termios.B230400,
+    460800: getattr(termios, "B460800", termios.B230400),
+    921600: getattr(termios, "B921600", termios.B230400),
+}
+# Rates above 921600 (for linktest.py) where the platform has them
+for _rate in (1000000, 1500000, 2000000, 2500000, 3000000, 3500000, 4000000):
+    if hasattr(termios, f"B{_rate}"):
+        BAUD_RATES[_rate] = getattr(termios, f"B{_rate}")
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray(b"\x00")
+    code_pos, code = 0, 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos, code = len(out), 1
+                out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(channel, payload):
+    raw = bytes([channel]) + payload
+    crc = crc16_ccitt(raw)
+    return cobs_encode(raw + bytes([crc & 0xFF, crc >> 8])) + b"\x00"
+
+
+def decode_frame(encoded):
+    raw = cobs_decode(encoded)
+    if raw is None or len(raw) < 3:
+        return None
+    crc = raw[-2] | (raw[-1] << 8)
+    if crc16_ccitt(raw[:-2]) != crc:
+        return None
+    return raw[0], raw[1:-2]
+
+
+def open_serial(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    speed = BAUD_RATES[baud]
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def switch_to_mux(fd):
+    """Sends `mux` and waits for the acknowledgement line."""
+    os.write(fd, b"\r\nmux\r")
+    seen = b""
+    while b"MUX ON\r\n" not in seen:
+        ready, _, _ = select.select([fd], [], [], 2.0)
+        if not ready:
+            raise RuntimeError("no 'MUX ON' acknowledgement from device")
+        seen = (seen + os.read(fd, 256))[-64:]
+        if b"Mux already active" in seen:
+            break
+    # Leading delimiter resynchronizes the device-side decoder
+    os.write(fd, b"\x00")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--link-dir", help="directory for per-channel symlinks")
+    args = parser.parse_args()
+
+    serial_fd = open_serial(args.port, args.baud)
+    switch_to_mux(serial_fd)
+
+    ptys = {}
+    for channel, name in CHANNELS.items():
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        ptys[channel] = (master, slave, name)
+        slave_name = os.ttyname(slave)
+        if args.link_dir:
+            os.makedirs(args.link_dir, exist_ok=True)
+            link = os.path.join(args.link_dir, name)
+            if os.path.lexists(link):
+                os.unlink(link)
+            os.symlink(slave_name, link)
+        print(f"{name:8s} {slave_name}", flush=True)
+
+    masters = {master: channel for channel, (master, _, _) in ptys.items()}
+    running = [True]
+    signal.signal(signal.SIGTERM, lambda *_: running.__setitem__(0, False))
+
+    pending = bytearray()
+    try:
+        while running[0]:
+            ready, _, _ = select.select([serial_fd] + list(masters), [], [], 0.5)
+            for fd in ready:
+                if fd == serial_fd:
+                    pending += os.read(serial_fd, 4096)
+                    while b"\x00" in pending:
+                        encoded, _, rest = pending.partition(b"\x00")
+                        pending = bytearray(rest)
+                        frame = decode_frame(bytes(encoded)) if encoded else None
+                        if frame and frame[0] in ptys:
+                            os.write(ptys[frame[0]][0], frame[1])
+                else:
+                    try:
+                        data = os.read(fd, MAX_PAYLOAD)
+                    except OSError:
+                        continue  # No client attached to this PTY yet
+                    channel = masters[fd]
+                    if channel == 0:
+                        # Only the console channel accepts host input
+                        os.write(serial_fd, encode_frame(channel, data))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.write(serial_fd, encode_frame(CH_CONTROL, bytes([CTRL_EXIT])))
+        termios.tcdrain(serial_fd)
+        if args.link_dir:
+            for _, _, name in ptys.values():
+                link = os.path.join(args.link_dir, name)
+                if os.path.islink(link):
+                    os.unlink(link)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
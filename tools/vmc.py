@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+"""Compiler and uploader for the firmware's script VM (Core/Inc/vm.h).
+
+Scripts use a small Forth-like, postfix language:
+
+    \\ comment to end of line       ( inline comment )
+    123  -7  0x40  'A'             push a constant
+    + - * / mod negate             arithmetic
+    and or xor not lshift rshift   bitwise (not is logical)
+    = <> < <= > >=                 comparisons (1 or 0)
+    dup drop swap over             stack
+    var x                          declare a variable (up to 8, see below)
+    x        5 to x                read / write a variable
+    if ... [else ...] then
+    begin ... until                repeat until the popped value is non-zero
+    begin ... while ... repeat
+    begin ... again
+    n times ... loop               run the body n times; `i` is the index
+    ms  ticks                      wait n ms / push the millisecond tick
+    run" gpio a5 %"                run a console command, each % takes a
+                                   value from the stack; pushes its result
+    .  emit  cr  ." text"          print number / char / newline / string
+    halt
+
+Each `times` loop uses two of the eight variables while it is open.
+
+Example, sweep LD2 and read it back:
+
+    4 times
+      i 1 and run" gpio a5 %" drop
+      ." PA5 -> " run" gpio a5" . cr
+      250 ms
+    loop
+
+Usage:
+    vmc.py script.vms [-o script.bin] [--list]
+    vmc.py script.vms --port /dev/ttyACM0 [--baud 115200] [--run] [--follow]
+"""
+
+import argparse
+import os
+import re
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+OPS = {
+    "halt": 0x00, "push8": 0x01, "push16": 0x02, "push32": 0x03,
+    "dup": 0x04, "drop": 0x05, "swap": 0x06, "over": 0x07,
+    "load": 0x08, "store": 0x09,
+    "+": 0x10, "-": 0x11, "*": 0x12, "/": 0x13, "mod": 0x14, "negate": 0x15,
+    "and": 0x16, "or": 0x17, "xor": 0x18, "not": 0x19, "lshift": 0x1A, "rshift": 0x1B,
+    "=": 0x20, "<>": 0x21, "<": 0x22, "<=": 0x23, ">": 0x24, ">=": 0x25,
+    "jmp": 0x30, "jz": 0x31, "jnz": 0x32,
+    "ms": 0x40, "ticks": 0x41,
+    "call": 0x50, ".": 0x51, "prints": 0x52, "emit": 0x53,
+}
+SIMPLE_WORDS = {"dup", "drop", "swap", "over", "+", "-", "*", "/", "mod", "negate",
+                "and", "or", "xor", "not", "lshift", "rshift", "=", "<>", "<", "<=",
+                ">", ">=", "ms", "ticks", ".", "emit", "halt"}
+NAMES = {v: k for k, v in OPS.items()}
+
+CODE_SIZE = 256
+NUM_VARS = 8
+LINE_SIZE = 64
+CHUNK = 24  # Bytes per `vm load` line (hex doubles them; line limit is 63)
+
+
+class CompileError(Exception):
+    pass
+
+
+def tokenize(source):
+    """Yields (token, line); strings are returned as ('."', text) etc."""
+    pattern = re.compile(r'\\[^\n]*|\(\s[^)]*\)|(\.|run)"\s?([^"]*)"|\S+|\n')
+    line = 1
+    for match in pattern.finditer(source):
+        text = match.group(0)
+        if text == "\n":
+            line += 1
+        elif text.startswith("\\") or text.startswith("( "):
+            line += text.count("\n")
+        elif match.group(1):
+            yield (match.group(1) + '"', match.group(2)), line
+        else:
+            yield text, line
+
+
+class Compiler:
+    def __init__(self):
+        self.code = bytearray()
+        self.vars = {}
+        self.control = []       # Open control structures
+        self.loops = []         # (index_var, limit_var) of open `times`
+
+    def emit(self, op, operand=b""):
+        self.code.append(OPS[op])
+        self.code += operand
+
+    def here(self):
+        return len(self.code)
+
+    def jump(self, op, target=0):
+        self.emit(op, struct.pack("<H", target))
+        return self.here() - 2
+
+    def patch(self, at, target):
+        self.code[at:at + 2] = struct.pack("<H", target)
+
+    def push(self, value):
+        if -128 <= value < 128:
+            self.emit("push8", struct.pack("<b", value))
+        elif -32768 <= value < 32768:
+            self.emit("push16", struct.pack("<h", value))
+        else:
+            self.emit("push32", struct.pack("<I", value & 0xFFFFFFFF))
+
+    def alloc_var(self):
+        used = set(self.vars.values()) | {v for loop in self.loops for v in loop}
+        for slot in range(NUM_VARS):
+            if slot not in used:
+                return slot
+        raise CompileError("out of variables")
+
+    def string_op(self, op, text):
+        data = text.encode()
+        if op == "call" and len(data) >= LINE_SIZE:
+            raise CompileError("command too long")
+        if len(data) > 255:
+            raise CompileError("string too long")
+        self.emit(op, bytes([len(data)]) + data)
+
+    def compile(self, source):
+        tokens = tokenize(source)
+        for token, line in tokens:
+            try:
+                self.word(token, tokens)
+            except CompileError as error:
+                raise CompileError(f"line {line}: {error}") from None
+        if self.control:
+            raise CompileError(f"unterminated '{self.control[-1][0]}'")
+        self.emit("halt")
+        if len(self.code) > CODE_SIZE:
+            raise CompileError(f"program is {len(self.code)} bytes, limit {CODE_SIZE}")
+        return bytes(self.code)
+
+    def word(self, token, tokens):
+        if isinstance(token, tuple):
+            kind, text = token
+            if kind == '."':
+                self.string_op("prints", text)
+            else:
+                self.string_op("call", text)
+            return
+
+        lower = token.lower()
+        number = parse_number(token)
+        if number is not None:
+            self.push(number)
+        elif lower in SIMPLE_WORDS:
+            self.emit(lower)
+        elif lower == "cr":
+            self.string_op("prints", "\r\n")
+        elif lower == "var":
+            name, _ = next(tokens, (None, None))
+            if not isinstance(name, str) or parse_number(name) is not None:
+                raise CompileError("'var' needs a name")
+            self.vars[name.lower()] = self.alloc_var()
+        elif lower == "to":
+            name, _ = next(tokens, (None, None))
+            if not isinstance(name, str) or name.lower() not in self.vars:
+                raise CompileError("'to' needs a declared variable")
+            self.emit("store", bytes([self.vars[name.lower()]]))
+        elif lower in self.vars:
+            self.emit("load", bytes([self.vars[lower]]))
+        elif lower == "if":
+            self.control.append(("if", self.jump("jz")))
+        elif lower == "else":
+            kind, at = self.pop_control("else", "if")
+            self.control.append(("else", self.jump("jmp")))
+            self.patch(at, self.here())
+        elif lower == "then":
+            kind, at = self.pop_control("then", "if", "else")
+            self.patch(at, self.here())
+        elif lower == "begin":
+            self.control.append(("begin", self.here()))
+        elif lower == "until":
+            _, start = self.pop_control("until", "begin")
+            self.jump("jz", start)
+        elif lower == "again":
+            _, start = self.pop_control("again", "begin")
+            self.jump("jmp", start)
+        elif lower == "while":
+            _, start = self.pop_control("while", "begin")
+            self.control.append(("while", (start, self.jump("jz"))))
+        elif lower == "repeat":
+            _, (start, exit_at) = self.pop_control("repeat", "while")
+            self.jump("jmp", start)
+            self.patch(exit_at, self.here())
+        elif lower == "times":
+            index = self.alloc_var()
+            self.loops.append((index, -1))
+            limit = self.alloc_var()
+            self.loops[-1] = (index, limit)
+            self.emit("store", bytes([limit]))
+            self.push(0)
+            self.emit("store", bytes([index]))
+            start = self.here()
+            self.emit("load", bytes([index]))
+            self.emit("load", bytes([limit]))
+            self.emit("<")
+            self.control.append(("times", (start, self.jump("jz"))))
+        elif lower == "loop":
+            _, (start, exit_at) = self.pop_control("loop", "times")
+            index, _ = self.loops.pop()
+            self.emit("load", bytes([index]))
+            self.push(1)
+            self.emit("+")
+            self.emit("store", bytes([index]))
+            self.jump("jmp", start)
+            self.patch(exit_at, self.here())
+        elif lower == "i":
+            if not self.loops:
+                raise CompileError("'i' outside 'times'")
+            self.emit("load", bytes([self.loops[-1][0]]))
+        else:
+            raise CompileError(f"unknown word '{token}'")
+
+    def pop_control(self, word, *expected):
+        if not self.control or self.control[-1][0] not in expected:
+            raise CompileError(f"'{word}' without '{expected[0]}'")
+        return self.control.pop()
+
+
+def parse_number(token):
+    if len(token) == 3 and token[0] == token[2] == "'":
+        return ord(token[1])
+    try:
+        return int(token, 0)
+    except ValueError:
+        return None
+
+
+def disassemble(code):
+    pc, lines = 0, []
+    while pc < len(code):
+        op = code[pc]
+        name = NAMES.get(op, f"?{op:02x}")
+        size = {"push8": 1, "push16": 2, "push32": 4, "load": 1, "store": 1,
+                "jmp": 2, "jz": 2, "jnz": 2}.get(name, 0)
+        if name in ("call", "prints"):
+            size = 1 + code[pc + 1]
+        operand = code[pc + 1:pc + 1 + size]
+        if name in ("call", "prints"):
+            text = repr(bytes(operand[1:]).decode(errors="replace"))
+        elif name == "push8":
+            text = str(struct.unpack("<b", operand)[0])
+        elif name == "push16":
+            text = str(struct.unpack("<h", operand)[0])
+        elif name == "push32":
+            text = str(struct.unpack("<i", operand)[0])
+        elif size == 2:
+            text = f"0x{struct.unpack('<H', operand)[0]:04x}"
+        elif size == 1:
+            text = str(operand[0])
+        else:
+            text = ""
+        lines.append(f"{pc:04x}  {code[pc:pc + 1 + size].hex():<16} {name} {text}".rstrip())
+        pc += 1 + size
+    return "\n".join(lines)
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+# -----------------------------------------------------------------------------
+# Upload over the text console
+# -----------------------------------------------------------------------------
+def open_serial(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = getattr(termios, f"B{baud}")
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def command(fd, line, expect, timeout=2.0):
+    """Sends a command line and returns the first reply line matching expect."""
+    os.write(fd, line.encode() + b"\r")
+    seen = b""
+    deadline = time.monotonic() + timeout
+    while True:
+        for reply in seen.split(b"\r\n")[:-1]:
+            match = re.search(expect, reply.decode(errors="replace"))
+            if match:
+                return match
+        remaining = deadline - time.monotonic()
+        ready, _, _ = select.select([fd], [], [], max(remaining, 0))
+        if not ready:
+            raise RuntimeError(f"no reply to '{line}'")
+        seen += os.read(fd, 256)
+
+
+def upload(fd, code):
+    for offset in range(0, len(code), CHUNK):
+        chunk = code[offset:offset + CHUNK]
+        match = command(fd, f"vm load {offset} {chunk.hex()}",
+                        r"VM loaded|VM is running|Bad load")
+        if not match.group(0).startswith("VM loaded"):
+            raise RuntimeError(f"load failed at offset {offset}: {match.group(0)}")
+    match = command(fd, "vm status", r"VM \w+, (\d+) bytes, crc 0x([0-9A-F]{4})")
+    if int(match.group(1)) != len(code) or int(match.group(2), 16) != crc16_ccitt(code):
+        raise RuntimeError("verification failed: " + match.group(0))
+
+
+def follow(fd):
+    """Prints script output until it halts or fails."""
+    seen = b""
+    while not re.search(rb"VM (done|error)[^\n]*\n", seen):
+        ready, _, _ = select.select([fd], [], [], 1.0)
+        if ready:
+            data = os.read(fd, 256)
+            sys.stdout.write(data.decode(errors="replace"))
+            sys.stdout.flush()
+            seen = (seen + data)[-128:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("script")
+    parser.add_argument("-o", "--output", help="write the bytecode to a file")
+    parser.add_argument("--list", action="store_true", help="print a disassembly")
+    parser.add_argument("--port", help="upload over this serial console")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--run", action="store_true", help="start the script after upload")
+    parser.add_argument("--follow", action="store_true", help="print output until it ends")
+    args = parser.parse_args()
+
+    with open(args.script) as f:
+        source = f.read()
+    try:
+        code = Compiler().compile(source)
+    except CompileError as error:
+        sys.exit(f"{args.script}: {error}")
+
+    print(f"{len(code)} bytes, crc 0x{crc16_ccitt(code):04X}", file=sys.stderr)
+    if args.list:
+        print(disassemble(code))
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(code)
+    if args.port:
+        fd = open_serial(args.port, args.baud)
+        os.write(fd, b"\r")  # Clear any partial line
+        upload(fd, code)
+        if args.run or args.follow:
+            command(fd, "vm run", r"VM running")
+            if args.follow:
+                follow(fd)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
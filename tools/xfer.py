@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Uploads a blob into board RAM or flash with the windowed transfer
+protocol (see Core/Inc/xfer.h).
+
+    xfer.py /dev/ttyACM0 pattern.bin                      (scratch RAM, offset 0)
+    xfer.py /dev/ttyACM0 image.bin --flash 0x08020000 --window 24
+
+Up to --window chunks are in flight. The link is FIFO, so an ack that
+covers a chunk proves every chunk sent before it that is still missing
+was lost: those are resent at once. Chunks at the tail, with nothing
+after them to reveal a loss, are resent after --rto ms.
+
+The console is switched to mux mode for the transfer and back afterwards;
+`xfer` on the console shows the board's view (duplicates, bad chunks,
+chunks dropped for lack of flash buffers).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from modlink import CH_DATA, MuxLink  # noqa: E402
+from vchan_demux import (BAUD_RATES, CH_CONTROL, CTRL_EXIT, crc16_ccitt,  # noqa: E402
+                         open_serial, switch_to_mux)
+
+MSG_OPEN, MSG_CHUNK, MSG_CLOSE, MSG_ACK = 0x30, 0x31, 0x32, 0x33
+TARGET_RAM, TARGET_FLASH = 0, 1
+MAX_CHUNK = 56
+MAX_WINDOW = 32  # XFER_MAX_WINDOW: chunks accepted beyond the first hole
+RETURN_CODES = ["ok", "full", "empty", "invalid argument", "error"]
+
+
+def parse_ack(payload):
+    """Returns (message, rc, next, value) of an ACK, or None."""
+    if len(payload) != 9 or payload[0] != MSG_ACK:
+        return None
+    return struct.unpack_from("<BBHI", payload, 1)
+
+
+class Sender:
+    """Sliding window with selective retransmit; transport agnostic so the
+    same logic can be driven by a simulated link."""
+
+    def __init__(self, blob, chunk_size, window, rto):
+        self.chunks = [blob[i:i + chunk_size] for i in range(0, len(blob), chunk_size)]
+        self.window = min(window, MAX_WINDOW + 1)
+        self.rto = rto
+        self.acked = [False] * len(self.chunks)
+        self.tx_order = {}     # seq -> transmission number of its latest copy
+        self.sent_at = {}      # seq -> time of its latest copy
+        self.lost = set()
+        self.base = 0          # First chunk not acknowledged
+        self.next_new = 0      # First chunk never sent
+        self.transmissions = 0
+        self.retransmits = 0
+
+    def done(self):
+        return self.base == len(self.chunks)
+
+    def message(self, seq):
+        data = self.chunks[seq]
+        return struct.pack("<BHH", MSG_CHUNK, seq, crc16_ccitt(data)) + data
+
+    def on_ack(self, next_seq, bitmap):
+        newest = -1
+        covered = list(range(self.base, min(next_seq, len(self.chunks))))
+        covered += [next_seq + 1 + i for i in range(32) if bitmap >> i & 1]
+        for seq in covered:
+            if seq < len(self.chunks) and not self.acked[seq]:
+                self.acked[seq] = True
+                newest = max(newest, self.tx_order.get(seq, -1))
+                self.sent_at.pop(seq, None)
+        self.base = max(self.base, min(next_seq, len(self.chunks)))
+        # Anything sent before a chunk that got through, and still missing, was lost
+        for seq, order in self.tx_order.items():
+            if not self.acked[seq] and order < newest:
+                self.lost.add(seq)
+
+    def to_send(self, now):
+        """Chunks to transmit now, resends first."""
+        out = []
+        for seq, at in self.sent_at.items():
+            if not self.acked[seq] and now - at > self.rto:
+                self.lost.add(seq)
+        for seq in sorted(self.lost):
+            if not self.acked[seq]:
+                out.append(seq)
+                self.retransmits += 1
+        self.lost.clear()
+        in_flight = sum(1 for seq in self.sent_at if not self.acked[seq]) - len(out)
+        while (self.next_new < len(self.chunks) and in_flight < self.window and
+               self.next_new <= self.base + MAX_WINDOW):
+            out.append(self.next_new)
+            self.next_new += 1
+            in_flight += 1
+        for seq in out:
+            self.tx_order[seq] = self.transmissions
+            self.sent_at[seq] = now
+            self.transmissions += 1
+        return out
+
+
+def request(link, message, payload, timeout):
+    """Sends a control message until its ACK arrives; returns (rc, next, value)."""
+    for _ in range(3):
+        link.send(CH_DATA, bytes([message]) + payload)
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            try:
+                ack = parse_ack(link.receive(CH_DATA, deadline - time.monotonic()))
+            except RuntimeError:
+                break
+            if ack and ack[0] == message:
+                return ack[1:]
+    raise RuntimeError(f"no acknowledgement for message 0x{message:02x}")
+
+
+def transfer(link, blob, target, address, args):
+    erase_s = len(blob) / 128 * 0.004 if target == TARGET_FLASH else 0
+    rc, _, start = request(link, MSG_OPEN, struct.pack("<BIIB", target, address, len(blob),
+                                                      args.chunk), 1.0 + erase_s)
+    if rc != 0:
+        raise RuntimeError(f"open refused: {RETURN_CODES[rc]}")
+
+    sender = Sender(blob, args.chunk, args.window, args.rto / 1000.0)
+    began = time.monotonic()
+    while not sender.done():
+        for seq in sender.to_send(time.monotonic()):
+            link.send(CH_DATA, sender.message(seq))
+        try:
+            ack = parse_ack(link.receive(CH_DATA, 0.02))
+        except RuntimeError:
+            continue  # Nothing this round; timeouts resend
+        if ack and ack[0] == MSG_CHUNK:
+            sender.on_ack(ack[2], ack[3])
+
+    rc, _, _ = request(link, MSG_CLOSE, struct.pack("<H", crc16_ccitt(blob)), 2.0)
+    elapsed = time.monotonic() - began
+    if rc != 0:
+        raise RuntimeError(f"close failed: {RETURN_CODES[rc]}")
+    print(f"{len(blob)} bytes to 0x{start:08x} in {elapsed:.2f} s ({len(blob) / elapsed:.0f} B/s), "
+          f"{sender.transmissions} chunks sent, {sender.retransmits} resent", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("file")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--ram", type=lambda v: int(v, 0), default=0, metavar="OFFSET",
+                        help="offset in the scratch RAM (default)")
+    parser.add_argument("--flash", type=lambda v: int(v, 0), metavar="ADDRESS",
+                        help="page-aligned flash address after the firmware")
+    parser.add_argument("--chunk", type=int, default=MAX_CHUNK, help="bytes per chunk")
+    parser.add_argument("--window", type=int, default=16, help="chunks in flight")
+    parser.add_argument("--rto", type=int, default=300, help="resend timeout, ms")
+    args = parser.parse_args()
+    if not 0 < args.chunk <= MAX_CHUNK:
+        parser.error(f"chunk is 1..{MAX_CHUNK}")
+
+    with open(args.file, "rb") as f:
+        blob = f.read()
+    target, address = (TARGET_FLASH, args.flash) if args.flash is not None else (TARGET_RAM, args.ram)
+
+    fd = open_serial(args.port, args.baud)
+    link = MuxLink(fd)
+    switch_to_mux(fd)
+    try:
+        transfer(link, blob, target, address, args)
+    except RuntimeError as error:
+        print(error, file=sys.stderr)
+        return 1
+    finally:
+        link.send(CH_CONTROL, bytes([CTRL_EXIT]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())